@@ -41,6 +41,8 @@
 #include "RSVP_PacketHeader.h"
 
 LogicalInterfaceUDP* RSVP_API::apiLif = NULL;
+LogicalInterfaceAPI_Stream* RSVP_API::apiStream = NULL;
+const char* RSVP_API::streamPath = NULL;
 int RSVP_API::apiRefCounter = 0;
 	
 inline ApiStateBlockList& RSVP_API::getStateList( const SESSION_Object& s ) {
@@ -90,11 +92,29 @@ void RSVP_API::constructor( uint16 apiPort, NetAddress apiHost ) {
 
 	//@@@@ hack! >>Xi2007<<
 	if (!apiLif) {
-		apiLif = new LogicalInterfaceUDP( RSVP_Global::apiUniClientName, 0, RSVP_Global::apiMTU );
 		PortList portList; portList.push_back( apiPort );
-		apiLif->configureUDP( 0, apiHost, portList );
-		apiLif->configureRefresh( 0 );
-		apiLif->initWithPort();	
+#if !defined(NS2)
+		// sessions registered over the stream socket live as long as the
+		// connection and are never refreshed; UDP remains the fallback
+		if ( streamPath ) {
+			apiStream = new LogicalInterfaceAPI_Stream( RSVP_Global::apiUniClientName, 0, RSVP_Global::apiMTU );
+			apiStream->configureUDP( 0, apiHost, portList );
+			apiStream->configureRefresh( 0 );
+			if ( apiStream->initStream( streamPath ) ) {
+				apiLif = apiStream;
+			} else {
+				LOG(2)( Log::API, "no API stream socket at", streamPath );
+				delete apiStream;
+				apiStream = NULL;
+			}
+		}
+#endif
+		if (!apiLif) {
+			apiLif = new LogicalInterfaceUDP( RSVP_Global::apiUniClientName, 0, RSVP_Global::apiMTU );
+			apiLif->configureUDP( 0, apiHost, portList );
+			apiLif->configureRefresh( 0 );
+			apiLif->initWithPort();	
+		}
 		LOG(2)( Log::API, "new API: ", *apiLif );
 	}
 	else {
@@ -121,7 +141,7 @@ RSVP_API::~RSVP_API() {
 	//@@@@ hack! >>Xi2007<<
 	apiRefCounter--;
 	if (apiRefCounter <= 0) {
-		delete apiLif; apiLif = NULL;
+		delete apiLif; apiLif = NULL; apiStream = NULL;
 	}
 }
 
@@ -145,23 +165,51 @@ void RSVP_API::sleep( TimeValue duration, const bool& endFlag ) {
 	}
 }
 
+// a stream read may deliver several upcalls; requests issued while
+// handling them are sent back in one write
 void RSVP_API::receiveAndProcess(zUpcall upcall) {
 	static INetworkBuffer buf( LogicalInterface::maxPayloadLength );
-	buf.init();
 	static Message msg;
-	msg.init();
 	static PacketHeader header;
-	if ( apiLif->receiveBuffer( buf, header ) ) {
-		if ( apiLif->parseBuffer( buf, header, msg ) ) {
-			if ( msg.getStatus() == Message::Reject ) {
-				LOG(4)( Log::Msg, "API ignoring message with status 'reject' from", header.getSrcAddress(), ":", msg );
-			} else {
-				process( msg , upcall);
+	beginBatch();
+	do {
+		buf.init();
+		msg.init();
+		if ( apiLif->receiveBuffer( buf, header ) ) {
+			if ( apiLif->parseBuffer( buf, header, msg ) ) {
+				if ( msg.getStatus() == Message::Reject ) {
+					LOG(4)( Log::Msg, "API ignoring message with status 'reject' from", header.getSrcAddress(), ":", msg );
+				} else {
+					process( msg , upcall);
+				}
 			}
 		}
+	} while ( apiStream && apiStream->hasPendingInput() );
+	endBatch();
+	if ( apiStream && apiStream->queryAndClearTransportReset() ) {
+		reregisterSessions();
+	}
+}
+
+// the daemon dropped all sessions of a lost stream connection
+void RSVP_API::reregisterSessions() {
+	uint32 i = 0;
+	for ( ; i < sessionHash; i += 1 ) {
+		ApiStateBlockList::ConstIterator iter = stateList[i].begin();
+		for ( ; iter != stateList[i].end(); ++iter ) {
+			refreshSession( **iter, apiRefresh );
+		}
 	}
 }
 
+void RSVP_API::beginBatch() {
+	if ( apiStream ) apiStream->beginBatch();
+}
+
+void RSVP_API::endBatch() {
+	if ( apiStream ) apiStream->endBatch();
+}
+
 void RSVP_API::process( Message& msg , zUpcall upcall) {
 #if defined(WITH_JAVA_API)
 	preUpcall();
@@ -617,13 +665,16 @@ void zInitRsvpPathRequest(void* thisApi, struct _sessionParameters* para, uint8
 	LABEL_REQUEST_Object *lr = NULL;
 	RSVP_API *api = (RSVP_API *)thisApi;
 	
+	api->beginBatch();
        RSVP_API::SessionId session = 
        api->createSession( NetAddress(para->Session_Para.destAddr.s_addr), para->Session_Para.destPort, 
                                     para->Session_Para.srcAddr.s_addr, (UpcallProcedure)rsvpUpcall);
 
 	//RSVP receiver stops here
-	if (!isSender)
+	if (!isSender) {
+		api->endBatch();
 		return;
+	}
 	
 	if (para->ADSpec_Para){
 	        ao = new ADSPEC_Object( para->ADSpec_Para->ADSpecHopCount, 
@@ -731,6 +782,7 @@ void zInitRsvpPathRequest(void* thisApi, struct _sessionParameters* para, uint8
 	if (stb) delete stb;
 	if (ssAttrib) delete ssAttrib;
 	if (upLabel) delete upLabel;
+	api->endBatch();
 
 	return;
 }
@@ -828,6 +880,7 @@ void zApiReceiveAndProcess(void *api, zUpcall upcall)
 void* zInitRsvpApiInstance()
 {
        Log::init( "all", "ref,packet,select" );
+	RSVP_API::configureStream( RSVP_Global::apiStreamPath );
 	RSVP_API *api = new RSVP_API();
 	return api;
 }
@@ -848,3 +901,13 @@ void zMonitoringQuery(void* api, uint32 ucid, uint32 seqnum, char* gri, uint32 d
 {
 	((RSVP_API *)api)->monitoringQuery(ucid, seqnum, gri, destAddrIp, tunnelId, extTunnelId); // last four argments: lspName, destIP, destPort, sourceIP
 }
+
+void zBeginRsvpBatch(void* api)
+{
+	((RSVP_API *)api)->beginBatch();
+}
+
+void zEndRsvpBatch(void* api)
+{
+	((RSVP_API *)api)->endBatch();
+}
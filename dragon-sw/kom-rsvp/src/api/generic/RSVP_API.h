@@ -42,6 +42,7 @@ class SESSION_Object;
 class ADSPEC_Object;
 class POLICY_DATA_Object;
 class LogicalInterfaceUDP;
+class LogicalInterfaceAPI_Stream;
 class Message;
 
 typedef SortableList<API_StateBlock*,SESSION_Object*> ApiStateBlockList;
@@ -211,11 +212,14 @@ protected:
 	ApiStateBlockList* stateList;
 
 	static LogicalInterfaceUDP* apiLif;
+	static LogicalInterfaceAPI_Stream* apiStream;      // == apiLif, if connected over the stream socket
+	static const char* streamPath;
 	static int apiRefCounter;
 
 	void process( Message& , zUpcall upcall = NULL);
 	static void refreshSession( const SESSION_Object& session, const TimeValue& = 0 );
 	void constructor( uint16 apiPort, NetAddress apiHost );
+	void reregisterSessions();
 	inline ApiStateBlockList& getStateList( const SESSION_Object& s );
 	friend class API_StateBlock;                       // access: refreshSession
 #if defined(NS2)
@@ -274,6 +278,11 @@ public:
 	void sleep( TimeValue, const bool& endFlag = false );
 	void run( const bool& endFlag = false );
 	void changeRefreshTimeout( const TimeValue& ar ) { apiRefresh = ar; }
+	// prefer the daemon's local stream socket for API instances created later
+	static void configureStream( const char* path ) { streamPath = path; }
+	// requests between beginBatch() and endBatch() are sent with one write
+	void beginBatch();
+	void endBatch();
        //$$$$ DRAGON
        void addLocalId(uint16 type, uint16 value, uint16 tag);
        //$$$$ DRAGON
@@ -297,6 +306,8 @@ extern "C" {
 	extern void zDeleteLocalId(void* api, uint16 type, uint16 value, uint16 tag);
 	extern void zRefreshLocalId(void* api, uint16 type, uint16 value, uint16 tag);
 	extern void zMonitoringQuery(void* api, uint32 ucid, uint32 seqnum, char* gri, uint32 destAddrIp, uint16 tunnelId, uint32 extTunnelId);
+	extern void zBeginRsvpBatch(void* api);
+	extern void zEndRsvpBatch(void* api);
 }
 
 #endif /* _RSVP_API_h */
@@ -47,6 +47,7 @@ const NetAddress LogicalInterface::noGatewayAddress("0.0.0.0");
 const TimeValue RSVP_Global::defaultApiRefresh(120,0);
 const char* const RSVP_Global::apiName = "rsvp-api";
 const char* const RSVP_Global::apiUniClientName = "rsvp-api-client";
+const char* const RSVP_Global::apiStreamPath = "/var/run/rsvpd.api";
 
 // configuration of hashed fuzzy timer system
 sint32 TimerSystem::slotCount = 0;
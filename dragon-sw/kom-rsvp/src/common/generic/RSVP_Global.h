@@ -67,6 +67,7 @@ struct RSVP_Global {
 	static const uint16 apiPort = 4000;
 	static const char* const apiName;
 	static const char* const apiUniClientName;
+	static const char* const apiStreamPath;
 	static const uint16 apiMTU = 8191;
 	static const TimeValue defaultApiRefresh;
 	// needed for class LogicalInterfaceSet
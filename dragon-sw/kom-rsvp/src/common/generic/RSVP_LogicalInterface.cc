@@ -29,6 +29,7 @@
 
 ****************************************************************************/
 #include "RSVP_LogicalInterface.h"
+#include "RSVP_APIStream.h"
 #include "RSVP_Global.h"
 #include "RSVP_Log.h"
 #include "RSVP_Message.h"
@@ -269,3 +270,80 @@ void LogicalInterfaceUDP::sendBuffer( const ONetworkBuffer& obuf, const NetAddre
 #endif
 }
 #endif /* defined(WITH_API) || defined(VIRT_NETWORK) */
+
+#if defined(WITH_API)
+LogicalInterfaceAPI_Stream::~LogicalInterfaceAPI_Stream() {
+	if ( stream ) {
+		delete stream;
+		fd = -1;
+	}
+}
+
+bool LogicalInterfaceAPI_Stream::initStream( const char* path ) {
+	InterfaceHandle streamFd = APIStream::connect( path );
+	if ( streamFd < 0 ) return false;
+	stream = new APIStream( streamFd );
+	// the daemon greets with an InitAPI message carrying the LIH of this connection
+	INetworkBuffer buf( maxPayloadLength );
+	PacketHeader header;
+	Message msg;
+	if ( stream->waitForRecord( TimeValue(5,0) ) && stream->nextRecord( buf ) ) {
+		buf >> header;
+		if ( parseBuffer( buf, header, msg ) && msg.getMsgType() == Message::InitAPI ) {
+			fd = streamFd;
+			setLIH( msg.getRSVP_HOP_Object().getLIH() );
+			LOG(4)( Log::API, "API stream connected to", path, "as", getLIH() );
+			return true;
+		}
+	}
+	delete stream;
+	stream = NULL;
+	return false;
+}
+
+void LogicalInterfaceAPI_Stream::fallbackToUDP() const {
+	LogicalInterfaceAPI_Stream* This = const_cast<LogicalInterfaceAPI_Stream*>(this);
+	InterfaceHandle streamFd = fd;
+	delete stream;
+	stream = NULL;
+	This->initWithPort();
+	// keep the descriptor number, the application may be selecting on it
+	if ( fd != streamFd && dup2( fd, streamFd ) >= 0 ) {
+		close( fd );
+		This->fd = streamFd;
+	}
+	transportReset = true;
+	ERROR(2)( Log::Error, "API stream to RSVPD lost, using UDP transport:", *this );
+}
+
+const LogicalInterface* LogicalInterfaceAPI_Stream::receiveBuffer( INetworkBuffer& buf, PacketHeader& header ) const {
+	if ( !stream ) return LogicalInterfaceUDP::receiveBuffer( buf, header );
+	if ( stream->nextRecord( buf ) || (stream->readData() && stream->nextRecord( buf )) ) {
+		buf >> header;
+		return this;
+	}
+	if ( stream->isBroken() ) fallbackToUDP();
+	header.init();
+	return NULL;
+}
+
+void LogicalInterfaceAPI_Stream::sendBuffer( const ONetworkBuffer& obuf, const NetAddress& dest, const NetAddress& src ) const {
+	if ( stream ) {
+		if ( stream->sendRecord( obuf ) ) return;
+		fallbackToUDP();
+	}
+	LogicalInterfaceUDP::sendBuffer( obuf, dest, src );
+}
+
+bool LogicalInterfaceAPI_Stream::hasPendingInput() const {
+	return stream && stream->hasRecord();
+}
+
+void LogicalInterfaceAPI_Stream::beginBatch() {
+	if ( stream ) stream->beginBatch();
+}
+
+void LogicalInterfaceAPI_Stream::endBatch() {
+	if ( stream && !stream->endBatch() ) fallbackToUDP();
+}
+#endif /* WITH_API */
@@ -40,6 +40,7 @@
 class Message;
 class TrafficControl;
 class Hop;
+class APIStream;
 
 typedef SimpleList<uint32> PortList;
 
@@ -187,6 +188,30 @@ public:
 		: LogicalInterfaceUDP(name, addr, MTU) {}
 	// implemented in RSVP_API_Server.cc
 	VIRTUAL void sendMessage( const Message& msg, const NetAddress&, const NetAddress&, const NetAddress& = noGatewayAddress ) const;
+	VIRTUAL const LogicalInterface* receiveBuffer( INetworkBuffer&, PacketHeader& ) const;
+};
+
+// API client over the daemon's local stream socket. The LIH is assigned by
+// the daemon when connecting. If the connection is lost, the interface falls
+// back to the UDP transport on the same descriptor.
+class LogicalInterfaceAPI_Stream : public LogicalInterfaceUDP {
+	mutable APIStream* stream;
+	mutable bool transportReset;
+	void fallbackToUDP() const;
+public:
+	LogicalInterfaceAPI_Stream( const String& name, const NetAddress& addr, uint32 MTU )
+		: LogicalInterfaceUDP(name, addr, MTU), stream(NULL), transportReset(false) {}
+	~LogicalInterfaceAPI_Stream();
+	bool initStream( const char* path );
+	VIRTUAL const LogicalInterface* receiveBuffer( INetworkBuffer&, PacketHeader& ) const;
+	VIRTUAL void sendBuffer( const ONetworkBuffer&, const NetAddress& dest, const NetAddress& ) const;
+	bool isStream() const { return stream != NULL; }
+	bool hasPendingInput() const;
+	void beginBatch();
+	void endBatch();
+	bool queryAndClearTransportReset() {
+		bool retval = transportReset; transportReset = false; return retval;
+	}
 };
 #endif
 
@@ -0,0 +1,212 @@
+/****************************************************************************
+
+Local stream (Unix-domain) transport for the RSVP API, source file RSVP_APIStream.cc
+
+****************************************************************************/
+#include "RSVP_APIStream.h"
+#include "RSVP_Log.h"
+
+#include "SystemCallCheck.h"
+
+#include <sys/types.h>                           // needed for other includes
+#include <sys/socket.h>                          // socket, bind, send, recv
+#include <sys/time.h>                            // FD_SET, etc.
+#include <sys/un.h>                              // sockaddr_un
+#include <fcntl.h>                               // fcntl
+#include <errno.h>
+
+#if defined(MSG_NOSIGNAL)
+#define API_STREAM_SEND_FLAGS MSG_NOSIGNAL
+#else
+#define API_STREAM_SEND_FLAGS 0
+#endif
+
+APIStream::APIStream( InterfaceHandle fd, bool queueOutput ) : fd(fd), inStart(0), inEnd(0),
+	outLength(0), outSize(bufferSize), batchDepth(0), queueOutput(queueOutput), broken(false) {
+	inBuffer = new uint8[bufferSize];
+	outBuffer = new uint8[bufferSize];
+}
+
+APIStream::~APIStream() {
+	if ( fd != -1 ) close( fd );
+	delete [] inBuffer;
+	delete [] outBuffer;
+}
+
+// the descriptor stays open (and readable) until the owner deletes the stream
+void APIStream::fail( const char* what ) {
+	if ( !broken ) {
+		LOG(4)( Log::API, "API stream", what, "failed:", strerror(errno) );
+		broken = true;
+		shutdown( fd, SHUT_RDWR );
+	}
+	outLength = 0;
+}
+
+bool APIStream::readData() {
+	if ( broken ) return false;
+	if ( inStart > 0 ) {
+		memmove( inBuffer, inBuffer + inStart, inEnd - inStart );
+		inEnd -= inStart;
+		inStart = 0;
+	}
+	if ( inEnd == bufferSize ) return true;
+	int length = recv( fd, (char*)inBuffer + inEnd, bufferSize - inEnd, MSG_DONTWAIT );
+	if ( length < 0 ) {
+		if ( errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR ) return true;
+		fail( "read" );
+		return false;
+	}
+	if ( length == 0 ) {
+		LOG(1)( Log::API, "API stream closed by peer" );
+		broken = true;
+		return false;
+	}
+	inEnd += length;
+	return true;
+}
+
+bool APIStream::waitForRecord( const TimeValue& timeout ) {
+	TimeValue remaining = timeout;
+	while ( !hasRecord() ) {
+		fd_set readfds;
+		FD_ZERO( &readfds );
+		FD_SET( fd, &readfds );
+		TimeValue startTime, endTime;
+		getCurrentSystemTime( startTime );
+		if ( select( fd + 1, &readfds, NULL, NULL, &remaining ) <= 0 ) return false;
+		if ( !readData() ) return false;
+		getCurrentSystemTime( endTime );
+		if ( endTime - startTime >= remaining ) return hasRecord();
+		remaining -= (endTime - startTime);
+	}
+	return true;
+}
+
+bool APIStream::hasRecord() const {
+	if ( inEnd - inStart < sizeof(uint32) ) return false;
+	uint32 length = ntohl( *(uint32*)(inBuffer + inStart) );
+	return inEnd - inStart - sizeof(uint32) >= length;
+}
+
+bool APIStream::nextRecord( INetworkBuffer& buffer ) {
+	if ( !hasRecord() ) return false;
+	uint32 length = ntohl( *(uint32*)(inBuffer + inStart) );
+	if ( length == 0 || length > buffer.getSize() ) {
+		ERROR(2)( Log::Error, "API stream: invalid record length", length );
+		errno = EPROTO;
+		fail( "parse" );
+		inStart = inEnd = 0;
+		return false;
+	}
+	memcpy( buffer.getWriteBuffer(), inBuffer + inStart + sizeof(uint32), length );
+	buffer.setWriteLength( (uint16)length );
+	inStart += sizeof(uint32) + length;
+	return true;
+}
+
+bool APIStream::sendRecord( const ONetworkBuffer& buffer ) {
+	if ( broken ) return false;
+	uint32 length = buffer.getUsedSize();
+	if ( outLength + sizeof(uint32) + length > outSize && !flush() ) return false;
+	if ( outLength + sizeof(uint32) + length > outSize ) {
+		// only with 'queueOutput': the socket is full, keep the record queued
+		if ( outSize >= maxOutputSize ) {
+			errno = ENOBUFS;
+			fail( "write" );
+			return false;
+		}
+		uint8* newBuffer = new uint8[outSize * 2];
+		memcpy( newBuffer, outBuffer, outLength );
+		delete [] outBuffer;
+		outBuffer = newBuffer;
+		outSize *= 2;
+	}
+	*(uint32*)(outBuffer + outLength) = htonl( length );
+	memcpy( outBuffer + outLength + sizeof(uint32), buffer.getContents(), length );
+	outLength += sizeof(uint32) + length;
+	if ( batchDepth == 0 ) return flush();
+	return true;
+}
+
+bool APIStream::endBatch() {
+	if ( batchDepth > 0 ) batchDepth -= 1;
+	if ( batchDepth == 0 ) return flush();
+	return true;
+}
+
+bool APIStream::flush() {
+	uint32 sent = 0;
+	while ( !broken && sent < outLength ) {
+		int length = send( fd, (char*)outBuffer + sent, outLength - sent, API_STREAM_SEND_FLAGS );
+		if ( length < 0 ) {
+			if ( errno == EINTR ) continue;
+			if ( queueOutput && (errno == EAGAIN || errno == EWOULDBLOCK) ) break;
+			// otherwise EAGAIN comes after 'sendTimeout': the peer does not read anymore
+			fail( "write" );
+			return false;
+		}
+		sent += length;
+	}
+	if ( broken ) return false;
+	if ( sent > 0 && sent < outLength ) {
+		memmove( outBuffer, outBuffer + sent, outLength - sent );
+	}
+	outLength -= sent;
+	return true;
+}
+
+static void setupStream( InterfaceHandle fd, bool blocking ) {
+	if ( blocking ) {
+		struct timeval tv;
+		tv.tv_sec = APIStream::sendTimeout;
+		tv.tv_usec = 0;
+		CHECK( setsockopt( fd, SOL_SOCKET, SO_SNDTIMEO, (char*)&tv, sizeof(tv) ) );
+	} else {
+		CHECK( fcntl( fd, F_SETFL, fcntl( fd, F_GETFL, 0 ) | O_NONBLOCK ) );
+	}
+	int bufsize = APIStream::bufferSize;
+	setsockopt( fd, SOL_SOCKET, SO_SNDBUF, (char*)&bufsize, sizeof(bufsize) );
+	setsockopt( fd, SOL_SOCKET, SO_RCVBUF, (char*)&bufsize, sizeof(bufsize) );
+}
+
+static bool setupAddress( struct sockaddr_un& addr, const char* path ) {
+	initMemoryWithZero( &addr, sizeof(addr) );
+	addr.sun_family = AF_UNIX;
+	if ( strlen(path) >= sizeof(addr.sun_path) ) return false;
+	strcpy( addr.sun_path, path );
+	return true;
+}
+
+InterfaceHandle APIStream::listen( const char* path ) {
+	struct sockaddr_un addr;
+	if ( !setupAddress( addr, path ) ) return -1;
+	InterfaceHandle fd = socket( AF_UNIX, SOCK_STREAM, 0 );
+	if ( fd < 0 ) return -1;
+	unlink( path );
+	if ( bind( fd, (struct sockaddr*)&addr, sizeof(addr) ) < 0 || ::listen( fd, 16 ) < 0 ) {
+		ERROR(4)( Log::Error, "cannot listen for API streams at", path, ":", strerror(errno) );
+		close( fd );
+		return -1;
+	}
+	return fd;
+}
+
+InterfaceHandle APIStream::accept( InterfaceHandle listenFd ) {
+	InterfaceHandle fd = ::accept( listenFd, NULL, NULL );
+	if ( fd >= 0 ) setupStream( fd, false );
+	return fd;
+}
+
+InterfaceHandle APIStream::connect( const char* path ) {
+	struct sockaddr_un addr;
+	if ( !setupAddress( addr, path ) ) return -1;
+	InterfaceHandle fd = socket( AF_UNIX, SOCK_STREAM, 0 );
+	if ( fd < 0 ) return -1;
+	if ( ::connect( fd, (struct sockaddr*)&addr, sizeof(addr) ) < 0 ) {
+		close( fd );
+		return -1;
+	}
+	setupStream( fd, true );
+	return fd;
+}
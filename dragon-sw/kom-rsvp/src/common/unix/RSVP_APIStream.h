@@ -0,0 +1,61 @@
+/****************************************************************************
+
+Local stream (Unix-domain) transport for the RSVP API, header file RSVP_APIStream.h
+
+A record on the stream is a 32-bit length in network byte order followed by
+exactly what the UDP API transport puts into one datagram (PacketHeader and
+RSVP message). Records can be queued between beginBatch() and endBatch() and
+are then written with a single send().
+
+A stream created with 'queueOutput' never blocks on send: what the socket does
+not take stays in the output buffer until flush() is called again, typically
+once select() reports the descriptor writable (see hasPendingOutput()).
+
+****************************************************************************/
+#ifndef _RSVP_APIStream_h_
+#define _RSVP_APIStream_h_ 1
+
+#include "RSVP_BasicTypes.h"
+#include "RSVP_TimeValue.h"
+
+class APIStream {
+	InterfaceHandle fd;
+	uint8* inBuffer;
+	uint32 inStart, inEnd;
+	uint8* outBuffer;
+	uint32 outLength;
+	uint32 outSize;
+	uint32 batchDepth;
+	bool queueOutput;
+	bool broken;
+	void fail( const char* );
+public:
+	static const uint32 bufferSize = 262144;
+	static const uint32 maxOutputSize = 16 * bufferSize; // queued for a peer that does not read
+	static const uint32 sendTimeout = 5;                 // seconds, streams without 'queueOutput'
+
+	APIStream( InterfaceHandle fd, bool queueOutput = false );
+	~APIStream();
+	InterfaceHandle getFileDesc() const { return fd; }
+	bool isBroken() const { return broken; }
+	bool hasPendingOutput() const { return outLength > 0; }
+
+	// read what is available without blocking; false once the peer is gone
+	bool readData();
+	// wait up to 'timeout' until a complete record has arrived
+	bool waitForRecord( const TimeValue& timeout );
+	bool hasRecord() const;
+	bool nextRecord( INetworkBuffer& );
+
+	bool sendRecord( const ONetworkBuffer& );
+	void beginBatch() { batchDepth += 1; }
+	bool endBatch();
+	bool flush();
+
+	static InterfaceHandle listen( const char* path );
+	// accepted streams are non-blocking, to be used with 'queueOutput'
+	static InterfaceHandle accept( InterfaceHandle listenFd );
+	static InterfaceHandle connect( const char* path );
+};
+
+#endif /* _RSVP_APIStream_h_ */
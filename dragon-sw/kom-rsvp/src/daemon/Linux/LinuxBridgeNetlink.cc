@@ -0,0 +1,273 @@
+/****************************************************************************
+
+Netlink based Linux bridge/VLAN driver source file LinuxBridgeNetlink.cc
+
+A VLAN is an ethernet bridge named BR_PREFIX<VID>; a tagged port is the
+802.1Q subinterface <ifname>.<VID> enslaved to that bridge and an untagged
+port is <ifname> itself enslaved to it, exactly as SwitchCtrl_Session_Linux
+sets them up with brctl/vconfig. All steps of one change are packed into
+one netlink batch.
+
+****************************************************************************/
+
+#if defined(Linux)
+
+#include "LinuxBridgeNetlink.h"
+#include "RSVP_Log.h"
+#include <net/if.h>
+#include <linux/if_link.h>
+#include <errno.h>
+#include <stdlib.h>
+
+#define NLMSG_TAIL(nmsg) ((struct rtattr *) (((char *) (nmsg)) + NLMSG_ALIGN((nmsg)->nlmsg_len)))
+
+bool LinuxBridgeNetlink::open()
+{
+	if (opened)
+		return true;
+	if (RTNetlink::rtnl_open(&rth, 0) < 0) {
+		LOG(2)( Log::MPLS, "LinuxBridgeNetlink: cannot open rtnetlink socket: ", strerror(errno));
+		return false;
+	}
+	opened = true;
+	return true;
+}
+
+void LinuxBridgeNetlink::close()
+{
+	if (opened) {
+		RTNetlink::rtnl_close(&rth);
+		opened = false;
+	}
+}
+
+bool LinuxBridgeNetlink::linkExists(const char* ifname)
+{
+	return (if_nametoindex(ifname) != 0);
+}
+
+struct nlmsghdr* LinuxBridgeNetlink::newRequest(int type, int flags, int bodylen)
+{
+	if (batchLength + (int)NLMSG_SPACE(bodylen) > LINUX_BRIDGE_BATCH_SIZE) {
+		batchFailed = true;
+		return NULL;
+	}
+	struct nlmsghdr* n = (struct nlmsghdr*)(batch + batchLength);
+	memset(n, 0, NLMSG_SPACE(bodylen));
+	n->nlmsg_len = NLMSG_LENGTH(bodylen);
+	n->nlmsg_type = type;
+	n->nlmsg_flags = NLM_F_REQUEST | flags;
+	return n;
+}
+
+// the request is only accounted for in the batch once all its attributes are added
+#define ROOM(n) (LINUX_BRIDGE_BATCH_SIZE - (int)((char*)(n) - batch))
+#define FINISH(n) (batchLength += NLMSG_ALIGN((n)->nlmsg_len))
+
+struct ifinfomsg* LinuxBridgeNetlink::newLinkRequest(int type, int flags, const char* ifname)
+{
+	struct nlmsghdr* n = newRequest(type, flags, sizeof(struct ifinfomsg));
+	if (!n)
+		return NULL;
+	struct ifinfomsg* ifi = (struct ifinfomsg*)NLMSG_DATA(n);
+	ifi->ifi_family = AF_UNSPEC;
+	if (!(flags & NLM_F_CREATE))
+		ifi->ifi_index = if_nametoindex(ifname);
+	if (RTNetlink::addattr_l(n, ROOM(n), IFLA_IFNAME, (void*)ifname, strlen(ifname) + 1) < 0) {
+		batchFailed = true;
+		return NULL;
+	}
+	return ifi;
+}
+
+void LinuxBridgeNetlink::addBridge(const char* brname)
+{
+	LOG(2)( Log::MPLS, "LinuxBridgeNetlink: addbr ", brname);
+	struct ifinfomsg* ifi = newLinkRequest(RTM_NEWLINK, NLM_F_CREATE, brname);
+	if (!ifi)
+		return;
+	struct nlmsghdr* n = (struct nlmsghdr*)((char*)ifi - NLMSG_HDRLEN);
+	ifi->ifi_change = IFF_UP;
+	ifi->ifi_flags = IFF_UP;
+
+	struct rtattr* linkinfo = NLMSG_TAIL(n);
+	RTNetlink::addattr_l(n, ROOM(n), IFLA_LINKINFO, NULL, 0);
+	RTNetlink::addattr_l(n, ROOM(n), IFLA_INFO_KIND, (void*)"bridge", strlen("bridge"));
+	struct rtattr* data = NLMSG_TAIL(n);
+	RTNetlink::addattr_l(n, ROOM(n), IFLA_INFO_DATA, NULL, 0);
+	RTNetlink::addattr32(n, ROOM(n), IFLA_BR_FORWARD_DELAY, 0);
+	if (RTNetlink::addattr32(n, ROOM(n), IFLA_BR_STP_STATE, 0) < 0) {
+		batchFailed = true;
+		return;
+	}
+	data->rta_len = (char*)NLMSG_TAIL(n) - (char*)data;
+	linkinfo->rta_len = (char*)NLMSG_TAIL(n) - (char*)linkinfo;
+	FINISH(n);
+}
+
+void LinuxBridgeNetlink::addVlanInterface(const char* ifname, int vid, const char* master)
+{
+	char vlanif[IFNAMSIZ];
+	unsigned int link = if_nametoindex(ifname), masterIndex = if_nametoindex(master);
+	if (link == 0 || masterIndex == 0) {
+		LOG(2)( Log::MPLS, "LinuxBridgeNetlink: no such interface ", (link == 0 ? ifname : master));
+		batchFailed = true;
+		return;
+	}
+	snprintf(vlanif, sizeof(vlanif), "%s.%d", ifname, vid);
+	LOG(4)( Log::MPLS, "LinuxBridgeNetlink: add ", vlanif, " up to ", master);
+
+	// without NLM_F_EXCL an existing subinterface is just reconfigured
+	struct ifinfomsg* ifi = newLinkRequest(RTM_NEWLINK, NLM_F_CREATE, vlanif);
+	if (!ifi)
+		return;
+	struct nlmsghdr* n = (struct nlmsghdr*)((char*)ifi - NLMSG_HDRLEN);
+	ifi->ifi_change = IFF_UP;
+	ifi->ifi_flags = IFF_UP;
+	RTNetlink::addattr32(n, ROOM(n), IFLA_LINK, link);
+	RTNetlink::addattr32(n, ROOM(n), IFLA_MASTER, masterIndex);
+
+	uint16_t id = vid;
+	struct rtattr* linkinfo = NLMSG_TAIL(n);
+	RTNetlink::addattr_l(n, ROOM(n), IFLA_LINKINFO, NULL, 0);
+	RTNetlink::addattr_l(n, ROOM(n), IFLA_INFO_KIND, (void*)"vlan", strlen("vlan"));
+	struct rtattr* data = NLMSG_TAIL(n);
+	RTNetlink::addattr_l(n, ROOM(n), IFLA_INFO_DATA, NULL, 0);
+	if (RTNetlink::addattr_l(n, ROOM(n), IFLA_VLAN_ID, &id, sizeof(id)) < 0) {
+		batchFailed = true;
+		return;
+	}
+	data->rta_len = (char*)NLMSG_TAIL(n) - (char*)data;
+	linkinfo->rta_len = (char*)NLMSG_TAIL(n) - (char*)linkinfo;
+	FINISH(n);
+}
+
+void LinuxBridgeNetlink::setMaster(const char* ifname, const char* master)
+{
+	unsigned int masterIndex = 0;
+	if (master && (masterIndex = if_nametoindex(master)) == 0) {
+		LOG(2)( Log::MPLS, "LinuxBridgeNetlink: no such bridge ", master);
+		batchFailed = true;
+		return;
+	}
+	if (master) {
+		LOG(4)( Log::MPLS, "LinuxBridgeNetlink: addif ", ifname, " up to ", master);
+	} else {
+		LOG(2)( Log::MPLS, "LinuxBridgeNetlink: delif ", ifname);
+	}
+	struct ifinfomsg* ifi = newLinkRequest(RTM_NEWLINK, 0, ifname);
+	if (!ifi)
+		return;
+	struct nlmsghdr* n = (struct nlmsghdr*)((char*)ifi - NLMSG_HDRLEN);
+	if (master) {
+		ifi->ifi_change = IFF_UP;
+		ifi->ifi_flags = IFF_UP;
+	}
+	if (RTNetlink::addattr32(n, ROOM(n), IFLA_MASTER, masterIndex) < 0) {
+		batchFailed = true;
+		return;
+	}
+	FINISH(n);
+}
+
+void LinuxBridgeNetlink::setDown(const char* ifname)
+{
+	// like ifconfig on a missing device: nothing to take down
+	if (!linkExists(ifname))
+		return;
+	LOG(2)( Log::MPLS, "LinuxBridgeNetlink: down ", ifname);
+	struct ifinfomsg* ifi = newLinkRequest(RTM_NEWLINK, 0, ifname);
+	if (!ifi)
+		return;
+	ifi->ifi_change = IFF_UP;
+	ifi->ifi_flags = 0;
+	FINISH((struct nlmsghdr*)((char*)ifi - NLMSG_HDRLEN));
+}
+
+void LinuxBridgeNetlink::delLink(const char* ifname)
+{
+	// like brctl delbr/vconfig rem on a missing device: nothing to do
+	if (!linkExists(ifname))
+		return;
+	LOG(2)( Log::MPLS, "LinuxBridgeNetlink: delete ", ifname);
+	struct ifinfomsg* ifi = newLinkRequest(RTM_DELLINK, 0, ifname);
+	if (!ifi)
+		return;
+	FINISH((struct nlmsghdr*)((char*)ifi - NLMSG_HDRLEN));
+}
+
+struct FlushArg {
+	LinuxBridgeNetlink* driver;
+	unsigned int index;
+	bool secondary;
+};
+
+static int queueAddressFlush(struct sockaddr_nl *who, struct nlmsghdr *n, void *arg)
+{
+	struct FlushArg* flush = (struct FlushArg*)arg;
+	struct ifaddrmsg* ifa = (struct ifaddrmsg*)NLMSG_DATA(n);
+
+	if (n->nlmsg_type != RTM_NEWADDR || n->nlmsg_len < NLMSG_LENGTH(sizeof(*ifa)))
+		return 0;
+	if (ifa->ifa_index != flush->index)
+		return 0;
+	if (((ifa->ifa_flags & IFA_F_SECONDARY) != 0) != flush->secondary)
+		return 0;
+	flush->driver->queueRequest(n, RTM_DELADDR);
+	return 0;
+}
+
+void LinuxBridgeNetlink::flushAddresses(const char* ifname)
+{
+	struct FlushArg flush;
+	flush.driver = this;
+	flush.index = if_nametoindex(ifname);
+	if (flush.index == 0 || !open())
+		return;
+
+	LOG(2)( Log::MPLS, "LinuxBridgeNetlink: flush addresses of ", ifname);
+	// secondaries first: deleting a primary already takes its secondaries
+	// along, and a later DELADDR for them would fail with EADDRNOTAVAIL
+	for (int pass = 0; pass < 2; pass++) {
+		flush.secondary = (pass == 0);
+		if (RTNetlink::rtnl_wilddump_request(&rth, AF_INET, RTM_GETADDR) < 0
+			|| RTNetlink::rtnl_dump_filter(&rth, queueAddressFlush, &flush, NULL, NULL) < 0) {
+			LOG(2)( Log::MPLS, "LinuxBridgeNetlink: cannot list addresses of ", ifname);
+			batchFailed = true;
+			return;
+		}
+	}
+}
+
+// copy a kernel message into the batch as request 'type' (used to delete dumped objects)
+void LinuxBridgeNetlink::queueRequest(struct nlmsghdr* msg, int type)
+{
+	struct nlmsghdr* n = newRequest(type, 0, msg->nlmsg_len - NLMSG_HDRLEN);
+	if (!n)
+		return;
+	memcpy(NLMSG_DATA(n), NLMSG_DATA(msg), msg->nlmsg_len - NLMSG_HDRLEN);
+	FINISH(n);
+}
+
+bool LinuxBridgeNetlink::commit()
+{
+	if (batchFailed) {
+		LOG(1)( Log::MPLS, "LinuxBridgeNetlink: VLAN change could not be prepared, nothing applied");
+		begin();
+		return false;
+	}
+	if (batchLength == 0)
+		return true;
+	if (!open())
+		return false;
+
+	int ret = RTNetlink::rtnl_talk_batch(&rth, batch, batchLength);
+	begin();
+	if (ret < 0) {
+		LOG(2)( Log::MPLS, "LinuxBridgeNetlink: kernel rejected VLAN change: ", strerror(errno));
+		return false;
+	}
+	return true;
+}
+
+#endif /* Linux */
@@ -0,0 +1,60 @@
+/****************************************************************************
+
+Netlink based Linux bridge/VLAN driver header file LinuxBridgeNetlink.h
+Used by SwitchCtrl_Session_Linux when the controlled Linux switch is the
+local host (CLI_SHELL), instead of running vconfig/ifconfig/brctl.
+
+****************************************************************************/
+
+#ifndef _LinuxBridgeNetlink_h_
+#define _LinuxBridgeNetlink_h_
+
+#if defined(Linux)
+
+#include "libnetlink.h"
+
+#define LINUX_BRIDGE_BATCH_SIZE 4096
+
+// Requests are queued with the add/set/del calls and applied by commit()
+// with a single sendmsg(); the kernel acknowledges each of them.
+class LinuxBridgeNetlink
+{
+public:
+	LinuxBridgeNetlink() : opened(false), batchLength(0), batchFailed(false) {}
+	~LinuxBridgeNetlink() { close(); }
+
+	bool open();
+	void close();
+
+	void begin() { batchLength = 0; batchFailed = false; }
+	bool commit();
+
+	// bridge 'brname' with forwarding delay 0 and STP off, brought up
+	void addBridge(const char* brname);
+	// 802.1Q subinterface 'ifname.vid' of 'ifname', brought up and enslaved to 'master'
+	void addVlanInterface(const char* ifname, int vid, const char* master);
+	// bring 'ifname' up and enslave it to 'master', or release it if 'master' is NULL
+	void setMaster(const char* ifname, const char* master);
+	// remove all IPv4 addresses of 'ifname' (same as "ifconfig ifname 0.0.0.0")
+	void flushAddresses(const char* ifname);
+	void setDown(const char* ifname);
+	void delLink(const char* ifname);
+
+	static bool linkExists(const char* ifname);
+	// copy a dumped kernel object into the batch as request 'type'
+	void queueRequest(struct nlmsghdr* msg, int type);
+
+private:
+	struct nlmsghdr* newRequest(int type, int flags, int bodylen);
+	struct ifinfomsg* newLinkRequest(int type, int flags, const char* ifname);
+
+	RTNetlink::rtnl_handle rth;
+	bool opened;
+	char batch[LINUX_BRIDGE_BATCH_SIZE];
+	int batchLength;
+	bool batchFailed;
+};
+
+#endif /* Linux */
+
+#endif /* _LinuxBridgeNetlink_h_ */
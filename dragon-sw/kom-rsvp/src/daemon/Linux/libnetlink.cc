@@ -326,6 +326,78 @@ RTNetlink::rtnl_talk(struct rtnl_handle *rtnl, struct nlmsghdr *n, pid_t peer,
         }
 }
 
+/*
+ * Send several requests packed back to back in 'buf' with one sendmsg()
+ * and collect one ACK per request. Returns -1 with errno of the first
+ * failed request if any of them was rejected.
+ */
+int 
+RTNetlink::rtnl_talk_batch(struct rtnl_handle *rtnl, char *buf, int len)
+{
+        int status, count = 0, acked = 0, first_err = 0;
+        unsigned first_seq = rtnl->seq + 1;
+        struct nlmsghdr *h;
+        struct sockaddr_nl nladdr;
+        char   rbuf[8192];
+        struct iovec iov = { (void*)buf, (size_t)len };
+        struct msghdr msg = {
+                (void*)&nladdr, sizeof(nladdr),
+                &iov,   1,
+                NULL,   0,
+                0
+        };
+
+        for (h = (struct nlmsghdr*)buf; NLMSG_OK(h, (unsigned)(len - ((char*)h - buf))); h = (struct nlmsghdr*)((char*)h + NLMSG_ALIGN(h->nlmsg_len))) {
+                h->nlmsg_seq = ++rtnl->seq;
+                h->nlmsg_flags |= NLM_F_REQUEST|NLM_F_ACK;
+                count++;
+        }
+        if (count == 0)
+                return 0;
+
+        memset(&nladdr, 0, sizeof(nladdr));
+        nladdr.nl_family = AF_NETLINK;
+
+        status = sendmsg(rtnl->fd, &msg, 0);
+        if (status < 0) {
+                fprintf(stderr, "Cannot talk to rtnetlink");
+                return -1;
+        }
+
+        iov.iov_base = rbuf;
+        iov.iov_len = sizeof(rbuf);
+
+        while (acked < count) {
+                status = recvmsg(rtnl->fd, &msg, 0);
+                if (status < 0) {
+                        if (errno == EINTR)
+                                continue;
+                        return -1;
+                }
+                if (status == 0) {
+                        fprintf(stderr, "EOF on netlink\n");
+                        return -1;
+                }
+                for (h = (struct nlmsghdr*)rbuf; NLMSG_OK(h, (unsigned)status); h = NLMSG_NEXT(h, status)) {
+                        if (h->nlmsg_pid != rtnl->local.nl_pid ||
+                            h->nlmsg_seq < first_seq || h->nlmsg_seq >= first_seq + count)
+                                continue;
+                        if (h->nlmsg_type == NLMSG_ERROR) {
+                                struct nlmsgerr *err = (struct nlmsgerr*)NLMSG_DATA(h);
+                                if (err->error != 0 && first_err == 0)
+                                        first_err = -err->error;
+                                acked++;
+                        }
+                }
+        }
+
+        if (first_err != 0) {
+                errno = first_err;
+                return -1;
+        }
+        return 0;
+}
+
 int 
 RTNetlink::rtnl_listen(struct rtnl_handle *rtnl, 
               int (*handler)(struct sockaddr_nl *,struct nlmsghdr *n, void *),
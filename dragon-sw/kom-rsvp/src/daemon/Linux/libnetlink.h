@@ -68,6 +68,7 @@ class RTNetlink
 	                     int (*junk)(struct sockaddr_nl *,struct nlmsghdr *n, void *),
 	                     void *jarg);
 	static int rtnl_send(struct rtnl_handle *rth, char *buf, int);
+	static int rtnl_talk_batch(struct rtnl_handle *rtnl, char *buf, int len);
 
 
 	static int addattr32(struct nlmsghdr *n, int maxlen, int type, __u32 data);
@@ -303,6 +303,13 @@ int RSVP::main() {
 					RSVP_Global::messageProcessor->processAsyncRoutingEvent( *sessionIter, src, *inLif, lifList );
 				}
 			}
+		} else if ( NetworkServiceDaemon::queryAndClearNarb() ) {
+			NARB_APIClient::processReplies();
+			RSVP_Global::messageProcessor->replayNarbDeferredMessages();
+#if defined(WITH_API)
+		} else if ( NetworkServiceDaemon::queryAndClearApiStream() ) {
+			apiServer->processStreams();
+#endif
 		} else if ( !endFlag ) {
 			FATAL(1)( Log::Fatal, "returned from queryInterfaces but without result" );
 			abortProcess();
@@ -50,6 +50,7 @@ class API_Entry : public API_EntryKey {
 	friend class API_Server;
 	TimeoutTimer<API_Entry> timer;
 	RefreshTimer<API_Entry> refreshTimer;
+	bool lease;                                        // bound to a stream connection, no timers
 	friend inline bool operator< ( const API_Entry&, const API_Entry& );
 	friend inline bool operator== ( const API_Entry&, const API_Entry& );
 	friend class TimeoutTimer<API_Entry>;
@@ -58,11 +59,14 @@ public:
 	inline void refresh();                             // implemented in API_Server.cc
 	API_Entry( const SESSION_Object& session, const NetAddress& addr, uint16 port, const TimeValue& timeout )
 		: API_EntryKey(session,addr,port), timer(*this,multiplyTimeoutTime(timeout)),
-		refreshTimer(*this,randomizeRefreshTime(timeout)) {}
+		refreshTimer(*this,randomizeRefreshTime(timeout)), lease(false) {}
+	API_Entry( const SESSION_Object& session, const NetAddress& addr, uint16 port )
+		: API_EntryKey(session,addr,port), timer(*this), refreshTimer(*this), lease(true) {}
 	void restartTimeout() {
-		timer.restart();
+		if ( !lease ) timer.restart();
 	}
 	void restartTimeout( const TimeValue& timeout ) {
+		if ( lease ) return;
 		timer.restart( multiplyTimeoutTime(timeout) );
 		refreshTimer.restart( randomizeRefreshTime(timeout) );
 	}
@@ -33,11 +33,15 @@
 #include "RSVP_API_Server.h"
 
 #include "RSVP.h"
+#include "RSVP_APIStream.h"
 #include "RSVP_Global.h"
 #include "RSVP_Hop.h"
 #include "RSVP_LogicalInterface.h"
 #include "RSVP_Message.h"
 #include "RSVP_MessageProcessor.h"
+#include "RSVP_NetworkService.h"
+#include "RSVP_NetworkServiceDaemon.h"
+#include "RSVP_PacketHeader.h"
 #include "RSVP_ProtocolObjects.h"
 #include "RSVP_TrafficControl.h"
 #include "RSVP_RoutingService.h"
@@ -64,13 +68,22 @@ inline const ApiEntryList& API_Server::getApiList( const SESSION_Object& s ) con
 }
 
 API_Server::API_Server( uint16 port ) : currentProcessor(NULL), currentPort(0),
-		currentAddress(NULL), clientCount(0) {
+		currentAddress(NULL), streamListener(-1), streamPortLimit(1),
+		currentStream(NULL), clientCount(0) {
 	apiEntryList = new ApiEntryList[RSVP_Global::apiHashCount];
 	apiLif = new LogicalInterfaceAPI_Server( RSVP_Global::apiName, 0, RSVP_Global::apiMTU );
 	PortList destPortList;
 	apiLif->configureUDP( port, NetAddress(0), destPortList );
 	apiLif->configureRefresh( 0 );
 	apiLif->configureTC( new TrafficControl(NULL) );
+	initMemoryWithZero( streams, sizeof(streams) );
+#if !defined(NS2)
+	streamListener = APIStream::listen( RSVP_Global::apiStreamPath );
+	if ( streamListener != -1 ) {
+		NetworkServiceDaemon::registerApiStream_Handle( streamListener );
+		LOG(2)( Log::API, "accepting API streams at", RSVP_Global::apiStreamPath );
+	}
+#endif
 }
 
 API_Server::~API_Server() {
@@ -85,6 +98,19 @@ API_Server::~API_Server() {
 		}
 	}
 	delete [] apiEntryList;
+	uint16 port = 1;
+	for ( ; port < streamPortLimit; ++port ) {
+		if ( streams[port] ) {
+			NetworkServiceDaemon::deregisterWrite_Handle( streams[port]->getFileDesc() );
+			NetworkServiceDaemon::deregisterApiStream_Handle( streams[port]->getFileDesc() );
+			delete streams[port];
+		}
+	}
+	if ( streamListener != -1 ) {
+		NetworkServiceDaemon::deregisterApiStream_Handle( streamListener );
+		close( streamListener );
+		unlink( RSVP_Global::apiStreamPath );
+	}
 }
 
 void API_Server::deregisterAPI( ApiEntryList::ConstIterator iter ) {
@@ -155,11 +181,22 @@ void API_Server::processMessage( const Message& msg, MessageProcessor& mp) {
   	ApiEntryList::ConstIterator iter = getApiList( session ).find( &key );
 	if ( msg.getMsgType() == Message::InitAPI ) {
 	  if ( iter == getApiList( session ).end() ) {
-			TimeValue apiRefresh = RSVP_Global::defaultApiRefresh;
-			if ( msg.hasTIME_VALUES_Object() ) {
-				apiRefresh = msg.getTIME_VALUES_Object().getRefreshTime();
+			API_Entry* entry;
+			if ( port < API_STREAM_PORTS ) {
+				if ( !streams[port] ) {
+					LOG(6)( Log::API, "ignoring", session, "for closed API stream at", address, "/", port );
+					currentProcessor = NULL;
+	return;
+				}
+				entry = new API_Entry(session,address,port);
+			} else {
+				TimeValue apiRefresh = RSVP_Global::defaultApiRefresh;
+				if ( msg.hasTIME_VALUES_Object() ) {
+					apiRefresh = msg.getTIME_VALUES_Object().getRefreshTime();
+				}
+				entry = new API_Entry(session,address,port,apiRefresh);
 			}
-			iter = getApiList( session ).insert_sorted( new API_Entry(session,address,port,apiRefresh) );
+			iter = getApiList( session ).insert_sorted( entry );
 			LOG(6)( Log::API, "registered", session, "for API at", address, "/", port );
 			currentAddress = &address;
 			currentPort = port;
@@ -186,18 +223,32 @@ void API_Server::processMessage( const Message& msg, MessageProcessor& mp) {
 	currentProcessor = NULL;
 }
 
+inline void API_Server::sendToClient( const Message& msg, const NetAddress& address, uint16 port ) {
+	if ( port < API_STREAM_PORTS ) {
+		// nothing to do for a stream client that has gone away
+		if ( streams[port] ) {
+			LOG(5)( Log::Msg, apiLif->getName(), "sends MSG to stream", port, ":", msg );
+			ONetworkBuffer* obuf = apiLif->createOutgoingBuffer( msg, address );
+			streams[port]->sendRecord( *obuf );
+			delete obuf;
+			watchStreamOutput( port );
+		}
+	} else {
+		apiLif->setDestPort( port );
+		apiLif->sendMessageInternal( msg, address, apiLif->getAddress() );
+	}
+}
+
 void API_Server::sendMessage( const Message& msg ) {
 	if ( currentPort ) {
-		apiLif->setDestPort( currentPort );
-		apiLif->sendMessageInternal( msg, *currentAddress, apiLif->getAddress() );
+		sendToClient( msg, *currentAddress, currentPort );
 	} else {
 		bool apiFound = false;
 		API_EntryKey key( msg.getSESSION_Object(), NetAddress(0), 0 );
 		ApiEntryList::ConstIterator iter = getApiList( key.getSession() ).lower_bound( &key );
 		for ( ; iter != getApiList( key.getSession() ).end() && (*iter)->session == key.getSession(); ++iter ) {
 			apiFound = true;
-			apiLif->setDestPort( (*iter)->port );
-			apiLif->sendMessageInternal( msg, (*iter)->address, apiLif->getAddress() );
+			sendToClient( msg, (*iter)->address, (*iter)->port );
 		}
 		if ( !apiFound ) {
 			LOG(2)( Log::API, "WARNING: no API client found for, sending to default API client", msg.getSESSION_Object() );
@@ -207,8 +258,7 @@ void API_Server::sendMessage( const Message& msg ) {
 			ApiEntryList::ConstIterator iter = getApiList( key1.getSession() ).lower_bound( &key1 );
 			for ( ; iter != getApiList( key1.getSession() ).end() && (*iter)->session == key1.getSession(); ++iter ) {
 				apiFound = true;
-				apiLif->setDestPort( (*iter)->port );
-				apiLif->sendMessageInternal( msg, (*iter)->address, apiLif->getAddress() );
+				sendToClient( msg, (*iter)->address, (*iter)->port );
 			}
 			if ( !apiFound ) {
 				LOG(2)( Log::API, "WARNING: no default API client found, unable to send message", defaultApiSession);
@@ -223,8 +273,112 @@ bool API_Server::findApiSession( const SESSION_Object& session ) const {
 	return iter != getApiList( session ).end() && (*iter)->session == session;
 }
 
+void API_Server::acceptStream() {
+	InterfaceHandle fd = APIStream::accept( streamListener );
+	if ( fd < 0 ) return;
+	uint16 port = 1;
+	while ( port < API_STREAM_PORTS && streams[port] ) port += 1;
+	if ( port == API_STREAM_PORTS ) {
+		ERROR(2)( Log::Error, "rejecting API stream, too many clients:", API_STREAM_PORTS - 1 );
+		close( fd );
+		return;
+	}
+	streams[port] = new APIStream( fd, true );
+	if ( port >= streamPortLimit ) streamPortLimit = port + 1;
+	NetworkServiceDaemon::registerApiStream_Handle( fd );
+	LOG(2)( Log::API, "accepted API stream", port );
+	// tell the client which LIH to use in its messages
+	Message msg( Message::InitAPI, 127, SESSION_Object() );
+	msg.setRSVP_HOP_Object( RSVP_HOP_Object( NetAddress(0), port ) );
+	sendToClient( msg, LogicalInterface::loopbackAddress, port );
+}
+
+void API_Server::closeStream( uint16 port ) {
+	APIStream* stream = streams[port];
+	streams[port] = NULL;
+	while ( streamPortLimit > 1 && !streams[streamPortLimit-1] ) streamPortLimit -= 1;
+	NetworkServiceDaemon::deregisterWrite_Handle( stream->getFileDesc() );
+	NetworkServiceDaemon::deregisterApiStream_Handle( stream->getFileDesc() );
+	delete stream;
+	LOG(2)( Log::API, "closed API stream", port );
+	// the leases of this connection end with it
+	currentProcessor = RSVP_Global::messageProcessor;
+	uint32 x = 0;
+	for ( ; x < RSVP_Global::apiHashCount; ++x ) {
+		ApiEntryList::ConstIterator iter = apiEntryList[x].begin();
+		while ( iter != apiEntryList[x].end() ) {
+			ApiEntryList::ConstIterator nextIter = iter.next();
+			if ( (*iter)->lease && (*iter)->port == port ) {
+				currentAddress = &(*iter)->address;
+				currentPort = port;
+				deregisterAPI( iter );
+			}
+			iter = nextIter;
+		}
+	}
+	currentPort = 0;
+	currentProcessor = NULL;
+}
+
+// Output the socket did not take is written once select() reports the stream
+// writable again, so a client that reads slowly never blocks the daemon.
+void API_Server::watchStreamOutput( uint16 port ) {
+	if ( streams[port]->hasPendingOutput() ) {
+		NetworkServiceDaemon::registerWrite_Handle( streams[port]->getFileDesc() );
+	} else {
+		NetworkServiceDaemon::deregisterWrite_Handle( streams[port]->getFileDesc() );
+	}
+}
+
+// All requests that are available on the stream connections are processed
+// in one go. Upcalls caused by them are collected per connection and written
+// when all requests are done.
+void API_Server::processStreams() {
+	uint16 port;
+	if ( streamListener != -1 && NetworkService::waitForPacket( streamListener, true ) ) {
+		acceptStream();
+	}
+	for ( port = 1; port < streamPortLimit; ++port ) {
+		if ( streams[port] ) streams[port]->beginBatch();
+	}
+	for ( port = 1; port < streamPortLimit; ++port ) {
+		if ( !streams[port] ) continue;
+		bool connected = streams[port]->readData();
+		currentStream = streams[port];
+		while ( currentStream->hasRecord() && !currentStream->isBroken() ) {
+			RSVP_Global::messageProcessor->readCurrentMessage( *apiLif );
+		}
+		currentStream = NULL;
+		if ( !connected ) closeStream( port );
+	}
+	for ( port = 1; port < streamPortLimit; ++port ) {
+		if ( !streams[port] ) continue;
+		streams[port]->endBatch();
+		watchStreamOutput( port );
+	}
+}
+
+bool API_Server::receiveStreamRecord( INetworkBuffer& buf, PacketHeader& header ) {
+	if ( !currentStream->nextRecord( buf ) ) {
+		header.init();
+		return false;
+	}
+	buf >> header;
+	if ( header.getSrcAddress() == NetAddress(0) ) {
+		header.setSrcAddress( LogicalInterface::loopbackAddress );
+	}
+	return true;
+}
+
 void LogicalInterfaceAPI_Server::sendMessage( const Message& msg, const NetAddress&, const NetAddress&, const NetAddress& ) const {
 	RSVP::getApiServer().sendMessage( msg );
 }
 
+const LogicalInterface* LogicalInterfaceAPI_Server::receiveBuffer( INetworkBuffer& buf, PacketHeader& header ) const {
+	if ( RSVP::getApiServer().isReadingStream() ) {
+		return RSVP::getApiServer().receiveStreamRecord( buf, header ) ? this : NULL;
+	}
+	return LogicalInterfaceUDP::receiveBuffer( buf, header );
+}
+
 #endif /* WITH_API */
@@ -40,12 +40,20 @@
 class SESSION_Object;
 class Message;
 class ONetworkBuffer;
+class INetworkBuffer;
+class PacketHeader;
+class APIStream;
 class LogicalInterfaceAPI_Server;
 class MessageProcessor;
 class Hop;
 
 typedef SortedList<API_Entry*,API_EntryKey*> ApiEntryList;
 
+// Clients on the local stream socket are identified by their slot number,
+// which they use as LIH. UDP clients use their (ephemeral) port number as
+// LIH, so the two never collide.
+#define API_STREAM_PORTS 1024
+
 class API_Server {
 	ApiEntryList* apiEntryList;
 	inline const ApiEntryList& getApiList( const SESSION_Object& ) const;
@@ -55,6 +63,16 @@ class API_Server {
 	uint16 currentPort;
 	const NetAddress* currentAddress;
 	void deregisterAPI( const ApiEntryList::ConstIterator );
+	// local stream clients: sessions registered over a connection are
+	// leases without timers, they end when the connection goes away
+	InterfaceHandle streamListener;
+	APIStream* streams[API_STREAM_PORTS];
+	uint16 streamPortLimit;
+	APIStream* currentStream;
+	void acceptStream();
+	void closeStream( uint16 port );
+	void watchStreamOutput( uint16 port );
+	inline void sendToClient( const Message& msg, const NetAddress&, uint16 );
 	// statistics data
 	uint32 clientCount;
 public:
@@ -66,6 +84,9 @@ public:
 	void sendMessage( const Message& msg );
 	const LogicalInterfaceAPI_Server* getApiLif() const { assert(apiLif); return apiLif; }
 	bool findApiSession( const SESSION_Object& session ) const;
+	void processStreams();
+	bool isReadingStream() const { return currentStream != NULL; }
+	bool receiveStreamRecord( INetworkBuffer&, PacketHeader& );
 #if defined(RSVP_STATS)
 	uint32 getNumberOfClients() { return clientCount; }
 #endif
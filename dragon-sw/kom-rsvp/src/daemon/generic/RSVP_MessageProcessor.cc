@@ -64,6 +64,7 @@ MessageProcessor::MessageProcessor() : ibuffer(LogicalInterface::maxPayloadLengt
 #endif
 
 	msgQueue = new MessageQueue;
+	narbQueue = new MessageQueue;
 
 //@@@@ Xi2008 >>
 	for (int i = 0; i < NSIG_SNC_STABLE; i++)
@@ -83,6 +84,15 @@ MessageProcessor::~MessageProcessor() {
 		delete msgQueue;
 		msgQueue = NULL;
 	}
+	if (narbQueue) {
+		MessageQueue::Iterator msgIter = narbQueue->begin();
+		for ( ; msgIter != narbQueue->end(); ++msgIter ) {
+			if (*msgIter)
+				delete (*msgIter);
+		}
+		delete narbQueue;
+		narbQueue = NULL;
+	}
 }
 
 //$$$$ Xi2008 for subnet control only >>
@@ -933,6 +943,38 @@ bool MessageProcessor::queryEnqueuedMessages( ) {
 
 // Xi2007 <<
 
+void MessageProcessor::deferPathForNarb( uint32 ucid, uint32 seqnum ) {
+	MessageQueue::Iterator msgIter = narbQueue->begin();
+	for ( ; msgIter != narbQueue->end(); ++msgIter ) {
+		// refresh of a Path that is already waiting for the same query
+		if ( (*msgIter)->getNarbUcid() == ucid && (*msgIter)->getNarbQuery() == seqnum )
+			return;
+	}
+	MessageEntry* msgEntry = new MessageEntry;
+	msgEntry->preserveMessage( (LogicalInterface*)currentLif, currentHeader, currentMessage, ucid, seqnum );
+	narbQueue->push_back( msgEntry );
+}
+
+void MessageProcessor::replayNarbDeferredMessages() {
+	MessageQueue::Iterator msgIter = narbQueue->begin();
+	while ( msgIter != narbQueue->end() ) {
+		MessageEntry* msgEntry = *msgIter;
+		if ( NARB_APIClient::isQueryPending( msgEntry->getNarbUcid(), msgEntry->getNarbQuery() ) ) {
+			++msgIter;
+			continue;
+		}
+		msgEntry->restoreMessage( (LogicalInterface* &)currentLif, currentHeader, currentMessage );
+		narbQueue->erase( msgIter );
+		delete msgEntry;
+		incomingLif = currentLif;
+		currentSession = NULL;
+		LOG(2)( Log::Msg, "replaying Path after NARB reply:", currentMessage.getSESSION_Object() );
+		processMessage();
+		// processing may have deferred the message again
+		msgIter = narbQueue->begin();
+	}
+}
+
 // DRAGON Monitoring >>
 void MessageProcessor::processDragonMonQuery(SESSION_Object& sessionObject, MON_Query_Subobject& monQuery)
 {
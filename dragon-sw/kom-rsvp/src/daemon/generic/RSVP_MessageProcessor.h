@@ -57,11 +57,16 @@ class MessageEntry {
 	INetworkBuffer ibuffer;
 	LogicalInterface* currentLif;
 	Session* currentSession;
+	PacketHeader currentHeader;
+	uint32 narbUcid;
+	uint32 narbQuery;
 
 public:
-	MessageEntry():ibuffer(65000), currentLif(NULL), currentSession(NULL) {}
+	MessageEntry():ibuffer(65000), currentLif(NULL), currentSession(NULL), narbUcid(0), narbQuery(0) {}
 	LogicalInterface* getCurrentLif() { return currentLif; }
 	Session* getCurrentSession() { return currentSession; }
+	uint32 getNarbUcid() { return narbUcid; }
+	uint32 getNarbQuery() { return narbQuery; }
 	void preserveMessage(LogicalInterface *lif,  Session *session, Message& msg) {
 		currentLif = lif;
 		currentSession = session;
@@ -79,6 +84,21 @@ public:
 		msg.init();
 		ibuffer >> msg;
 	}
+	// Path message waiting for the NARB reply to query (ucid, seqnum)
+	void preserveMessage(LogicalInterface *lif, const PacketHeader& header, Message& msg, uint32 ucid, uint32 seqnum) {
+		preserveMessage(lif, NULL, msg);
+		currentHeader = header;
+		narbUcid = ucid;
+		narbQuery = seqnum;
+	}
+	void restoreMessage(LogicalInterface* &lif, PacketHeader& header, Message& msg) {
+		assert(currentLif);
+		lif = currentLif;
+		header = currentHeader;
+		assert(ibuffer.getRemainingSize() > 0);
+		msg.init();
+		ibuffer >> msg;
+	}
 };
 
 typedef SimpleList<MessageEntry*> MessageQueue;
@@ -119,6 +139,8 @@ class MessageProcessor {
 // Xi2007>>
 	MessageQueue* msgQueue;
 // Xi2007<<
+	// Path messages waiting for an outstanding NARB query
+	MessageQueue* narbQueue;
 
 public:
 #if defined(ONEPASS_RESERVATION)
@@ -191,6 +213,10 @@ public:
 	bool queryEnqueuedMessages();
 // Xi2007 for SubnetUNI<<
 
+	// park the current Path message until NARB has answered query (ucid, seqnum)
+	void deferPathForNarb( uint32 ucid, uint32 seqnum );
+	void replayNarbDeferredMessages();
+
 // DRAGON Monitoring >>
 	void processDragonMonQuery(SESSION_Object& sessionObject, MON_Query_Subobject& monQuery);
 // DRAGON Monitoring <<
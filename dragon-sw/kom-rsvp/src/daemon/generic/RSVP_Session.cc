@@ -1018,6 +1018,13 @@ void Session::processPATH( const Message& msg, Hop& hop, uint8 TTL ) {
 			                            //@@@@ Missing ingress port/interface on this VLSR?!
 			                            //@@@@ oldExplicitRoute = explicitRoute;
 			                            explicitRoute = narbClient->getExplicitRoute(msg, hasReceivedExplicitRoute, (void*)this);
+							if (!explicitRoute && narbClient->getPendingQuery()) {
+								//NARB reply still outstanding; the Path is replayed once it arrives
+								LOG(5)( Log::Routing,  "LSP=", msg.getSESSION_ATTRIBUTE_Object().getSessionName(), ": ",
+									"Path waiting for NARB reply to query ", narbClient->getPendingQuery());
+								RSVP_Global::messageProcessor->deferPathForNarb(narbClient->getPendingUcid(), narbClient->getPendingQuery());
+								return;
+							}
 			                            //@@@@ push_front ... those TE addreses of local interfaces not in the new ERO
 							if (explicitRoute) {
 								if (!narbClient->handleRsvpMessage(msg)) {
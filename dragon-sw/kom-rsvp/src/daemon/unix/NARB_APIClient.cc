@@ -17,12 +17,28 @@ To be incorporated into KOM-RSVP-TE package
 #include "RSVP_ProtocolObjects.h"
 #include "RSVP_Message.h"
 #include "RSVP_Session.h"
+#include "RSVP_BaseTimer.h"
+#include "RSVP_NetworkServiceDaemon.h"
 #include "NARB_APIClient.h"
 
 String NARB_APIClient::_host = "";
 int NARB_APIClient::_port = 0;
 uint32 NARB_APIClient::extra_options = 0;
-UsedVtagList* NARB_APIClient::vtagsAllowedforUse;
+uint8* NARB_APIClient::vtagsAllowedforUse = NULL;
+EroSessionHash NARB_APIClient::eroSessionHash(NARB_ERO_HASH_SIZE);
+EroPointerHash NARB_APIClient::eroPointerHash(NARB_ERO_HASH_SIZE);
+int NARB_APIClient::fd = -1;
+char* NARB_APIClient::readBuffer = NULL;
+int NARB_APIClient::readLength = 0;
+int NARB_APIClient::readSize = 0;
+NarbQueryList NARB_APIClient::queryList;
+int NARB_APIClient::retryDelay = NARB_RETRY_MIN;
+TimeValue NARB_APIClient::nextConnectTime;
+bool NARB_APIClient::connecting = false;
+TimeValue NARB_APIClient::connectDeadline;
+char* NARB_APIClient::writeBuffer = NULL;
+int NARB_APIClient::writeLength = 0;
+int NARB_APIClient::writeSize = 0;
 
 
 int readn (int fd, char *ptr, int nbytes)
@@ -82,112 +98,57 @@ bool NARB_APIClient::operational()
     if (_host.length() == 0 || _port == 0)
         return false;
 
-    int val, ret=0;
-    int sock;
-    struct sockaddr_in addr;
-    struct hostent *hp;
-    int flags, old_flags;
-    fd_set sset;
-    struct timeval tv;
-    socklen_t lon;
-
-    sock = socket (AF_INET, SOCK_STREAM, 0);
-    if (sock < 0)
-      return -1;
-
-    flags = old_flags = fcntl(sock, F_GETFL, 0);
-#if defined(O_NONBLOCK)
-    flags |= O_NONBLOCK;
-#elif defined(O_NDELAY)
-    flags |= O_NDELAY;
-#elif defined(FNDELAY)
-    flags |= FNDELAY;
-#endif
-
-    if (fcntl(sock, F_SETFL, flags) == -1) {
-        return false;
-    }
-
-    hp = gethostbyname (_host.chars());
-    if (!hp)
-    {
-        LOG(2)(Log::Routing, "NARB_APIClient::Connect: no such host %s\n", _host);
-        return (false);
-    }
-
-    memset (&addr, 0, sizeof (struct sockaddr_in));
-    memcpy (&addr.sin_addr, hp->h_addr, hp->h_length);
-    addr.sin_family = AF_INET;
-    addr.sin_port = htons (_port);
-
-    ret = connect (sock, (struct sockaddr *) &addr, sizeof(struct sockaddr_in));
-    if(ret < 0) {
-       if (errno == EINPROGRESS) {
-           tv.tv_sec = 1;
-           tv.tv_usec = 0;
-           FD_ZERO(&sset);
-           FD_SET(sock, &sset);
-           if(select(sock+1, NULL, &sset, NULL, &tv) > 0) {
-               lon = sizeof(int);
-               getsockopt(sock, SOL_SOCKET, SO_ERROR, (void*)(&val), &lon); 
-               close (sock);
-               return ((val != 0)? false : true);
-           }
-           else {
-               close (sock);
-               return false;
-           }
-       }
-       else {
-           close (sock);
-           return false;
-       }
-   }
-
-    if (fcntl(sock, F_SETFL, old_flags) == -1) {
-         close (sock);
-         return false;
-    }
-    close (sock);
-    return true;
+    // the shared connection is both the probe and the channel used for queries
+    return (active() || doConnect() >= 0);
 }
 
 NARB_APIClient::~NARB_APIClient()
 {
-    disconnect();
-    EroSearchList::Iterator iter = eroSearchList.begin();
-    for ( ; iter != eroSearchList.end(); ++iter)
-    {
-            if ((*iter)->ero)
-                (*iter)->ero->destroy();
-            delete (*iter);
-    }
+    while (!eroSearchList.empty())
+        removeEntry(eroSearchList.front());
 }
 
+class NarbQueryTimer: public BaseTimer {
+public:
+	NarbQueryTimer(): BaseTimer(TimeValue(0,0)) {}
+	virtual void internalFire() {
+		cancel();
+		NARB_APIClient::expireQueries();
+	}
+	void Start(const TimeValue& timeout) { restart(timeout); }
+};
+
+static NarbQueryTimer* narbQueryTimer = NULL;
+
 int NARB_APIClient::doConnect(char *host, int port)
 {
       struct sockaddr_in addr;
       struct hostent *hp;
       int ret;
       int on = 1;
+      int flags;
 
       _host = host;
       _port = port;
   
       assert (strlen(host) > 0 || port > 0);
+
+      // back off after failures instead of stalling every Path on an unreachable NARB
+      if (RSVP_Global::currentTimerSystem->getCurrentTime() < nextConnectTime)
+          return (-1);
   	
       hp = gethostbyname (host);
       if (!hp)
       {
           LOG(2)( Log::Routing, "NARB_APIClient::Connect: no such host %s\n", host);
-          return (-1);
+          goto _FAILED;
       }
   
       fd = socket (AF_INET, SOCK_STREAM, 0);
       if (fd < 0)
       {
   	  LOG(2)( Log::Routing, "NARB_APIClient::Connect: socket(): ", strerror (errno));
-  	  return (-1);
+  	  goto _FAILED;
       }
                                                                                  
       /* Reuse addr and port */
@@ -195,9 +156,7 @@ int NARB_APIClient::doConnect(char *host, int port)
       if (ret < 0)
       {
           LOG(1)( Log::Routing, "NARB_APIClient::Connect: SO_REUSEADDR failed.");
-          close (fd);
-          fd = -1;
-          return (-1);
+          goto _FAILED;
       }
   
   #ifdef SO_REUSEPORT
@@ -206,9 +165,7 @@ int NARB_APIClient::doConnect(char *host, int port)
     if (ret < 0)
     {
         LOG(1)( Log::Routing, "NARB_APIClient::Connect: SO_REUSEPORT failed.");
-        close (fd);
-        fd = -1;
-        return (-1);
+        goto _FAILED;
     }
   #endif /* SO_REUSEPORT */
 
@@ -218,19 +175,125 @@ int NARB_APIClient::doConnect(char *host, int port)
     addr.sin_family = AF_INET;
     addr.sin_port = htons (port);
     //addr.sin_len = sizeof (struct sockaddr_in);
-   
-    /* Now establish synchronous channel with NARB daemon */
+
+    /* Connect without blocking; the main loop completes it (finishConnect) */
+    flags = fcntl(fd, F_GETFL, 0);
+    flags |= O_NONBLOCK;
+    if (fcntl(fd, F_SETFL, flags) == -1)
+        goto _FAILED;
+
+    readLength = 0;
+    writeLength = 0;
     ret = connect (fd, (struct sockaddr *) &addr,
                    sizeof (struct sockaddr_in));
     if (ret < 0)
     {
-        LOG(2)( Log::Routing, "NARB_APIClient::Connect: connect(): ", strerror (errno));
-        close (fd);
-        fd = -1;
-        return (-1);
+        if (errno != EINPROGRESS)
+        {
+            LOG(2)( Log::Routing, "NARB_APIClient::Connect: connect(): ", strerror (errno));
+            goto _FAILED;
+        }
+        NetworkServiceDaemon::registerNarb_Handle(fd);
+        NetworkServiceDaemon::registerWrite_Handle(fd);
+        connecting = true;
+        connectDeadline = RSVP_Global::currentTimerSystem->getCurrentTime() + TimeValue(NARB_CONNECT_TIMEOUT);
+        if (!narbQueryTimer)
+            narbQueryTimer = new NarbQueryTimer;
+        narbQueryTimer->Start(TimeValue(NARB_CONNECT_TIMEOUT));
+        return fd;
     }
 
+    /* Requests are written blocking; replies are read when select() reports them */
+    if (fcntl(fd, F_SETFL, flags & ~O_NONBLOCK) == -1)
+        goto _FAILED;
+
+    NetworkServiceDaemon::registerNarb_Handle(fd);
+    retryDelay = NARB_RETRY_MIN;
     return fd;
+
+_FAILED:
+    if (fd >= 0)
+        close (fd);
+    fd = -1;
+    backOff();
+    return (-1);
+}
+
+void NARB_APIClient::backOff()
+{
+    nextConnectTime = RSVP_Global::currentTimerSystem->getCurrentTime() + TimeValue(retryDelay);
+    if (retryDelay < NARB_RETRY_MAX)
+        retryDelay *= 2;
+}
+
+// returns false while the connect is still in progress or after it failed
+bool NARB_APIClient::finishConnect()
+{
+    struct sockaddr_in addr;
+    socklen_t len = sizeof(addr);
+    socklen_t lon = sizeof(int);
+    int val = 0;
+    int ret;
+
+    if (getpeername(fd, (struct sockaddr *)&addr, &len) < 0)
+    {
+        if (getsockopt(fd, SOL_SOCKET, SO_ERROR, (void*)(&val), &lon) < 0)
+            val = errno;
+        if (val == 0)
+            return false;
+        LOG(2)( Log::Routing, "NARB_APIClient::Connect: connect(): ", strerror (val));
+        disconnect();
+        backOff();
+        return false;
+    }
+
+    connecting = false;
+    NetworkServiceDaemon::deregisterWrite_Handle(fd);
+    if (fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) & ~O_NONBLOCK) == -1)
+    {
+        disconnect();
+        backOff();
+        return false;
+    }
+    retryDelay = NARB_RETRY_MIN;
+
+    //send the requests queued while connecting
+    if (writeLength > 0)
+    {
+        ret = writen(fd, writeBuffer, writeLength);
+        writeLength = 0;
+        if (ret <= 0)
+        {
+            LOG(2)(Log::Routing, "NARB_APIClient::finishConnect failed to write to: ", fd);
+            disconnect();
+            return false;
+        }
+    }
+    return true;
+}
+
+// writes a request, or queues it while the connect is in progress
+int NARB_APIClient::sendMessage(struct narb_api_msg_header* msgheader)
+{
+    int len = sizeof(struct narb_api_msg_header)+ntohs(msgheader->length);
+
+    if (!connecting)
+        return writen(fd, (char*)msgheader, len);
+
+    if (writeSize - writeLength < len)
+    {
+        while (writeSize - writeLength < len)
+            writeSize = (writeSize == 0 ? 4096 : writeSize * 2);
+        char* buf = new char[writeSize];
+        if (writeLength > 0)
+            memcpy(buf, writeBuffer, writeLength);
+        if (writeBuffer)
+            delete []writeBuffer;
+        writeBuffer = buf;
+    }
+    memcpy(writeBuffer + writeLength, msgheader, len);
+    writeLength += len;
+    return len;
 }
 
 int NARB_APIClient::doConnect()
@@ -240,8 +303,8 @@ int NARB_APIClient::doConnect()
     if (_host.length() == 0 || _port == 0)
         return -1;
 
-    if (fd > 0)
-        close (fd);
+    if (fd >= 0)
+        disconnect();
     if ((fd = doConnect((char*)(_host.chars()), _port)) < 0)
     {
         return -1;
@@ -252,16 +315,23 @@ int NARB_APIClient::doConnect()
 
 void NARB_APIClient::disconnect()
 {
-    if (fd > 0)
+    if (fd >= 0)
     {
+        if (connecting)
+            NetworkServiceDaemon::deregisterWrite_Handle(fd);
+        NetworkServiceDaemon::deregisterNarb_Handle(fd);
         close (fd);
         fd = -1;
     }
+    connecting = false;
+    readLength = 0;
+    writeLength = 0;
+    failQueries();
 }
 
 bool NARB_APIClient::active()
 {
-    return (fd > 0);
+    return (fd >= 0);
 }
 
 static int buildNarbEroTlv (char *buf, EXPLICIT_ROUTE_Object* ero)
@@ -396,15 +466,11 @@ static void deleteNarbApiMessage(narb_api_msg_header* apiMsg)
    delete []((char*)apiMsg);
 }
 
-EXPLICIT_ROUTE_Object* NARB_APIClient::getExplicitRoute(uint32 src, uint32 dest, uint8 swtype, uint8 encoding, float bandwidth, 
-	uint32& vtag, uint32& srcLocalId, uint32& destLocalId, uint32 hopBackAddr, uint32 excl_options, uint32 ucid, uint32 seqnum)
+struct narb_query* NARB_APIClient::sendQuery(uint32 src, uint32 dest, uint8 swtype, uint8 encoding, float bandwidth, 
+	uint32 vtag, uint32 srcLocalId, uint32 destLocalId, uint32 hopBackAddr, uint32 excl_options, uint32 ucid, uint32 seqnum)
 {
-    char buf[1024];
-    EXPLICIT_ROUTE_Object* ero = NULL;
-    te_tlv_header *tlv;
-    int len, offset;
-    ipv4_prefix_subobj* subobj_ipv4;
-    unum_if_subobj* subobj_unum;
+    struct narb_query* query = NULL;
+    int len;
     struct narb_api_msg_header* msgheader = buildNarbApiMessage(DMSG_CLI_TOPO_CREATE
             , src, dest, swtype, encoding, bandwidth, vtag,  ucid, seqnum, hopBackAddr);
     msgheader->options = htonl(ntohl(msgheader->options) | excl_options | NARB_APIClient::extra_options); //@@@@
@@ -414,63 +480,93 @@ EXPLICIT_ROUTE_Object* NARB_APIClient::getExplicitRoute(uint32 src, uint32 dest,
             goto _RETURN;
 
     //send query
-    len = writen(fd, (char*)msgheader, sizeof(struct narb_api_msg_header)+ntohs(msgheader->length));
+    len = sendMessage(msgheader);
     if (len < 0)
     {
-        LOG(2)(Log::Routing, "NARB_APIClient::getExplicitRoute failed to write to: ", fd);
+        LOG(2)(Log::Routing, "NARB_APIClient::sendQuery failed to write to: ", fd);
+        disconnect();
 	goto _RETURN;
     }
     else if (len ==0)
     {
        disconnect();
-	LOG(1)(Log::Routing, "connection closed for NARB_APIClient in ::getExplicitRoute.");
+	LOG(1)(Log::Routing, "connection closed for NARB_APIClient in ::sendQuery.");
         goto _RETURN;
     }
     else if (len != (int)(sizeof(struct narb_api_msg_header)+ntohs(msgheader->length)))
     {
-        LOG(2)(Log::Routing, "NARB_APIClient::getExplicitRoute cannot write the message to: ", fd);
+        LOG(2)(Log::Routing, "NARB_APIClient::sendQuery cannot write the message to: ", fd);
+        disconnect();
         goto _RETURN; 
     } 
 
-    //read reply
-    len = readn(fd, buf, sizeof(struct narb_api_msg_header));
-    if (len < 0)
-    {
-        LOG(2)(Log::Routing, "NARB_APIClient::getExplicitRoute failed to read from: ", fd);
-	goto _RETURN;
-    }
+    //the reply is picked up by processReplies() from the main loop
+    query = new narb_query();
+    query->index.dest_addr = dest;
+    query->ucid = ucid;
+    query->seqnum = seqnum;
+    query->src_addr = src;
+    query->vtag = vtag;
+    query->srcLocalId = srcLocalId;
+    query->destLocalId = destLocalId;
+    query->state = NARB_QUERY_PENDING;
+    query->deadline = RSVP_Global::currentTimerSystem->getCurrentTime() + TimeValue(NARB_QUERY_TIMEOUT);
+    queryList.push_back(query);
+
+    if (!narbQueryTimer)
+        narbQueryTimer = new NarbQueryTimer;
+    if (!narbQueryTimer->isActive())
+        narbQueryTimer->Start(TimeValue(NARB_QUERY_TIMEOUT));
 
-    tlv = (te_tlv_header*)((char*)buf + sizeof(struct narb_api_msg_header));
-    len = readn(fd, buf+sizeof(struct narb_api_msg_header), ntohs(((struct narb_api_msg_header*)buf)->length));
-    if (len < 0)
-    {
-        LOG(2)(Log::Routing, "NARB_APIClient::getExplicitRoute failed to read from: ", fd);
-	goto _RETURN;
-    }
+_RETURN:
+    deleteNarbApiMessage(msgheader);
+    return query;
+}
+
+EXPLICIT_ROUTE_Object* NARB_APIClient::parseReply(te_tlv_header* tlv, int bodyLen, struct narb_query* query)
+{
+    EXPLICIT_ROUTE_Object* ero = NULL;
+    int len, offset, subLen;
+    ipv4_prefix_subobj* subobj_ipv4;
+    unum_if_subobj* subobj_unum;
+    uint32& vtag = query->vtag;
+    uint32& srcLocalId = query->srcLocalId;
+    uint32& destLocalId = query->destLocalId;
 
     //parse NARB reply
-    if (ntohs(tlv->type) != 3) // 3 == TLV_TYPE_NARB_ERO
-        goto _RETURN;
+    if (bodyLen < (int)sizeof(struct te_tlv_header) || ntohs(tlv->type) != 3) // 3 == TLV_TYPE_NARB_ERO
+        return NULL;
 
-    ero = new EXPLICIT_ROUTE_Object;
     len = ntohs(tlv->length) ;
-    assert( len > 0);
+    if (len > bodyLen - (int)sizeof(struct te_tlv_header))
+    {
+        LOG(1)(Log::Routing, "NARB_APIClient::parseReply: ERO TLV runs past the reply.");
+        return NULL;
+    }
+
+    ero = new EXPLICIT_ROUTE_Object;
     offset = sizeof(struct te_tlv_header);
 
     subobj_ipv4  = (ipv4_prefix_subobj *)((char *)tlv + offset);
     while (len > 0)
     {
+        //the subobject has to be complete and lie within the TLV
+        subLen = (len >= 2 ? subobj_ipv4->length : 0);
         if ((subobj_ipv4->l_and_type & 0x7f) == 4) //UnNumInterface
             subobj_unum = (unum_if_subobj *)((char *)tlv + offset);
         else
             subobj_unum = NULL;
+        if (subLen < (int)(subobj_unum ? sizeof(unum_if_subobj) : sizeof(ipv4_prefix_subobj)) || subLen > len)
+        {
+            LOG(1)(Log::Routing, "NARB_APIClient::parseReply: malformed ERO subobject.");
+            ero->destroy();
+            return NULL;
+        }
 
         if (subobj_unum)
         {
             AbstractNode node(((subobj_unum->l_and_type>>7) == 1), NetAddress(subobj_unum->addr.s_addr), (uint32)ntohl(subobj_unum->ifid));
       	     ero->pushBack(node);
-            len -= sizeof(unum_if_subobj);
-            offset += sizeof(unum_if_subobj);
             if (vtag == ANY_VTAG)
             {
                 vtag = (0xffff&ntohl(subobj_unum->ifid));
@@ -492,10 +588,10 @@ EXPLICIT_ROUTE_Object* NARB_APIClient::getExplicitRoute(uint32 src, uint32 dest,
         {
             AbstractNode node(((subobj_ipv4->l_and_type>>7) == 1), NetAddress(*(uint32*)subobj_ipv4->addr), (uint8)32);
       	     ero->pushBack(node);
-            len -= sizeof(ipv4_prefix_subobj);
-            offset += sizeof(ipv4_prefix_subobj);
         }
 
+        len -= subLen;
+        offset += subLen;
         subobj_ipv4  = (ipv4_prefix_subobj *)((char *)tlv + offset);
     }
 
@@ -509,22 +605,185 @@ EXPLICIT_ROUTE_Object* NARB_APIClient::getExplicitRoute(uint32 src, uint32 dest,
         // Create source localID subobj
         if(srcLocalId >> 16 != LOCAL_ID_TYPE_NONE)
         {
-            AbstractNode node(false, NetAddress(src), srcLocalId);
+            AbstractNode node(false, NetAddress(query->src_addr), srcLocalId);
             ero->pushFront(node);
         }
         //Create destination localID subobj
         if(destLocalId >> 16 != LOCAL_ID_TYPE_NONE)
         {
-            AbstractNode node(false, NetAddress(dest), destLocalId);
+            AbstractNode node(false, NetAddress(query->index.dest_addr), destLocalId);
             ero->pushBack(node);
         }
     }
-    
-_RETURN:
-    deleteNarbApiMessage(msgheader);
+
     return ero;
 }
 
+void NARB_APIClient::processReplies()
+{
+    struct narb_api_msg_header* msgheader;
+    struct narb_query* query;
+    NarbQueryList::Iterator iter;
+    int len, msglen;
+
+    if (!active())
+        return;
+    if (connecting && !finishConnect())
+        return;
+
+    //drain the socket; replies may span several reads and have any length
+    for (;;)
+    {
+        if (readSize - readLength < (int)sizeof(struct narb_api_msg_header) + 1024)
+        {
+            readSize = (readSize == 0 ? 4096 : readSize * 2);
+            char* buf = new char[readSize];
+            if (readLength > 0)
+                memcpy(buf, readBuffer, readLength);
+            if (readBuffer)
+                delete []readBuffer;
+            readBuffer = buf;
+        }
+        len = recv(fd, readBuffer + readLength, readSize - readLength, MSG_DONTWAIT);
+        if (len < 0)
+        {
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+                break;
+            LOG(2)(Log::Routing, "NARB_APIClient::processReplies failed to read from: ", fd);
+            disconnect();
+            return;
+        }
+        else if (len == 0)
+        {
+            LOG(1)(Log::Routing, "connection closed for NARB_APIClient in ::processReplies.");
+            disconnect();
+            return;
+        }
+        readLength += len;
+    }
+
+    //match complete replies to the outstanding queries
+    while (readLength >= (int)sizeof(struct narb_api_msg_header))
+    {
+        msgheader = (struct narb_api_msg_header*)readBuffer;
+        msglen = sizeof(struct narb_api_msg_header) + ntohs(msgheader->length);
+        if (readLength < msglen)
+            break;
+
+        for (iter = queryList.begin(); iter != queryList.end(); ++iter)
+        {
+            query = *iter;
+            if (query->state == NARB_QUERY_PENDING && query->seqnum == ntohl(msgheader->seqnum)
+                && query->ucid == ntohl(msgheader->ucid))
+            {
+                query->ero = parseReply((te_tlv_header*)(readBuffer + sizeof(struct narb_api_msg_header)), ntohs(msgheader->length), query);
+                query->state = (query->ero ? NARB_QUERY_DONE : NARB_QUERY_FAILED);
+                break;
+            }
+        }
+
+        readLength -= msglen;
+        if (readLength > 0)
+            memmove(readBuffer, readBuffer + msglen, readLength);
+    }
+}
+
+void NARB_APIClient::expireQueries()
+{
+    NarbQueryList::Iterator iter;
+    struct narb_query* query;
+    TimeValue now = RSVP_Global::currentTimerSystem->getCurrentTime();
+
+    if (connecting && !(connectDeadline > now))
+    {
+        LOG(1)( Log::Routing, "NARB_APIClient::Connect: connect() timed out.");
+        disconnect();
+        backOff();
+    }
+
+    for (iter = queryList.begin(); iter != queryList.end(); )
+    {
+        query = *iter;
+        ++iter;
+        if (query->state == NARB_QUERY_PENDING)
+        {
+            if (!(query->deadline > now))
+            {
+                LOG(1)(Log::Routing, "NARB_APIClient::expireQueries: no reply from NARB in time.");
+                query->state = NARB_QUERY_FAILED;
+                NetworkServiceDaemon::signalNarb();
+            }
+        }
+        else if (!(query->deadline + TimeValue(NARB_QUERY_TIMEOUT) > now))
+        {
+            //answered but never claimed by a replayed Path
+            if (query->ero)
+                query->ero->destroy();
+            removeQuery(query);
+        }
+    }
+
+    if (connecting && narbQueryTimer)
+        narbQueryTimer->Start(connectDeadline - now);
+    else if (!queryList.empty() && narbQueryTimer)
+        narbQueryTimer->Start(TimeValue(NARB_QUERY_TIMEOUT));
+}
+
+void NARB_APIClient::failQueries()
+{
+    NarbQueryList::Iterator iter;
+
+    for (iter = queryList.begin(); iter != queryList.end(); ++iter)
+    {
+        if ((*iter)->state == NARB_QUERY_PENDING)
+        {
+            (*iter)->state = NARB_QUERY_FAILED;
+            NetworkServiceDaemon::signalNarb();
+        }
+    }
+}
+
+bool NARB_APIClient::isQueryPending(uint32 ucid, uint32 seqnum)
+{
+    NarbQueryList::Iterator iter;
+
+    for (iter = queryList.begin(); iter != queryList.end(); ++iter)
+    {
+        if ((*iter)->ucid == ucid && (*iter)->seqnum == seqnum)
+            return ((*iter)->state == NARB_QUERY_PENDING);
+    }
+
+    return false;
+}
+
+struct narb_query* NARB_APIClient::lookupQuery(uint32 dest_addr, uint32 tunnel_id, uint32 ext_tunnel_id)
+{
+    NarbQueryList::Iterator iter;
+
+    for (iter = queryList.begin(); iter != queryList.end(); ++iter)
+    {
+        if ((*iter)->index.dest_addr == dest_addr && (*iter)->index.tunnel_id == tunnel_id
+            && (*iter)->index.ext_tunnel_id == ext_tunnel_id)
+            return (*iter);
+    }
+
+    return NULL;
+}
+
+void NARB_APIClient::removeQuery(struct narb_query* query)
+{
+    NarbQueryList::Iterator iter;
+
+    for (iter = queryList.begin(); iter != queryList.end(); ++iter)
+    {
+        if ((*iter) == query)
+        {
+            queryList.erase(iter);
+            break;
+        }
+    }
+    delete query;
+}
 EXPLICIT_ROUTE_Object* NARB_APIClient::getExplicitRoute(const Message& msg, bool hasReceivedEro, void* ss_ptr)
 {
     uint32 srcAddr = 0, destAddr = 0, srcLocalId = 0, destLocalId = 0, vtag = 0, hopBackAddr = 0;
@@ -585,23 +844,28 @@ EXPLICIT_ROUTE_Object* NARB_APIClient::getExplicitRoute(const Message& msg, bool
             (uint32)msg.getSESSION_Object().getExtendedTunnelId(), ss_ptr); //using ss_ptr as a index for local-session mutual exclusion
 
     struct ero_search_entry *entry = NULL;
+    struct narb_query *query = NULL;
+
+    pendingUcid = pendingQuery = 0;
 
     if (!ero) {
-        uint32 excl_options = RSVP_Global::switchController->getExclEntry(msg.getSESSION_ATTRIBUTE_Object().getSessionName());
+        query = lookupQuery(destAddr, (uint32)msg.getSESSION_Object().getTunnelId(),
+            (uint32)msg.getSESSION_Object().getExtendedTunnelId());
+    }
 
-        if (hasReceivedEro && msg.getEXPLICIT_ROUTE_Object() &&  msg.getEXPLICIT_ROUTE_Object()->getAbstractNodeList().size() > 0)
-        {
-            const AbstractNode &headNode = msg.getEXPLICIT_ROUTE_Object()->getAbstractNodeList().front();
-            if (vtag ==0 && (headNode.getInterfaceID() >> 16) == LOCAL_ID_TYPE_TAGGED_GROUP_GLOBAL)
-                vtag = (headNode.getInterfaceID() & 0xffff);
-	     if (!headNode.isLoose() && (LogicalInterface*)RSVP_Global::rsvp->getRoutingService().findInterfaceByData(headNode.getAddress(), headNode.getInterfaceID()))
-                hopBackAddr = headNode.getAddress().rawAddress();
+    if (!ero && query) {
+        //the Path message is being replayed once the reply has arrived or the query has failed
+        if (query->state == NARB_QUERY_PENDING) {
+            pendingUcid = query->ucid;
+            pendingQuery = query->seqnum;
+            return NULL;
         }
-
-        ero = getExplicitRoute(srcAddr, destAddr, msg.getLABEL_REQUEST_Object().getSwitchingType(), 
-                msg.getLABEL_REQUEST_Object().getLspEncodingType(), 
-                msg.getSENDER_TSPEC_Object().get_r(),
-                vtag, srcLocalId, destLocalId, hopBackAddr, excl_options, ucid, seqnum);
+        ero = query->ero;
+        query->ero = NULL;
+        vtag = query->vtag;
+        ucid = query->ucid;
+        seqnum = query->seqnum;
+        removeQuery(query);
 	 if (ero) {
             if (uni && uni->getVlanTag().vtag == ANY_VTAG)
             {
@@ -622,6 +886,7 @@ EXPLICIT_ROUTE_Object* NARB_APIClient::getExplicitRoute(const Message& msg, bool
             entry->index.lsp_id = (uint32)msg.getSENDER_TEMPLATE_Object().getLspId();
             entry->index.bw = (float)((const TSpec &)msg.getSENDER_TSPEC_Object()).get_r();
             entry->session_ptr = ss_ptr;
+            entry->owner = this;
             //$$$$ setting entry->qconf_id
             if (ucid != 0 && ucid != srcAddr || (NARB_APIClient::extra_options & (0x0200 << 16)) != 0)
             {
@@ -629,10 +894,37 @@ EXPLICIT_ROUTE_Object* NARB_APIClient::getExplicitRoute(const Message& msg, bool
                 entry->qconf_id.seqnum = seqnum;
             }
             eroSearchList.push_back(entry);
+            eroSessionHash.insert_sorted(entry);
+            eroPointerHash.insert_sorted(entry);
 	 }
 	 else
 	 	return NULL;
     }
+    else if (!ero) {
+        uint32 excl_options = RSVP_Global::switchController->getExclEntry(msg.getSESSION_ATTRIBUTE_Object().getSessionName());
+
+        if (hasReceivedEro && msg.getEXPLICIT_ROUTE_Object() &&  msg.getEXPLICIT_ROUTE_Object()->getAbstractNodeList().size() > 0)
+        {
+            const AbstractNode &headNode = msg.getEXPLICIT_ROUTE_Object()->getAbstractNodeList().front();
+            if (vtag ==0 && (headNode.getInterfaceID() >> 16) == LOCAL_ID_TYPE_TAGGED_GROUP_GLOBAL)
+                vtag = (headNode.getInterfaceID() & 0xffff);
+	     if (!headNode.isLoose() && (LogicalInterface*)RSVP_Global::rsvp->getRoutingService().findInterfaceByData(headNode.getAddress(), headNode.getInterfaceID()))
+                hopBackAddr = headNode.getAddress().rawAddress();
+        }
+
+        //send the query and let the caller defer this Path until the reply is in
+        query = sendQuery(srcAddr, destAddr, msg.getLABEL_REQUEST_Object().getSwitchingType(), 
+                msg.getLABEL_REQUEST_Object().getLspEncodingType(), 
+                msg.getSENDER_TSPEC_Object().get_r(),
+                vtag, srcLocalId, destLocalId, hopBackAddr, excl_options, ucid, seqnum);
+        if (!query)
+            return NULL;
+        query->index.tunnel_id = (uint32)msg.getSESSION_Object().getTunnelId();
+        query->index.ext_tunnel_id = (uint32)msg.getSESSION_Object().getExtendedTunnelId();
+        pendingUcid = query->ucid;
+        pendingQuery = query->seqnum;
+        return NULL;
+    }
     else //ERO has existed
     {
         // updating the DRAGON_UNI based on information in the ero
@@ -670,12 +962,16 @@ EXPLICIT_ROUTE_Object* NARB_APIClient::lookupExplicitRoute(uint32 dest_addr, uin
     target.index.dest_addr = dest_addr;
     target.index.tunnel_id = tunnel_id;
     target.index.ext_tunnel_id = ext_tunnel_id;
-    target.session_ptr = session_ptr;
 
-    EroSearchList::Iterator iter = eroSearchList.begin();
-    for ( ; iter != eroSearchList.end(); ++iter)
+    //entries of the same session key are adjacent, the NULL session_ptr sorts first
+    EroSessionHash::HashBucket::Iterator iter = eroSessionHash.lower_bound(&target);
+    for ( ; iter != eroSessionHash.getHashBucket(&target).end(); ++iter)
     {
-        if (*(*iter) == target)
+        if (memcmp(&(*iter)->index, &target.index, 12) != 0)
+            break;
+        //without a session pointer only this client's own entries match; the hash is shared by all sessions
+        if (session_ptr == NULL ? (*iter)->owner == this
+            : ((*iter)->session_ptr == NULL || (*iter)->session_ptr == session_ptr))
             return (*iter)->ero;
     }
 
@@ -684,16 +980,41 @@ EXPLICIT_ROUTE_Object* NARB_APIClient::lookupExplicitRoute(uint32 dest_addr, uin
 
 struct ero_search_entry* NARB_APIClient::lookupEntry(EXPLICIT_ROUTE_Object* ero)
 {
-    EroSearchList::Iterator iter = eroSearchList.begin();
-    for ( ; iter != eroSearchList.end(); ++iter)
-    {
-        if ((*iter)->ero == ero)
-            return (*iter);
-    }
+    struct ero_search_entry target;
+    target.ero = ero;
+
+    EroPointerHash::HashBucket::Iterator iter = eroPointerHash.find(&target);
+    if (iter != eroPointerHash.getHashBucket(&target).end())
+        return (*iter);
 
     return NULL;
 }
 
+void NARB_APIClient::removeEntry(struct ero_search_entry* entry)
+{
+    EroSearchList& ownerList = entry->owner->eroSearchList;
+    EroSearchList::Iterator iter = ownerList.begin();
+    for ( ; iter != ownerList.end(); ++iter)
+    {
+        if ((*iter) == entry) {
+            ownerList.erase(iter);
+            break;
+        }
+    }
+    EroSessionHash::HashBucket::Iterator iterSession = eroSessionHash.lower_bound(entry);
+    for ( ; iterSession != eroSessionHash.getHashBucket(entry).end(); ++iterSession)
+    {
+        if ((*iterSession) == entry) {
+            eroSessionHash.erase(iterSession);
+            break;
+        }
+    }
+    eroPointerHash.erase_key(entry);
+    if (entry->ero)
+        entry->ero->destroy();
+    delete entry;
+}
+
 uint32 NARB_APIClient::getVtagFromERO(EXPLICIT_ROUTE_Object* ero)
 {
     if (!ero)
@@ -709,36 +1030,16 @@ uint32 NARB_APIClient::getVtagFromERO(EXPLICIT_ROUTE_Object* ero)
 
 void NARB_APIClient::removeExplicitRoute(uint32 dest_addr, uint32 tunnel_id, uint32 ext_tunnel_id)
 {
-    struct ero_search_entry target;
-    memset(&target, 0, sizeof(struct ero_search_entry));
-    target.index.dest_addr = dest_addr;
-    target.index.tunnel_id = tunnel_id;
-    target.index.ext_tunnel_id = ext_tunnel_id;
-    //target.index.src_addr = src_addr;
-    //target.index.lsp_id = lsp_id;
-
-    EroSearchList::Iterator iter = eroSearchList.begin();
-    for ( ; iter != eroSearchList.end(); ++iter)
-    {
-        if (*(*iter) == target) {
-            (*iter)->ero->destroy();
-            eroSearchList.erase(iter);
-            return;
-      	}
-    }
+    EXPLICIT_ROUTE_Object* ero = lookupExplicitRoute(dest_addr, tunnel_id, ext_tunnel_id);
+    if (ero)
+        removeExplicitRoute(ero);
 }
 
 void NARB_APIClient::removeExplicitRoute(EXPLICIT_ROUTE_Object* ero)
 {
-    EroSearchList::Iterator iter = eroSearchList.begin();
-    for ( ; iter != eroSearchList.end(); ++iter)
-    {
-        if ((*iter)->ero == ero) {
-            (*iter)->ero->destroy();
-            eroSearchList.erase(iter);
-            return;
-      	}
-    }
+    struct ero_search_entry* entry = lookupEntry(ero);
+    if (entry)
+        removeEntry(entry);
 }
 
 void NARB_APIClient::confirmReservation(const Message& msg)
@@ -772,8 +1073,15 @@ void NARB_APIClient::confirmReservation(const Message& msg)
     struct narb_api_msg_header* msgheader = buildNarbApiMessage(DMSG_CLI_TOPO_CONFIRM
             , entry->index.src_addr, entry->index.dest_addr, 0, 0, entry->index.bw, 0, ucid, seqnum, 0, ero);
 
+    if (!active())
+        if (doConnect() < 0)
+        {
+            deleteNarbApiMessage(msgheader);
+            return;
+        }
+
     //send api message
-    int len = writen(fd, (char*)msgheader, sizeof(struct narb_api_msg_header)+ntohs(msgheader->length));
+    int len = sendMessage(msgheader);
     if (len < 0)
     {
         LOG(2)(Log::Routing, "NARB_APIClient::confirmReservation failed to write to: ", fd);
@@ -823,7 +1131,9 @@ void NARB_APIClient::releaseReservation(const Message& msg)
             , entry->index.src_addr, entry->index.dest_addr, 0, 0, entry->index.bw, 0, ucid, seqnum, 0, ero);
 
     //send api message
-    int len = writen(fd, (char*)msgheader, sizeof(struct narb_api_msg_header)+ntohs(msgheader->length));
+    int len = -1;
+    if (active() || doConnect() >= 0)
+        len = sendMessage(msgheader);
     if (len < 0)
     {
         LOG(2)(Log::Routing, "NARB_APIClient::releaseReservation failed to write to: ", fd);
@@ -883,34 +1193,24 @@ void NARB_APIClient::setExtraOption(String opt_str)
 //VTAG mutral-exclusion feature --> Review
 void NARB_APIClient::addVtagInUse(int vtag)
 {
+    if (vtag < 1 || vtag > MAX_VLAN_NUM)
+        return;
 
     if (!vtagsAllowedforUse)
-         vtagsAllowedforUse = new UsedVtagList;
-
-    UsedVtagList::Iterator it = vtagsAllowedforUse->begin();
-    for (; it != vtagsAllowedforUse->end(); ++it)
     {
-        if (*it == (uint32)vtag)
-            return;
+        vtagsAllowedforUse = new uint8[MAX_VLAN_NUM/8];
+        memset(vtagsAllowedforUse, 0, MAX_VLAN_NUM/8);
     }
-    vtagsAllowedforUse->push_back(vtag);
+    SET_VLAN(vtagsAllowedforUse, vtag);
 }
 
 
 void NARB_APIClient::removeVtagInUse(int vtag)
 {
-    if (!vtagsAllowedforUse)
+    if (!vtagsAllowedforUse || vtag < 1 || vtag > MAX_VLAN_NUM)
         return;
 
-    UsedVtagList::Iterator it = vtagsAllowedforUse->begin();
-    for (; it != vtagsAllowedforUse->end(); ++it)
-    {
-        if (*it == (uint32)vtag)
-        {
-            vtagsAllowedforUse->erase(it);
-            return;
-        }
-    }
+    RESET_VLAN(vtagsAllowedforUse, vtag);
 }
 
 void NARB_APIClient::setAllowedVtags(uint8* bitmask)
@@ -918,11 +1218,8 @@ void NARB_APIClient::setAllowedVtags(uint8* bitmask)
     if (!vtagsAllowedforUse)
 	return;
 
-    UsedVtagList::Iterator it = vtagsAllowedforUse->begin();
-    for (; it != vtagsAllowedforUse->end(); ++it)
-    {
-        SET_VLAN(bitmask, *it);
-    }
+    for (int i = 0; i < MAX_VLAN_NUM/8; i++)
+        bitmask[i] |= vtagsAllowedforUse[i];
 }
 //
 
@@ -9,6 +9,8 @@ To be incorporated into KOM-RSVP-TE package
 #ifndef _NARB_APICLIENT_H_
 #define _NARB_APICLIENT_H_
 
+#include "RSVP_SortableHash.h"
+
 //App-NARB API message types
 #define MSG_APP_REQUEST 0x0001
 #define DMSG_CLI_TO_NARB_BASE			0x01	/* 0x01 -- 0x1F */
@@ -105,6 +107,7 @@ enum  narb_tlv_type
 #define ANY_TIMESLOT 0xff
 
 class EXPLICIT_ROUTE_Object;
+class NARB_APIClient;
 
 struct ero_search_entry
 {
@@ -122,6 +125,7 @@ struct ero_search_entry
 	} qconf_id;
 	void * session_ptr;
 	EXPLICIT_ROUTE_Object *ero;
+	NARB_APIClient *owner;
 };
 extern inline bool operator== (struct ero_search_entry& a, struct ero_search_entry& b)
 {
@@ -139,7 +143,67 @@ extern inline bool operator!= (struct ero_search_entry& a, struct ero_search_ent
 }
 
 typedef SimpleList<struct ero_search_entry*> EroSearchList;
-typedef SimpleList<uint32> UsedVtagList;
+
+// ERO search entries are indexed twice: by session key (dest_addr, tunnel_id, ext_tunnel_id, session_ptr)
+// for Path refreshes and by ERO pointer for confirmation and release.
+struct EroSessionLess {
+	bool operator()( const ero_search_entry* e1, const ero_search_entry* e2 ) const {
+		int ret = memcmp(&e1->index, &e2->index, 12);
+		if (ret != 0)
+			return ret < 0;
+		return e1->session_ptr < e2->session_ptr;
+	}
+};
+struct EroSessionHashValue {
+	uint32 operator()( const ero_search_entry* e, uint32 hashCount ) const {
+		return (ntohl(e->index.dest_addr) ^ (e->index.tunnel_id << 8) ^ e->index.ext_tunnel_id) % hashCount;
+	}
+};
+struct EroPointerLess {
+	bool operator()( const ero_search_entry* e1, const ero_search_entry* e2 ) const {
+		return e1->ero < e2->ero;
+	}
+};
+struct EroPointerHashValue {
+	uint32 operator()( const ero_search_entry* e, uint32 hashCount ) const {
+		return ((unsigned long)e->ero >> 4) % hashCount;
+	}
+};
+typedef SortableHash<ero_search_entry*,ero_search_entry*,EroSessionLess,EroSessionHashValue> EroSessionHash;
+typedef SortableHash<ero_search_entry*,ero_search_entry*,EroPointerLess,EroPointerHashValue> EroPointerHash;
+#define NARB_ERO_HASH_SIZE 1024
+
+// outstanding path query on the shared NARB connection, matched to its reply by (ucid, seqnum)
+enum narb_query_state
+{
+	NARB_QUERY_PENDING = 1,
+	NARB_QUERY_DONE,
+	NARB_QUERY_FAILED
+};
+
+struct narb_query
+{
+	struct {
+		uint32 dest_addr;
+		uint32 tunnel_id;
+		uint32 ext_tunnel_id;
+	} index;
+	uint32 ucid;
+	uint32 seqnum;
+	uint32 src_addr;
+	uint32 vtag;
+	uint32 srcLocalId;
+	uint32 destLocalId;
+	uint32 state;
+	TimeValue deadline;
+	EXPLICIT_ROUTE_Object *ero;
+};
+typedef SimpleList<struct narb_query*> NarbQueryList;
+
+#define NARB_QUERY_TIMEOUT 30		// seconds to wait for a NARB reply
+#define NARB_CONNECT_TIMEOUT 1		// seconds to wait for connect()
+#define NARB_RETRY_MIN 1		// reconnect backoff, doubled up to NARB_RETRY_MAX
+#define NARB_RETRY_MAX 64
 
 class Message;
 class NARB_APIClient{
@@ -148,14 +212,20 @@ public:
 	NARB_APIClient(const char *host, int port) { _host = host; _port = port; Init(); }
 	~NARB_APIClient();
 	void Init() {
-		fd = -1; lastState = 0;
+		lastState = 0; pendingUcid = 0; pendingQuery = 0;
 	}
-	int doConnect(char *host, int port);
-	int doConnect();
-	void disconnect();
-	bool active();
-	EXPLICIT_ROUTE_Object* getExplicitRoute(uint32 src, uint32 dest, uint8 swtype, uint8 encoding, float bandwidth, uint32& vtag, uint32& srcLclId, uint32& destLclId, uint32 hopBackAddr, uint32 excl_options, uint32 ucid, uint32 seqnum);
+	static int doConnect(char *host, int port);
+	static int doConnect();
+	static void disconnect();
+	static bool active();
+	// getExplicitRoute() returns NULL with pendingQuery set while NARB is still computing;
+	// the caller defers the Path message until isQueryPending(pendingUcid, pendingQuery) turns false.
 	EXPLICIT_ROUTE_Object* getExplicitRoute(const Message& msg, bool hasReceivedEro, void* ss_ptr = NULL);
+	uint32 getPendingUcid() { return pendingUcid; }
+	uint32 getPendingQuery() { return pendingQuery; }
+	static bool isQueryPending(uint32 ucid, uint32 seqnum);
+	static void processReplies();
+	static void expireQueries();
 	//EXPLICIT_ROUTE_Object* lookupExplicitRoute(uint32 src_addr, uint32 dest_addr, uint32 lsp_id, uint32 tunnel_id, uint32 ext_tunnel_id);
 	EXPLICIT_ROUTE_Object* lookupExplicitRoute(uint32 dest_addr, uint32 tunnel_id, uint32 ext_tunnel_id, void* session_ptr = NULL);
 	struct ero_search_entry* lookupEntry(EXPLICIT_ROUTE_Object* ero);
@@ -171,7 +241,7 @@ public:
 	static void setExtraOption(String opt_str);
 
        //VTAG mutral-exclusion feature --> Review
-	static UsedVtagList* vtagsAllowedforUse;
+	static uint8* vtagsAllowedforUse;
 	static void addVtagInUse(int vtag);
 	static void removeVtagInUse(int vtag);
 	static void setAllowedVtags(uint8* bitmask);
@@ -183,9 +253,40 @@ public:
 
 
 private:
-	int fd;
+	static struct narb_query* sendQuery(uint32 src, uint32 dest, uint8 swtype, uint8 encoding, float bandwidth, uint32 vtag, uint32 srcLclId, uint32 destLclId, uint32 hopBackAddr, uint32 excl_options, uint32 ucid, uint32 seqnum);
+	static struct narb_query* lookupQuery(uint32 dest_addr, uint32 tunnel_id, uint32 ext_tunnel_id);
+	static void removeQuery(struct narb_query* query);
+	static void failQueries();
+	static EXPLICIT_ROUTE_Object* parseReply(te_tlv_header* tlv, int bodyLen, struct narb_query* query);
+	static int sendMessage(struct narb_api_msg_header* msgheader);
+	static bool finishConnect();
+	static void backOff();
+
+	// one connection to NARB, multiplexed by all sessions
+	static int fd;
+	static char* readBuffer;
+	static int readLength;
+	static int readSize;
+	static NarbQueryList queryList;
+	static int retryDelay;
+	static TimeValue nextConnectTime;
+	// a connect() in progress is completed from the main loop; requests wait in writeBuffer
+	static bool connecting;
+	static TimeValue connectDeadline;
+	static char* writeBuffer;
+	static int writeLength;
+	static int writeSize;
+
+	// EROs of all sessions, shared so lookups do not depend on the number of LSPs
+	static EroSessionHash eroSessionHash;
+	static EroPointerHash eroPointerHash;
+	static void removeEntry(struct ero_search_entry* entry);
+
 	uint32 lastState; // last state == last processed message type ...
-	EroSearchList eroSearchList; 
+	// (ucid, seqnum) of the query the last Path is waiting for
+	uint32 pendingUcid;
+	uint32 pendingQuery;
+	EroSearchList eroSearchList; // entries added by this client, released with it
 };
 
 #endif
@@ -92,6 +92,12 @@ InterfaceHandle NetworkServiceDaemon::rsrrSocket = -1;
 bool NetworkServiceDaemon::rsrrReady = false;
 InterfaceHandle NetworkServiceDaemon::routingSocket = -1;
 bool NetworkServiceDaemon::routingReady = false;
+InterfaceHandle NetworkServiceDaemon::narbSocket = -1;
+bool NetworkServiceDaemon::narbReady = false;
+InterfaceHandleMask NetworkServiceDaemon::writeFdmask;
+int NetworkServiceDaemon::writeFdCount = 0;
+SimpleList<InterfaceHandle> NetworkServiceDaemon::apiStreamList;
+bool NetworkServiceDaemon::apiStreamReady = false;
 const LogicalInterface* NetworkServiceDaemon::globalVirtualInterface = NULL;
 const LogicalInterface** NetworkServiceDaemon::indexToInterfaceTable = NULL;
 int NetworkServiceDaemon::numSystemIndices = 0;
@@ -307,13 +313,15 @@ void NetworkServiceDaemon::cleanup() {
 // routines from 'NetworkService[Daemon]'.
 const LogicalInterface* NetworkServiceDaemon::queryInterfaces() {
 	static SimpleList<const LogicalInterface*> readyList;
-	while ( readyList.empty() && !(rsrrReady || routingReady ) ) {
+	while ( readyList.empty() && !(rsrrReady || routingReady || narbReady || apiStreamReady ) ) {
 		static InterfaceHandleMask readfds;
+		static InterfaceHandleMask writefds;
 		static int fdCount;
 		TimeValue zeroTime(0,0);
 		set_fdMask( readfds );
+		writefds = writeFdmask;
 		// first check for incoming packets, otherwise execute pending timers
-		fdCount = select( NetworkService::maxSelectFDs, &readfds, NULL, NULL, &zeroTime );
+		fdCount = select( NetworkService::maxSelectFDs, &readfds, writeFdCount ? &writefds : NULL, NULL, &zeroTime );
 		if ( fdCount == 0 ) {
 			static TimeValue* waitTime;
 			static TimeValue remainingTime;
@@ -327,7 +335,8 @@ const LogicalInterface* NetworkServiceDaemon::queryInterfaces() {
 				LOG(2)( Log::Select, "NetworkService calling blocking select, timeout is", (waitTime ? *waitTime : TimeValue(0)) );
 #endif
 			set_fdMask( readfds );
-			fdCount = select( NetworkService::maxSelectFDs, &readfds, NULL, NULL, waitTime );
+			writefds = writeFdmask;
+			fdCount = select( NetworkService::maxSelectFDs, &readfds, writeFdCount ? &writefds : NULL, NULL, waitTime );
 		}
 		if ( fdCount < 0 ) {
 			if ( errno == EINTR ) {
@@ -359,6 +368,27 @@ const LogicalInterface* NetworkServiceDaemon::queryInterfaces() {
 			fdCount -= 1;
 		}
 #endif
+		// check NARB client socket
+		if ( narbSocket != -1 && FD_ISSET( narbSocket, &readfds ) ) {
+			narbReady = true;
+			fdCount -= 1;
+		}
+		if ( narbSocket != -1 && writeFdCount && FD_ISSET( narbSocket, &writefds ) ) {
+			narbReady = true;
+			fdCount -= 1;
+		}
+		// check local stream API sockets
+		static SimpleList<InterfaceHandle>::ConstIterator streamIter;
+		for ( streamIter = apiStreamList.begin(); fdCount > 0 && streamIter != apiStreamList.end(); ++streamIter ) {
+			if ( FD_ISSET( *streamIter, &readfds ) ) {
+				apiStreamReady = true;
+				fdCount -= 1;
+			}
+			if ( FD_ISSET( *streamIter, &writefds ) ) {
+				apiStreamReady = true;
+				fdCount -= 1;
+			}
+		}
 		// check other interfaces, if necessary (vif or API or UDP interfaces)
 		static uint32 i;
 		for ( i = 0; fdCount > 0 && i < RSVP_Global::rsvp->getInterfaceCount(); ++i ) {
@@ -402,6 +432,48 @@ void NetworkServiceDaemon::deregisterRouting_Handle( InterfaceHandle fd ) {
 	FD_CLR( fd, &NetworkService::fdmask );
 }
 
+void NetworkServiceDaemon::registerNarb_Handle( InterfaceHandle fd ) {
+	narbSocket = fd;
+	FD_SET( fd, &NetworkService::fdmask );
+	if ( fd >= NetworkService::maxSelectFDs ) NetworkService::maxSelectFDs = fd + 1;
+}
+
+void NetworkServiceDaemon::deregisterNarb_Handle( InterfaceHandle fd ) {
+	narbSocket = -1;
+	narbReady = false;
+	FD_CLR( fd, &NetworkService::fdmask );
+}
+
+void NetworkServiceDaemon::registerWrite_Handle( InterfaceHandle fd ) {
+	if ( FD_ISSET( fd, &writeFdmask ) ) return;
+	FD_SET( fd, &writeFdmask );
+	writeFdCount += 1;
+	if ( fd >= NetworkService::maxSelectFDs ) NetworkService::maxSelectFDs = fd + 1;
+}
+
+void NetworkServiceDaemon::deregisterWrite_Handle( InterfaceHandle fd ) {
+	if ( !FD_ISSET( fd, &writeFdmask ) ) return;
+	FD_CLR( fd, &writeFdmask );
+	writeFdCount -= 1;
+}
+
+void NetworkServiceDaemon::registerApiStream_Handle( InterfaceHandle fd ) {
+	apiStreamList.push_back( fd );
+	FD_SET( fd, &NetworkService::fdmask );
+	if ( fd >= NetworkService::maxSelectFDs ) NetworkService::maxSelectFDs = fd + 1;
+}
+
+void NetworkServiceDaemon::deregisterApiStream_Handle( InterfaceHandle fd ) {
+	SimpleList<InterfaceHandle>::Iterator iter = apiStreamList.begin();
+	for ( ; iter != apiStreamList.end(); ++iter ) {
+		if ( *iter == fd ) {
+			apiStreamList.erase( iter );
+	break;
+		}
+	}
+	FD_CLR( fd, &NetworkService::fdmask );
+}
+
 void NetworkServiceDaemon::registerApiClient_Handle( InterfaceHandle fd ) {
        if (FD_ISSET(fd, &NetworkService::fdmask))    return;
 	FD_SET( fd, &NetworkService::fdmask );
@@ -67,9 +67,37 @@ class NetworkServiceDaemon {
 		bool retval = routingReady; routingReady = false; return retval;
 	}
 
+	// NARB path computation replies
+	static InterfaceHandle narbSocket;
+	static bool narbReady;
+	static void registerNarb_Handle( InterfaceHandle );
+	static void deregisterNarb_Handle( InterfaceHandle );
+	static bool queryAndClearNarb() {
+		bool retval = narbReady; narbReady = false; return retval;
+	}
+	static void signalNarb() { narbReady = true; }
+
+	// descriptors select() also watches for writing: a NARB connect in progress,
+	// API streams with queued output
+	static InterfaceHandleMask writeFdmask;
+	static int writeFdCount;
+	static void registerWrite_Handle( InterfaceHandle );
+	static void deregisterWrite_Handle( InterfaceHandle );
+
+	// local stream API clients and their listen socket
+	static SimpleList<InterfaceHandle> apiStreamList;
+	static bool apiStreamReady;
+	static void registerApiStream_Handle( InterfaceHandle );
+	static void deregisterApiStream_Handle( InterfaceHandle );
+	static bool queryAndClearApiStream() {
+		bool retval = apiStreamReady; apiStreamReady = false; return retval;
+	}
+
 	friend class RSVP;                                  // access: buildInterfaceList,queryAndClearAsyncRouting,queryInterfaces,cleanup
 	friend class RSRR;                                  // access: registerRSRR_Handle, deregisterRSRR_Handle
 	friend class RoutingService;                        // access: registerRouting_Handle, deregisterRouting_Handle, getInterfaceBySystemIndex
+	friend class NARB_APIClient;                        // access: registerNarb_Handle, deregisterNarb_Handle, signalNarb, registerWrite_Handle, deregisterWrite_Handle
+	friend class API_Server;                            // access: registerApiStream_Handle, deregisterApiStream_Handle, registerWrite_Handle, deregisterWrite_Handle
 public:
 	// interface configuration
 	static InterfaceHandle initRawInterfaceIP4( const NetAddress& );
@@ -10,6 +10,10 @@ and adding the VLAN interface, ie eth0.VID, to the ethernet bridge VID.
 
 For this class to work the user CLI_USERNAME _must_ be able to run ifconfig, 
 brctl & vconfig through sudo without password.
+
+When the switch is the local host (CLI_SHELL), VLAN changes are applied
+through rtnetlink by LinuxBridgeNetlink instead, one batch per change; the
+shell is then only used to read the initial configuration.
 ****************************************************************************/
 
 #ifdef Linux
@@ -33,6 +37,15 @@ bool SwitchCtrl_Session_Linux::connectSwitch(const char *loginString)
     return false;
   }
 
+  if (CLI_SESSION_TYPE == CLI_SHELL && netlink == NULL) {
+    netlink = new LinuxBridgeNetlink;
+    if (!netlink->open()) {
+      LOG(1) (Log::MPLS, "cannot open rtnetlink, falling back to brctl/vconfig through the shell");
+      delete netlink;
+      netlink = NULL;
+    }
+  }
+
   active = true;
 
   return true;
@@ -40,6 +53,11 @@ bool SwitchCtrl_Session_Linux::connectSwitch(const char *loginString)
 
 void SwitchCtrl_Session_Linux::disconnectSwitch()
 {
+  if (netlink) {
+    delete netlink;
+    netlink = NULL;
+  }
+
   for(PortToIfMap::iterator i = _ports.begin(); i != _ports.end(); i++)
     free(i->second);
   
@@ -88,8 +106,15 @@ bool SwitchCtrl_Session_Linux::movePortToVLANAsUntagged(uint32 port, uint32 vlan
     if (vpmAll) 
       {
 	SetPortBit(vpmAll->portbits, port);
-	//clear address and activate interface before adding to bridge
 	char command[100];
+	if (netlink) {
+	  snprintf(command, sizeof(command), "%s%d", BR_PREFIX, vlanID);
+	  netlink->begin();
+	  netlink->flushAddresses(i->second);
+	  netlink->setMaster(i->second, command);
+	  return netlink->commit();
+	}
+	//clear address and activate interface before adding to bridge
 	snprintf(command, sizeof(command), "sudo %s %s 0.0.0.0 up\n", IFCONFIG_PATH, i->second);
 	LOG(1) (Log::MPLS, command);
 	DIE_IF_NEGATIVE(writeShell(command, 5));
@@ -128,8 +153,14 @@ bool SwitchCtrl_Session_Linux::movePortToVLANAsTagged(uint32 port, uint32 vlanID
     if (vpmAll) 
       {
 	SetPortBit(vpmAll->portbits, port);
-	//now add to new VLAN
 	char command[100];
+	if (netlink) {
+	  snprintf(command, sizeof(command), "%s%d", BR_PREFIX, vlanID);
+	  netlink->begin();
+	  netlink->addVlanInterface(i->second, vlanID, command);
+	  return netlink->commit();
+	}
+	//now add to new VLAN
 	snprintf(command, sizeof(command), "sudo %s add %s %d\n", VCONFIG_PATH, i->second, vlanID);
 	LOG(1) (Log::MPLS, command);
 	DIE_IF_NEGATIVE(writeShell(command, 5));
@@ -237,6 +268,11 @@ bool SwitchCtrl_Session_Linux::readVLANFromSwitch() {
 bool SwitchCtrl_Session_Linux::verifyVLAN(uint32 vlanID) {
   char command[100];
   
+  if (netlink) {
+    snprintf(command, sizeof(command), "%s%d", BR_PREFIX, vlanID);
+    return LinuxBridgeNetlink::linkExists(command);
+  }
+
   snprintf(command, sizeof(command), "%s %s%d\n", IFCONFIG_PATH, BR_PREFIX, vlanID);
   LOG(1) (Log::MPLS, command);
   DIE_IF_NEGATIVE(writeShell(command, 5));
@@ -277,8 +313,19 @@ bool SwitchCtrl_Session_Linux::removePortFromVLAN(uint32 port, uint32 vlanID) {
       ResetPortBit(vpmAll->portbits, port);
     }
 
-    /* run brctl to remove interface from bridge representing vlan */	
     char command[100], *ifname = i->second;
+    if (netlink) {
+      netlink->begin();
+      if (isTagged) {
+        /* deleting the subinterface also takes it out of the bridge */
+        snprintf(command, sizeof(command), "%s.%d", ifname, vlanID);
+        netlink->delLink(command);
+      } else
+        netlink->setMaster(ifname, NULL);
+      return netlink->commit();
+    }
+
+    /* run brctl to remove interface from bridge representing vlan */	
     if(isTagged) 
       snprintf(command, sizeof(command), "sudo %s delif %s%d %s.%d\n", BRCTL_PATH, BR_PREFIX, vlanID, ifname, vlanID);
     else
@@ -325,6 +372,14 @@ bool SwitchCtrl_Session_Linux::hook_removeVLAN(const uint32 vlanID)
 	DIE_IF_EQUAL(vlanID, 0);	
 	
 	char command[100];
+	if (netlink) {
+	  snprintf(command, sizeof(command), "%s%d", BR_PREFIX, vlanID);
+	  netlink->begin();
+	  netlink->setDown(command);
+	  netlink->delLink(command);
+	  return netlink->commit();
+	}
+
 	//need to take the interface down first
 	snprintf(command, sizeof(command), "sudo %s %s%d down\n", IFCONFIG_PATH, BR_PREFIX, vlanID);
 	LOG(1) (Log::MPLS, command);
@@ -344,6 +399,15 @@ bool SwitchCtrl_Session_Linux::hook_createVLAN(const uint32 vlanID)
 	DIE_IF_EQUAL(vlanID, 0);
 
 	char command[100];
+	if (netlink) {
+	  snprintf(command, sizeof(command), "%s%d", BR_PREFIX, vlanID);
+	  netlink->begin();
+	  netlink->addBridge(command);
+	  DIE_IF_EQUAL(netlink->commit(), false);
+	  addEmptyVLAN(vlanID);
+	  return true;
+	}
+
 	snprintf(command, sizeof(command), "sudo %s addbr %s%d\n", BRCTL_PATH, BR_PREFIX, vlanID);
 	LOG(1) (Log::MPLS, command);
 	DIE_IF_NEGATIVE(writeShell(command, 5)) ;
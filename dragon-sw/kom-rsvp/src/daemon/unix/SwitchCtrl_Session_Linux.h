@@ -16,6 +16,7 @@ Modified by Xi Yang, 2006
 #include "SwitchCtrl_Global.h"
 #include "CLI_Session.h"
 #include "RSVP_Log.h"
+#include "LinuxBridgeNetlink.h"
 
 class SwitchCtrl_Session_Linux: public CLI_Session
 {
@@ -26,11 +27,13 @@ public:
   SwitchCtrl_Session_Linux(): CLI_Session() {
     rfc2674_compatible = false;
     snmp_enabled = false;
+    netlink = NULL;
   }
 
   SwitchCtrl_Session_Linux(const String& sName, const NetAddress& swAddr): CLI_Session(sName, swAddr) {
     rfc2674_compatible = false;
     snmp_enabled = false;
+    netlink = NULL;
   }
 
   virtual ~SwitchCtrl_Session_Linux() {}
@@ -130,6 +133,12 @@ public:
    * @returns an interface name if port can be found, NULL otherwise.
    */
   char *portNumToInterface(int portNum);
+
+  /**
+   * Netlink driver used instead of sudo vconfig/ifconfig/brctl when the
+   * switch is the local host (CLI_SHELL); NULL otherwise.
+   */
+  LinuxBridgeNetlink *netlink;
 };
 
 #endif //ifndef _SwitchCtrl_Session_Linux_H_
@@ -35,6 +35,7 @@ void SwitchCtrl_Session_SubnetUNI::internalInit ()
     resourceHeld = false;
     isTunnelMode = false;
     memset(&DTL, 0, sizeof(DTL_Subobject));
+    entityChecked = entityExists = 0;
 }
 
 void SwitchCtrl_Session_SubnetUNI::setSubnetUniData(SubnetUNI_Data& data, uint8 subuni_id, uint8 first_ts,
@@ -868,6 +869,220 @@ void SwitchCtrl_Session_SubnetUNI::getDTLString(String& dtlStr)
     return;
 }
 
+//////////////// Pipelined TL1 commands >> begin //////////////
+//
+// Independent commands are written back to back, each with a CTAG of its own, and the
+// "M  <ctag> COMPLD/DENY" responses are matched with them as they arrive.
+//
+
+extern void sigalrm(int signo);
+
+void SwitchCtrl_Session_SubnetUNI::resetTL1State()
+{
+    tl1Responses.clear();
+    entityChecked = entityExists = 0;
+}
+
+// read one line of switch output without the line break; a truncated listing has none
+int SwitchCtrl_Session_SubnetUNI::readLineTL1(char* line, int timeout)
+{
+    int n = 0;
+
+    if (fdin < 0)
+        return -1;
+
+    signal(SIGALRM, sigalrm);
+    alarm(timeout);
+    for (;;)
+    {
+        if (read(fdin, &line[n], 1) != 1)
+        {
+            alarm(0);
+            return -1;
+        }
+        ///////// debug info ////////
+        fputc(0xff & (int)line[n], stdout);
+        if (line[n] == '\r')
+            continue;
+        if (line[n] == '\n')
+            break;
+        line[++n] = '\0';
+        if (n == LINELEN || (n >= 10 && strcmp(line+n-10, "TRUNCATED\"") == 0))
+            break;
+    }
+    alarm(0);
+    line[n] = '\0';
+    return n;
+}
+
+// read through the end of the next response; echoed commands and autonomous messages are skipped
+int SwitchCtrl_Session_SubnetUNI::readResponseTL1(uint32& ctag, int timeout)
+{
+    char line[LINELEN+1];
+    char status[20];
+    char* p;
+    int result = 0;
+
+    for (;;)
+    {
+        if (readLineTL1(line, timeout) < 0)
+            return -1;
+        for (p = line; *p == ' ' || *p == '\t'; p++) ;
+        if (result == 0)
+        {
+            if (p[0] == 'M' && (p[1] == ' ' || p[1] == '\t') && sscanf(p+1, "%u %19s", &ctag, status) == 2)
+                result = (strcmp(status, "COMPLD") == 0 ? TL1_COMPLD : TL1_DENY);
+        }
+        else if (*p == ';' || strstr(line, "TRUNCATED\"") != NULL)
+            return result;
+    }
+}
+
+bool SwitchCtrl_Session_SubnetUNI::sendTL1(const char* cmd, uint32 ctag)
+{
+    TL1_Response pending;
+
+    if (writeShell((char*)cmd, 5) < 0)
+        return false;
+    pending.ctag = ctag;
+    pending.result = 0;
+    tl1Responses.push_back(pending);
+    return true;
+}
+
+// wait for the response to 'ctag', keeping those to other outstanding commands read on the way
+int SwitchCtrl_Session_SubnetUNI::waitTL1(uint32 ctag, int timeout)
+{
+    TL1_ResponseList::Iterator it;
+    uint32 respCtag;
+    int result;
+
+    for (;;)
+    {
+        for (it = tl1Responses.begin(); it != tl1Responses.end(); ++it)
+            if ((*it).ctag == ctag)
+                break;
+        if (it == tl1Responses.end())
+            return -1;
+        if ((*it).result != 0)
+        {
+            result = (*it).result;
+            tl1Responses.erase(it);
+            return result;
+        }
+
+        if ((result = readResponseTL1(respCtag, timeout)) < 0)
+        {
+            //no telling which responses are still on their way: give up on all of them
+            tl1Responses.clear();
+            return -1;
+        }
+        for (it = tl1Responses.begin(); it != tl1Responses.end(); ++it)
+        {
+            if ((*it).ctag == respCtag && (*it).result == 0)
+            {
+                (*it).result = result;
+                break;
+            }
+        }
+    }
+}
+
+// write all commands before reading any response; results[i] is TL1_COMPLD, TL1_DENY or -1
+bool SwitchCtrl_Session_SubnetUNI::pipelineTL1(String* cmds, uint32* ctags, int* results, int num)
+{
+    int i, sent;
+    bool ok = true;
+
+    for (sent = 0; sent < num; sent++)
+        if (!sendTL1(cmds[sent].chars(), ctags[sent]))
+            break;
+
+    for (i = 0; i < num; i++)
+    {
+        results[i] = (i < sent ? waitTL1(ctags[i]) : -1);
+        if (results[i] != TL1_COMPLD)
+            ok = false;
+    }
+    return ok;
+}
+
+// retrieve all entities of the current circuit in one round of RTRV commands;
+// has*_TL1() then answer from the results until the switch session ends
+void SwitchCtrl_Session_SubnetUNI::probeEntities_TL1()
+{
+    static const char* eflowSuffix[4] = {"in", "in_multicast", "out", "out_multicast"};
+    String cmds[8];
+    uint32 ctags[8];
+    uint32 entities[8];
+    int results[8];
+    int i, num = 0;
+
+    entityChecked |= TL1_ENTITY_PROBED;
+    if (!currentVCG.empty())
+    {
+        ctags[num] = getNewCtag();
+        sprintf(bufCmd, "rtrv-vcg::%s:%d;\r", currentVCG.chars(), ctags[num]);
+        cmds[num] = bufCmd;
+        entities[num++] = TL1_ENTITY_VCG;
+        for (i = 0; i < 4; i++)
+        {
+            ctags[num] = getNewCtag();
+            sprintf(bufCmd, "rtrv-eflow::dcs_eflow_%s_%s:%d;", currentVCG.chars(), eflowSuffix[i], ctags[num]);
+            cmds[num] = bufCmd;
+            entities[num++] = (TL1_ENTITY_EFLOW_IN << i);
+        }
+    }
+    if (!currentGTP.empty())
+    {
+        ctags[num] = getNewCtag();
+        sprintf(bufCmd, "rtrv-gtp::%s-1:%d;", currentGTP.chars(), ctags[num]);
+        cmds[num] = bufCmd;
+        entities[num++] = TL1_ENTITY_GTP;
+    }
+    if (!currentSNC.empty())
+    {
+        ctags[num] = getNewCtag();
+        sprintf(bufCmd, "rtrv-snc-stspc::%s-1:%d;", currentSNC.chars(), ctags[num]);
+        cmds[num] = bufCmd;
+        entities[num++] = TL1_ENTITY_SNC;
+    }
+    if (!currentCRS.empty())
+    {
+        ctags[num] = getNewCtag();
+        sprintf(bufCmd, "rtrv-crs-stspc::name=%s-1:%d;", currentCRS.chars(), ctags[num]);
+        cmds[num] = bufCmd;
+        entities[num++] = TL1_ENTITY_CRS;
+    }
+    if (num == 0)
+        return;
+
+    pipelineTL1(cmds, ctags, results, num);
+    for (i = 0; i < num; i++)
+    {
+        if (results[i] > 0)
+        {
+            setEntityCached(entities[i], results[i] == TL1_COMPLD);
+        }
+        else
+        {
+            LOG(5)(Log::MPLS, "LSP=", currentLspName, ": ", "existence checking via TL1_TELNET failed...\n", cmds[i]);
+        }
+    }
+}
+
+//return -1 if the existence of the entity is not known in this switch session
+int SwitchCtrl_Session_SubnetUNI::getEntityCached(uint32 entity)
+{
+    if ((entityChecked & TL1_ENTITY_PROBED) == 0)
+        probeEntities_TL1();
+    if ((entityChecked & entity) == 0)
+        return -1;
+    return ((entityExists & entity) != 0 ? 1 : 0);
+}
+
+//////////////// Pipelined TL1 commands << end //////////////
+
 //rtrv-eqpt::com:234;
 void SwitchCtrl_Session_SubnetUNI::getCienaSoftwareVersion_TL1(String &swVrsn)
 {
@@ -917,12 +1132,17 @@ _out:
 //
 bool SwitchCtrl_Session_SubnetUNI::createEFLOWs_TL1(String& vcgName, int vlanLow, int vlanHigh, int vlanTrunk)
 {
-    int ret = 0;
     char colonPadding[10];
     char packetType[100];
     char modificationRule[100];
     String suppTtp, ettpName;
-
+    String cmds[4];
+    uint32 ctags[4];
+    uint32 entities[4];
+    const char* flowNames[4];
+    int results[4];
+    int i, num = 0;
+    bool ok = true;
 
     String &swVrsn = getCienaSoftwareVersion();
     if (swVrsn.empty())
@@ -964,53 +1184,22 @@ bool SwitchCtrl_Session_SubnetUNI::createEFLOWs_TL1(String& vcgName, int vlanLow
         sprintf(modificationRule+strlen(modificationRule), "tagstoadd=add_none,");
     }
 
+    // the EFLOWs do not depend on each other: all ent-eflow commands are pipelined
+    ctags[num] = getNewCtag();
     sprintf(bufCmd, "ent-eflow::dcs_eflow_%s_in:%d%singressporttype=ettp,ingressportname=%s,%s,egressporttype=vcg,egressportname=%s,cosmapping=cos_port_default,%scollectpm=yes;",
-        vcgName.chars(), getNewCtag(), colonPadding, ettpName.chars(), packetType, vcgName.chars(), modificationRule);
-
-    if ( (ret = writeShell(bufCmd, 5)) < 0 ) goto _out;
-
-    sprintf(strCOMPLD, "M  %d COMPLD", getCurrentCtag());
-    sprintf(strDENY, "M  %d DENY", getCurrentCtag());
-    ret = readShell(strCOMPLD, strDENY, 1, 5);
-    if (ret == 1) 
-    {
-        LOG(6)(Log::MPLS, "LSP=", currentLspName, ": ", vcgName, " Ingress-EFLOW has been created successfully.\n", bufCmd);
-        readShell(SWITCH_PROMPT, NULL, 1, 5);
-        // contine to other EFLOW creation ...
-    }
-    else if (ret == 2)
-    {
-        LOG(6)(Log::MPLS, "LSP=", currentLspName, ": ", vcgName, " Ingress-EFLOW creation has been denied.\n", bufCmd);
-        readShell(SWITCH_PROMPT, NULL, 1, 5);
-        return false;
-    }
-    else 
-        goto _out;
+        vcgName.chars(), ctags[num], colonPadding, ettpName.chars(), packetType, vcgName.chars(), modificationRule);
+    cmds[num] = bufCmd;
+    entities[num] = TL1_ENTITY_EFLOW_IN;
+    flowNames[num++] = " Ingress-EFLOW";
 
     if (strncmp(packetType, "pkttype=untagged", 16) == 0)
     {
+        ctags[num] = getNewCtag();
         sprintf(bufCmd, "ent-eflow::dcs_eflow_%s_in_multicast:%d%singressporttype=ettp,ingressportname=%s,pkttype=untagged_multicast,,,egressporttype=vcg,egressportname=%s,cosmapping=cos_port_default,%scollectpm=yes;",
-            vcgName.chars(), getNewCtag(), colonPadding, ettpName.chars(), vcgName.chars(), modificationRule);
-        if ( (ret = writeShell(bufCmd, 5)) < 0 ) goto _out;
-    
-        sprintf(strCOMPLD, "M  %d COMPLD", getCurrentCtag());
-        sprintf(strDENY, "M  %d DENY", getCurrentCtag());
-        ret = readShell(strCOMPLD, strDENY, 1, 5);
-        if (ret == 1) 
-        {
-            LOG(6)(Log::MPLS, "LSP=", currentLspName, ": ", vcgName, " Ingress-EFLOW (untagged multicast) has been created successfully.\n", bufCmd);
-            readShell(SWITCH_PROMPT, NULL, 1, 5);
-            // contine to other EFLOW creation ...
-        }
-        else if (ret == 2)
-        {
-            LOG(6)(Log::MPLS, "LSP=", currentLspName, ": ", vcgName, " Ingress-EFLOW (untagged multicast) creation has been denied.\n", bufCmd);
-            readShell(SWITCH_PROMPT, NULL, 1, 5);
-            return false;
-        }
-        else 
-            goto _out;
-
+            vcgName.chars(), ctags[num], colonPadding, ettpName.chars(), vcgName.chars(), modificationRule);
+        cmds[num] = bufCmd;
+        entities[num] = TL1_ENTITY_EFLOW_IN_MULTICAST;
+        flowNames[num++] = " Ingress-EFLOW (untagged multicast)";
     }
 
     if (vlanTrunk == 0)
@@ -1038,57 +1227,43 @@ bool SwitchCtrl_Session_SubnetUNI::createEFLOWs_TL1(String& vcgName, int vlanLow
         sprintf(modificationRule+strlen(modificationRule), "tagstoadd=add_none,");
     }
 
+    ctags[num] = getNewCtag();
     sprintf(bufCmd, "ent-eflow::dcs_eflow_%s_out:%d%singressporttype=vcg,ingressportname=%s,%s,egressporttype=ettp,egressportname=%s,cosmapping=cos_port_default,%scollectpm=yes;",
-        vcgName.chars(), getNewCtag(), colonPadding, vcgName.chars(), packetType, ettpName.chars(), modificationRule);
-
-    if ( (ret = writeShell((char*)bufCmd, 5)) < 0 ) goto _out;
+        vcgName.chars(), ctags[num], colonPadding, vcgName.chars(), packetType, ettpName.chars(), modificationRule);
+    cmds[num] = bufCmd;
+    entities[num] = TL1_ENTITY_EFLOW_OUT;
+    flowNames[num++] = " Egress-EFLOW";
 
-    sprintf(strCOMPLD, "M  %d COMPLD", getCurrentCtag());
-    sprintf(strDENY, "M  %d DENY", getCurrentCtag());
-    ret = readShell(strCOMPLD, strDENY, 1, 5);
-    if (ret == 1) 
-    {
-        LOG(6)(Log::MPLS, "LSP=", currentLspName, ": ", vcgName, " Egress-EFLOW has been created successfully.\n", bufCmd);
-        readShell(SWITCH_PROMPT, NULL, 1, 5);
-        if (strncmp(packetType, "pkttype=untagged", 16) != 0)
-            return true;
-        //otherwise, contine to create egress untagged multicast eflow
-    }
-    else if (ret == 2)
+    if (strncmp(packetType, "pkttype=untagged", 16) == 0)
     {
-        LOG(6)(Log::MPLS, "LSP=", currentLspName, ": ", vcgName, " Egress-EFLOW creation has been denied.\n", bufCmd);
-        readShell(SWITCH_PROMPT, NULL, 1, 5);
-        return false;
+        ctags[num] = getNewCtag();
+        sprintf(bufCmd, "ent-eflow::dcs_eflow_%s_out_multicast:%d%singressporttype=vcg,ingressportname=%s,pkttype=untagged_multicast,,,egressporttype=ettp,egressportname=%s,cosmapping=cos_port_default,%scollectpm=yes;",
+            vcgName.chars(), ctags[num], colonPadding, vcgName.chars(), ettpName.chars(), modificationRule);
+        cmds[num] = bufCmd;
+        entities[num] = TL1_ENTITY_EFLOW_OUT_MULTICAST;
+        flowNames[num++] = " Egress-EFLOW (untagged multicast)";
     }
-    else 
-        goto _out;
 
-    if (strncmp(packetType, "pkttype=untagged", 16) == 0)
+    pipelineTL1(cmds, ctags, results, num);
+    for (i = 0; i < num; i++)
     {
-        sprintf(bufCmd, "ent-eflow::dcs_eflow_%s_out_multicast:%d%singressporttype=vcg,ingressportname=%s,pkttype=untagged_multicast,,,egressporttype=ettp,egressportname=%s,cosmapping=cos_port_default,%scollectpm=yes;",
-            vcgName.chars(), getNewCtag(), colonPadding, vcgName.chars(), ettpName.chars(), modificationRule);
-    
-        if ( (ret = writeShell((char*)bufCmd, 5)) < 0 ) goto _out;
-    
-        sprintf(strCOMPLD, "M  %d COMPLD", getCurrentCtag());
-        sprintf(strDENY, "M  %d DENY", getCurrentCtag());
-        ret = readShell(strCOMPLD, strDENY, 1, 5);
-        if (ret == 1) 
+        if (results[i] == TL1_COMPLD) 
         {
-            LOG(6)(Log::MPLS, "LSP=", currentLspName, ": ", vcgName, " Egress-EFLOW (untagged multicast) has been created successfully.\n", bufCmd);
-            readShell(SWITCH_PROMPT, NULL, 1, 5);
-            // done!
-            return true;
+            LOG(7)(Log::MPLS, "LSP=", currentLspName, ": ", vcgName, flowNames[i], " has been created successfully.\n", cmds[i]);
+            setEntityCached(entities[i], true);
         }
-        else if (ret == 2)
+        else if (results[i] == TL1_DENY)
         {
-            LOG(6)(Log::MPLS, "LSP=", currentLspName, ": ", vcgName, " Egress-EFLOW (untagged multicast) creation has been denied.\n", bufCmd);
-            readShell(SWITCH_PROMPT, NULL, 1, 5);
-            return false;
+            LOG(7)(Log::MPLS, "LSP=", currentLspName, ": ", vcgName, flowNames[i], " creation has been denied.\n", cmds[i]);
+            ok = false;
         }
         else 
-            goto _out;
+        {
+            LOG(7)(Log::MPLS, "LSP=", currentLspName, ": ", vcgName, flowNames[i], " creation via TL1_TELNET failed...\n", cmds[i]);
+            ok = false;
+        }
     }
+    return ok;
 
 _out:
         LOG(6)(Log::MPLS, "LSP=", currentLspName, ": ", vcgName, " EFLOWs creation via TL1_TELNET failed...\n", bufCmd);
@@ -1098,107 +1273,64 @@ _out:
 //dlt-elow::myeflow1:myctag;
 bool SwitchCtrl_Session_SubnetUNI::deleteEFLOWs_TL1(String& vcgName, bool hasIngressUntaggedMulticast, bool hasEgressUntaggedMulticast)
 {
-    int ret = 0;
+    String cmds[4];
+    uint32 ctags[4];
+    uint32 entities[4];
+    const char* flowNames[4];
+    int results[4];
+    int i, num = 0;
+    bool ok = true;
+
+    ctags[num] = getNewCtag();
+    sprintf(bufCmd, "dlt-eflow::dcs_eflow_%s_in:%d;", vcgName.chars(), ctags[num]);
+    cmds[num] = bufCmd;
+    entities[num] = TL1_ENTITY_EFLOW_IN;
+    flowNames[num++] = " Ingress-EFLOW";
+
+    ctags[num] = getNewCtag();
+    sprintf(bufCmd, "dlt-eflow::dcs_eflow_%s_out:%d;", vcgName.chars(), ctags[num]);
+    cmds[num] = bufCmd;
+    entities[num] = TL1_ENTITY_EFLOW_OUT;
+    flowNames[num++] = " Egress-EFLOW";
 
-    sprintf(bufCmd, "dlt-eflow::dcs_eflow_%s_in:%d;", vcgName.chars(), getNewCtag());
-
-    if ( (ret = writeShell((char*)bufCmd, 5)) < 0 ) goto _out;
-
-    sprintf(strCOMPLD, "M  %d COMPLD", getCurrentCtag());
-    sprintf(strDENY, "M  %d DENY", getCurrentCtag());
-    ret = readShell(strCOMPLD, strDENY, 1, 5);
-    if (ret == 1) 
-    {
-        LOG(6)(Log::MPLS, "LSP=", currentLspName, ": ", vcgName, " Ingress-EFLOW has been deleted successfully.\n", bufCmd);
-        readShell(SWITCH_PROMPT, NULL, 1, 5);
-        // contine to delete other eflows
-    }
-    else if (ret == 2)
+    if (hasIngressUntaggedMulticast)
     {
-        LOG(6)(Log::MPLS, "LSP=", currentLspName, ": ", vcgName, " Ingress-EFLOW deletion has been denied.\n", bufCmd);
-        readShell(SWITCH_PROMPT, NULL, 1, 5);
-        return false;
+        ctags[num] = getNewCtag();
+        sprintf(bufCmd, "dlt-eflow::dcs_eflow_%s_in_multicast:%d;", vcgName.chars(), ctags[num]);
+        cmds[num] = bufCmd;
+        entities[num] = TL1_ENTITY_EFLOW_IN_MULTICAST;
+        flowNames[num++] = " Ingress-EFLOW (untagged multicast)";
     }
-    else 
-        goto _out;
-
-    sprintf(bufCmd, "dlt-eflow::dcs_eflow_%s_out:%d;", vcgName.chars(), getNewCtag());
 
-    if ( (ret = writeShell((char*)bufCmd, 5)) < 0 ) goto _out;
-
-    sprintf(strCOMPLD, "M  %d COMPLD", getCurrentCtag());
-    sprintf(strDENY, "M  %d DENY", getCurrentCtag());
-    ret = readShell(strCOMPLD, strDENY, 1, 5);
-    if (ret == 1) 
+    if (hasEgressUntaggedMulticast)
     {
-        LOG(6)(Log::MPLS, "LSP=", currentLspName, ": ", vcgName, " Egress-EFLOW has been deleted successfully.\n", bufCmd);
-        readShell(SWITCH_PROMPT, NULL, 1, 5);
-        if (!hasIngressUntaggedMulticast&&!hasEgressUntaggedMulticast)
-            return true;
-        //otherwise continue to delete other eflows
+        ctags[num] = getNewCtag();
+        sprintf(bufCmd, "dlt-eflow::dcs_eflow_%s_out_multicast:%d;", vcgName.chars(), ctags[num]);
+        cmds[num] = bufCmd;
+        entities[num] = TL1_ENTITY_EFLOW_OUT_MULTICAST;
+        flowNames[num++] = " Egress-EFLOW (untagged multicast)";
     }
-    else if (ret == 2)
-    {
-        LOG(6)(Log::MPLS, "LSP=", currentLspName, ": ", vcgName, " Egress-EFLOW deletion has been denied.\n", bufCmd);
-        readShell(SWITCH_PROMPT, NULL, 1, 5);
-        return false;
-    }
-    else 
-        goto _out;
 
-    if (hasIngressUntaggedMulticast)
+    pipelineTL1(cmds, ctags, results, num);
+    for (i = 0; i < num; i++)
     {
-        sprintf(bufCmd, "dlt-eflow::dcs_eflow_%s_in_multicast:%d;", vcgName.chars(), getNewCtag());
-       
-        if ( (ret = writeShell((char*)bufCmd, 5)) < 0 ) goto _out;
-       
-        sprintf(strCOMPLD, "M  %d COMPLD", getCurrentCtag());
-        sprintf(strDENY, "M  %d DENY", getCurrentCtag());
-        ret = readShell(strCOMPLD, strDENY, 1, 5);
-        if (ret == 1) 
+        if (results[i] == TL1_COMPLD) 
         {
-            LOG(6)(Log::MPLS, "LSP=", currentLspName, ": ", vcgName, " Ingress-EFLOW (untagged multicast) has been deleted successfully.\n", bufCmd);
-            readShell(SWITCH_PROMPT, NULL, 1, 5);
-            // contine to egress untagged multicast EFLOW creation ...
+            LOG(7)(Log::MPLS, "LSP=", currentLspName, ": ", vcgName, flowNames[i], " has been deleted successfully.\n", cmds[i]);
+            setEntityCached(entities[i], false);
         }
-        else if (ret == 2)
+        else if (results[i] == TL1_DENY)
         {
-            LOG(6)(Log::MPLS, "LSP=", currentLspName, ": ", vcgName, " Ingress-EFLOW (untagged multicast) deletion has been denied.\n", bufCmd);
-            readShell(SWITCH_PROMPT, NULL, 1, 5);
-            return false;
+            LOG(7)(Log::MPLS, "LSP=", currentLspName, ": ", vcgName, flowNames[i], " deletion has been denied.\n", cmds[i]);
+            ok = false;
         }
         else 
-            goto _out;
-    }
-
-    if (hasEgressUntaggedMulticast)
-    {
-        sprintf(bufCmd, "dlt-eflow::dcs_eflow_%s_out_multicast:%d;", vcgName.chars(), getNewCtag());
-    
-        if ( (ret = writeShell((char*)bufCmd, 5)) < 0 ) goto _out;
-    
-        sprintf(strCOMPLD, "M  %d COMPLD", getCurrentCtag());
-        sprintf(strDENY, "M  %d DENY", getCurrentCtag());
-        ret = readShell(strCOMPLD, strDENY, 1, 5);
-        if (ret == 1) 
         {
-            LOG(6)(Log::MPLS, "LSP=", currentLspName, ": ", vcgName, " Egress-EFLOW (untagged multicast) has been deleted successfully.\n", bufCmd);
-            readShell(SWITCH_PROMPT, NULL, 1, 5);
-            return true;
+            LOG(7)(Log::MPLS, "LSP=", currentLspName, ": ", vcgName, flowNames[i], " deletion via TL1_TELNET failed...\n", cmds[i]);
+            ok = false;
         }
-        else if (ret == 2)
-        {
-            LOG(6)(Log::MPLS, "LSP=", currentLspName, ": ", vcgName, " Egress-EFLOW (untagged multicast) deletion has been denied.\n", bufCmd);
-            readShell(SWITCH_PROMPT, NULL, 1, 5);
-            return false;
-        }
-        else 
-            goto _out;
     }
-
-_out:
-        LOG(6)(Log::MPLS, "LSP=", currentLspName, ": ", vcgName, " EFLOWs deletion via TL1_TELNET failed...\n", bufCmd);
-        return false;
+    return ok;
 }
 
 //rtrv-eflow::myeflow1:myctag;
@@ -1206,6 +1338,12 @@ bool SwitchCtrl_Session_SubnetUNI::hasEFLOW_TL1(String& vcgName, bool ingress, b
 {
     int ret = 0;
 
+    if (vcgName == currentVCG && (ret = getEntityCached(TL1_ENTITY_EFLOW_IN << ((ingress ? 0 : 2) + (untaggedMulticast ? 1 : 0)))) >= 0)
+    {
+        LOG(5)(Log::MPLS, "LSP=", currentLspName, ": ", vcgName, (ret == 1 ? " does exist (cached).\n" : " does not exist (cached).\n"));
+        return (ret == 1);
+    }
+
     sprintf(bufCmd, "rtrv-eflow::dcs_eflow_%s_%s%s:%d;", vcgName.chars(), ingress? "in":"out", untaggedMulticast? "_multicast":"", getNewCtag());
 
     if ( (ret = writeShell((char*)bufCmd, 5)) < 0 ) goto _out;
@@ -1285,6 +1423,7 @@ bool SwitchCtrl_Session_SubnetUNI::createVCG_TL1(String& vcgName, bool tunnelMod
     {
         LOG(6)(Log::MPLS, "LSP=", currentLspName, ": ", vcgName, " has been created successfully.\n", cmdString);
         readShell(SWITCH_PROMPT, NULL, 1, 5);
+        setEntityCached(TL1_ENTITY_VCG, true);
         return true;
     }
     else if (ret == 2)
@@ -1344,6 +1483,7 @@ bool SwitchCtrl_Session_SubnetUNI::deleteVCG_TL1(String& vcgName)
     {
         LOG(6)(Log::MPLS, "LSP=", currentLspName, ": ", vcgName, " has been deleted successfully.\n", bufCmd);
         readShell(SWITCH_PROMPT, NULL, 1, 5);
+        setEntityCached(TL1_ENTITY_VCG, false);
         return true;
     }
     else if (ret == 2)
@@ -1364,6 +1504,12 @@ bool SwitchCtrl_Session_SubnetUNI::hasVCG_TL1(String& vcgName)
 {
     int ret = 0;
 
+    if (vcgName == currentVCG && (ret = getEntityCached(TL1_ENTITY_VCG)) >= 0)
+    {
+        LOG(5)(Log::MPLS, "LSP=", currentLspName, ": ", vcgName, (ret == 1 ? " does exist (cached).\n" : " does not exist (cached).\n"));
+        return (ret == 1);
+    }
+
     sprintf( bufCmd, "rtrv-vcg::%s:%d;\r", vcgName.chars(), getNewCtag() );
     if ( (ret = writeShell(bufCmd, 5)) < 0 ) goto _out;
 
@@ -1393,7 +1539,6 @@ _out:
 //;ENT-GTP::gtp1:123::lbl=label,,ctp=vcg01-CTP-1&vcg01-CTP-2&vcg01-CTP-3&vcg01-CTP-4;
 bool SwitchCtrl_Session_SubnetUNI::createGTP_TL1(String& gtpName, String& vcgName)
 {
-    int ret = 0;
     char ctag[10];
     sprintf(ctag, "%d", getNewCtag());
     gtpName = "dcs_gtp_";
@@ -1409,81 +1554,98 @@ bool SwitchCtrl_Session_SubnetUNI::createGTP_TL1(String& gtpName, String& vcgNam
         return false;
     }
 
+    String cmds[4];
+    uint32 ctags[4];
+    int results[4];
     int group;
+    bool ok = true;
     for (group = 0; group < numGroups; group++)
     {
         assert(!ctpGroupStringArray[group].empty());
 
-        sprintf( bufCmd, "ent-gtp::%s-%d:%s::lbl=gtp-%s,,ctp=%s;", gtpName.chars(), group+1, ctag, vcgName.chars(), ctpGroupStringArray[group].chars() );
-
-        if ( (ret = writeShell(bufCmd, 5)) < 0 ) goto _out;
+        ctags[group] = getNewCtag();
+        sprintf( bufCmd, "ent-gtp::%s-%d:%d::lbl=gtp-%s,,ctp=%s;", gtpName.chars(), group+1, ctags[group], vcgName.chars(), ctpGroupStringArray[group].chars() );
+        cmds[group] = bufCmd;
+    }
 
-        sprintf(strCOMPLD, "M  %d COMPLD", getCurrentCtag());
-        sprintf(strDENY, "M  %d DENY", getCurrentCtag());
-        ret = readShell(strCOMPLD, strDENY, 1, 5);
-        if (ret == 1) 
+    pipelineTL1(cmds, ctags, results, numGroups);
+    for (group = 0; group < numGroups; group++)
+    {
+        if (results[group] == TL1_COMPLD) 
         {
-            LOG(8)(Log::MPLS, "LSP=", currentLspName, ": ", gtpName, "-", group+1, " has been created successfully.\n", bufCmd);
-            readShell(SWITCH_PROMPT, NULL, 1, 5);
+            LOG(8)(Log::MPLS, "LSP=", currentLspName, ": ", gtpName, "-", group+1, " has been created successfully.\n", cmds[group]);
         }
-        else if (ret == 2)
+        else if (results[group] == TL1_DENY)
         {
-            LOG(8)(Log::MPLS, "LSP=", currentLspName, ": ", gtpName, "-", group+1, " creation has been denied.\n", bufCmd);
-            readShell(SWITCH_PROMPT, NULL, 1, 5);
-            gtpName = "";
-            return false;
+            LOG(8)(Log::MPLS, "LSP=", currentLspName, ": ", gtpName, "-", group+1, " creation has been denied.\n", cmds[group]);
+            ok = false;
         }
         else 
-            goto _out;
+        {
+            LOG(8)(Log::MPLS, "LSP=", currentLspName, ": ", gtpName, "-", group+1, " creation via TL1_TELNET failed...\n", cmds[group]);
+            ok = false;
+        }
     }
 
+    if (!ok)
+    {
+        gtpName = "";
+        return false;
+    }
+    setEntityCached(TL1_ENTITY_GTP, true);
     return true;
-    
-_out:
-    LOG(8)(Log::MPLS, "LSP=", currentLspName, ": ", gtpName, "-", group+1, " creation via TL1_TELNET failed...\n", bufCmd);
-    gtpName = "";
-    return false;    
 }
 
 //;DLT-GTP::gtp1:123;
 bool SwitchCtrl_Session_SubnetUNI::deleteGTP_TL1(String& gtpName)
 {
-    int ret = 0;
+    String cmds[4];
+    uint32 ctags[4];
+    int results[4];
     int group;
+    bool ok = true;
+
     for (group = 0; group < numGroups; group++)
     {
-        sprintf( bufCmd, "dlt-gtp::%s-%d:%d;", gtpName.chars(), group+1, getNewCtag() );
-        if ( (ret = writeShell(bufCmd, 5)) < 0 ) goto _out;
+        ctags[group] = getNewCtag();
+        sprintf( bufCmd, "dlt-gtp::%s-%d:%d;", gtpName.chars(), group+1, ctags[group] );
+        cmds[group] = bufCmd;
+    }
 
-        sprintf(strCOMPLD, "M  %d COMPLD", getCurrentCtag());
-        sprintf(strDENY, "M  %d DENY", getCurrentCtag());
-        ret = readShell(strCOMPLD, strDENY, 1, 5);
-        if (ret == 1) 
+    pipelineTL1(cmds, ctags, results, numGroups);
+    for (group = 0; group < numGroups; group++)
+    {
+        if (results[group] == TL1_COMPLD) 
         {
-            LOG(8)(Log::MPLS, "LSP=", currentLspName, ": ", gtpName, "-", group+1, " has been deleted successfully.\n", bufCmd);
-            readShell(SWITCH_PROMPT, NULL, 1, 5);
+            LOG(8)(Log::MPLS, "LSP=", currentLspName, ": ", gtpName, "-", group+1, " has been deleted successfully.\n", cmds[group]);
         }
-        else if (ret == 2)
+        else if (results[group] == TL1_DENY)
         {
-            LOG(8)(Log::MPLS, "LSP=", currentLspName, ": ", gtpName, "-", group+1, " deletion has been denied.\n", bufCmd);
-            readShell(SWITCH_PROMPT, NULL, 1, 5);
-            return false;
+            LOG(8)(Log::MPLS, "LSP=", currentLspName, ": ", gtpName, "-", group+1, " deletion has been denied.\n", cmds[group]);
+            ok = false;
         }
         else 
-            goto _out;
+        {
+            LOG(8)(Log::MPLS, "LSP=", currentLspName, ": ", gtpName, "-", group+1, " deletion via TL1_TELNET failed...\n", cmds[group]);
+            ok = false;
+        }
     }
 
-    return true;
-
-_out:
-    LOG(8)(Log::MPLS, "LSP=", currentLspName, ": ", gtpName, "-", group+1, " deletion via TL1_TELNET failed...\n", bufCmd);
-    return false;    
+    if (ok)
+        setEntityCached(TL1_ENTITY_GTP, false);
+    return ok;
 }
 
 bool SwitchCtrl_Session_SubnetUNI::hasGTP_TL1(String& gtpName)
 {
     int ret = 0;
 
+    if (gtpName == currentGTP && (ret = getEntityCached(TL1_ENTITY_GTP)) >= 0)
+    {
+        LOG(5)(Log::MPLS, "LSP=", currentLspName, ": ", gtpName, (ret == 1 ? " does exist (cached).\n" : " does not exist (cached).\n"));
+        return (ret == 1);
+    }
+
     //only checking the first group if more than one.
     sprintf( bufCmd, "rtrv-gtp::%s-1:%d;", gtpName.chars(), getNewCtag() );
     if ( (ret = writeShell(bufCmd, 5)) < 0 ) goto _out;
@@ -1516,6 +1678,11 @@ bool SwitchCtrl_Session_SubnetUNI::createSNC_TL1(String& sncName, String& gtpNam
 {
     int ret = 0;
     char ctag[10];
+    String cmds[4];
+    uint32 ctags[4];
+    int results[4];
+    int group;
+    bool ok = true;
 
     sprintf(ctag, "%d", getNewCtag());
     sncName = "dcs_snc_";
@@ -1599,7 +1766,6 @@ bool SwitchCtrl_Session_SubnetUNI::createSNC_TL1(String& sncName, String& gtpNam
         }
     }
 
-    int group;
     for (group = 0; group < numGroups; group++)
     {
         char dtl_cstr[40];
@@ -1615,38 +1781,45 @@ bool SwitchCtrl_Session_SubnetUNI::createSNC_TL1(String& sncName, String& gtpNam
         {
             sprintf(supptptype_cstr,"supptptype=sttp,");
         }
-        sprintf( bufCmd, "ent-snc-stspc:%s:%s-%d,%s:%s::name=%s-%d,type=dynamic,rmnode=%s,%slep=gtp_nametype,alias=%s,%sconndir=bi_direction,meshrst=no,prtt=aps_vlsr_unprotected,pst=is;",
-            (const char*)subnetUniSrc.node_name, gtpName.chars(), group+1, destTimeslotsStringArray[group].chars(), ctag, sncName.chars(), group+1, 
+        //each group gets a CTAG of its own so that the pipelined responses can be told apart
+        ctags[group] = getNewCtag();
+        sprintf( bufCmd, "ent-snc-stspc:%s:%s-%d,%s:%d::name=%s-%d,type=dynamic,rmnode=%s,%slep=gtp_nametype,alias=%s,%sconndir=bi_direction,meshrst=no,prtt=aps_vlsr_unprotected,pst=is;",
+            (const char*)subnetUniSrc.node_name, gtpName.chars(), group+1, destTimeslotsStringArray[group].chars(), ctags[group], sncName.chars(), group+1, 
                 (const char*)subnetUniDest.node_name, supptptype_cstr, currentLspName.chars(), dtl_cstr);
+        cmds[group] = bufCmd;
+    }
 
-        if ( (ret = writeShell(bufCmd, 5)) < 0 ) goto _out;
-
-        sprintf(strCOMPLD, "M  %s COMPLD", ctag);
-        sprintf(strDENY, "M  %s DENY", ctag);
-        ret = readShell(strCOMPLD, strDENY, 1, 5);
-        if (ret == 1) 
+    pipelineTL1(cmds, ctags, results, numGroups);
+    for (group = 0; group < numGroups; group++)
+    {
+        if (results[group] == TL1_COMPLD) 
         {
-            LOG(8)(Log::MPLS, "LSP=", currentLspName, ": ", sncName, "-", group+1, " has been created successfully.\n", bufCmd);
-            readShell(SWITCH_PROMPT, NULL, 1, 5);
+            LOG(8)(Log::MPLS, "LSP=", currentLspName, ": ", sncName, "-", group+1, " has been created successfully.\n", cmds[group]);
         }
-        else if (ret == 2)
+        else if (results[group] == TL1_DENY)
         {
-            LOG(8)(Log::MPLS, "LSP=", currentLspName, ": ", sncName, "-", group+1, " creation has been denied.\n", bufCmd);
-            readShell(SWITCH_PROMPT, NULL, 1, 5);
-
-            // TODO: dlt-snc for other groups; dlt-dlt-set:: ; dlt-dlt::
-
-            sncName = "";
-            return false;
+            LOG(8)(Log::MPLS, "LSP=", currentLspName, ": ", sncName, "-", group+1, " creation has been denied.\n", cmds[group]);
+            ok = false;
         }
         else 
-            goto _out;
+        {
+            LOG(8)(Log::MPLS, "LSP=", currentLspName, ": ", sncName, "-", group+1, " creation via TL1_TELNET failed...\n", cmds[group]);
+            ok = false;
+        }
     }
 
+    if (!ok)
+    {
+        // TODO: dlt-snc for other groups; dlt-dlt-set:: ; dlt-dlt::
+
+        sncName = "";
+        return false;
+    }
+    setEntityCached(TL1_ENTITY_SNC, true);
     return true;
 
 _out:
-    LOG(8)(Log::MPLS, "LSP=", currentLspName, ": ", sncName, "-", group+1, " creation via TL1_TELNET failed...\n", bufCmd);
+    LOG(6)(Log::MPLS, "LSP=", currentLspName, ": ", sncName, " DTL creation via TL1_TELNET failed...\n", bufCmd);
     sncName = "";
     return false;    
 }
@@ -1657,54 +1830,69 @@ bool SwitchCtrl_Session_SubnetUNI::deleteSNC_TL1(String& sncName)
 {
     int ret = 0;
     String dtlString;
-
+    String cmds[4];
+    uint32 ctags[4];
+    int results[4];
     int group;
+    bool ok = true;
+
     for (group = 0; group < numGroups; group++)
     {
-        sprintf( bufCmd, "ed-snc-stspc::%s-%d:%d::,pst=oos;", sncName.chars(), group+1, getNewCtag() );
-        if ( (ret = writeShell(bufCmd, 5)) < 0 ) goto _out;
+        ctags[group] = getNewCtag();
+        sprintf( bufCmd, "ed-snc-stspc::%s-%d:%d::,pst=oos;", sncName.chars(), group+1, ctags[group] );
+        cmds[group] = bufCmd;
+    }
 
-        sprintf(strCOMPLD, "M  %d COMPLD", getCurrentCtag());
-        sprintf(strDENY, "M  %d DENY", getCurrentCtag());
-        ret = readShell(strCOMPLD, strDENY, 1, 5);
-        if (ret == 1) 
+    pipelineTL1(cmds, ctags, results, numGroups);
+    for (group = 0; group < numGroups; group++)
+    {
+        if (results[group] == TL1_COMPLD) 
         {
-            LOG(8)(Log::MPLS, "LSP=", currentLspName, ": ", sncName, "-", group+1, " state has been changed into OOS.\n", bufCmd);
-            readShell(SWITCH_PROMPT, NULL, 1, 5);
-            //continue to next command ...
+            LOG(8)(Log::MPLS, "LSP=", currentLspName, ": ", sncName, "-", group+1, " state has been changed into OOS.\n", cmds[group]);
         }
-        else if (ret == 2)
+        else if (results[group] == TL1_DENY)
         {
-            LOG(8)(Log::MPLS, "LSP=", currentLspName, ": ", sncName, "-", group+1, " state change to OOS has been denied.\n", bufCmd);
-            readShell(SWITCH_PROMPT, NULL, 1, 5);
-            return false;
+            LOG(8)(Log::MPLS, "LSP=", currentLspName, ": ", sncName, "-", group+1, " state change to OOS has been denied.\n", cmds[group]);
+            ok = false;
         }
         else 
-            goto _out;
+        {
+            LOG(8)(Log::MPLS, "LSP=", currentLspName, ": ", sncName, "-", group+1, " change via TL1_TELNET failed...\n", cmds[group]);
+            ok = false;
+        }
+    }
+    if (!ok)
+        return false;
 
-        // sleep 7 second to let finish status change into OOS  
-        sleep(7);
+    // sleep 7 second to let finish status change into OOS (once for all groups)
+    sleep(7);
 
-        sprintf( bufCmd, "dlt-snc-stspc::%s-%d:%d;", sncName.chars(), group+1, getNewCtag() );
-        if ( (ret = writeShell(bufCmd, 5)) < 0 ) goto _out;
+    for (group = 0; group < numGroups; group++)
+    {
+        ctags[group] = getNewCtag();
+        sprintf( bufCmd, "dlt-snc-stspc::%s-%d:%d;", sncName.chars(), group+1, ctags[group] );
+        cmds[group] = bufCmd;
+    }
 
-        sprintf(strCOMPLD, "M  %d COMPLD", getCurrentCtag());
-        sprintf(strDENY, "M  %d DENY", getCurrentCtag());
-        ret = readShell(strCOMPLD, strDENY, 1, 5);
-        if (ret == 1) 
+    pipelineTL1(cmds, ctags, results, numGroups);
+    for (group = 0; group < numGroups; group++)
+    {
+        if (results[group] == TL1_COMPLD) 
         {
-            LOG(8)(Log::MPLS, "LSP=", currentLspName, ": ", sncName, "-", group+1, " has been deleted successfully.\n", bufCmd);
-            readShell(SWITCH_PROMPT, NULL, 1, 5);
+            LOG(8)(Log::MPLS, "LSP=", currentLspName, ": ", sncName, "-", group+1, " has been deleted successfully.\n", cmds[group]);
         }
-        else if (ret == 2)
+        else if (results[group] == TL1_DENY)
         {
-            LOG(8)(Log::MPLS, "LSP=", currentLspName, ": ", sncName, "-", group+1, " deletion has been denied.\n", bufCmd);
-            readShell(SWITCH_PROMPT, NULL, 1, 5);
+            LOG(8)(Log::MPLS, "LSP=", currentLspName, ": ", sncName, "-", group+1, " deletion has been denied.\n", cmds[group]);
             //continue to delete dtl-set
         }
         else 
-            goto _out;
+        {
+            LOG(8)(Log::MPLS, "LSP=", currentLspName, ": ", sncName, "-", group+1, " deletion via TL1_TELNET failed...\n", cmds[group]);
+            return false;
+        }
     }
+    setEntityCached(TL1_ENTITY_SNC, false);
 
     getDTLString(dtlString);
     if (!dtlString.empty())
@@ -1759,7 +1947,7 @@ bool SwitchCtrl_Session_SubnetUNI::deleteSNC_TL1(String& sncName)
     return true;
 
 _out:
-    LOG(8)(Log::MPLS, "LSP=", currentLspName, ": ", sncName, "-", group+1, " change/deletion via TL1_TELNET failed...\n", bufCmd);
+    LOG(6)(Log::MPLS, "LSP=", currentLspName, ": ", sncName, " DTL deletion via TL1_TELNET failed...\n", bufCmd);
     return false;    
 }
 
@@ -1767,6 +1955,12 @@ bool SwitchCtrl_Session_SubnetUNI::hasSNC_TL1(String& sncName)
 {
     int ret = 0;
 
+    if (sncName == currentSNC && (ret = getEntityCached(TL1_ENTITY_SNC)) >= 0)
+    {
+        LOG(5)(Log::MPLS, "LSP=", currentLspName, ": ", sncName, (ret == 1 ? " does exist (cached).\n" : " does not exist (cached).\n"));
+        return (ret == 1);
+    }
+
     //only checking the first SNC if more than one SNCs are created for the LSP.
     sprintf( bufCmd, "rtrv-snc-stspc::%s-1:%d;", sncName.chars(), getNewCtag() );
     if ( (ret = writeShell(bufCmd, 5)) < 0 ) goto _out;
@@ -1851,7 +2045,6 @@ _out:
 //;ent-crs-stspc::fromendpoint=gtp01,toendpoint=gtp02:myctag::name=crs01,fromtype=gtp,totype=gtp,;
 bool SwitchCtrl_Session_SubnetUNI::createCRS_TL1(String& crsName, String& gtpName)
 {
-    int ret = 0;
     char ctag[10];
 
     sprintf(ctag, "%d", getNewCtag());
@@ -1868,98 +2061,111 @@ bool SwitchCtrl_Session_SubnetUNI::createCRS_TL1(String& crsName, String& gtpNam
         return false;
     }
 
+    String cmds[4];
+    uint32 ctags[4];
+    int results[4];
     int group;
+    bool ok = true;
     for (group = 0; group < numGroups; group++)
     {
-        sprintf( bufCmd, "ent-crs-stspc::fromendpoint=%s-%d,toendpoint=%s-%d:%s::name=%s-%d,fromtype=gtp,totype=gtp, alias=%s;",
-            gtpName.chars(), group+1, destGtpName.chars(), group+1, ctag, crsName.chars(), group+1, currentLspName.chars());
-
-        if ( (ret = writeShell(bufCmd, 5)) < 0 ) goto _out;
+        ctags[group] = getNewCtag();
+        sprintf( bufCmd, "ent-crs-stspc::fromendpoint=%s-%d,toendpoint=%s-%d:%d::name=%s-%d,fromtype=gtp,totype=gtp, alias=%s;",
+            gtpName.chars(), group+1, destGtpName.chars(), group+1, ctags[group], crsName.chars(), group+1, currentLspName.chars());
+        cmds[group] = bufCmd;
+    }
 
-        sprintf(strCOMPLD, "M  %d COMPLD", getCurrentCtag());
-        sprintf(strDENY, "M  %d DENY", getCurrentCtag());
-        ret = readShell(strCOMPLD, strDENY, 1, 5);
-        if (ret == 1) 
+    pipelineTL1(cmds, ctags, results, numGroups);
+    for (group = 0; group < numGroups; group++)
+    {
+        if (results[group] == TL1_COMPLD) 
         {
-            LOG(8)(Log::MPLS, "LSP=", currentLspName, ": ", crsName, "-", group+1, " has been created successfully.\n", bufCmd);
-            readShell(SWITCH_PROMPT, NULL, 1, 5);
+            LOG(8)(Log::MPLS, "LSP=", currentLspName, ": ", crsName, "-", group+1, " has been created successfully.\n", cmds[group]);
         }
-        else if (ret == 2)
+        else if (results[group] == TL1_DENY)
         {
-            LOG(8)(Log::MPLS, "LSP=", currentLspName, ": ", crsName, "-", group+1, " creation has been denied.\n", bufCmd);
-            readShell(SWITCH_PROMPT, NULL, 1, 5);
-            crsName = "";
-            return false;
+            LOG(8)(Log::MPLS, "LSP=", currentLspName, ": ", crsName, "-", group+1, " creation has been denied.\n", cmds[group]);
+            ok = false;
         }
         else 
-            goto _out;
+        {
+            LOG(8)(Log::MPLS, "LSP=", currentLspName, ": ", crsName, "-", group+1, " creation via TL1_TELNET failed...\n", cmds[group]);
+            ok = false;
+        }
     }
 
+    if (!ok)
+    {
+        crsName = "";
+        return false;
+    }
+    setEntityCached(TL1_ENTITY_CRS, true);
     return true;
-
-_out:
-    LOG(8)(Log::MPLS, "LSP=", currentLspName, ": ", crsName, "-", group+1, " creation via TL1_TELNET failed...\n", bufCmd);
-    crsName = "";
-    return false;
 }
 
 bool SwitchCtrl_Session_SubnetUNI::deleteCRS_TL1(String& crsName)
 {
-    int ret = 0;
-
+    String cmds[4];
+    uint32 ctags[4];
+    int results[4];
     int group;
+
     for (group = 0; group < numGroups; group++)
     {
-        sprintf( bufCmd, "ed-crs-stspc::name=%s-%d:%d::,pst=oos;", crsName.chars(), group+1, getNewCtag() );
-        if ( (ret = writeShell(bufCmd, 5)) < 0 ) goto _out;
+        ctags[group] = getNewCtag();
+        sprintf( bufCmd, "ed-crs-stspc::name=%s-%d:%d::,pst=oos;", crsName.chars(), group+1, ctags[group] );
+        cmds[group] = bufCmd;
+    }
 
-        sprintf(strCOMPLD, "M  %d COMPLD", getCurrentCtag());
-        sprintf(strDENY, "M  %d DENY", getCurrentCtag());
-        ret = readShell(strCOMPLD, strDENY, 1, 5);
-        if (ret == 1) 
+    pipelineTL1(cmds, ctags, results, numGroups);
+    for (group = 0; group < numGroups; group++)
+    {
+        if (results[group] == TL1_COMPLD) 
         {
-            LOG(8)(Log::MPLS, "LSP=", currentLspName, ": ", crsName, "-", group+1, " state has been changed into OOS.\n", bufCmd);
-            readShell(SWITCH_PROMPT, NULL, 1, 5);
-            //continue to next command ...
+            LOG(8)(Log::MPLS, "LSP=", currentLspName, ": ", crsName, "-", group+1, " state has been changed into OOS.\n", cmds[group]);
         }
-        else if (ret == 2)
+        else if (results[group] == TL1_DENY)
         {
-            LOG(8)(Log::MPLS, "LSP=", currentLspName, ": ", crsName, "-", group+1, " state change to OOS has been denied.\n", bufCmd);
-            readShell(SWITCH_PROMPT, NULL, 1, 5);
+            LOG(8)(Log::MPLS, "LSP=", currentLspName, ": ", crsName, "-", group+1, " state change to OOS has been denied.\n", cmds[group]);
             return false;
         }
         else 
-            goto _out;
+        {
+            LOG(8)(Log::MPLS, "LSP=", currentLspName, ": ", crsName, "-", group+1, " change via TL1_TELNET failed...\n", cmds[group]);
+            return false;
+        }
+    }
 
-        sprintf( bufCmd, "dlt-crs-stspc::name=%s-%d:%d;", crsName.chars(), group+1, getNewCtag() );
-        if ( (ret = writeShell(bufCmd, 5)) < 0 ) goto _out;
+    for (group = 0; group < numGroups; group++)
+    {
+        ctags[group] = getNewCtag();
+        sprintf( bufCmd, "dlt-crs-stspc::name=%s-%d:%d;", crsName.chars(), group+1, ctags[group] );
+        cmds[group] = bufCmd;
+    }
 
-        sprintf(strCOMPLD, "M  %d COMPLD", getCurrentCtag());
-        sprintf(strDENY, "M  %d DENY", getCurrentCtag());
-        ret = readShell(strCOMPLD, strDENY, 1, 5);
-        if (ret == 1) 
+    pipelineTL1(cmds, ctags, results, numGroups);
+    for (group = 0; group < numGroups; group++)
+    {
+        if (results[group] == TL1_COMPLD) 
         {
-            LOG(8)(Log::MPLS, "LSP=", currentLspName, ": ", crsName, "-", group+1, " has been deleted successfully.\n", bufCmd);
-            readShell(SWITCH_PROMPT, NULL, 1, 5);
+            LOG(8)(Log::MPLS, "LSP=", currentLspName, ": ", crsName, "-", group+1, " has been deleted successfully.\n", cmds[group]);
         }
-        else if (ret == 2)
+        else if (results[group] == TL1_DENY)
         {
-            LOG(8)(Log::MPLS, "LSP=", currentLspName, ": ", crsName, "-", group+1, " deletion has been denied.\n", bufCmd);
-            readShell(SWITCH_PROMPT, NULL, 1, 5);
+            LOG(8)(Log::MPLS, "LSP=", currentLspName, ": ", crsName, "-", group+1, " deletion has been denied.\n", cmds[group]);
             return false;
         }
         else 
-            goto _out;
+        {
+            LOG(8)(Log::MPLS, "LSP=", currentLspName, ": ", crsName, "-", group+1, " deletion via TL1_TELNET failed...\n", cmds[group]);
+            return false;
+        }
     }
+    setEntityCached(TL1_ENTITY_CRS, false);
 
     //sleep one second to let finish status change for cross-connect 
     sleep(1);
 
     return true;
-
-_out:
-    LOG(8)(Log::MPLS, "LSP=", currentLspName, ": ", crsName, "-", group+1, " change/deletion via TL1_TELNET failed...\n", bufCmd);
-    return false;
 }
 
 //rtrv-crs-stspc::name=crsName:123;
@@ -1967,6 +2173,12 @@ bool SwitchCtrl_Session_SubnetUNI::hasCRS_TL1(String& crsName)
 {
     int ret = 0;
 
+    if (crsName == currentCRS && (ret = getEntityCached(TL1_ENTITY_CRS)) >= 0)
+    {
+        LOG(5)(Log::MPLS, "LSP=", currentLspName, ": ", crsName, (ret == 1 ? " does exist (cached).\n" : " does not exist (cached).\n"));
+        return (ret == 1);
+    }
+
     //only checking the first CRS if more than one is created for the LSP.
     sprintf( bufCmd, "rtrv-crs-stspc::name=%s-1:%d;", crsName.chars(), getNewCtag() );
     if ( (ret = writeShell(bufCmd, 5)) < 0 ) goto _out;
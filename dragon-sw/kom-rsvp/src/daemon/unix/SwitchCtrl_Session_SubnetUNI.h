@@ -53,6 +53,26 @@ typedef enum SONET_ConcatenationUnit {
 	CATUNIT_150MBPS,
 } SONET_CATUNIT;
 
+//Outstanding TL1 command, matched with its "M  <ctag> COMPLD/DENY" response by CTAG
+#define TL1_COMPLD 1
+#define TL1_DENY 2
+typedef struct TL1_Response_struct {
+	uint32 ctag;
+	int result; // 0 while outstanding, otherwise TL1_COMPLD or TL1_DENY
+} TL1_Response;
+typedef SimpleList<TL1_Response> TL1_ResponseList;
+
+//Entities of the current circuit whose existence is cached for one switch session
+#define TL1_ENTITY_VCG 0x0001
+#define TL1_ENTITY_GTP 0x0002
+#define TL1_ENTITY_SNC 0x0004
+#define TL1_ENTITY_CRS 0x0008
+#define TL1_ENTITY_EFLOW_IN 0x0010
+#define TL1_ENTITY_EFLOW_IN_MULTICAST 0x0020
+#define TL1_ENTITY_EFLOW_OUT 0x0040
+#define TL1_ENTITY_EFLOW_OUT_MULTICAST 0x0080
+#define TL1_ENTITY_PROBED 0x8000
+
 class SwitchCtrl_Session_SubnetUNI;
 typedef SimpleList<SwitchCtrl_Session_SubnetUNI*> SwitchCtrl_Session_SubnetUNI_List;
 class SONET_SDH_SENDER_TSPEC_Object;
@@ -78,12 +98,13 @@ public:
 		return (isSourceDestSame() && (subnetUniSrc.logical_port >> 8) == (subnetUniDest.logical_port>>8));
 	}
 	//Backward compatibility with general SwitchCtrl_Session operations
-	virtual bool connectSwitch() { return CLI_Session::engage(); }
+	virtual bool connectSwitch() { resetTL1State(); return CLI_Session::engage(); }
 	virtual void disconnectSwitch() 
 	{
 		char canc_user[50];
 		sprintf (canc_user, "canc-user::%s:%d;", CLI_USERNAME, getNewCtag());
 		CLI_Session::disengage(canc_user);
+		resetTL1State();
 	}
 	virtual bool refresh() { return true; } //NOP
 	
@@ -124,6 +145,17 @@ public:
 
 	uint32 getNewCtag() { ++ctagNum; return (getPseudoSwitchID()+ctagNum+(isSource?0:500000))%999999+1; }
 	uint32 getCurrentCtag() { return (getPseudoSwitchID()+ctagNum+(isSource?0:500000))%999999+1; }
+	void resetTL1State();
+	bool sendTL1(const char* cmd, uint32 ctag);
+	int waitTL1(uint32 ctag, int timeout = 5);
+	bool pipelineTL1(String* cmds, uint32* ctags, int* results, int num);
+	void probeEntities_TL1();
+	int getEntityCached(uint32 entity);
+	void setEntityCached(uint32 entity, bool exists) 
+	{
+		entityChecked |= entity;
+		if (exists) entityExists |= entity; else entityExists &= ~entity;
+	}
 	String& getCienaSoftwareVersion();
 	void getCienaTimeslotsString(String& groupMemString);
 	void getCienaLogicalPortString(String& OMPortString, String& ETTPString, uint32 logicalPort=0);
@@ -337,8 +369,15 @@ protected:
 
 	//DCN-DTL special
 	DTL_Subobject DTL; //valid if DTL.count > 0
+
+	//Pipelined TL1 commands and entity existence cache (both reset with the switch session)
+	TL1_ResponseList tl1Responses;
+	uint32 entityChecked;
+	uint32 entityExists;
 private:	
 	void internalInit ();
+	int readLineTL1(char* line, int timeout);
+	int readResponseTL1(uint32& ctag, int timeout);
 	void setSubnetUniData(SubnetUNI_Data& data, uint8 id, uint8 first_ts, uint16 tunnel_id, float bw, uint32 tna, uint32 uni_c_id, 
 		uint32 uni_n_id, uint32 data_if, uint32 port, uint32 egress_label, uint32 upstream_label, uint8* node_name, uint8* cc_name, uint8* bitmask);
 
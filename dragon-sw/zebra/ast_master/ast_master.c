@@ -25,6 +25,10 @@ char *glob_minion_recv_xml = NULL;
 
 xmlRelaxNGValidCtxtPtr incoming_xml_ctxt = NULL;
 
+/* reply to the client of the request being handled, built in memory */
+static char *master_resp = NULL;
+static size_t master_resp_len = 0;
+
 char *status_type_details[] =
   { "ast_unknown", "ast_success", "ast_failure", "ast_pending",
     "ast_ast_complete", "ast_app_complete" };
@@ -714,14 +718,176 @@ send_file_to_agent(char *ipadd, int port, char *newpath)
   return sock;
 }
 
+/* receive a whole message (until the peer shuts down its side) into memory;
+ * the returned buffer is NUL terminated and has to be freed by the caller
+ */
+char *
+recv_buffer(int servSock, int buffersize, int to, int *length)
+{
+  char *buf, *newbuf;
+  int bytesRcvd, size, total = 0;
+
+  if (servSock == -1 || !length)
+    return NULL;
+
+  size = buffersize;
+  buf = malloc(size);
+  if (!buf)
+    return NULL;
+
+  master_recv_alarm = 1;
+  alarm(to);
+  errno = 0;
+  while ((bytesRcvd = recv(servSock, buf+total, size-total-1, 0)) > 0) {
+    total += bytesRcvd;
+    if (errno == EINTR) {
+      /* alarm went off
+       */
+      zlog_info("client: alarm went off");
+      break;
+    }
+    if (size-total-1 == 0) {
+      newbuf = realloc(buf, size*2);
+      if (!newbuf) {
+	zlog_err("recv_buffer(): message exceeds %d bytes", size);
+	break;
+      }
+      buf = newbuf;
+      size *= 2;
+    }
+    alarm(to);
+  }
+  alarm(0);
+  master_recv_alarm = 0;
+
+  if (total == 0) {
+    free(buf);
+    return NULL;
+  }
+  buf[total] = '\0';
+  *length = total;
+
+  return buf;
+}
+
+int
+send_buf_over_sock(int sock, char *buf, int length)
+{
+  int sent, total = 0;
+
+  if (sock < 0 || !buf)
+    return 1;
+
+  while (total < length) {
+    sent = send(sock, buf+total, length-total, 0);
+    if (sent < 0) {
+      if (errno == EINTR)
+	continue;
+      zlog_err("send_buf_over_sock: send() failed; %d(%s)", errno, strerror(errno));
+      return 1;
+    }
+    total += sent;
+  }
+
+  return 0;
+}
+
+int
+send_buf_to_agent(char *ipadd, int port, char *buf, int length)
+{
+  int sock;
+  struct sockaddr_in servAddr;
+
+  if (!ipadd || !buf) 
+    return -1;
+
+  if ((sock = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP)) < 0) {
+    zlog_err("send_buf_to_agent: socket() failed");
+    return (-1);
+  }
+
+  memset(&servAddr, 0, sizeof(servAddr));
+  servAddr.sin_family = AF_INET;
+  servAddr.sin_addr.s_addr = inet_addr(ipadd);
+  servAddr.sin_port = htons(port);
+
+  if (connect(sock, (struct sockaddr*)&servAddr, sizeof(servAddr)) < 0) {
+    zlog_err("send_buf_to_agent: connect() failed to %s port %d", ipadd, port);
+    close(sock);
+    return -1;
+  }
+
+  if (send_buf_over_sock(sock, buf, length)) {
+    close(sock);
+    return -1;
+  }
+
+  return sock;
+}
+
+/* keep a copy of a message in the ast_id directory */
+int
+save_buffer(char *path, char *buf, int length)
+{
+  int fd, ret_value = 0;
+
+  if (!path || !buf)
+    return 1;
+
+  fd = open(path, O_WRONLY|O_CREAT|O_TRUNC, 0644);
+  if (fd == -1) {
+    zlog_err("save_buffer: can't open %s; error = %d(%s)", 
+		path, errno, strerror(errno));
+    return 1;
+  }
+  if (write(fd, buf, length) != length)
+    ret_value = 1;
+  close(fd);
+
+  return ret_value;
+}
+
+/* start a new reply to the client; the previous one is discarded */
+FILE *
+master_resp_open()
+{
+  master_resp_clear();
+  return open_memstream(&master_resp, &master_resp_len);
+}
+
 void
-print_error_response(char *path)
+master_resp_close(FILE *fp)
 {
-  FILE *fp;
+  if (fp)
+    fclose(fp);
+}
 
-  if (!path)
-    return;
-  fp = fopen(path, "w+");
+int
+master_resp_ready()
+{
+  return master_resp != NULL;
+}
+
+int
+master_resp_send(int sock)
+{
+  if (!master_resp)
+    return 1;
+  return send_buf_over_sock(sock, master_resp, master_resp_len);
+}
+
+void
+master_resp_clear()
+{
+  if (master_resp)
+    free(master_resp);
+  master_resp = NULL;
+  master_resp_len = 0;
+}
+
+void
+print_error_response_fp(FILE *fp)
+{
   if (!fp)
     return;
 
@@ -730,8 +896,6 @@ print_error_response(char *path)
     fprintf(fp, "<status>AST_FAILURE</status>\n");
     fprintf(fp, "<details>Incoming XML file can't be parsed successfully</details>\n");
     fprintf(fp, "</topology>\n");
-    fflush(fp);
-    fclose(fp);
     return;
   }
 
@@ -742,6 +906,20 @@ print_error_response(char *path)
   if (glob_app_cfg->details[0] != '\0')
     fprintf(fp, "<details>%s</details>\n", glob_app_cfg->details);
   fprintf(fp, "</topology>\n");
+}
+
+void
+print_error_response(char *path)
+{
+  FILE *fp;
+
+  if (!path)
+    return;
+  fp = fopen(path, "w+");
+  if (!fp)
+    return;
+
+  print_error_response_fp(fp);
   fflush(fp);
   fclose(fp);
 }
@@ -856,14 +1034,8 @@ print_xml_response(char* path, int agent)
 }
 
 void
-print_final(char *path, int agent)
+print_final_fp(FILE *fp, int agent)
 {
-  FILE *fp;
-  
-  if (!path)
-    return;
-
-  fp = fopen(path, "w+");
   if (!fp)
     return;
 
@@ -882,6 +1054,21 @@ print_final(char *path, int agent)
   print_res_list(fp, glob_app_cfg->link_list, agent);
 
   fprintf(fp, "</topology>");
+}
+
+void
+print_final(char *path, int agent)
+{
+  FILE *fp;
+  
+  if (!path)
+    return;
+
+  fp = fopen(path, "w+");
+  if (!fp)
+    return;
+
+  print_final_fp(fp, agent);
   fflush(fp);
   fclose(fp);
 }
@@ -905,17 +1092,22 @@ findxmlnode(xmlNodePtr cur, char* keyToFound)
   return NULL;
 }
 
-int
-xml_parser(char* filename)
+/* parse a message held in memory */
+xmlDocPtr
+xml_read_buffer(char *buf, int length)
 {
-  xmlDocPtr doc;
-  xmlNodePtr cur;
+  if (!buf || length <= 0)
+    return NULL;
+  return xmlReadMemory(buf, length, NULL, NULL, 0);
+}
 
-  doc = xmlParseFile(filename);
+static int
+xml_parse_type(xmlDocPtr doc)
+{
+  xmlNodePtr cur;
 
   if (doc == NULL) {
     zlog_err("xml_parser: Invalid XML document");
-    xmlFreeDoc(doc);
     return 0;
   }
 
@@ -952,6 +1144,18 @@ xml_parser(char* filename)
   return 0;
 }
 
+int
+xml_parser(char* filename)
+{
+  return xml_parse_type(xmlParseFile(filename));
+}
+
+int
+xml_parser_mem(char* buf, int length)
+{
+  return xml_parse_type(xml_read_buffer(buf, length));
+}
+
 struct application_cfg*
 agent_final_parser(char* filename)
 {
@@ -1035,11 +1239,10 @@ master_final_parser(char* filename, int agent)
   return (ret);
 }
 
-struct application_cfg *
-old_topo_xml_parser(char* filename, int agent)
+static struct application_cfg *
+old_topo_xml_parse_doc(xmlDocPtr doc, int agent)
 {
   xmlChar *key;
-  xmlDocPtr doc;
   xmlNodePtr cur, topo_ptr, node_ptr, resource_ptr;
   char keyToFound[100]; 
   struct resource *myres, *myres2;
@@ -1051,8 +1254,6 @@ old_topo_xml_parser(char* filename, int agent)
   node_list = NULL;
   link_list = NULL;
 
-  doc = xmlParseFile(filename);
- 
   if (doc == NULL) {
     zlog_err("topo_xml_parser: Document not parsed successfully.");
     return NULL;
@@ -1241,16 +1442,27 @@ old_topo_xml_parser(char* filename, int agent)
   return app_cfg;
 } 
 
+struct application_cfg *
+old_topo_xml_parser(char* filename, int agent)
+{
+  return old_topo_xml_parse_doc(xmlParseFile(filename), agent);
+}
+
+struct application_cfg *
+old_topo_xml_parser_mem(char* buf, int length, int agent)
+{
+  return old_topo_xml_parse_doc(xml_read_buffer(buf, length), agent);
+}
+
 /* parse xml and build internal representation;
  * parser_type:
  *	FULL_VERSION		1
  *	BRIEF_VERSION		2
  */
-struct application_cfg *
-topo_xml_parser(char* filename, int agent)
+static struct application_cfg *
+topo_xml_parse_doc(xmlDocPtr doc, int agent)
 {
   xmlChar *key;
-  xmlDocPtr doc;
   xmlNodePtr cur, topo_ptr, node_ptr, resource_ptr;
   xmlRelaxNGValidCtxtPtr ctxt;
   struct resource *myres, *myres2;
@@ -1263,7 +1475,6 @@ topo_xml_parser(char* filename, int agent)
   node_list = NULL;
   link_list = NULL;
 
-  doc = xmlParseFile(filename);
   if (!doc) {
     zlog_err("topo_xml_parser: Document not parsed successfully.");
     return NULL;
@@ -1272,6 +1483,7 @@ topo_xml_parser(char* filename, int agent)
   /* validate the doc against standard topology xml file */
   if (xmlRelaxNGValidateDoc(incoming_xml_ctxt, doc)) {
     zlog_err("topo_xml_parser: Incomding xml failed to validate against standard schema; consult schema at ...");
+    xmlFreeDoc(doc);
     return NULL;
   }
    
@@ -1445,6 +1657,18 @@ topo_xml_parser(char* filename, int agent)
   return app_cfg;
 }
 
+struct application_cfg *
+topo_xml_parser(char* filename, int agent)
+{
+  return topo_xml_parse_doc(xmlParseFile(filename), agent);
+}
+
+struct application_cfg *
+topo_xml_parser_mem(char* buf, int length, int agent)
+{
+  return topo_xml_parse_doc(xml_read_buffer(buf, length), agent);
+}
+
 int 
 validate_res_list(struct application_cfg *app_cfg, 
 		  struct adtlist *res_list, 
@@ -90,7 +90,7 @@ struct res_mod {
   void *(*read_func)(struct application_cfg*, xmlNodePtr, int);
   int (*validate_func)(struct application_cfg*, struct resource*, int);
   int (*process_resp_func) (struct application_cfg *, struct resource *, struct resource *);
-  int (*compose_req_func)(char*, struct application_cfg*, struct resource*);
+  int (*compose_req_func)(FILE*, struct application_cfg*, struct resource*);
   void (*print_func)(FILE*, void*, int);
   void (*print_cli_func)(struct vty*, void*);
   void (*free_func) (void*);
@@ -190,17 +190,18 @@ struct adtlist app_list;
 #define XML_NEW_FILE "/tmp/app_ready.xml"
 #define XML_DRAGON_RETURN_FILE "/tmp/dragon_resp.xml"
 
-#define AST_XML_RESULT  "/usr/local/ast_master_ret.xml"
-
 #define FULL_VERSION	1
 #define BRIEF_VERSION	2
 
 /* Functions related to overall topology configuraiton processing */
 struct application_cfg* topo_xml_parser(char*, int);
 struct application_cfg* old_topo_xml_parser(char*, int);
+struct application_cfg* topo_xml_parser_mem(char*, int, int);
+struct application_cfg* old_topo_xml_parser_mem(char*, int, int);
 struct application_cfg* retrieve_app_cfg(char*, int);
 int topo_validate_graph(int, struct application_cfg*);
 int xml_parser(char*);
+int xml_parser_mem(char*, int);
 int init_resource();
 
 /* Functions for communicating to minions */
@@ -215,13 +216,29 @@ void print_res_list(FILE *fp, struct adtlist *res_list, int agent);
 
 /* overall printing functions */
 void print_final(char*, int);
+void print_final_fp(FILE*, int);
 void print_error_response(char*);
+void print_error_response_fp(FILE*);
 
 /* xml file transfer */
 int send_file_over_sock(int, char*);
 int send_file_to_agent(char*, int, char*);
 int recv_file(int, char*, int, int, int);
 
+/* xml messages kept in memory */
+char *recv_buffer(int, int, int, int*);
+int send_buf_over_sock(int, char*, int);
+int send_buf_to_agent(char*, int, char*, int);
+int save_buffer(char*, char*, int);
+xmlDocPtr xml_read_buffer(char*, int);
+
+/* reply to the client of the request being handled */
+FILE *master_resp_open();
+void master_resp_close(FILE*);
+int master_resp_ready();
+int master_resp_send(int);
+void master_resp_clear();
+
 /* overall searching functions */
 struct resource * search_res_by_name(struct application_cfg*, enum resource_type, char*);
 struct resource * search_link_by_name(struct application_cfg*, char*);
@@ -12,8 +12,10 @@
 #include "linklist.h"
 #include "memory.h"
 #include "buffer.h"
+#include "prefix.h"
 #include "ast_master_ext.h"
 #include "ast_master.h"
+#include "dragon_app.h"
 
 char master_prompt[100] = "ast_master# ";
 extern struct host host;
@@ -32,12 +34,10 @@ struct cmd_node master_node =
   1
 };
 
+/* hostname and password are written by config_write_host() */
 int master_config_write(struct vty *vty)
 {
-  if (host.name)   
-    vty_out (vty, "hostname %s%s", host.name, VTY_NEWLINE);
-  if (host.password)
-        vty_out (vty, "password %s%s%s", host.password, VTY_NEWLINE, VTY_NEWLINE);
+  dragon_ip_block_config_write(vty);
 
   return 0;
 }
@@ -275,10 +275,41 @@ DEFUN (master_set_es,
   return CMD_SUCCESS;
 }
 
+DEFUN (master_set_data_plane_block,
+	master_set_data_plane_block_cmd,
+	"set data_plane_block A.B.C.D/M",
+	"Set data plane address blocks\n"
+	"Add /30 blocks assigned to dragon links\n"
+	"prefix to split into /30 blocks, with a length between 16 and 30\n"
+	)
+{
+  struct prefix_ipv4 p;
+
+  if (str2prefix_ipv4(argv[0], &p) <= 0 || 
+      dragon_ip_block_add(p.prefix, p.prefixlen)) {
+    vty_out(vty, "Invalid prefix %s%s", argv[0], VTY_NEWLINE);
+    return CMD_WARNING;
+  }
+
+  return CMD_SUCCESS;
+}
+
+DEFUN (master_show_data_plane_block,
+	master_show_data_plane_block_cmd,
+	"show data_plane_block",
+	SHOW_STR
+	"Show data plane address blocks and their use\n")
+{
+  vty_out(vty, "%-20s%s%s", "slash_30", "in_use", VTY_NEWLINE);
+  dragon_ip_block_show(vty);
+
+  return CMD_SUCCESS;
+}
+
 void
 master_supp_vty_init()
 {
-  install_node(&master_node, NULL);
+  install_node(&master_node, master_config_write);
   
   install_element(VIEW_NODE, &master_show_ast_cmd);
   install_element(VIEW_NODE, &master_show_ast_all_cmd);
@@ -288,4 +319,8 @@ master_supp_vty_init()
 
   install_element(VIEW_NODE, &master_set_es_cmd);
   install_element(CONFIG_NODE, &master_set_es_cmd);
+
+  install_element(VIEW_NODE, &master_show_data_plane_block_cmd);
+  install_element(VIEW_NODE, &master_set_data_plane_block_cmd);
+  install_element(CONFIG_NODE, &master_set_data_plane_block_cmd);
 }
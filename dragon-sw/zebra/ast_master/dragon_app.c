@@ -16,6 +16,7 @@
 #include "ast_master_ext.h"
 #include "buffer.h"
 #include "log.h"
+#include "prefix.h"
 #include "local_id_cfg.h"
 #include "dragon_app.h"
 
@@ -74,8 +75,8 @@ struct res_mod {
   void (*free_func) (void*);
 };
 */
-#define SQL_RESULT       	"/tmp/mysql.result"
 #define XML_SERVICE_DEF_FILE    "/usr/local/ast_file/service_template.xml"
+#define DATA_PLANE_BLOCK_FILE	AST_DIR "/data_plane_blocks"
 
 extern struct res_mods all_res_mod;
 extern char *status_type_details[];
@@ -230,15 +231,239 @@ autofill_es_info(struct resource* res)
   return 1;
 }
 
+/* Pool of the /30 data plane blocks handed out to dragon links, in place 
+ * of the data_plane_blocks table of the dragon sql database.
+ * The blocks are configured with "set data_plane_block"; the ones in use 
+ * are kept in DATA_PLANE_BLOCK_FILE so that they survive a restart.
+ * Blocks of that file that are not configured (yet) are kept in saved[]
+ * and marked in use as soon as they are added.
+ */
+static struct {
+  int number;
+  int size;
+  int next;
+  int loaded;
+  struct in_addr *slash_30;
+  u_int8_t *in_use;
+  int saved_number;
+  struct in_addr *saved;
+  int prefix_number;
+  struct prefix_ipv4 *prefix;
+} ip_block_pool;
+
+static int
+ip_block_find(struct in_addr slash_30)
+{
+  int i;
+
+  for (i = 0; i < ip_block_pool.number; i++)
+    if (ip_block_pool.slash_30[i].s_addr == slash_30.s_addr)
+      return i;
+
+  return -1;
+}
+
+static void
+ip_block_save()
+{
+  FILE *fp;
+  int i;
+
+  if (mkdir(AST_DIR, 0755) == -1 && errno != EEXIST) {
+    zlog_err("Can't create directory %s", AST_DIR);
+    return;
+  }
+
+  fp = fopen(DATA_PLANE_BLOCK_FILE ".tmp", "w");
+  if (!fp) {
+    zlog_err("Can't open the file %s; error = %d(%s)",
+		DATA_PLANE_BLOCK_FILE ".tmp", errno, strerror(errno));
+    return;
+  }
+  for (i = 0; i < ip_block_pool.number; i++)
+    if (ip_block_pool.in_use[i])
+      fprintf(fp, "%s\n", inet_ntoa(ip_block_pool.slash_30[i]));
+  for (i = 0; i < ip_block_pool.saved_number; i++)
+    fprintf(fp, "%s\n", inet_ntoa(ip_block_pool.saved[i]));
+  fclose(fp);
+
+  if (rename(DATA_PLANE_BLOCK_FILE ".tmp", DATA_PLANE_BLOCK_FILE) == -1)
+    zlog_err("Can't rename %s to %s; errno = %d(%s)",
+	     DATA_PLANE_BLOCK_FILE ".tmp", DATA_PLANE_BLOCK_FILE, 
+	     errno, strerror(errno));
+}
+
+/* read the blocks in use before the first block is configured */
+static void
+ip_block_load()
+{
+  FILE *fp;
+  char line[100], *c;
+  struct in_addr slash_30, *saved;
+  int size = 0;
+
+  if (ip_block_pool.loaded)
+    return;
+  ip_block_pool.loaded = 1;
+
+  fp = fopen(DATA_PLANE_BLOCK_FILE, "r");
+  if (!fp)
+    return;
+
+  while (fgets(line, sizeof(line), fp)) {
+    if ((c = strchr(line, '\n')) != NULL)
+      *c = '\0';
+    if (!inet_aton(line, &slash_30))
+      continue;
+    if (ip_block_pool.saved_number == size) {
+      size = size ? size * 2 : 64;
+      saved = realloc(ip_block_pool.saved, size * sizeof(struct in_addr));
+      if (!saved) {
+	zlog_err("ip_block_load: out of memory");
+	break;
+      }
+      ip_block_pool.saved = saved;
+    }
+    ip_block_pool.saved[ip_block_pool.saved_number++] = slash_30;
+  }
+  fclose(fp);
+}
+
+/* whether slash_30 was in use before the restart; the entry is 
+ * dropped from saved[] as the pool takes over
+ */
+static int
+ip_block_saved(struct in_addr slash_30)
+{
+  int i;
+
+  for (i = 0; i < ip_block_pool.saved_number; i++)
+    if (ip_block_pool.saved[i].s_addr == slash_30.s_addr) {
+      ip_block_pool.saved[i] = ip_block_pool.saved[--ip_block_pool.saved_number];
+      return 1;
+    }
+
+  return 0;
+}
+
+/* add all the /30 blocks of prefix/prefixlen to the pool */
+int
+dragon_ip_block_add(struct in_addr prefix, int prefixlen)
+{
+  u_int32_t start, count, i;
+  struct in_addr slash_30;
+  struct prefix_ipv4 *p;
+
+  if (prefixlen < 16 || prefixlen > 30)
+    return 1;
+
+  ip_block_load();
+
+  count = 1 << (30 - prefixlen);
+  start = ntohl(prefix.s_addr) & (0xffffffff << (32 - prefixlen));
+
+  /* remembered as configured, for master_config_write() */
+  for (i = 0; i < ip_block_pool.prefix_number; i++)
+    if (ntohl(ip_block_pool.prefix[i].prefix.s_addr) == start &&
+	ip_block_pool.prefix[i].prefixlen == prefixlen)
+      break;
+  if (i == ip_block_pool.prefix_number) {
+    p = realloc(ip_block_pool.prefix, (i + 1) * sizeof(struct prefix_ipv4));
+    if (!p)
+      return 1;
+    ip_block_pool.prefix = p;
+    p += ip_block_pool.prefix_number++;
+    memset(p, 0, sizeof(struct prefix_ipv4));
+    p->family = AF_INET;
+    p->prefix.s_addr = htonl(start);
+    p->prefixlen = prefixlen;
+  }
+
+  for (i = 0; i < count; i++) {
+    slash_30.s_addr = htonl(start + (i << 2));
+    if (ip_block_find(slash_30) != -1)
+      continue;
+
+    if (ip_block_pool.number == ip_block_pool.size) {
+      ip_block_pool.size = ip_block_pool.size ? ip_block_pool.size * 2 : 64;
+      ip_block_pool.slash_30 = realloc(ip_block_pool.slash_30, 
+			ip_block_pool.size * sizeof(struct in_addr));
+      ip_block_pool.in_use = realloc(ip_block_pool.in_use, 
+			ip_block_pool.size * sizeof(u_int8_t));
+    }
+    ip_block_pool.slash_30[ip_block_pool.number] = slash_30;
+    ip_block_pool.in_use[ip_block_pool.number] = ip_block_saved(slash_30);
+    ip_block_pool.number++;
+  }
+
+  return 0;
+}
+
+void
+dragon_ip_block_config_write(struct vty *vty)
+{
+  int i;
+
+  for (i = 0; i < ip_block_pool.prefix_number; i++)
+    vty_out(vty, "set data_plane_block %s/%d%s", 
+		inet_ntoa(ip_block_pool.prefix[i].prefix), 
+		ip_block_pool.prefix[i].prefixlen, VTY_NEWLINE);
+}
+
+static int
+ip_block_reserve(struct in_addr *slash_30)
+{
+  int i, index;
+
+  for (i = 0; i < ip_block_pool.number; i++) {
+    index = (ip_block_pool.next + i) % ip_block_pool.number;
+    if (ip_block_pool.in_use[index])
+      continue;
+
+    ip_block_pool.in_use[index] = 1;
+    ip_block_pool.next = index + 1;
+    ip_block_save();
+    *slash_30 = ip_block_pool.slash_30[index];
+    return 0;
+  }
+
+  return 1;
+}
+
+static void
+ip_block_release(struct in_addr slash_30)
+{
+  int index;
+
+  index = ip_block_find(slash_30);
+  if (index == -1 || !ip_block_pool.in_use[index])
+    return;
+
+  ip_block_pool.in_use[index] = 0;
+  ip_block_save();
+}
+
+void
+dragon_ip_block_show(struct vty *vty)
+{
+  int i, used = 0;
+
+  for (i = 0; i < ip_block_pool.number; i++) {
+    vty_out(vty, "%-20s%s%s", inet_ntoa(ip_block_pool.slash_30[i]), 
+		ip_block_pool.in_use[i] ? "yes" : "no", VTY_NEWLINE);
+    used += ip_block_pool.in_use[i];
+  }
+  vty_out(vty, "%d of %d blocks in use%s", used, ip_block_pool.number, VTY_NEWLINE);
+}
+
 static int
 lookup_assign_ip(struct resource *res)
 {
   struct dragon_node_pc *src_node, *dest_node;
   struct dragon_endpoint *src_ep, *dest_ep;
   struct dragon_link *link;
-  FILE *fp;
-  char *f_ret, *token, line[100], addr[200];
-  struct in_addr mask, ip;
+  char addr[200];
+  struct in_addr mask, ip, slash_30;
 
   zlog_info("lookup_assign_ip() ... for link %s", res->name);
 
@@ -275,73 +500,32 @@ lookup_assign_ip(struct resource *res)
   if (dest_ep->ifp->assign_ip && src_ep->ifp->assign_ip)
     return 0;
 
-  system("mysql -hlocalhost -udragon -pflame -e \"use dragon; select * from data_plane_blocks where in_use='no' limit 1;\" > /tmp/mysql.result");
-
-  /* error if 
-   * SQL_RESULT doesn't start with slash_30
-   * return file format:
-   * slash_30	in_use 
-   * 140.173.96.32   no
-   *
-   */
-  fp = fopen(SQL_RESULT, "r");
-  if (!fp) {
-    return 1;
-  }
-
-  f_ret = fgets(line, 100, fp);
-  if (!f_ret) {
-    fclose(fp);
-    zlog_err("lookup_assign_ip: sql server returns empty file");
-    return 1;
-  }
-
-  if (strncmp(f_ret, "slash_30", 8) != 0) {
-    fclose(fp);
-    zlog_err("lookup_assign_ip: sql server returns error"); 
-    return 1;
-  }
-
-  f_ret = fgets(line, 100, fp);
-  if (!f_ret) {
-    fclose(fp);
-    zlog_err("lookup_assign_ip: sql server returns no slash_30");
+  if (ip_block_reserve(&slash_30)) {
+    zlog_err("lookup_assign_ip: no free data plane block left");
     return 1;
   }
-
-  token = strtok(f_ret, "\t");
-  if (!token) { 
-    fclose(fp);       
-    zlog_err("lookup_assign_ip: sql server returns no slash_30");
-    return 1;
-  }
-  zlog_info("for link %s, assign slash_30 %s", res->name, token);
+  zlog_info("for link %s, assign slash_30 %s", res->name, inet_ntoa(slash_30));
 
   /* for src */
   mask.s_addr = inet_addr("0.0.0.1");
-  ip.s_addr = inet_addr(token) | mask.s_addr;
+  ip.s_addr = slash_30.s_addr | mask.s_addr;
   zlog_info("for src, assign %s", inet_ntoa(ip));
   sprintf(addr, "%s/30", inet_ntoa(ip));
   src_ep->ifp->assign_ip = strdup(addr);
  
   mask.s_addr = inet_addr("0.0.0.2");
-  ip.s_addr = inet_addr(token) | mask.s_addr;
+  ip.s_addr = slash_30.s_addr | mask.s_addr;
   zlog_info("for dest, assign %s", inet_ntoa(ip)); 
   sprintf(addr, "%s/30", inet_ntoa(ip));
   dest_ep->ifp->assign_ip = strdup(addr);
 
-  sprintf(addr, "mysql -hlocalhost -udragon -pflame  -e \"use dragon; update data_plane_blocks set in_use='yes' where slash_30='%s';\"", token);
-
-  system(addr);
-  fclose(fp);
-
   return 0;
 }
 
 static int
 cleanup_assign_ip(struct resource *res)
 {
-  char *c, addr[200];
+  char *c;
   struct in_addr mask, ip, slash_30;
   struct dragon_endpoint *src_ep;
   struct dragon_link *link;
@@ -366,10 +550,9 @@ cleanup_assign_ip(struct resource *res)
   mask.s_addr = inet_addr("255.255.255.252");
   slash_30.s_addr = ip.s_addr & mask.s_addr;
 
-  /* don't care if this addr is from SQL database or not, just remove it
+  /* don't care if this addr is from the pool or not, just release it
    */
-  sprintf(addr, "mysql -hlocalhost -udragon -pflame  -e \"use dragon; update data_plane_blocks set in_use='no' where slash_30='%s';\"", inet_ntoa(slash_30));
-  system(addr);
+  ip_block_release(slash_30);
 
   return 0;
 }
@@ -719,7 +902,7 @@ dragon_node_pc_process_resp(struct application_cfg *old_cfg,
 }
  
 int 
-dragon_node_pc_compose_req(char* path, 
+dragon_node_pc_compose_req(FILE* fp, 
 			   struct application_cfg* app_cfg, 
 			   struct resource* res)
 {
@@ -1489,17 +1672,16 @@ dragon_link_process_resp(struct application_cfg *old_cfg,
  *	2: fundamental error
  */
 int
-dragon_link_compose_req(char* path, 
+dragon_link_compose_req(FILE* fp, 
 			struct application_cfg* app_cfg, 
 			struct resource* res) 
 {
-  FILE *fp;
   struct dragon_link *link;
   struct dragon_node_pc *src_node;
   struct adtlistnode *curnode;
   struct resource *res2;
 
-  if (!res || !app_cfg || !path || strlen(path) == 0)
+  if (!res || !app_cfg || !fp)
     return 2;
 
   if (app_cfg->action != setup_req && 
@@ -1507,13 +1689,6 @@ dragon_link_compose_req(char* path,
       app_cfg->action != ast_complete)
     return 1;
 
-  fp = fopen(path, "w+");
-  if (!fp) {
-    zlog_err("Can't open the file %s; error = %d(%s)",
-		path, errno, strerror(errno));
-    return 2;
-  }
-
   link = (struct dragon_link*)res->res;
   fprintf(fp, "<topology ast_id=\"%s\" action=\"%s\">\n", app_cfg->ast_id, action_type_details[app_cfg->action]);
   print_res_list(fp, app_cfg->node_list, MASTER);
@@ -1533,8 +1708,6 @@ dragon_link_compose_req(char* path,
     print_res(fp, res, MASTER);
 
   fprintf(fp, "</topology>\n");
-  fflush(fp);
-  fclose(fp); 
 
   return 0;
 }
@@ -61,7 +61,7 @@ struct dragon_link {
 void* dragon_node_pc_read(struct application_cfg*, xmlNodePtr, int);
 int dragon_node_pc_validate(struct application_cfg*, struct resource*, int);
 int dragon_node_pc_process_resp(struct application_cfg *, struct resource *, struct resource *);
-int dragon_node_pc_compose_req(char*, struct application_cfg*, struct resource*);
+int dragon_node_pc_compose_req(FILE*, struct application_cfg*, struct resource*);
 void dragon_node_pc_print(FILE*, void*, int);
 void dragon_node_pc_print_cli(struct vty*, void*);
 void dragon_node_pc_free(void*);
@@ -71,13 +71,18 @@ void dragon_node_pc_old_print(FILE*, struct resource*, int);
 void* dragon_link_read(struct application_cfg*, xmlNodePtr, int);
 int dragon_link_validate(struct application_cfg*, struct resource*, int);
 int dragon_link_process_resp(struct application_cfg *, struct resource *, struct resource *);
-int dragon_link_compose_req(char*, struct application_cfg*, struct resource*);
+int dragon_link_compose_req(FILE*, struct application_cfg*, struct resource*);
 void dragon_link_print(FILE*, void*, int);
 void dragon_link_print_cli(struct vty*, void*);
 void dragon_link_free(void*);
 void dragon_link_old_print(FILE*, struct resource*, int);
 void* dragon_link_old_read(struct application_cfg*, xmlNodePtr, int);
 
+/* data plane /30 blocks for the links */
+int dragon_ip_block_add(struct in_addr, int);
+void dragon_ip_block_show(struct vty*);
+void dragon_ip_block_config_write(struct vty*);
+
 /* functions for dragon app modele */
 int init_dragon_module();
 #endif /* _AST_MASTER_DRAGON_APP_H */
@@ -9,7 +9,6 @@
 #include "local_id_cfg.h"
 
 extern char* status_type_details[];
-extern int send_file_to_agent(char *, int, char *);
 
 extern xmlNodePtr findxmlnode(xmlNodePtr, char*);
 extern void free_id_cfg_res(struct id_cfg_res*);
@@ -64,22 +63,15 @@ get_id_action_by_name(char* action)
 }
 
 int
-compose_id_req(struct application_cfg *app_cfg, char* path, struct id_cfg_res *res)
+compose_id_req(struct application_cfg *app_cfg, FILE* send_file, struct id_cfg_res *res)
 {
   struct adtlistnode *cur;
   struct local_id_cfg *id_cfg;
-  FILE *send_file;
   int i;
 
-  if (!app_cfg || !path || strlen(path) == 0 || !res ) 
+  if (!app_cfg || !send_file || !res ) 
     return 0;
 
-  send_file = fopen(path, "w+");
-  if (!send_file) {
-    zlog_err("compose_id_req: Can't open the file %s", path);
-    return 0;
-  }
-
   if (app_cfg->xml_type == ID_XML) 
     fprintf(send_file, "<local_id_cfg ast_id=\"%s\">\n", app_cfg->ast_id);
   else 
@@ -111,9 +103,6 @@ compose_id_req(struct application_cfg *app_cfg, char* path, struct id_cfg_res *r
     fprintf(send_file, "</local_id_cfg>\n");
   else 
     fprintf(send_file, "</local_id_query>\n");
-  
-  fflush(send_file);
-  fclose(send_file);
 
   return 1;
 }
@@ -195,18 +184,13 @@ process_id_result(struct application_cfg *working_app_cfg, struct id_cfg_res* re
 }
  
 void
-print_id_response(char * path, int agent)
+print_id_response_fp(FILE *fp, int agent)
 {
   struct adtlistnode *cur, *cur1;
   struct id_cfg_res* myres;
   struct local_id_cfg* myid;
-  FILE *fp;
   int i;
 
-  if (!path)
-    return;
-
-  fp = fopen(path, "w+");
   if (!fp)
     return;
 
@@ -214,8 +198,6 @@ print_id_response(char * path, int agent)
     fprintf(fp, "<local_id_cfg>\n");
     fprintf(fp, "<status>AST_FAILURE</status>\n");
     fprintf(fp, "</local_id_cfg>\n");
-    fflush(fp);
-    fclose(fp);
     return;
   }
 
@@ -267,15 +249,43 @@ print_id_response(char * path, int agent)
     fprintf(fp, "</local_id_cfg>\n");
   else 
     fprintf(fp, "</local_id_query>\n");
+}
+
+void
+print_id_response(char * path, int agent)
+{
+  FILE *fp;
+
+  if (!path)
+    return;
+
+  fp = fopen(path, "w+");
+  if (!fp)
+    return;
+
+  print_id_response_fp(fp, agent);
   fflush(fp);
   fclose(fp);
 }
 
-struct application_cfg* 
-id_xml_parser(char* filename, int agent)
+/* the reply to the client of this request */
+static void
+master_id_response()
+{
+  FILE *fp;
+
+  fp = master_resp_open();
+  if (!fp)
+    return;
+
+  print_id_response_fp(fp, MASTER);
+  master_resp_close(fp);
+}
+
+static struct application_cfg* 
+id_xml_parse_doc(xmlDocPtr doc, int agent)
 {
   xmlChar *key;
-  xmlDocPtr doc;
   xmlNodePtr cur, cur1, cur2, resource_ptr;
   int i, err, type;
   struct _xmlAttr* attr;
@@ -283,8 +293,6 @@ id_xml_parser(char* filename, int agent)
   struct local_id_cfg* myIDcfg;
   struct application_cfg* app_cfg;
 
-  doc = xmlParseFile(filename);
-
   if (!doc) {
     zlog_err("id_xml_parser: document not parsed successfully");
     return NULL;
@@ -520,28 +528,40 @@ id_xml_parser(char* filename, int agent)
   return app_cfg;
 }
 
+struct application_cfg* 
+id_xml_parser(char* filename, int agent)
+{
+  return id_xml_parse_doc(xmlParseFile(filename), agent);
+}
+
+struct application_cfg* 
+id_xml_parser_mem(char* buf, int length, int agent)
+{
+  return id_xml_parse_doc(xml_read_buffer(buf, length), agent);
+}
+
 int
-master_process_id(char* filename)
+master_process_id(char* buf, int length)
 {
   struct adtlistnode *cur;
   struct id_cfg_res* myres;
   int sock;
-  static char buffer[RCVBUFSIZE];
-  static char ret_buf[SENDBUFSIZE];
-  int bytesRcvd, total, ret_value = 1;
-  FILE* ret_file = NULL;
+  int total, ret_value = 1;
+  char *req, *resp;
+  size_t req_len;
+  FILE *fp;
   char directory[80];
   char newpath[105];
   struct application_cfg *working_app_cfg;
 
-  if ((glob_app_cfg = id_xml_parser(filename, MASTER)) == NULL) {
-    print_id_response(AST_XML_RESULT, MASTER);
+  if ((glob_app_cfg = id_xml_parser_mem(buf, length, MASTER)) == NULL) {
+    master_id_response();
     return 0;
   }
 
   if (!glob_app_cfg->node_list) {
     glob_app_cfg->status = ast_success;
-    print_id_response(AST_XML_RESULT, MASTER);
+    master_id_response();
     return 1;
   }
 
@@ -568,11 +588,8 @@ master_process_id(char* filename)
   }
 
   sprintf(newpath, "%s/orig.xml", directory);
-  if (rename(filename, newpath) == -1)
-    zlog_err("master_process_id: Can't rename %s to %s; errno = %d(%s)",
-		filename, newpath, errno, strerror(errno));
-
-  memset(buffer, 0, RCVBUFSIZE);
+  if (save_buffer(newpath, buf, length))
+    zlog_err("master_process_id: Can't save the request to %s", newpath);
 
   /* now, send the task list to all related node */
   for (cur = glob_app_cfg->node_list->head;
@@ -580,15 +597,22 @@ master_process_id(char* filename)
        cur = cur->next) {
     myres = (struct id_cfg_res*) cur->data;
 
-    sprintf(newpath, "%s/%s.xml", directory, myres->name);
-    
-    /* compose the sending file */
-    compose_id_req(glob_app_cfg, newpath, myres);
+    /* compose the request */
+    req = NULL;
+    req_len = 0;
+    fp = open_memstream(&req, &req_len);
+    if (!fp) {
+      myres->status = ast_failure;
+      ret_value = 0;
+      continue;
+    }
+    compose_id_req(glob_app_cfg, fp, myres);
+    fclose(fp);
 
-    /* call send_file_to_agent */
     zlog_info("master_process_id: sending request to %s (%s:%d)", 
 	      myres->name, myres->ip, DEFAULT_LINK_XML_PORT);
-    sock = send_file_to_agent(myres->ip, DEFAULT_LINK_XML_PORT, newpath);
+    sock = send_buf_to_agent(myres->ip, DEFAULT_LINK_XML_PORT, req, req_len);
+    free(req);
 
     if (sock == -1) {
       myres->status = ast_failure;
@@ -599,37 +623,19 @@ master_process_id(char* filename)
     }
 
     /* waiting the result to come back */
-    total = 0;
-    memset(ret_buf, 0, SENDBUFSIZE);
-    while ((bytesRcvd = recv(sock, buffer, RCVBUFSIZE-1, 0))  > 0) {
-      
-      if (!total) {
-	zlog_info("master_process_id: Received confirmation from %s", myres->name);
-	sprintf(newpath, "%s/resp_%s.xml", directory, myres->name);
-	ret_file = fopen(newpath, "w");
-	if (!ret_file) {
-	  zlog_err("master_process_id: can't open %s; error = %d(%s)",
-		      newpath, errno, strerror(errno));
-	  ret_value = 0;
-	  continue;
-	}
-      }
-      total+=bytesRcvd;
-      buffer[bytesRcvd] = '\0';
-      sprintf(ret_buf+strlen(ret_buf), buffer);
-      fprintf(ret_file, buffer);
-    }
+    resp = recv_buffer(sock, RCVBUFSIZE, 0, &total);
 
-    if (total == 0) {
+    if (!resp) {
       zlog_err("master_process_id: No confirmation from %s", myres->name);
       myres->status = status_unknown;
       ret_value = 0;
     } else {
 
-      fflush(ret_file);
-      fclose(ret_file);
+      zlog_info("master_process_id: Received confirmation from %s", myres->name);
+      sprintf(newpath, "%s/resp_%s.xml", directory, myres->name);
+      save_buffer(newpath, resp, total);
 
-      if ((working_app_cfg = id_xml_parser(newpath, MASTER)) == NULL) {
+      if ((working_app_cfg = id_xml_parser_mem(resp, total, MASTER)) == NULL) {
 	zlog_err("master_process_id: returned file (%s) is not parsed correctly", newpath);
 	myres->status = status_unknown;
 	myres->msg = strdup("The response file is not parsed correctly");
@@ -638,19 +644,20 @@ master_process_id(char* filename)
 	if (process_id_result(working_app_cfg, myres) != 1)
 	  ret_value = 0;
 	free_application_cfg(working_app_cfg);
+      free(resp);
     }
     close(sock);
   }
 
-  /* integrate the result and put the result into AST_XML_RESULT */
+  /* integrate the result and make it the reply to the client */
   if (ret_value)
     glob_app_cfg->status = ast_success;
   else
     glob_app_cfg->status = ast_failure;
 
   sprintf(newpath, "%s/final.xml", directory);
-  symlink(newpath, AST_XML_RESULT);
   print_id_response(newpath, MASTER);
+  master_id_response();
 
   return ret_value;
 }
@@ -31,3 +31,4 @@ struct local_id_cfg {
 struct adtlist *glob_id_cfg_list;
 
 struct application_cfg* id_xml_parser(char*, int);
+struct application_cfg* id_xml_parser_mem(char*, int, int);
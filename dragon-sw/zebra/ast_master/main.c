@@ -34,17 +34,15 @@
 /* NEW STUFF */
 extern struct res_mods all_res_mod;
 
-#ifdef RESOURCE_BROKER
-#define BROKER_SEND     "/usr/local/broker_send.xml"
-#define BROKER_RECV     "/usr/local/broker_resp.xml"
-#endif
-
 #define AST_CLIENT_SEND_FILE 	"/usr/local/ast_client_sent.xml"
 #define AST_CLIENT_RESULT_FILE 	"/usr/local/ast_client_result.xml"
 
-#define AST_TEMP_FILE		"/usr/local/ast_master_temp.xml"
-
 #define CLIENT_TIMEOUT	20
+#define MINION_SEND_TIMEOUT	10
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL	0
+#endif
 
 /* Configuration filename and directory. */
 char config_current[] = MASTER_DEFAULT_CONFIG;
@@ -59,10 +57,14 @@ static void clean_socket(struct application_cfg *);
 static void init_socket(struct application_cfg *);
 static void master_check_app_list();
 static void handle_alarm();
-extern int master_process_id(char*);
+extern int master_process_id(char*, int);
 extern struct application_cfg* master_final_parser(char*, int);
 extern int send_file_to_agent(char *, int, char *);
 
+/* the message being processed, as received from the client or minion */
+static char *master_recv_buf = NULL;
+static int master_recv_len = 0;
+
 /* backward compatibility */
 struct vtag_tank {
   int number;
@@ -124,26 +126,48 @@ NSF AST Master.\n\n\
   exit (status);
 }
 
+static void
+master_recv_done()
+{
+  if (master_recv_buf)
+    free(master_recv_buf);
+  master_recv_buf = NULL;
+  master_recv_len = 0;
+}
+
+static void
+master_save_recv(char *path)
+{
+  if (!master_recv_buf)
+    return;
+
+  if (save_buffer(path, master_recv_buf, master_recv_len))
+    zlog_err("Can't save the received message to %s", path);
+}
+
 void 
 release_ast(char* ast_id)
 {
-  FILE *fp;
+  char req[300];
+  char *saved_buf = master_recv_buf;
+  int saved_len = master_recv_len;
 
-  fp = fopen(AST_XML_RECV, "w+");
-  fprintf(fp, "<topology ast_id=\"%s\" action=\"RELEASE_REQ\"></topology>",
-		  ast_id);
-  fflush(fp);
-  fclose(fp);
+  snprintf(req, sizeof(req), 
+	   "<topology ast_id=\"%s\" action=\"RELEASE_REQ\"></topology>",
+	   ast_id);
 
-  glob_app_cfg = topo_xml_parser(AST_XML_RECV, MASTER);
+  glob_app_cfg = topo_xml_parser_mem(req, strlen(req), MASTER);
   if (!glob_app_cfg) {
     zlog_info("internal error");
     return;
   }
   glob_app_cfg->clnt_sock = -1;
 
+  master_recv_buf = req;
+  master_recv_len = strlen(req);
   master_process_release_req();
-
+  master_recv_buf = saved_buf;
+  master_recv_len = saved_len;
 }
 
 static void 
@@ -236,15 +260,10 @@ set_res_fail(char* error_msg, struct resource *res)
 }
 
 void
-print_old_final(char* path)
+print_old_final_fp(FILE *fp)
 {
-  FILE *fp;
   struct adtlistnode *curnode;
 
-  if (!path)
-    return;
-
-  fp = fopen(path, "w+");
   if (!fp)
     return;
 
@@ -273,17 +292,40 @@ print_old_final(char* path)
       dragon_link_old_print(fp, (struct resource*)curnode->data, MASTER);
   }
   fprintf(fp, "</topology>");
+}
+
+void
+print_old_final(char* path)
+{
+  FILE *fp;
+
+  if (!path)
+    return;
+
+  fp = fopen(path, "w+");
+  if (!fp)
+    return;
+
+  print_old_final_fp(fp);
   fflush(fp);
   fclose(fp);
 }
 
-void
-print_final_client(char *path)
+/* render glob_app_cfg as the reply to the client */
+static void
+print_final_client()
 {
+  FILE *fp;
+
+  fp = master_resp_open();
+  if (!fp)
+    return;
+
   if (!glob_app_cfg->old_xml)
-    print_final(path, MASTER);
+    print_final_fp(fp, MASTER);
   else 
-    print_old_final(path);
+    print_old_final_fp(fp);
+  master_resp_close(fp);
 }
 
 int
@@ -433,7 +475,7 @@ master_save_file(struct application_cfg *new_cfg,
       return;
   }
 
-  rename(AST_XML_RECV, newpath);
+  master_save_recv(newpath);
 }
 
 int
@@ -541,9 +583,7 @@ master_process_setup_req()
     }
   }
   sprintf(newpath, "%s/setup_original.xml", directory);
-  if (rename(AST_XML_RECV, newpath) == -1) 
-    zlog_err("Can't rename %s to %s; errno = %d(%s)",
-	     AST_XML_RECV, newpath, errno, strerror(errno));
+  master_save_recv(newpath);
 
   app_cfg_pre_req();
   init_socket(glob_app_cfg);
@@ -585,9 +625,7 @@ master_process_query_req()
   }
 
   sprintf(newpath, "%s/%s/query_original.xml", AST_DIR, glob_app_cfg->ast_id);
-  if (rename(AST_XML_RECV, newpath) == -1) 
-    zlog_err("Can't rename %s to %s; errno = %d(%s)",
-	     AST_XML_RECV, newpath, errno, strerror(errno));
+  master_save_recv(newpath);
 
   glob_app_cfg->status = ast_success;
   if (send_task_to_minions(glob_app_cfg->node_list, res_node))
@@ -623,11 +661,16 @@ master_process_release_req()
   } else if (strcasecmp(glob_app_cfg->ast_id, "all") == 0) {
 
     FILE *fp;
+    char *resp = NULL;
+    size_t resp_len = 0;
     struct adtlistnode *curnode;
     struct application_cfg *curcfg, *tempcfg = glob_app_cfg;
     
     glob_app_cfg = NULL;
-    fp = fopen(AST_TEMP_FILE, "w+");
+    /* the individual releases may produce replies of their own,
+     * so collect this one aside and install it at the end
+     */
+    fp = open_memstream(&resp, &resp_len);
     fprintf(fp, "<topology action=\"release_resp\">\n");
     fprintf(fp, "<status>ast_success</status>\n");
     fprintf(fp, "<details>\n");
@@ -647,9 +690,13 @@ master_process_release_req()
       } 
     }
     fprintf(fp, "</details>\n</topology>\n");
-    fflush(fp);
     fclose(fp);
-    rename(AST_TEMP_FILE, AST_XML_RESULT);
+    fp = master_resp_open();
+    if (fp) {
+      fwrite(resp, 1, resp_len, fp);
+      master_resp_close(fp);
+    }
+    free(resp);
     tempcfg->action = release_resp;
     tempcfg->status = ast_success;
     glob_app_cfg = tempcfg;
@@ -708,9 +755,7 @@ master_process_release_req()
 
   /* now, save the release_original first */
   sprintf(path, "%s/%s/release_original.xml", AST_DIR, glob_app_cfg->ast_id);
-  if (rename(AST_XML_RECV, path) == -1)
-    zlog_err("Can't rename %s to %s; errno = %d(%s)",
-	     AST_XML_RECV, path, errno, strerror(errno));
+  master_save_recv(path);
 
   app_cfg_pre_req();
   glob_app_cfg->flags |= FLAG_RELEASE_REQ;
@@ -728,19 +773,12 @@ master_process_release_req()
 }
 
 int
-master_process_topo(char* input_file)
+master_process_topo(char* buf, int length)
 {
-  char system_call[300];
-
-  if (strcasecmp(input_file, AST_XML_RECV) != 0) { 
-    sprintf(system_call, "cp %s %s", input_file, AST_XML_RECV); 
-    system(system_call);
-  }
-
-  /* after all the preparation, parse the application xml file 
+  /* parse the application xml message
    */ 
-  if ((glob_app_cfg = old_topo_xml_parser(AST_XML_RECV, MASTER)) == NULL &&
-      (glob_app_cfg = topo_xml_parser(AST_XML_RECV, MASTER)) == NULL) { 
+  if ((glob_app_cfg = old_topo_xml_parser_mem(buf, length, MASTER)) == NULL &&
+      (glob_app_cfg = topo_xml_parser_mem(buf, length, MASTER)) == NULL) { 
     zlog_err("master_process_topo: topo_xml_parser() failed"); 
     return 0;
   }
@@ -787,18 +825,19 @@ master_process_topo(char* input_file)
 }
 
 int 
-master_process_ctrl(char* filename)
+master_process_ctrl()
 {
   FILE *fp;
 
-  fp = fopen(AST_XML_RESULT, "w+");
+  fp = master_resp_open();
+  if (!fp)
+    return 0;
   
   fprintf(fp, "<ast_ctrl action=\"HELLO_RESP\">\n");
   fprintf(fp, "\t<msg>AST_MASTER, Version 1.0</msg>\n");
   fprintf(fp, "</ast_ctrl>\n");
  
-  fflush(fp);
-  fclose(fp);
+  master_resp_close(fp);
 
   return 1;
 }
@@ -1090,78 +1129,272 @@ main(int argc, char* argv[])
 
 int
 master_compose_req(struct application_cfg *app_cfg, 
-		  	    char *path, 
+		  	    FILE *fp, 
 			    struct resource* res)
 {
-  FILE *fp;
   int compose_req_value = 1;
 
-  if (!res || !app_cfg || !path || strlen(path) == 0) 
+  if (!res || !app_cfg || !fp) 
     return 1;
 
   if (res->res && res->subtype->mod && res->subtype->mod->compose_req_func)
-    compose_req_value = res->subtype->mod->compose_req_func(path, app_cfg, res);
+    compose_req_value = res->subtype->mod->compose_req_func(fp, app_cfg, res);
 
   if (compose_req_value != 1)
     return compose_req_value;
 
-  fp = fopen(path, "w+");
-  if (!fp) {
-    zlog_err("Can't open the file %s; error = %d(%s)", 
-		path, errno, strerror(errno));
-    return 1;
-  }
-  
   fprintf(fp, "<topology ast_id=\"%s\" action=\"%s\">\n", app_cfg->ast_id, action_type_details[app_cfg->action]);
 
   print_res(fp, res, MASTER);
   fprintf(fp, "</topology>");
-  fflush(fp);
-  fclose(fp);
 
   return 0;
 }
 
 int
-master_compose_broker_request(struct resource *myres, char* path)
+master_compose_broker_request(struct resource *myres, char* buf, int size)
 {
-  FILE *send_file;
-
-  if (!myres)
-    return 0;
-   
-  if (!path || strlen(path) == 0)
+  if (!myres || !buf)
     return 0;
 
-  send_file = fopen(path, "w+");
-  if (!send_file) 
+  if (snprintf(buf, size, "<topology>\n"
+	       "<resource type=\"%s\" name=\"%s\">\n"
+	       "</resource>\n"
+	       "</topology>", "FIONA", myres->name) >= size)
     return 0;
 
-  fprintf(send_file, "<topology>\n");
-  fprintf(send_file, "<resource type=\"%s\" name=\"%s\">\n",
-		"FIONA", myres->name);
-  fprintf(send_file, "</resource>\n"); 
-  fprintf(send_file, "</topology>");
-  fflush(send_file);
-  fclose(send_file);
-
   return 1;
 }
 
+/* A request on its way to a minion. The connect and the write are 
+ * driven by the thread loop, so all the minions of an ast are contacted 
+ * at once and an unreachable one only costs its own deadline.
+ * The resource is looked up again by name when the send finishes, as 
+ * the ast may have been released or failed in the meantime.
+ */
+struct minion_send {
+  char *ast_id;
+  char res_name[NODENAME_MAXLEN + 1];
+  enum resource_type res_type;
+  enum action_type action;
+  int keep;			/* wait for the reply on this socket */
+  int sock;
+  char *buf;
+  int length;
+  int sent;
+  struct thread *t_write;
+  struct thread *t_timeout;
+};
+
+static int minion_send_write(struct thread *);
+static int minion_send_timeout(struct thread *);
+
+static void
+minion_send_free(struct minion_send *ms)
+{
+  if (ms->t_write)
+    thread_cancel(ms->t_write);
+  if (ms->t_timeout)
+    thread_cancel(ms->t_timeout);
+  free(ms->ast_id);
+  free(ms->buf);
+  free(ms);
+}
+
+static struct resource *
+minion_send_res(struct minion_send *ms, struct application_cfg **app_cfg)
+{
+  *app_cfg = search_cfg_in_list(ms->ast_id);
+  if (!*app_cfg)
+    return NULL;
+
+  return search_res_by_name(*app_cfg, ms->res_type, ms->res_name);
+}
+
+/* the minion can't be reached; account for it the way 
+ * send_task_to_minions() does for a request that can't be sent
+ */
+static void
+minion_send_fail(struct minion_send *ms, char *error_msg)
+{
+  struct application_cfg *app_cfg;
+  struct resource *res;
+
+  close(ms->sock);
+  res = minion_send_res(ms, &app_cfg);
+  if (!res) {
+    zlog_err("%s (%s of %s)", error_msg, ms->res_name, ms->ast_id);
+    minion_send_free(ms);
+    return;
+  }
+
+  glob_app_cfg = app_cfg;
+  set_res_fail(error_msg, res);
+  if (ms->action == setup_req)
+    app_cfg->setup_ready++;
+  else if (ms->action == release_req)
+    app_cfg->release_ready++;
+  minion_send_free(ms);
+
+  integrate_result();
+  glob_app_cfg = NULL;
+  master_check_app_list();
+}
+
+static void
+minion_send_done(struct minion_send *ms)
+{
+  struct application_cfg *app_cfg;
+  struct resource *res;
+  int sock = ms->sock;
+
+  /* minion_callback() reads the reply with blocking recv() */
+  fcntl(sock, F_SETFL, fcntl(sock, F_GETFL) & ~O_NONBLOCK);
+
+  res = minion_send_res(ms, &app_cfg);
+  if (!res || !ms->keep) {
+    close(sock);
+    minion_send_free(ms);
+    return;
+  }
+
+  zlog_info("SOCK: %d added for minion_callback", sock); 
+  thread_add_read(master, minion_callback, NULL, sock); 
+  if (res->minion_sock != -1) { 
+    thread_remove_read(master, minion_callback, NULL, res->minion_sock); 
+    close(res->minion_sock); 
+    res->minion_sock = -1;
+  } 
+  res->minion_sock = sock; 
+  minion_send_free(ms);
+}
+
+static int
+minion_send_write(struct thread *thread)
+{
+  struct minion_send *ms = THREAD_ARG(thread);
+  int sent, err = 0;
+  socklen_t len = sizeof(err);
+
+  ms->t_write = NULL;
+
+  if (ms->sent == 0) {
+    if (getsockopt(ms->sock, SOL_SOCKET, SO_ERROR, &err, &len) < 0)
+      err = errno;
+    if (err) {
+      zlog_err("connect() to minion %s failed; %d(%s)", 
+		ms->res_name, err, strerror(err));
+      minion_send_fail(ms, "problem encountered to connect to the minion");
+      return 0;
+    }
+  }
+
+  while (ms->sent < ms->length) {
+    sent = send(ms->sock, ms->buf + ms->sent, ms->length - ms->sent, MSG_NOSIGNAL);
+    if (sent < 0) {
+      if (errno == EINTR)
+	continue;
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+	ms->t_write = thread_add_write(master, minion_send_write, ms, ms->sock);
+	return 0;
+      }
+      zlog_err("send() to minion %s failed; %d(%s)", 
+		ms->res_name, errno, strerror(errno));
+      minion_send_fail(ms, "problem encountered to send the request to the minion");
+      return 0;
+    }
+    ms->sent += sent;
+  }
+
+  minion_send_done(ms);
+  return 0;
+}
+
+static int
+minion_send_timeout(struct thread *thread)
+{
+  struct minion_send *ms = THREAD_ARG(thread);
+
+  ms->t_timeout = NULL;
+  minion_send_fail(ms, "minion didn't accept the request in time");
+  return 0;
+}
+
+/* start sending buf to the minion of res; returns -1 when that fails 
+ * right away, otherwise the outcome is handled by the thread loop.
+ * A setup still stops at the first minion that fails right away, but
+ * one that turns out unreachable later no longer keeps the request 
+ * from going to the minions after it.
+ */
+static int
+minion_send_start(struct resource *res, char *buf, int length, int keep)
+{
+  struct minion_send *ms;
+  struct sockaddr_in servAddr;
+  int sock;
+
+  if ((sock = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP)) < 0) {
+    zlog_err("minion_send_start: socket() failed");
+    return -1;
+  }
+  fcntl(sock, F_SETFL, fcntl(sock, F_GETFL) | O_NONBLOCK);
+
+  memset(&servAddr, 0, sizeof(servAddr));
+  servAddr.sin_family = AF_INET;
+  servAddr.sin_addr = res->ip;
+  servAddr.sin_port = htons(res->subtype->agent_port);
+
+  if (connect(sock, (struct sockaddr*)&servAddr, sizeof(servAddr)) < 0 &&
+      errno != EINPROGRESS) {
+    zlog_err("minion_send_start: connect() failed to %s port %d", 
+		inet_ntoa(res->ip), res->subtype->agent_port);
+    close(sock);
+    return -1;
+  }
+
+  ms = malloc(sizeof(struct minion_send));
+  if (!ms) {
+    zlog_err("minion_send_start: out of memory");
+    close(sock);
+    return -1;
+  }
+  memset(ms, 0, sizeof(struct minion_send));
+  ms->ast_id = strdup(glob_app_cfg->ast_id);
+  ms->buf = malloc(length);
+  if (!ms->ast_id || !ms->buf) {
+    zlog_err("minion_send_start: out of memory");
+    close(sock);
+    minion_send_free(ms);
+    return -1;
+  }
+  strcpy(ms->res_name, res->name);
+  ms->res_type = res->res_type;
+  ms->action = glob_app_cfg->action;
+  ms->keep = keep;
+  ms->sock = sock;
+  memcpy(ms->buf, buf, length);
+  ms->length = length;
+
+  ms->t_write = thread_add_write(master, minion_send_write, ms, sock);
+  ms->t_timeout = thread_add_timer(master, minion_send_timeout, ms, MINION_SEND_TIMEOUT);
+
+  return 0;
+}
+
 int
 send_task_to_minions(struct adtlist *res_list, 
 		     enum resource_type res_type)
 {
   struct adtlistnode *curnode;
   struct resource *res;
-  int sock, ready = 0, ret_value = 0;
+  int keep, ready = 0, ret_value = 0;
   u_int16_t flags;
-  static char buffer[RCVBUFSIZE];
-  static char send_buf[SENDBUFSIZE];
   static char directory[300];
   static char newpath[300];
-  static char path_prefix[300];
   char *type = (res_type == res_node)?"node":"link";
+  char *req = NULL;
+  size_t req_len = 0;
+  FILE *fp;
 
   if (!res_list)
     return 1;
@@ -1172,25 +1405,27 @@ send_task_to_minions(struct adtlist *res_list,
   
   if (glob_app_cfg->action == setup_req) {
     flags = FLAG_SETUP_REQ;
-    sprintf(path_prefix, "%s/setup_", directory);
   } else if (glob_app_cfg->action == release_req) {
     flags = FLAG_RELEASE_REQ;
-    sprintf(path_prefix, "%s/release_", directory);
   } else if (glob_app_cfg->action == query_req) {
     flags = FLAG_QUERY_REQ;
-    sprintf(path_prefix, "%s/query_", directory);
   } else if (glob_app_cfg->action == ast_complete) {
     flags = FLAG_AST_COMPLETE;
+    /* every minion gets the same ast_complete message */
+    fp = open_memstream(&req, &req_len);
+    if (!fp) {
+      zlog_err("send_task_to_minions: can't compose ast_complete");
+      return 1;
+    }
+    print_final_fp(fp, MASTER);
+    fclose(fp);
     sprintf(newpath, "%s/ast_complete.xml", directory);
-    print_final(newpath, MASTER);
+    save_buffer(newpath, req, req_len);
   } else {
     zlog_err("send_task_to_minions: invalid action");
     return 0;
   }
 
-  memset(buffer, 0, RCVBUFSIZE);
-  memset(send_buf, 0, SENDBUFSIZE);
-
   for (curnode = res_list->head;
        curnode && !(ready && glob_app_cfg->action == setup_req);
        curnode = curnode->next) {
@@ -1213,27 +1448,20 @@ send_task_to_minions(struct adtlist *res_list,
     }
 
     if (glob_app_cfg->action != ast_complete) {
-      sprintf(newpath, "%srequest_%s_%s.xml", path_prefix, type, res->name);
-      if (master_compose_req(glob_app_cfg, newpath, res)) {
+      if (req)
+	free(req);
+      req = NULL;
+      req_len = 0;
+      fp = open_memstream(&req, &req_len);
+      if (!fp || master_compose_req(glob_app_cfg, fp, res)) {
+	if (fp)
+	  fclose(fp);
 	ready++; 
 	ret_value++;
 	set_res_fail("problem encountered to compose the request to minion", res);
 	continue;
       }
-    }
-
-    zlog_info("sending request to %s (%s:%d)", 
-		res->name, inet_ntoa(res->ip), res->subtype->agent_port);
-    sock = send_file_to_agent(inet_ntoa(res->ip), res->subtype->agent_port, newpath);
-    if (sock == -1)  {
-      ready++;
-      ret_value++;
-      set_res_fail("problem encountered to connect to the minion", res);
-      res->status = ast_failure;
-      continue;
-    } else {
-      res->status = ast_pending,
-      res->flags |= flags;
+      fclose(fp);
     }
 
 // FIONA
@@ -1247,24 +1475,29 @@ send_task_to_minions(struct adtlist *res_list,
  * thus, when it's case of res_link, we don't add the socket to minion_callback if it's
  * setup_req
  */
-    if ((glob_app_cfg->action != ast_complete && res_type == res_node) || 
- 	(glob_app_cfg->action != setup_req && res_type == res_link)) { 
-      zlog_info("SOCK: %d added for minion_callback", sock); 
-      thread_add_read(master, minion_callback, NULL, sock); 
-      if (res->minion_sock != -1) { 
-	thread_remove_read(master, minion_callback, NULL, res->minion_sock); 
-	close(res->minion_sock); 
-//	zlog_info("SOCK: closing minion_sock %d", res->minion_sock); 
-	res->minion_sock = -1;
-      } 
-      res->minion_sock = sock; 
-    } else  
-      close(sock); 
+    keep = ((glob_app_cfg->action != ast_complete && res_type == res_node) || 
+ 	    (glob_app_cfg->action != setup_req && res_type == res_link)); 
+
+    zlog_info("sending request to %s (%s:%d)", 
+		res->name, inet_ntoa(res->ip), res->subtype->agent_port);
+    if (minion_send_start(res, req, req_len, keep) == -1)  {
+      ready++;
+      ret_value++;
+      set_res_fail("problem encountered to connect to the minion", res);
+      res->status = ast_failure;
+      continue;
+    } else {
+      res->status = ast_pending,
+      res->flags |= flags;
+    }
 
     if (glob_app_cfg->action == setup_req) 
       glob_app_cfg->setup_sent++;
   }
 
+  if (req)
+    free(req);
+
   if (glob_app_cfg->action == setup_req)
     glob_app_cfg->setup_ready += ready;
   else if (glob_app_cfg->action == release_req)
@@ -1282,6 +1515,7 @@ integrate_result()
   static char newpath[300];
   static char path_prefix[300];
   int sendtask_ret;
+  FILE *fp;
 
   /* first, save the cur cfg into final.xml */
   sprintf(directory, "%s/%s", AST_DIR, glob_app_cfg->ast_id);
@@ -1290,7 +1524,10 @@ integrate_result()
     print_final(newpath, MASTER);
   }
   add_cfg_to_list();
-  symlink(newpath, AST_XML_RESULT);
+  if (!master_resp_ready() && (fp = master_resp_open()) != NULL) {
+    print_final_fp(fp, MASTER);
+    master_resp_close(fp);
+  }
 
   switch (glob_app_cfg->action) {
     case setup_resp:
@@ -1377,9 +1614,8 @@ integrate_result()
     else 
       glob_app_cfg->flags |= FLAG_RELEASE_RESP;
 
-    unlink(AST_XML_RESULT);
-    print_final_client(AST_XML_RESULT);
-    if (send_file_over_sock(glob_app_cfg->clnt_sock, AST_XML_RESULT))
+    print_final_client();
+    if (master_resp_send(glob_app_cfg->clnt_sock))
       zlog_err("Failed to send the result back to client");
     close(glob_app_cfg->clnt_sock);
     glob_app_cfg->clnt_sock = -1;
@@ -1413,15 +1649,13 @@ master_accept(struct thread *thread)
   int servSock, clntSock;
   struct sockaddr_in clntAddr;
   unsigned int clntLen;
-  struct stat sb;
-  int fd;
+  FILE *fp;
 
   alarm(0);
   servSock = THREAD_FD(thread);
 
   clntLen = sizeof(clntAddr);
-  unlink(AST_XML_RESULT);
-  unlink(AST_XML_RECV);
+  master_resp_clear();
     
   if ((clntSock = accept(servSock, (struct sockaddr*)&clntAddr, &clntLen)) < 0) {
     zlog_err("master_accept: accept() failed");
@@ -1429,7 +1663,8 @@ master_accept(struct thread *thread)
   }
 
   zlog_info("master_accept(): START; fd: %d", clntSock);
-  if (recv_file(clntSock, AST_XML_RECV, 4000, TIMEOUT_SECS, MASTER)) {
+  master_recv_buf = recv_buffer(clntSock, 4000, TIMEOUT_SECS, &master_recv_len);
+  if (!master_recv_buf) {
     zlog_info("master_accept(): recv error");
     close(clntSock);
     thread_add_read(master, master_accept, NULL, servSock);
@@ -1439,24 +1674,25 @@ master_accept(struct thread *thread)
   glob_app_cfg = NULL;
   zlog_info("Handling client %s ...", inet_ntoa(clntAddr.sin_addr));
 
-  switch(xml_parser(AST_XML_RECV)) {
+  switch(xml_parser_mem(master_recv_buf, master_recv_len)) {
 
     case TOPO_XML:
 
       zlog_info("XML_TYPE: TOPO_XML");
-      if (!master_process_topo(AST_XML_RECV)) {
-	if (!glob_app_cfg)
-	  print_error_response(AST_XML_RESULT);
-	else
+      if (!master_process_topo(master_recv_buf, master_recv_len)) {
+	if (!glob_app_cfg) {
+	  if ((fp = master_resp_open()) != NULL) {
+	    print_error_response_fp(fp);
+	    master_resp_close(fp);
+	  }
+	} else
 	  glob_app_cfg->status = ast_failure;
 	  
 	break;
-      } else {
-	/* supposedly at this point, AST_XML_RECV should exist */
-	fd = open(AST_XML_RESULT, O_RDONLY);
-	if (fd == -1)
-	  print_final(AST_XML_RESULT, MASTER);
-	close(fd);
+      } else if (!master_resp_ready() && glob_app_cfg &&
+		 (fp = master_resp_open()) != NULL) {
+	print_final_fp(fp, MASTER);
+	master_resp_close(fp);
       }
 
       if (glob_app_cfg && glob_app_cfg->details[0] != '\0')
@@ -1480,7 +1716,7 @@ master_accept(struct thread *thread)
     case ID_XML:
 
       zlog_info("XML_TYPE: ID_XML");
-      master_process_id(AST_XML_RECV);
+      master_process_id(master_recv_buf, master_recv_len);
       free_application_cfg(glob_app_cfg);
       glob_app_cfg = NULL;
 
@@ -1489,14 +1725,14 @@ master_accept(struct thread *thread)
     case ID_QUERY_XML:
 
       zlog_info("XML_TYPE: ID_QUERY_XML");
-      master_process_id(AST_XML_RECV);
+      master_process_id(master_recv_buf, master_recv_len);
       free_application_cfg(glob_app_cfg);
       glob_app_cfg = NULL;
      
       break;
     case CTRL_XML:
       zlog_info("XML_TYPE: CTRL_XML");
-      master_process_ctrl(AST_XML_RECV);
+      master_process_ctrl();
    
       break;
    
@@ -1515,10 +1751,12 @@ master_accept(struct thread *thread)
     /* CASE:
      * we simply have no glob_app_cfg pointer; fundamental error
      */
-    if (stat(AST_XML_RESULT, &sb) == -1)
-      print_error_response(AST_XML_RESULT);
+    if (!master_resp_ready() && (fp = master_resp_open()) != NULL) {
+      print_error_response_fp(fp);
+      master_resp_close(fp);
+    }
 
-    send_file_over_sock(clntSock, AST_XML_RESULT);
+    master_resp_send(clntSock);
     close(clntSock);
 //    zlog_info("SOCK: closing clntSock %d", clntSock);
   } else if (strcasecmp(glob_app_cfg->ast_id, "all") == 0) {
@@ -1526,13 +1764,14 @@ master_accept(struct thread *thread)
     /* CASE: 
      * when user is calling to release ALL ast 
      */
-    send_file_over_sock(clntSock, AST_XML_RESULT);
+    master_resp_send(clntSock);
     close(clntSock);
     zlog_info("SOCK: closing clntSock %d", clntSock);
     glob_app_cfg->clnt_sock = -1;
     zlog_info("master_accept(): DONE");
     thread_add_read(master, master_accept, NULL, servSock);
     free_application_cfg(glob_app_cfg);
+    master_recv_done();
 
     return 1;
   } else if (glob_app_cfg->clnt_sock == -1 || 
@@ -1549,10 +1788,9 @@ master_accept(struct thread *thread)
       glob_app_cfg->action = release_resp;
       glob_app_cfg->flags |= FLAG_RELEASE_RESP;
     } 
-    unlink(AST_XML_RESULT); 
-    print_final_client(AST_XML_RESULT);
+    print_final_client();
 
-    send_file_over_sock(clntSock, AST_XML_RESULT);
+    master_resp_send(clntSock);
     close(clntSock);
     glob_app_cfg->clnt_sock = -1;
   } else if (glob_app_cfg->clnt_sock == -1 || 
@@ -1568,6 +1806,7 @@ master_accept(struct thread *thread)
     free_application_cfg(glob_app_cfg);
   glob_app_cfg = NULL;
 
+  master_recv_done();
   zlog_info("master_accept(): DONE; fd: %d", clntSock);
 
   thread_add_read(master, master_accept, NULL, servSock);
@@ -1584,15 +1823,15 @@ minion_callback(struct thread *thread)
 
   alarm(0);
   servSock = THREAD_FD(thread);
-  unlink(AST_XML_RECV);
 
   zlog_info("minion_callback(): START; fd: %d", servSock);
 
-  if (recv_file(servSock, AST_XML_RECV, RCVBUFSIZE, TIMEOUT_SECS, MASTER)) {
+  master_recv_buf = recv_buffer(servSock, RCVBUFSIZE, TIMEOUT_SECS, &master_recv_len);
+  if (!master_recv_buf) {
     ret_value = 0;
   } else {
       
-    if ((glob_app_cfg = topo_xml_parser(AST_XML_RECV, MASTER)) == NULL) {
+    if ((glob_app_cfg = topo_xml_parser_mem(master_recv_buf, master_recv_len, MASTER)) == NULL) {
       zlog_err("received file is not parsed correctly, ignore ...");
       ret_value = 0;
     } else if (topo_validate_graph(MASTER, glob_app_cfg)) {
@@ -1622,6 +1861,7 @@ minion_callback(struct thread *thread)
   }
 
   close(servSock);
+  master_recv_done();
   master_check_app_list();
   zlog_info("minion_callback(): DONE; fd: %d", servSock);
 
@@ -1635,15 +1875,12 @@ master_locate_resource()
   struct adtlistnode *curnode;
   struct resource *myres, *newres;
   int sock;
+  char request[300];
   char buffer[501];
   int bytesRcvd;
-  FILE *fp;
   struct application_cfg *working_app_cfg; 
   struct resource_agent *agent;
 
-  unlink(BROKER_SEND);
-  unlink(BROKER_RECV);
-
   if (!glob_app_cfg->node_list)
     return 0;
 
@@ -1662,11 +1899,11 @@ master_locate_resource()
       return 0;
     }
 
-    if (!master_compose_broker_request(myres, BROKER_SEND)) {
+    if (!master_compose_broker_request(myres, request, sizeof(request))) {
       set_res_fail("Fail to compose broker request", myres);
       return 0;
     }
-    sock = send_file_to_agent(agent->add, agent->port, BROKER_SEND);
+    sock = send_buf_to_agent(agent->add, agent->port, request, strlen(request));
 
     if (sock == -1) {
       set_res_fail("Error in connecting the broker", myres);
@@ -1675,12 +1912,8 @@ master_locate_resource()
 
     if ((bytesRcvd = recv(sock, buffer, 500, 0))  > 0) {
       buffer[bytesRcvd] = '\0';
-      fp = fopen(BROKER_RECV, "w+");
-      fprintf(fp, buffer);
-      fflush(fp);
-      fclose(fp);
       close(sock);
-      if ((working_app_cfg = topo_xml_parser(BROKER_RECV, BRIEF_VERSION)) == NULL) { 
+      if ((working_app_cfg = topo_xml_parser_mem(buffer, bytesRcvd, BRIEF_VERSION)) == NULL) { 
 	set_res_fail("Broker resource can't be parsed successfully", myres);
 	return 0;
       } else if (!working_app_cfg->node_list) {
@@ -1759,11 +1992,11 @@ master_check_app_list()
       print_final(newpath, MASTER);
       sprintf(newpath, "%s/%s/final.xml", AST_DIR, app_cfg->ast_id);
       print_final(newpath, MASTER);
-      print_final_client(AST_XML_RESULT);
+      print_final_client();
 
       glob_app_cfg = cur_cfg;
 
-      if (send_file_over_sock(app_cfg->clnt_sock, AST_XML_RESULT))
+      if (master_resp_send(app_cfg->clnt_sock))
 	zlog_err("Failed to send the result back to client");
       close(app_cfg->clnt_sock);
       app_cfg->clnt_sock = -1;
@@ -1781,10 +2014,10 @@ master_check_app_list()
       print_final(newpath, MASTER);
       sprintf(newpath, "%s/%s/final.xml", AST_DIR, app_cfg->ast_id);
       print_final(newpath, MASTER);
-      print_final_client(AST_XML_RESULT);
+      print_final_client();
       glob_app_cfg = NULL;
 
-      if (send_file_over_sock(app_cfg->clnt_sock, AST_XML_RESULT))
+      if (master_resp_send(app_cfg->clnt_sock))
 	zlog_err("Failed to send the result back to client");
       close(app_cfg->clnt_sock);
       app_cfg->clnt_sock = -1;
@@ -25,6 +25,9 @@
 #include "prefix.h"
 #include "hash.h"
 #include "thread.h"
+#include "linklist.h"
+#include "stream.h"
+#include "if.h"
 
 #include "bgpd/bgpd.h"
 #include "bgpd/bgp_table.h"
@@ -35,6 +38,7 @@
 #include "bgpd/bgp_packet.h"
 #include "bgpd/bgp_fsm.h"
 #include "bgpd/bgp_mplsvpn.h"
+#include "bgpd/bgp_nexthop.h"
  
 /* BGP advertise attribute is used for pack same attribute update into
    one packet.  To do that we maintain attribute hash in struct
@@ -403,3 +407,262 @@ bgp_sync_delete (struct peer *peer)
 	hash_free (peer->hash[afi][safi]);
       }
 }
+
+/* Update groups.  Established peers are grouped per address family by
+   what their outbound UPDATEs depend on; a peer which is not in a peer
+   group, or has an ORF prefix-list, is a group of its own.  Groups are
+   rebuilt lazily after any peer changes state or outbound config.  */
+static int
+bgp_update_group_name_same (char *n1, char *n2)
+{
+  if (n1 == NULL || n2 == NULL)
+    return n1 == n2;
+  return strcmp (n1, n2) == 0;
+}
+
+static int
+bgp_update_group_match (struct peer *p1, struct peer *p2,
+			afi_t afi, safi_t safi)
+{
+  struct bgp_filter *f1 = &p1->filter[afi][safi];
+  struct bgp_filter *f2 = &p2->filter[afi][safi];
+
+  if (! p1->group || p1->group != p2->group)
+    return 0;
+
+  if (p1->orf_plist[afi][safi] || p2->orf_plist[afi][safi])
+    return 0;
+
+  if (peer_sort (p1) != peer_sort (p2)
+      || p1->as != p2->as
+      || p1->local_as != p2->local_as
+      || p1->change_local_as != p2->change_local_as
+      || p1->version != p2->version
+      || p1->shared_network != p2->shared_network
+      || p1->af_flags[afi][safi] != p2->af_flags[afi][safi]
+      || (CHECK_FLAG (p1->af_sflags[afi][safi], PEER_STATUS_DEFAULT_ORIGINATE)
+	  != CHECK_FLAG (p2->af_sflags[afi][safi],
+			 PEER_STATUS_DEFAULT_ORIGINATE)))
+    return 0;
+
+  /* A third party nexthop depends on the connected network of each
+     eBGP peer.  */
+  if (peer_sort (p1) == BGP_PEER_EBGP
+      && ! CHECK_FLAG (p1->af_flags[afi][safi], PEER_FLAG_NEXTHOP_SELF)
+      && ! bgp_multiaccess_same_v4 (p1->host, p2->host))
+    return 0;
+
+  /* The nexthop is our address on each session.  */
+  if (! IPV4_ADDR_SAME (&p1->nexthop.v4, &p2->nexthop.v4))
+    return 0;
+#ifdef HAVE_IPV6
+  if (! IPV6_ADDR_SAME (&p1->nexthop.v6_global, &p2->nexthop.v6_global)
+      || ! IPV6_ADDR_SAME (&p1->nexthop.v6_local, &p2->nexthop.v6_local))
+    return 0;
+#endif /* HAVE_IPV6 */
+
+  return (bgp_update_group_name_same (f1->dlist[FILTER_OUT].name,
+				      f2->dlist[FILTER_OUT].name)
+	  && bgp_update_group_name_same (f1->plist[FILTER_OUT].name,
+					 f2->plist[FILTER_OUT].name)
+	  && bgp_update_group_name_same (f1->aslist[FILTER_OUT].name,
+					 f2->aslist[FILTER_OUT].name)
+	  && bgp_update_group_name_same (f1->map[FILTER_OUT].name,
+					 f2->map[FILTER_OUT].name)
+	  && bgp_update_group_name_same (f1->usmap.name, f2->usmap.name));
+}
+
+static void
+bgp_update_cache_free (struct bgp_update_group *group,
+		       struct bgp_update_cache *cache)
+{
+  int i;
+
+  FIFO_DEL (cache);
+  group->cache_count--;
+
+  stream_free (cache->packet);
+  bgp_attr_unintern (cache->attr);
+  for (i = 0; i < cache->count; i++)
+    bgp_unlock_node (cache->rn[i]);
+  XFREE (MTYPE_BGP_UPDATE_CACHE, cache->rn);
+  XFREE (MTYPE_BGP_UPDATE_CACHE, cache);
+}
+
+static void
+bgp_update_group_free (struct bgp_update_group *group)
+{
+  struct bgp_update_cache *cache;
+
+  while ((cache = (struct bgp_update_cache *) FIFO_HEAD (&group->cache)))
+    bgp_update_cache_free (group, cache);
+
+  list_delete (group->peer);
+  XFREE (MTYPE_BGP_UPDATE_GROUP, group);
+}
+
+static void
+bgp_update_groups_clear (struct bgp *bgp, afi_t afi, safi_t safi)
+{
+  struct list *groups;
+  struct listnode *nn;
+  struct bgp_update_group *group;
+  struct peer *peer;
+
+  groups = bgp->update_groups[afi][safi];
+  if (! groups)
+    return;
+
+  LIST_LOOP (groups, group, nn)
+    bgp_update_group_free (group);
+  list_delete (groups);
+  bgp->update_groups[afi][safi] = NULL;
+
+  LIST_LOOP (bgp->peer, peer, nn)
+    peer->update_group[afi][safi] = NULL;
+}
+
+/* Outbound state of some peer changed: drop the groups and their cached
+   packets, they are built again on next use.  */
+void
+bgp_update_group_reset (struct bgp *bgp)
+{
+  afi_t afi;
+  safi_t safi;
+
+  if (! bgp)
+    return;
+
+  for (afi = AFI_IP; afi < AFI_MAX; afi++)
+    for (safi = SAFI_UNICAST; safi < SAFI_MAX; safi++)
+      bgp_update_groups_clear (bgp, afi, safi);
+}
+
+/* Update groups of BGP for AFI/SAFI, regrouping the peers if needed.  */
+struct list *
+bgp_update_groups (struct bgp *bgp, afi_t afi, safi_t safi)
+{
+  struct listnode *nn;
+  struct listnode *nm;
+  struct peer *peer;
+  struct bgp_update_group *group;
+
+  if (bgp->update_groups[afi][safi])
+    return bgp->update_groups[afi][safi];
+
+  bgp->update_groups[afi][safi] = list_new ();
+
+  LIST_LOOP (bgp->peer, peer, nn)
+    {
+      if (peer->status != Established || ! peer->afc_nego[afi][safi])
+	continue;
+
+      LIST_LOOP (bgp->update_groups[afi][safi], group, nm)
+	if (bgp_update_group_match (getdata (listhead (group->peer)),
+				    peer, afi, safi))
+	  break;
+
+      if (! nm)
+	{
+	  group = XCALLOC (MTYPE_BGP_UPDATE_GROUP,
+			   sizeof (struct bgp_update_group));
+	  group->afi = afi;
+	  group->safi = safi;
+	  group->peer = list_new ();
+	  FIFO_INIT (&group->cache);
+	  listnode_add (bgp->update_groups[afi][safi], group);
+	}
+
+      listnode_add (group->peer, peer);
+      peer->update_group[afi][safi] = group;
+    }
+
+  return bgp->update_groups[afi][safi];
+}
+
+/* Look for an UPDATE another member of PEER's group has built from the
+   same advertisements PEER is about to send, starting with ADV.  The
+   packet takes ADV and then the advertisements of its attribute in
+   list order, as bgp_advertise_clean hands them out.  */
+struct bgp_update_cache *
+bgp_update_cache_lookup (struct peer *peer, afi_t afi, safi_t safi,
+			 struct bgp_advertise *adv)
+{
+  struct bgp_update_group *group;
+  struct bgp_update_cache *cache;
+  struct bgp_advertise *next;
+  struct peer *from;
+  struct fifo *f;
+  int i;
+
+  group = peer->update_group[afi][safi];
+  if (! group || ! adv->baa || ! adv->binfo || ! adv->rn)
+    return NULL;
+  from = adv->binfo->peer;
+
+  for (f = group->cache.next; f != &group->cache; f = f->next)
+    {
+      cache = (struct bgp_update_cache *) f;
+      if (cache->attr != adv->baa->attr
+	  || cache->rn[0] != adv->rn
+	  || cache->from != from
+	  || ! IPV4_ADDR_SAME (&cache->from_id, &from->remote_id))
+	continue;
+
+      i = 1;
+      for (next = adv->baa->adv; next && i < cache->count; next = next->next)
+	{
+	  if (next == adv)
+	    continue;
+	  if (next->rn != cache->rn[i])
+	    break;
+	  i++;
+	}
+      if (i == cache->count)
+	return cache;
+    }
+  return NULL;
+}
+
+/* PEER sent CACHE's packet; drop it once no other member may.  */
+void
+bgp_update_cache_used (struct peer *peer, afi_t afi, safi_t safi,
+		       struct bgp_update_cache *cache)
+{
+  if (--cache->users <= 0)
+    bgp_update_cache_free (peer->update_group[afi][safi], cache);
+}
+
+/* Remember PACKET, built for PEER, for the other members of its group.  */
+void
+bgp_update_cache_add (struct peer *peer, afi_t afi, safi_t safi,
+		      struct stream *packet, struct attr *attr,
+		      struct peer *from, struct bgp_node **rn, int count)
+{
+  struct bgp_update_group *group;
+  struct bgp_update_cache *cache;
+  int i;
+
+  group = peer->update_group[afi][safi];
+  if (! group || listcount (group->peer) < 2 || count == 0)
+    return;
+
+  if (group->cache_count >= BGP_UPDATE_CACHE_MAX)
+    bgp_update_cache_free (group, (struct bgp_update_cache *)
+			   FIFO_HEAD (&group->cache));
+
+  cache = XCALLOC (MTYPE_BGP_UPDATE_CACHE, sizeof (struct bgp_update_cache));
+  cache->packet = stream_share (packet);
+  cache->attr = bgp_attr_intern (attr);
+  cache->from = from;
+  cache->from_id = from->remote_id;
+  cache->count = count;
+  cache->users = listcount (group->peer) - 1;
+  cache->rn = XMALLOC (MTYPE_BGP_UPDATE_CACHE,
+		       sizeof (struct bgp_node *) * count);
+  for (i = 0; i < count; i++)
+    cache->rn[i] = bgp_lock_node (rn[i]);
+
+  FIFO_ADD (&group->cache, cache);
+  group->cache_count++;
+}
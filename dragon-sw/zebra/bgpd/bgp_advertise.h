@@ -99,6 +99,45 @@ struct bgp_synchronize
   struct bgp_advertise_fifo withdraw_low;
 };
 
+/* Peers with the same outbound policy and capabilities form an update
+   group.  Policy is evaluated once per group, and the UPDATE packets
+   built for one member are shared with the others.  */
+struct bgp_update_group
+{
+  afi_t afi;
+  safi_t safi;
+
+  /* Members.  The first one stands for the group in policy checks.  */
+  struct list *peer;
+
+  /* Recently built UPDATE packets, oldest first.  */
+  struct fifo cache;
+  unsigned long cache_count;
+};
+
+/* An UPDATE packet built for a member of an update group.  */
+struct bgp_update_cache
+{
+  struct bgp_update_cache *next;
+  struct bgp_update_cache *prev;
+
+  /* The packet, sharing its data with the member it was built for.  */
+  struct stream *packet;
+
+  /* What it was built from: the attribute, the peer the route came
+     from and the prefixes in packet order.  */
+  struct attr *attr;
+  struct peer *from;
+  struct in_addr from_id;
+  struct bgp_node **rn;
+  int count;
+
+  /* Members which may still use it.  */
+  int users;
+};
+
+#define BGP_UPDATE_CACHE_MAX  64
+
 /* BGP adjacency linked list.  */
 #define BGP_INFO_ADD(N,A,TYPE)                        \
   do {                                                \
@@ -143,3 +182,14 @@ bgp_advertise_clean (struct peer *, struct bgp_adj_out *, afi_t, safi_t);
 
 void bgp_sync_init (struct peer *);
 void bgp_sync_delete (struct peer *);
+
+void bgp_update_group_reset (struct bgp *);
+struct list *bgp_update_groups (struct bgp *, afi_t, safi_t);
+struct bgp_update_cache *
+bgp_update_cache_lookup (struct peer *, afi_t, safi_t,
+			 struct bgp_advertise *);
+void bgp_update_cache_used (struct peer *, afi_t, safi_t,
+			    struct bgp_update_cache *);
+void bgp_update_cache_add (struct peer *, afi_t, safi_t, struct stream *,
+			   struct attr *, struct peer *, struct bgp_node **,
+			   int);
@@ -125,6 +125,44 @@ aspath_delimiter_char (u_char type, u_char which)
   return ' ';
 }
 
+/* Check the segments of AS path and count the AS numbers in it for
+   best path selection.  Return -1 when the AS path is malformed. */
+static int
+aspath_count_make (struct aspath *as)
+{
+  caddr_t pnt;
+  caddr_t end;
+  struct assegment *assegment;
+  int count = 0;
+
+  pnt = as->data;
+  end = pnt + as->length;
+
+  while (pnt < end)
+    {
+      assegment = (struct assegment *) pnt;
+
+      if ((assegment->type != AS_SET) && 
+	  (assegment->type != AS_SEQUENCE) &&
+	  (assegment->type != AS_CONFED_SET) && 
+	  (assegment->type != AS_CONFED_SEQUENCE))
+	return -1;
+
+      if ((pnt + (assegment->length * AS_VALUE_SIZE) + AS_HEADER_SIZE) > end)
+	return -1;
+
+      if (assegment->type == AS_SEQUENCE)
+	count += assegment->length;
+      else if (assegment->type == AS_SET)
+	count++;
+
+      pnt += (assegment->length * AS_VALUE_SIZE) + AS_HEADER_SIZE;
+    }
+
+  as->count = count;
+  return 0;
+}
+
 /* Convert aspath structure to string expression. */
 char *
 aspath_make_str_count (struct aspath *as)
@@ -268,8 +306,16 @@ aspath_intern (struct aspath *aspath)
 
   find->refcnt++;
 
-  if (! find->str)
-    find->str = aspath_make_str_count (find);
+  /* The string is made when it is first printed. */
+  if (find == aspath)
+    {
+      if (find->str)
+	{
+	  XFREE (MTYPE_AS_STR, find->str);
+	  find->str = NULL;
+	}
+      aspath_count_make (find);
+    }
 
   return find;
 }
@@ -318,11 +364,8 @@ aspath_hash_alloc (struct aspath *arg)
   else
     aspath->data = NULL;
 
-  /* Make AS path string. */
-  aspath->str = aspath_make_str_count (aspath);
-
   /* Malformed AS path value. */
-  if (! aspath->str)
+  if (aspath_count_make (aspath) < 0)
     {
       aspath_free (aspath);
       return NULL;
@@ -962,7 +1005,6 @@ aspath_empty_get ()
   struct aspath *aspath;
 
   aspath = aspath_new ();
-  aspath->str = aspath_make_str_count (aspath);
   return aspath;
 }
 
@@ -971,6 +1013,29 @@ aspath_count ()
 {
   return ashash->count;
 }     
+
+static void
+aspath_memory_iterator (struct hash_backet *backet, unsigned long *bytes)
+{
+  struct aspath *as = backet->data;
+
+  *bytes += sizeof (struct aspath) + as->length;
+  if (as->str)
+    *bytes += strlen (as->str) + 1;
+}
+
+/* Return bytes used by interned AS paths.  */
+unsigned long
+aspath_memory ()
+{
+  unsigned long bytes = 0;
+
+  hash_iterate (ashash,
+		(void (*) (struct hash_backet *, void *))
+		aspath_memory_iterator,
+		&bytes);
+  return bytes;
+}
  
 /* 
    Theoretically, one as path can have:
@@ -1106,7 +1171,7 @@ aspath_str2aspath (char *str)
 	}
     }
 
-  aspath->str = aspath_make_str_count (aspath);
+  aspath_count_make (aspath);
 
   return aspath;
 }
@@ -1115,20 +1180,7 @@ aspath_str2aspath (char *str)
 unsigned int
 aspath_key_make (struct aspath *aspath)
 {
-  unsigned int key = 0;
-  int length;
-  unsigned short *pnt;
-
-  length = aspath->length / 2;
-  pnt = (unsigned short *) aspath->data;
-
-  while (length)
-    {
-      key += *pnt++;
-      length--;
-    }
-
-  return key;
+  return hash_bytes (aspath->data, aspath->length);
 }
 
 /* If two aspath have same value then return 1 else return 0 */
@@ -1153,14 +1205,16 @@ aspath_init ()
 const char *
 aspath_print (struct aspath *as)
 {
-  return as->str;
+  if (! as->str)
+    as->str = aspath_make_str_count (as);
+  return as->str ? as->str : "";
 }
 
 /* Printing functions */
 void
 aspath_print_vty (struct vty *vty, struct aspath *as)
 {
-  vty_out (vty, "%s", as->str);
+  vty_out (vty, "%s", aspath_print (as));
 }
 
 void
@@ -1171,7 +1225,7 @@ aspath_show_all_iterator (struct hash_backet *backet, struct vty *vty)
   as = (struct aspath *) backet->data;
 
   vty_out (vty, "[%p:%d] (%ld) ", backet, backet->key, as->refcnt);
-  vty_out (vty, "%s%s", as->str, VTY_NEWLINE);
+  vty_out (vty, "%s%s", aspath_print (as), VTY_NEWLINE);
 }
 
 /* Print all aspath and hash information.  This function is used from
@@ -75,3 +75,4 @@ int aspath_loop_check (struct aspath *, as_t);
 int aspath_private_as_check (struct aspath *);
 int aspath_firstas_check (struct aspath *, as_t);
 unsigned long aspath_count ();
+unsigned long aspath_memory ();
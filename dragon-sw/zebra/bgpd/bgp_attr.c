@@ -111,17 +111,7 @@ cluster_loop_check (struct cluster_list *cluster, struct in_addr originator)
 unsigned int
 cluster_hash_key_make (struct cluster_list *cluster)
 {
-  unsigned int key = 0;
-  int length;
-  caddr_t pnt;
-
-  length = cluster->length;
-  pnt = (caddr_t) cluster->list;
-  
-  while (length)
-    key += pnt[--length];
-
-  return key;
+  return hash_bytes (cluster->list, cluster->length);
 }
 
 int
@@ -242,17 +232,7 @@ transit_unintern (struct transit *transit)
 unsigned int
 transit_hash_key_make (struct transit *transit)
 {
-  unsigned int key = 0;
-  int length;
-  caddr_t pnt;
-
-  length = transit->length;
-  pnt = (caddr_t) transit->val;
-  
-  while (length)
-    key += pnt[--length];
-
-  return key;
+  return hash_bytes (transit->val, transit->length);
 }
 
 int
@@ -274,68 +254,64 @@ transit_init ()
 
 struct hash *attrhash;
 
+/* Attribute hash key is made from the attribute values in a fixed
+   order.  The referenced structures are already interned when an
+   attribute is hashed, so their addresses stand for their values just
+   as they do in attrhash_cmp(). */
+#define ATTR_KEY_PUT(P,V)   (memcpy ((P), &(V), sizeof (V)), (P) += sizeof (V))
+
 unsigned int
 attrhash_key_make (struct attr *attr)
 {
-  unsigned int key = 0;
-
-  key += attr->origin;
-  key += attr->nexthop.s_addr;
-  key += attr->med;
-  key += attr->local_pref;
-  key += attr->aggregator_as;
-  key += attr->aggregator_addr.s_addr;
-  key += attr->weight;
-
-  key += attr->mp_nexthop_global_in.s_addr;
-  if (attr->aspath)
-    key += aspath_key_make (attr->aspath);
-  if (attr->community)
-    key += community_hash_make (attr->community);
-  if (attr->ecommunity)
-    key += ecommunity_hash_make (attr->ecommunity);
-  if (attr->cluster)
-    key += cluster_hash_key_make (attr->cluster);
-  if (attr->transit)
-    key += transit_hash_key_make (attr->transit);
-
+  u_char buf[sizeof (struct attr)];
+  u_char *pnt = buf;
+
+  ATTR_KEY_PUT (pnt, attr->flag);
+  ATTR_KEY_PUT (pnt, attr->origin);
+  ATTR_KEY_PUT (pnt, attr->nexthop);
+  ATTR_KEY_PUT (pnt, attr->med);
+  ATTR_KEY_PUT (pnt, attr->local_pref);
+  ATTR_KEY_PUT (pnt, attr->weight);
+  ATTR_KEY_PUT (pnt, attr->aspath);
+  ATTR_KEY_PUT (pnt, attr->community);
+  ATTR_KEY_PUT (pnt, attr->aggregator_as);
+  ATTR_KEY_PUT (pnt, attr->aggregator_addr);
+  ATTR_KEY_PUT (pnt, attr->mp_nexthop_global_in);
+  ATTR_KEY_PUT (pnt, attr->cluster);
+  ATTR_KEY_PUT (pnt, attr->ecommunity);
+  ATTR_KEY_PUT (pnt, attr->transit);
 #ifdef HAVE_IPV6
-  {
-    int i;
-   
-    key += attr->mp_nexthop_len;
-    for (i = 0; i < 16; i++)
-      key += attr->mp_nexthop_global.s6_addr[i];
-    for (i = 0; i < 16; i++)
-      key += attr->mp_nexthop_local.s6_addr[i];
-  }
+  ATTR_KEY_PUT (pnt, attr->mp_nexthop_len);
+  ATTR_KEY_PUT (pnt, attr->mp_nexthop_global);
+  ATTR_KEY_PUT (pnt, attr->mp_nexthop_local);
 #endif /* HAVE_IPV6 */
 
-  return key;
+  return hash_bytes (buf, pnt - buf);
 }
 
 int
 attrhash_cmp (struct attr *attr1, struct attr *attr2)
 {
-  if (attr1->flag == attr2->flag
-      && attr1->origin == attr2->origin
+  if (attr1->aspath == attr2->aspath
+      && attr1->community == attr2->community
       && attr1->nexthop.s_addr == attr2->nexthop.s_addr
       && attr1->med == attr2->med
       && attr1->local_pref == attr2->local_pref
+      && attr1->weight == attr2->weight
+      && attr1->flag == attr2->flag
+      && attr1->origin == attr2->origin
       && attr1->aggregator_as == attr2->aggregator_as
       && attr1->aggregator_addr.s_addr == attr2->aggregator_addr.s_addr
-      && attr1->weight == attr2->weight
+      && IPV4_ADDR_SAME (&attr1->mp_nexthop_global_in, &attr2->mp_nexthop_global_in)
+      && attr1->cluster == attr2->cluster
+      && attr1->ecommunity == attr2->ecommunity
+      && attr1->transit == attr2->transit
 #ifdef HAVE_IPV6
       && attr1->mp_nexthop_len == attr2->mp_nexthop_len
       && IPV6_ADDR_SAME (&attr1->mp_nexthop_global, &attr2->mp_nexthop_global)
       && IPV6_ADDR_SAME (&attr1->mp_nexthop_local, &attr2->mp_nexthop_local)
 #endif /* HAVE_IPV6 */
-      && IPV4_ADDR_SAME (&attr1->mp_nexthop_global_in, &attr2->mp_nexthop_global_in)
-      && attr1->aspath == attr2->aspath
-      && attr1->community == attr2->community
-      && attr1->ecommunity == attr2->ecommunity
-      && attr1->cluster == attr2->cluster
-      && attr1->transit == attr2->transit)
+      )
     return 1;
   else
     return 0;
@@ -344,7 +320,7 @@ attrhash_cmp (struct attr *attr1, struct attr *attr2)
 void
 attrhash_init ()
 {
-  attrhash = hash_create (attrhash_key_make, attrhash_cmp);
+  attrhash = hash_create_size (32767, attrhash_key_make, attrhash_cmp);
 }
 
 void
@@ -365,6 +341,57 @@ attr_show_all (struct vty *vty)
 		vty);
 }
 
+static void
+cluster_memory_iterator (struct hash_backet *backet, unsigned long *bytes)
+{
+  struct cluster_list *cluster = backet->data;
+
+  *bytes += sizeof (struct cluster_list) + cluster->length;
+}
+
+static void
+transit_memory_iterator (struct hash_backet *backet, unsigned long *bytes)
+{
+  struct transit *transit = backet->data;
+
+  *bytes += sizeof (struct transit) + transit->length;
+}
+
+static unsigned long
+attr_hash_memory (struct hash *hash, void (*func) (struct hash_backet *,
+						     unsigned long *))
+{
+  unsigned long bytes = 0;
+
+  hash_iterate (hash, (void (*) (struct hash_backet *, void *)) func, &bytes);
+  return bytes;
+}
+
+/* Show entries and bytes of each kind of interned attribute data. */
+void
+attr_memory_show (struct vty *vty)
+{
+  vty_out (vty, "%-24s %10s %12s%s", "Attribute", "Entries", "Bytes",
+	   VTY_NEWLINE);
+  vty_out (vty, "%-24s %10ld %12ld%s", "Path attributes",
+	   attrhash->count, attrhash->count * sizeof (struct attr),
+	   VTY_NEWLINE);
+  vty_out (vty, "%-24s %10ld %12ld%s", "AS paths",
+	   aspath_count (), aspath_memory (), VTY_NEWLINE);
+  vty_out (vty, "%-24s %10ld %12ld%s", "Communities",
+	   community_count (), community_memory (), VTY_NEWLINE);
+  vty_out (vty, "%-24s %10ld %12ld%s", "Extended communities",
+	   ecommunity_count (), ecommunity_memory (), VTY_NEWLINE);
+  vty_out (vty, "%-24s %10ld %12ld%s", "Cluster lists",
+	   cluster_hash->count,
+	   attr_hash_memory (cluster_hash, cluster_memory_iterator),
+	   VTY_NEWLINE);
+  vty_out (vty, "%-24s %10ld %12ld%s", "Unknown transit",
+	   transit_hash->count,
+	   attr_hash_memory (transit_hash, transit_memory_iterator),
+	   VTY_NEWLINE);
+}
+
 void *
 bgp_attr_hash_alloc (struct attr *val)
 {
@@ -40,7 +40,9 @@ Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
 /* BGP attribute header must bigger than 2. */
 #define BGP_ATTR_MIN_LEN        2       /* Attribute flag and type. */
 
-/* BGP attribute structure. */
+/* BGP attribute structure.  The attributes read by best path selection
+   and the attribute hash come first so that they share cache lines;
+   those only some paths carry follow. */
 struct attr
 {
   /* Reference count of this attribute. */
@@ -51,22 +53,11 @@ struct attr
 
   /* Attributes. */
   u_char origin;
+  u_char mp_nexthop_len;
   struct in_addr nexthop;
   u_int32_t med;
   u_int32_t local_pref;
-  as_t aggregator_as;
-  struct in_addr aggregator_addr;
   u_int32_t weight;
-  struct in_addr originator_id;
-  struct cluster_list *cluster;
-
-  u_char mp_nexthop_len;
-#ifdef HAVE_IPV6
-  struct in6_addr mp_nexthop_global;
-  struct in6_addr mp_nexthop_local;
-#endif /* HAVE_IPV6 */
-  struct in_addr mp_nexthop_global_in;
-  struct in_addr mp_nexthop_local_in;
 
   /* AS Path structure */
   struct aspath *aspath;
@@ -74,11 +65,23 @@ struct attr
   /* Community structure */
   struct community *community;	
 
+  /* Less frequent attributes. */
+  as_t aggregator_as;
+  struct in_addr aggregator_addr;
+  struct in_addr originator_id;
+  struct in_addr mp_nexthop_global_in;
+  struct cluster_list *cluster;
+
   /* Extended Communities attribute. */
   struct ecommunity *ecommunity;
 
   /* Unknown transitive attribute. */
   struct transit *transit;
+
+#ifdef HAVE_IPV6
+  struct in6_addr mp_nexthop_global;
+  struct in6_addr mp_nexthop_local;
+#endif /* HAVE_IPV6 */
 };
 
 /* Router Reflector related structure. */
@@ -116,6 +119,7 @@ void bgp_dump_routes_attr (struct stream *, struct attr *);
 unsigned int attrhash_key_make (struct attr *);
 int attrhash_cmp (struct attr *, struct attr *);
 void attr_show_all (struct vty *);
+void attr_memory_show (struct vty *);
 
 /* Cluster list prototypes. */
 int cluster_loop_check (struct cluster_list *, struct in_addr);
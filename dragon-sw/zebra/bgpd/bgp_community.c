@@ -309,10 +309,6 @@ community_intern (struct community *com)
   /* Increment refrence counter.  */
   find->refcnt++;
 
-  /* Make string.  */
-  if (! find->str)
-    find->str = community_com2str (find);
-
   return find;
 }
 
@@ -387,17 +383,7 @@ community_str (struct community *com)
 unsigned int
 community_hash_make (struct community *com)
 {
-  int c;
-  unsigned int key;
-  unsigned char *pnt;
-
-  key = 0;
-  pnt = (unsigned char *)com->val;
-  
-  for(c = 0; c < com->size * 4; c++)
-    key += pnt[c];
-      
-  return key;
+  return hash_bytes (com->val, com_length (com));
 }
 
 int
@@ -614,6 +600,29 @@ community_count ()
   return comhash->count;
 }
 
+static void
+community_memory_iterator (struct hash_backet *backet, unsigned long *bytes)
+{
+  struct community *com = backet->data;
+
+  *bytes += sizeof (struct community) + com_length (com);
+  if (com->str)
+    *bytes += strlen (com->str) + 1;
+}
+
+/* Return bytes used by interned communities.  */
+unsigned long
+community_memory ()
+{
+  unsigned long bytes = 0;
+
+  hash_iterate (comhash,
+		(void (*) (struct hash_backet *, void *))
+		community_memory_iterator,
+		&bytes);
+  return bytes;
+}
+
 /* Return communities hash.  */
 struct hash *
 community_hash ()
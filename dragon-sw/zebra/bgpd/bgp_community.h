@@ -65,4 +65,5 @@ struct community *community_dup (struct community *);
 int community_include (struct community *, u_int32_t);
 void community_del_val (struct community *, u_int32_t *);
 unsigned long community_count ();
+unsigned long community_memory ();
 struct hash *community_hash ();
@@ -38,53 +38,120 @@ Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
 struct bgp_damp_config bgp_damp_cfg;
 struct bgp_damp_config *damp = &bgp_damp_cfg;
 
-/* Utility macro to add and delete BGP dampening information to no
-   used list.  */
-#define BGP_DAMP_LIST_ADD(N,A)  BGP_INFO_ADD(N,A,no_reuse_list)
-#define BGP_DAMP_LIST_DEL(N,A)  BGP_INFO_DEL(N,A,no_reuse_list)
+int bgp_reuse_timer (struct thread *);
  
-/* Calculate reuse list index by penalty value.  */
+/* Number of reuse ticks until PENALTY decays down to LIMIT.  */
 static int
-bgp_reuse_index (int penalty)
+bgp_reuse_ticks (int penalty, int limit)
 {
   int i;
-  int index;
+  int ticks = 0;
+
+  /* Whole half-lives first, the reuse index array covers the rest.  */
+  while (limit > 0 && penalty >= limit * 2)
+    {
+      penalty /= 2;
+      ticks += damp->half_life / DELTA_REUSE;
+    }
 
-  i = (int)(((double) penalty / damp->reuse_limit - 1.0) * damp->scale_factor);
+  if (penalty <= limit)
+    return ticks;
+
+  i = (int)(((double) penalty / limit - 1.0) * damp->scale_factor);
   
   if ( i >= damp->reuse_index_size )
     i = damp->reuse_index_size - 1;
 
-  index = damp->reuse_index[i] - damp->reuse_index[0];
+  return ticks + damp->reuse_index[i] - damp->reuse_index[0];
+}
 
-  return (damp->reuse_offset + index) % damp->reuse_list_size;  
+/* Return the reuse wheel slot of TICK.  Ticks beyond the second level
+   are parked in its last slot and placed again when it comes up.  */
+static int
+bgp_reuse_slot (time_t tick)
+{
+  time_t now = damp->reuse_tick;
+
+  if (tick - now < REUSE_LIST_SIZE)
+    return tick % REUSE_LIST_SIZE;
+
+  if (tick / REUSE_LIST_SIZE - now / REUSE_LIST_SIZE >= REUSE_LIST_SIZE)
+    tick = (now / REUSE_LIST_SIZE + REUSE_LIST_SIZE - 1) * REUSE_LIST_SIZE;
+
+  return REUSE_LIST_SIZE + (tick / REUSE_LIST_SIZE) % REUSE_LIST_SIZE;
 }
 
-/* Add BGP dampening information to reuse list.  */
-static void 
-bgp_reuse_list_add (struct bgp_damp_info *bdi)
+/* Link BGP dampening information into the slot of its reuse tick.  */
+static void
+bgp_reuse_list_link (struct bgp_damp_info *bdi)
 {
   int index;
 
-  index = bdi->index = bgp_reuse_index (bdi->penalty);
+  index = bdi->index = bgp_reuse_slot (bdi->reuse_tick);
 
   bdi->prev = NULL;
   bdi->next = damp->reuse_list[index];
   if (damp->reuse_list[index])
     damp->reuse_list[index]->prev = bdi;
   damp->reuse_list[index] = bdi;
+  damp->reuse_count++;
 }
 
-/* Delete BGP dampening information from reuse list.  */
+/* Add BGP dampening information to the reuse wheel.  A suppressed
+   route is due when it falls below the reuse limit or reaches the
+   maximum suppress time, any other one when its penalty is low enough
+   to forget it.  */
+static void 
+bgp_reuse_list_add (struct bgp_damp_info *bdi)
+{
+  time_t tick;
+  time_t max;
+
+  /* The wheel stands still while it is empty.  */
+  if (! damp->t_reuse)
+    {
+      damp->reuse_tick = time (NULL) / DELTA_REUSE;
+      damp->t_reuse =
+	thread_add_timer (master, bgp_reuse_timer, NULL, DELTA_REUSE);
+    }
+
+  tick = (bdi->t_updated + DELTA_REUSE - 1) / DELTA_REUSE;
+
+  if (CHECK_FLAG (bdi->binfo->flags, BGP_INFO_DAMPED))
+    {
+      tick += bgp_reuse_ticks (bdi->penalty, damp->reuse_limit);
+
+      max = (bdi->suppress_time + damp->max_suppress_time
+	     + DELTA_REUSE - 1) / DELTA_REUSE;
+      if (tick > max)
+	tick = max;
+    }
+  else
+    tick += bgp_reuse_ticks (bdi->penalty, damp->reuse_limit / 2);
+
+  if (tick <= damp->reuse_tick)
+    tick = damp->reuse_tick + 1;
+
+  bdi->reuse_tick = tick;
+  bgp_reuse_list_link (bdi);
+}
+
+/* Delete BGP dampening information from the reuse wheel.  */
 static void
 bgp_reuse_list_delete (struct bgp_damp_info *bdi)
 {
+  if (bdi->index < 0)
+    return;
+
   if (bdi->next)
     bdi->next->prev = bdi->prev;
   if (bdi->prev)
     bdi->prev->next = bdi->next;
   else
     damp->reuse_list[bdi->index] = bdi->next;
+
+  bdi->index = -1;
+  damp->reuse_count--;
 }   
  
 /* Return decayed penalty value.  */
@@ -104,16 +171,60 @@ bgp_damp_decay (time_t tdiff, int penalty)
   return (int) (penalty * damp->decay_array[i]);
 }
 
-/* Handler of reuse timer event.  Each route in the current reuse-list
-   is evaluated.  RFC2439 Section 4.8.7.  */
+/* Evaluate dampening information which came due on the reuse wheel.
+   RFC2439 Section 4.8.7.  */
+static void
+bgp_reuse_process (struct bgp *bgp, struct bgp_damp_info *bdi, time_t t_now)
+{
+  int bgp_process (struct bgp *, struct bgp_node *, afi_t, safi_t);
+
+  /* Set figure-of-merit = figure-of-merit * decay-array-ok [t-diff] */
+  bdi->penalty = bgp_damp_decay (t_now - bdi->t_updated, bdi->penalty);
+  bdi->t_updated = t_now;
+
+  if (CHECK_FLAG (bdi->binfo->flags, BGP_INFO_DAMPED))
+    {
+      /* Re-insert into another list (See RFC2439 Section 4.8.6).  */
+      if (bdi->penalty >= damp->reuse_limit
+	  && t_now - bdi->suppress_time < damp->max_suppress_time)
+	{
+	  bgp_reuse_list_add (bdi);
+	  return;
+	}
+
+      if (bdi->penalty > damp->reuse_limit)
+	bdi->penalty = damp->reuse_limit;
+
+      /* Reuse the route.  */
+      UNSET_FLAG (bdi->binfo->flags, BGP_INFO_DAMPED);
+      bdi->suppress_time = 0;
+
+      if (bdi->lastrecord == BGP_RECORD_UPDATE)
+	{
+	  UNSET_FLAG (bdi->binfo->flags, BGP_INFO_HISTORY);
+	  bgp_aggregate_increment (bgp, &bdi->rn->p, bdi->binfo,
+				   bdi->afi, bdi->safi);   
+	  bgp_process (bgp, bdi->rn, bdi->afi, bdi->safi);
+	}
+    }
+
+  /* Release the dampening information and history route.  */
+  if (bdi->penalty <= damp->reuse_limit / 2.0)
+    bgp_damp_info_free (bdi, 1);
+  else
+    bgp_reuse_list_add (bdi);
+}
+
+/* Handler of reuse timer event.  Only the slots which came due since
+   the last run are looked at, route selection for what they release
+   is left to the process queue.  */
 int
 bgp_reuse_timer (struct thread *t)
 {
   struct bgp_damp_info *bdi;
-  struct bgp_damp_info *next;
-  time_t t_now, t_diff;
+  time_t t_now, tick;
   struct bgp *bgp;
-  int bgp_process (struct bgp *, struct bgp_node *, afi_t, safi_t);
+  int index;
 
   damp->t_reuse = NULL;
   damp->t_reuse =
@@ -124,53 +235,40 @@ bgp_reuse_timer (struct thread *t)
     return 0;
 
   t_now = time (NULL);
+  tick = t_now / DELTA_REUSE;
 
-  /* 1.  save a pointer to the current zeroth queue head and zero the
-     list head entry.  */
-  bdi = damp->reuse_list[damp->reuse_offset];
-  damp->reuse_list[damp->reuse_offset] = NULL;
-
-  /* 2.  set offset = modulo reuse-list-size ( offset + 1 ), thereby
-     rotating the circular queue of list-heads.  */
-  damp->reuse_offset = (damp->reuse_offset + 1) % damp->reuse_list_size;
-
-  /* 3. if ( the saved list head pointer is non-empty ) */
-  for (; bdi; bdi = next)
+  while (damp->reuse_tick < tick)
     {
-      next = bdi->next;
-
-      /* Set t-diff = t-now - t-updated.  */
-      t_diff = t_now - bdi->t_updated;
-
-      /* Set figure-of-merit = figure-of-merit * decay-array-ok [t-diff] */
-      bdi->penalty = bgp_damp_decay (t_diff, bdi->penalty);   
+      damp->reuse_tick++;
 
-      /* Set t-updated = t-now.  */
-      bdi->t_updated = t_now;
-
-      /* if (figure-of-merit < reuse).  */
-      if (bdi->penalty < damp->reuse_limit)
+      /* The first level wrapped around, spread the next slot of the
+	 second level over it.  */
+      if (damp->reuse_tick % REUSE_LIST_SIZE == 0)
 	{
-	  /* Reuse the route.  */
-	  UNSET_FLAG (bdi->binfo->flags, BGP_INFO_DAMPED);
-	  bdi->suppress_time = 0;
+	  index = REUSE_LIST_SIZE
+	    + (damp->reuse_tick / REUSE_LIST_SIZE) % REUSE_LIST_SIZE;
 
-	  if (bdi->lastrecord == BGP_RECORD_UPDATE)
+	  while ((bdi = damp->reuse_list[index]) != NULL)
 	    {
-	      UNSET_FLAG (bdi->binfo->flags, BGP_INFO_HISTORY);
-	      bgp_aggregate_increment (bgp, &bdi->rn->p, bdi->binfo,
-				       bdi->afi, bdi->safi);   
-	      bgp_process (bgp, bdi->rn, bdi->afi, bdi->safi);
+	      bgp_reuse_list_delete (bdi);
+	      bgp_reuse_list_link (bdi);
 	    }
+	}
+
+      index = damp->reuse_tick % REUSE_LIST_SIZE;
 
-	  if (bdi->penalty <= damp->reuse_limit / 2.0)
-	    bgp_damp_info_free (bdi, 1);
-	  else
-	    BGP_DAMP_LIST_ADD (damp, bdi);
+      while ((bdi = damp->reuse_list[index]) != NULL)
+	{
+	  bgp_reuse_list_delete (bdi);
+	  bgp_reuse_process (bgp, bdi, t_now);
 	}
-      else
-	/* Re-insert into another list (See RFC2439 Section 4.8.6).  */
-	bgp_reuse_list_add (bdi);
+    }
+
+  /* Stop turning until something is added again.  */
+  if (! damp->reuse_count)
+    {
+      thread_cancel (damp->t_reuse);
+      damp->t_reuse = NULL;
     }
 
   return 0;
@@ -210,7 +308,6 @@ bgp_damp_withdraw (struct bgp_info *binfo, struct bgp_node *rn,
       bdi->afi = afi;
       bdi->safi = safi;
       binfo->damp_info = bdi;
-      BGP_DAMP_LIST_ADD (damp, bdi);
     }
   else
     {
@@ -233,7 +330,7 @@ bgp_damp_withdraw (struct bgp_info *binfo, struct bgp_node *rn,
   /* Make this route as historical status.  */
   SET_FLAG (binfo->flags, BGP_INFO_HISTORY);
 
-  /* Remove the route from a reuse list if it is on one.  */
+  /* Move the route on the reuse wheel if it is suppressed.  */
   if (CHECK_FLAG (bdi->binfo->flags, BGP_INFO_DAMPED))
     {
       /* If decay rate isn't equal to 0, reinsert brn. */  
@@ -251,10 +348,11 @@ bgp_damp_withdraw (struct bgp_info *binfo, struct bgp_node *rn,
     {
       SET_FLAG (bdi->binfo->flags, BGP_INFO_DAMPED);
       bdi->suppress_time = t_now;
-      BGP_DAMP_LIST_DEL (damp, bdi);
-      bgp_reuse_list_add (bdi);
     }
 
+  bgp_reuse_list_delete (bdi);
+  bgp_reuse_list_add (bdi);
+
   return BGP_DAMP_USED;
 }
 
@@ -283,8 +381,6 @@ bgp_damp_update (struct bgp_info *binfo, struct bgp_node *rn,
 	   && (bdi->penalty < damp->reuse_limit) )
     {
       UNSET_FLAG (bdi->binfo->flags, BGP_INFO_DAMPED);
-      bgp_reuse_list_delete (bdi);
-      BGP_DAMP_LIST_ADD (damp, bdi);
       bdi->suppress_time = 0;
       status = BGP_DAMP_USED;
     }
@@ -292,66 +388,23 @@ bgp_damp_update (struct bgp_info *binfo, struct bgp_node *rn,
     status = BGP_DAMP_SUPPRESSED;  
 
   if (bdi->penalty > damp->reuse_limit / 2.0)
-    bdi->t_updated = t_now;
+    {
+      bdi->t_updated = t_now;
+      bgp_reuse_list_delete (bdi);
+      bgp_reuse_list_add (bdi);
+    }
   else
     bgp_damp_info_free (bdi, 0);
 	
   return status;
 }
 
-/* Remove dampening information and history route.  */
-int 
-bgp_damp_scan (struct bgp_info *binfo, afi_t afi, safi_t safi)
-{
-  time_t t_now, t_diff;
-  struct bgp_damp_info *bdi;
-
-  t_now = time (NULL);
-  bdi = binfo->damp_info;
- 
-  if (CHECK_FLAG (binfo->flags, BGP_INFO_DAMPED))
-    {
-      t_diff = t_now - bdi->suppress_time;
-
-      if (t_diff >= damp->max_suppress_time)
-        {
-          UNSET_FLAG (binfo->flags, BGP_INFO_DAMPED);
-          bgp_reuse_list_delete (bdi);
-	  BGP_DAMP_LIST_ADD (damp, bdi);
-          bdi->penalty = damp->reuse_limit;
-          bdi->suppress_time = 0;
-          bdi->t_updated = t_now;
-          
-          /* Need to announce UPDATE once this binfo is usable again. */
-          if (bdi->lastrecord == BGP_RECORD_UPDATE)
-            return 1;
-          else
-            return 0;
-        }
-    }
-  else
-    {
-      t_diff = t_now - bdi->t_updated;
-      bdi->penalty = bgp_damp_decay (t_diff, bdi->penalty);
-
-      if (bdi->penalty <= damp->reuse_limit / 2.0)
-        {
-          /* release the bdi, bdi->binfo. */  
-          bgp_damp_info_free (bdi, 1);
-          return 0;
-        }            
-      else
-        bdi->t_updated = t_now;
-    }       
-  return 0;
-}
-
 void
 bgp_damp_info_free (struct bgp_damp_info *bdi, int withdraw)
 {
   struct bgp_info *binfo;
-  void bgp_info_delete (struct bgp_node *, struct bgp_info *);
-  void bgp_info_free (struct bgp_info *);
+  void bgp_info_remove (struct bgp_node *, struct bgp_info *);
+  int bgp_process (struct bgp *, struct bgp_node *, afi_t, safi_t);
 
   if (! bdi)
     return;
@@ -359,19 +412,15 @@ bgp_damp_info_free (struct bgp_damp_info *bdi, int withdraw)
   binfo = bdi->binfo;
   binfo->damp_info = NULL;
 
-  if (CHECK_FLAG (binfo->flags, BGP_INFO_DAMPED))
-    bgp_reuse_list_delete (bdi);
-  else
-    BGP_DAMP_LIST_DEL (damp, bdi);
+  bgp_reuse_list_delete (bdi);
 
   UNSET_FLAG (binfo->flags, BGP_INFO_DAMPED);
   UNSET_FLAG (binfo->flags, BGP_INFO_HISTORY);
 
   if (bdi->lastrecord == BGP_RECORD_WITHDRAW && withdraw)
     {
-      bgp_info_delete (bdi->rn, binfo);
-      bgp_info_free (binfo);
-      bgp_unlock_node (bdi->rn);
+      bgp_process (binfo->peer->bgp, bdi->rn, bdi->afi, bdi->safi);
+      bgp_info_remove (bdi->rn, binfo);
     }
   XFREE (MTYPE_BGP_DAMP_INFO, bdi);
 }
@@ -404,23 +453,11 @@ bgp_damp_parameter_set (int hlife, int reuse, int sup, int maxsup)
   for (i = 2; i < damp->decay_array_size; i++)
     damp->decay_array[i] = damp->decay_array[i-1] * damp->decay_array[1];
 	
-  /* Reuse-list computations */
-  i = ceil ((double)damp->max_suppress_time / DELTA_REUSE) + 1;
-  if (i > REUSE_LIST_SIZE || i == 0)
-    i = REUSE_LIST_SIZE;
-  damp->reuse_list_size = i; 
-
-  damp->reuse_list = XCALLOC (MTYPE_BGP_DAMP_ARRAY, 
-			      damp->reuse_list_size 
-			      * sizeof (struct bgp_reuse_node *));
-  memset (damp->reuse_list, 0x00, 
-          damp->reuse_list_size * sizeof (struct bgp_reuse_node *));  
-
   /* Reuse-array computations */
   damp->reuse_index = XMALLOC (MTYPE_BGP_DAMP_ARRAY, 
 			       sizeof(int) * damp->reuse_index_size);
   memset (damp->reuse_index, 0x00,
-          damp->reuse_list_size * sizeof (int));
+          damp->reuse_index_size * sizeof (int));
 
   reuse_max_ratio = (double)damp->ceiling/damp->reuse_limit;
   j = (exp((double)damp->max_suppress_time/damp->half_life) * log10(2.0));
@@ -454,11 +491,8 @@ bgp_damp_enable (struct bgp *bgp, afi_t afi, safi_t safi, int half,
   SET_FLAG (bgp->af_flags[afi][safi], BGP_CONFIG_DAMPENING);
   bgp_damp_parameter_set (half, reuse, suppress, max);
 
-  /* Register reuse timer.  */
-  if (! damp->t_reuse)
-    damp->t_reuse = 
-      thread_add_timer (master, bgp_reuse_timer, NULL, DELTA_REUSE);
-
+  /* The reuse timer is registered along with the first route put on
+     the reuse wheel.  */
   return 0;
 }
 
@@ -470,39 +504,17 @@ bgp_damp_config_clean (struct bgp_damp_config *damp)
 
   /* Free reuse index array */
   XFREE (MTYPE_BGP_DAMP_ARRAY, damp->reuse_index);
-
-  /* Free reuse list array. */
-  XFREE (MTYPE_BGP_DAMP_ARRAY, damp->reuse_list);
 }
 
-/* Clean all the bgp_damp_info stored in reuse_list. */
+/* Clean all the bgp_damp_info stored on the reuse wheel. */
 void
 bgp_damp_info_clean ()
 {
   int i;
-  struct bgp_damp_info *bdi, *next;
-
-  damp->reuse_offset = 0;
-
-  for (i = 0; i < damp->reuse_list_size; i++)
-    {
-      if (! damp->reuse_list[i])
-	continue;
 
-      for (bdi = damp->reuse_list[i]; bdi; bdi = next)
-	{
-	  next = bdi->next;
-	  bgp_damp_info_free (bdi, 1);
-	}
-      damp->reuse_list[i] = NULL;
-    }
-
-  for (bdi = damp->no_reuse_list; bdi; bdi = next)
-    {
-      next = bdi->next;
-      bgp_damp_info_free (bdi, 1);
-    }
-  damp->no_reuse_list = NULL;
+  for (i = 0; i < REUSE_LIST_SIZE * 2; i++)
+    while (damp->reuse_list[i])
+      bgp_damp_info_free (damp->reuse_list[i], 1);
 }
 
 int
@@ -21,8 +21,8 @@ Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
 /* Structure maintained on a per-route basis. */
 struct bgp_damp_info
 {
-  /* Doubly linked list.  This information must be linked to
-     reuse_list or no_reuse_list.  */
+  /* Doubly linked list.  Every dampening information is linked to
+     one slot of the reuse wheel.  */
   struct bgp_damp_info *next;
   struct bgp_damp_info *prev;
 
@@ -47,9 +47,12 @@ struct bgp_damp_info
   /* Back reference to bgp_node. */
   struct bgp_node *rn;
 
-  /* Current index in the reuse_list. */
+  /* Current slot on the reuse wheel, -1 when not on it. */
   int index;
 
+  /* Reuse tick at which this information is next looked at.  */
+  time_t reuse_tick;
+
   /* Last time message type. */
   u_char lastrecord;
 #define BGP_RECORD_UPDATE	1
@@ -59,6 +62,9 @@ struct bgp_damp_info
   safi_t safi;
 };
 
+/* Number of slots per level of the reuse wheel. */
+#define REUSE_LIST_SIZE          256
+
 /* Specified parameter set configuration. */
 struct bgp_damp_config
 {
@@ -78,7 +84,6 @@ struct bgp_damp_config
    * To change this values, init_bgp_damp() should be modified.
    */
   int tmax;		  /* Max time previous instability retained */
-  int reuse_list_size;		/* Number of reuse lists */
   int reuse_index_size;		/* Size of reuse index array */
 
   /* Non-configurable parameters.  Most of these are calculated from
@@ -96,12 +101,15 @@ struct bgp_damp_config
   /* Reuse index array per-set based. */ 
   int *reuse_index;
 
-  /* Reuse list array per-set based. */  
-  struct bgp_damp_info **reuse_list;
-  int reuse_offset;
-        
-  /* All dampening information which is not on reuse list.  */
-  struct bgp_damp_info *no_reuse_list;
+  /* Two level reuse wheel.  The first REUSE_LIST_SIZE slots hold the
+     information due within REUSE_LIST_SIZE ticks, one tick per slot.
+     The rest hold later information, REUSE_LIST_SIZE ticks per slot,
+     and are cascaded down when the first level wraps around.  */
+  struct bgp_damp_info *reuse_list[REUSE_LIST_SIZE * 2];
+
+  /* Last reuse tick processed and number of entries on the wheel.  */
+  time_t reuse_tick;
+  unsigned long reuse_count;
 
   /* Reuse timer thread per-set base. */
   struct thread* t_reuse;
@@ -123,7 +131,6 @@ struct bgp_damp_config
 #define DEFAULT_REUSE 	       	 750
 #define DEFAULT_SUPPRESS 	2000
 
-#define REUSE_LIST_SIZE          256
 #define REUSE_ARRAY_SIZE        1024
 
 int bgp_damp_enable (struct bgp *, afi_t, safi_t, int, int, int, int);
@@ -131,7 +138,6 @@ int bgp_damp_disable (struct bgp *, afi_t, safi_t);
 int bgp_damp_withdraw (struct bgp_info *, struct bgp_node *,
 		       afi_t, safi_t, int);
 int bgp_damp_update (struct bgp_info *, struct bgp_node *, afi_t, safi_t);
-int bgp_damp_scan (struct bgp_info *, afi_t, safi_t);
 void bgp_damp_info_free (struct bgp_damp_info *, int);
 void bgp_damp_info_clean ();
 char * bgp_get_reuse_time (int, char*, size_t);
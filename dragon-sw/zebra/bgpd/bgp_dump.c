@@ -401,8 +401,11 @@ bgp_dump_packet_func (struct bgp_dump *bgp_dump, struct peer *peer,
   bgp_dump_header (obuf, MSG_PROTOCOL_BGP4MP, BGP4MP_MESSAGE);
   bgp_dump_common (obuf, peer);
 
-  /* Packet contents. */
-  stream_put (obuf, STREAM_DATA (packet), stream_get_endp (packet));
+  /* Packet contents.  The message starts at the get pointer of the
+     input buffer and carries its own length. */
+  stream_put (obuf, STREAM_PNT (packet),
+	      stream_getw_from (packet,
+				stream_get_getp (packet) + BGP_MARKER_SIZE));
   
   /* Set length. */
   bgp_dump_set_size (obuf, MSG_PROTOCOL_BGP4MP);
@@ -200,9 +200,6 @@ ecommunity_intern (struct ecommunity *ecom)
 
   find->refcnt++;
 
-  if (! find->str)
-    find->str = ecommunity_ecom2str (find, ECOMMUNITY_FORMAT_DISPLAY);
-
   return find;
 }
 
@@ -230,17 +227,7 @@ ecommunity_unintern (struct ecommunity *ecom)
 unsigned int
 ecommunity_hash_make (struct ecommunity *ecom)
 {
-  int c;
-  unsigned int key;
-  unsigned char *pnt;
-
-  key = 0;
-  pnt = ecom->val;
-  
-  for (c = 0; c < ecom->size * ECOMMUNITY_SIZE; c++)
-    key += pnt[c];
-
-  return key;
+  return hash_bytes (ecom->val, ecom->size * ECOMMUNITY_SIZE);
 }
 
 /* Compare two Extended Communities Attribute structure.  */
@@ -253,6 +240,36 @@ ecommunity_cmp (struct ecommunity *ecom1, struct ecommunity *ecom2)
   return 0;
 }
 
+/* Return Extended Communities hash entry count.  */
+unsigned long
+ecommunity_count ()
+{
+  return ecomhash->count;
+}
+
+static void
+ecommunity_memory_iterator (struct hash_backet *backet, unsigned long *bytes)
+{
+  struct ecommunity *ecom = backet->data;
+
+  *bytes += sizeof (struct ecommunity) + ecom_length (ecom);
+  if (ecom->str)
+    *bytes += strlen (ecom->str) + 1;
+}
+
+/* Return bytes used by interned Extended Communities.  */
+unsigned long
+ecommunity_memory ()
+{
+  unsigned long bytes = 0;
+
+  hash_iterate (ecomhash,
+		(void (*) (struct hash_backet *, void *))
+		ecommunity_memory_iterator,
+		&bytes);
+  return bytes;
+}
+
 /* Initialize Extended Comminities related hash. */
 void
 ecommunity_init ()
@@ -72,3 +72,5 @@ struct ecommunity *ecommunity_str2com (char *, int, int);
 char *ecommunity_ecom2str (struct ecommunity *, int);
 int ecommunity_match (struct ecommunity *, struct ecommunity *);
 char *ecommunity_str (struct ecommunity *);
+unsigned long ecommunity_count (void);
+unsigned long ecommunity_memory (void);
@@ -38,6 +38,7 @@ Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
 #include "bgpd/bgp_packet.h"
 #include "bgpd/bgp_network.h"
 #include "bgpd/bgp_route.h"
+#include "bgpd/bgp_advertise.h"
 #include "bgpd/bgp_dump.h"
 #include "bgpd/bgp_open.h"
 #ifdef HAVE_SNMP
@@ -385,9 +386,6 @@ bgp_stop (struct peer *peer)
   /* Delete all existing events of the peer. */
   BGP_EVENT_DELETE (peer);
 
-  /* Stream reset. */
-  peer->packet_size = 0;
-
   /* Clear input and output buffer.  */
   if (peer->ibuf)
     stream_reset (peer->ibuf);
@@ -608,6 +606,10 @@ bgp_fsm_change_status (struct peer *peer, int status)
   /* Preserve old status and change into new status. */
   peer->ostatus = peer->status;
   peer->status = status;
+
+  /* Established peers are grouped by their outbound policy.  */
+  if (peer->status == Established || peer->ostatus == Established)
+    bgp_update_group_reset (peer->bgp);
 }
 
 /* Keepalive send to peer. */
@@ -22,6 +22,12 @@ Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
 /* Macro for BGP read, write and timer thread.  */
 #define BGP_READ_ON(T,F,V)   THREAD_READ_ON(master,T,F,peer,V)
 #define BGP_READ_OFF(X)      THREAD_READ_OFF(X)
+#define BGP_READ_YIELD(T,F)  THREAD_BACKGROUND_ON(master,T,F,peer)
+#define BGP_READ_AFTER_EVENTS(T,F) \
+  do { \
+    if (! (T)) \
+      (T) = thread_add_event (master, (F), peer, 0); \
+  } while (0)
 
 #define BGP_WRITE_ON(T,F,V)  THREAD_WRITE_ON(master,T,F,peer,V)
 #define BGP_WRITE_OFF(X)     THREAD_WRITE_OFF(X)
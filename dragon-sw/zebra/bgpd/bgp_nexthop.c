@@ -36,6 +36,8 @@ Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
 #include "bgpd/bgp_nexthop.h"
 #include "bgpd/bgp_debug.h"
 #include "bgpd/bgp_damp.h"
+#include "bgpd/bgp_zebra.h"
+#include "bgpd/bgp_advertise.h"
 #include "zebra/rib.h"
 #include "zebra/zserv.h"	/* For ZEBRA_SERV_PATH. */
 
@@ -58,13 +60,9 @@ int bgp_import_interval;
 
 /* Route table for next-hop lookup cache. */
 struct bgp_table *bgp_nexthop_cache_ipv4;
-struct bgp_table *cache1;
-struct bgp_table *cache2;
 
 /* Route table for next-hop lookup cache. */
 struct bgp_table *bgp_nexthop_cache_ipv6;
-struct bgp_table *cache6_1;
-struct bgp_table *cache6_2;
 
 /* Route table for connected route. */
 struct bgp_table *bgp_connected_ipv4;
@@ -224,86 +222,95 @@ bgp_nexthop_check_ebgp (afi_t afi, struct attr *attr)
   return 0;
 }
 
+/* Nexthop tracking.  Each nexthop BGP paths resolve through has a cache
+   entry, registered with zebra, which tells us whenever the nexthop
+   resolves differently; the paths of the entry are then revalidated.  */
+
+/* Table of nexthop cache entries of AFI. */
+static struct bgp_table *
+bgp_nexthop_cache_table (afi_t afi)
+{
 #ifdef HAVE_IPV6
-/* Check specified next-hop is reachable or not. */
-int
-bgp_nexthop_lookup_ipv6 (struct peer *peer, struct bgp_info *ri, int *changed,
-			 int *metricchanged)
+  if (afi == AFI_IP6)
+    return bgp_nexthop_cache_ipv6;
+#endif /* HAVE_IPV6 */
+  return bgp_nexthop_cache_ipv4;
+}
+
+/* Nexthop path RI resolves through.  Return 0 when it is not looked
+   up. */
+static int
+bgp_nexthop_prefix (afi_t afi, struct bgp_info *ri, struct prefix *p)
 {
-  struct bgp_node *rn;
-  struct prefix p;
-  struct bgp_nexthop_cache *bnc;
-  struct attr *attr;
+  memset (p, 0, sizeof (struct prefix));
 
-  /* If lookup is not enabled, return valid. */
-  if (zlookup->sock < 0)
+  if (afi == AFI_IP)
     {
-      ri->igpmetric = 0;
+      p->family = AF_INET;
+      p->prefixlen = IPV4_MAX_BITLEN;
+      p->u.prefix4 = ri->attr->nexthop;
       return 1;
     }
-
+#ifdef HAVE_IPV6
   /* Only check IPv6 global address only nexthop. */
-  attr = ri->attr;
+  if (afi == AFI_IP6
+      && ri->attr->mp_nexthop_len == 16
+      && ! IN6_IS_ADDR_LINKLOCAL (&ri->attr->mp_nexthop_global))
+    {
+      p->family = AF_INET6;
+      p->prefixlen = IPV6_MAX_BITLEN;
+      p->u.prefix6 = ri->attr->mp_nexthop_global;
+      return 1;
+    }
+#endif /* HAVE_IPV6 */
+  return 0;
+}
 
-  if (attr->mp_nexthop_len != 16 
-      || IN6_IS_ADDR_LINKLOCAL (&attr->mp_nexthop_global))
-    return 1;
+/* Resolve nexthop P the first time it is used. */
+static struct bgp_nexthop_cache *
+bgp_nexthop_cache_query (struct prefix *p)
+{
+  struct bgp_nexthop_cache *bnc = NULL;
 
-  memset (&p, 0, sizeof (struct prefix));
-  p.family = AF_INET6;
-  p.prefixlen = IPV6_MAX_BITLEN;
-  p.u.prefix6 = attr->mp_nexthop_global;
+  /* If lookup is not enabled, take it as valid until zebra tells. */
+  if (zlookup->sock < 0)
+    {
+      bnc = bnc_new ();
+      bnc->valid = 1;
+      return bnc;
+    }
 
-  /* IBGP or ebgp-multihop */
-  rn = bgp_node_get (bgp_nexthop_cache_ipv6, &p);
+  if (p->family == AF_INET)
+    bnc = zlookup_query (p->u.prefix4);
+#ifdef HAVE_IPV6
+  else if (p->family == AF_INET6)
+    bnc = zlookup_query_ipv6 (&p->u.prefix6);
+#endif /* HAVE_IPV6 */
 
-  if (rn->info)
+  if (! bnc)
     {
-      bnc = rn->info;
-      bgp_unlock_node (rn);
+      bnc = bnc_new ();
+      bnc->valid = 0;
     }
-  else
-    {
-      bnc = zlookup_query_ipv6 (&attr->mp_nexthop_global);
-      if (bnc)
-	{
-	  struct bgp_table *old;
-	  struct bgp_node *oldrn;
-	  struct bgp_nexthop_cache *oldbnc;
-
-	  if (changed)
-	    {
-	      if (bgp_nexthop_cache_ipv6 == cache6_1)
-		old = cache6_2;
-	      else
-		old = cache6_1;
+  return bnc;
+}
 
-	      oldrn = bgp_node_lookup (old, &p);
-	      if (oldrn)
-		{
-		  oldbnc = oldrn->info;
+/* Reachability of path RI from its nexthop cache entry. */
+static int
+bgp_nexthop_valid (afi_t afi, struct bgp_info *ri)
+{
+  struct bgp_nexthop_cache *bnc = ri->nexthop;
 
-		  bnc->changed = bgp_nexthop_cache_changed (bnc, oldbnc);
+  if (peer_sort (ri->peer) == BGP_PEER_EBGP && ri->peer->ttl == 1
+      && ! CHECK_FLAG (ri->peer->flags, PEER_FLAG_ENFORCE_MULTIHOP))
+    return (afi == AFI_IP ? bgp_nexthop_check_ebgp (afi, ri->attr) : 1);
 
-		  if (bnc->metric != oldbnc->metric)
-		    bnc->metricchanged = 1;
-		}
-	    }
-	}
-      else
-	{
-	  bnc = bnc_new ();
-	  bnc->valid = 0;
-	}
-      rn->info = bnc;
+  if (! bnc)
+    {
+      ri->igpmetric = 0;
+      return 1;
     }
 
-  if (changed)
-    *changed = bnc->changed;
-
-  if (metricchanged)
-    *metricchanged = bnc->metricchanged;
-
   if (bnc->valid)
     ri->igpmetric = bnc->metric;
   else
@@ -311,130 +318,254 @@ bgp_nexthop_lookup_ipv6 (struct peer *peer, struct bgp_info *ri, int *changed,
 
   return bnc->valid;
 }
-#endif /* HAVE_IPV6 */
 
-/* Check specified next-hop is reachable or not. */
+/* Stop tracking the nexthop of path RI. */
+void
+bgp_nexthop_untrack (struct bgp_info *ri)
+{
+  struct bgp_nexthop_cache *bnc = ri->nexthop;
+
+  if (! bnc)
+    return;
+
+  if (ri->nh_next)
+    ri->nh_next->nh_prev = ri->nh_prev;
+  if (ri->nh_prev)
+    ri->nh_prev->nh_next = ri->nh_next;
+  else
+    bnc->paths = ri->nh_next;
+
+  ri->nexthop = NULL;
+  ri->nh_next = ri->nh_prev = NULL;
+  ri->nh_rn = NULL;
+
+  /* Last path gone, so is our interest in the nexthop. */
+  if (! bnc->paths)
+    {
+      bgp_zebra_nexthop_send (ZEBRA_NEXTHOP_UNREGISTER, &bnc->node->p);
+      bnc->node->info = NULL;
+      bgp_unlock_node (bnc->node);
+      bnc_free (bnc);
+    }
+}
+
+/* Track the nexthop of path RI of route node RN, so that the path is
+   revalidated when the nexthop changes.  Return whether the path is
+   reachable now. */
 int
-bgp_nexthop_lookup (afi_t afi, struct peer *peer, struct bgp_info *ri,
-		    int *changed, int *metricchanged)
+bgp_nexthop_track (afi_t afi, struct bgp_node *rn, struct bgp_info *ri)
 {
-  struct bgp_node *rn;
   struct prefix p;
+  struct bgp_node *node;
   struct bgp_nexthop_cache *bnc;
-  struct in_addr addr;
 
-  /* If lookup is not enabled, return valid. */
-  if (zlookup->sock < 0)
+  if (! bgp_nexthop_prefix (afi, ri, &p))
     {
-      ri->igpmetric = 0;
-      return 1;
+      bgp_nexthop_untrack (ri);
+      return bgp_nexthop_valid (afi, ri);
     }
 
-#ifdef HAVE_IPV6
-  if (afi == AFI_IP6)
-    return bgp_nexthop_lookup_ipv6 (peer, ri, changed, metricchanged);
-#endif /* HAVE_IPV6 */
-
-  addr = ri->attr->nexthop;
+  /* Still the same nexthop. */
+  if (ri->nexthop && prefix_same (&ri->nexthop->node->p, &p))
+    return bgp_nexthop_valid (afi, ri);
 
-  memset (&p, 0, sizeof (struct prefix));
-  p.family = AF_INET;
-  p.prefixlen = IPV4_MAX_BITLEN;
-  p.u.prefix4 = addr;
-
-  /* IBGP or ebgp-multihop */
-  rn = bgp_node_get (bgp_nexthop_cache_ipv4, &p);
-
-  if (rn->info)
+  node = bgp_node_get (bgp_nexthop_cache_table (afi), &p);
+  if (node->info)
     {
-      bnc = rn->info;
-      bgp_unlock_node (rn);
+      bnc = node->info;
+      bgp_unlock_node (node);
     }
   else
     {
-      bnc = zlookup_query (addr);
-      if (bnc)
-	{
-	  struct bgp_table *old;
-	  struct bgp_node *oldrn;
-	  struct bgp_nexthop_cache *oldbnc;
+      bnc = bgp_nexthop_cache_query (&p);
+      bnc->node = node;
+      node->info = bnc;
+      bgp_zebra_nexthop_send (ZEBRA_NEXTHOP_REGISTER, &p);
+    }
 
-	  if (changed)
-	    {
-	      if (bgp_nexthop_cache_ipv4 == cache1)
-		old = cache2;
-	      else
-		old = cache1;
+  /* The new entry is held by now, so the old one may go away. */
+  bgp_nexthop_untrack (ri);
 
-	      oldrn = bgp_node_lookup (old, &p);
-	      if (oldrn)
-		{
-		  oldbnc = oldrn->info;
+  ri->nexthop = bnc;
+  ri->nh_rn = rn;
+  ri->nh_prev = NULL;
+  ri->nh_next = bnc->paths;
+  if (bnc->paths)
+    bnc->paths->nh_prev = ri;
+  bnc->paths = ri;
 
-		  bnc->changed = bgp_nexthop_cache_changed (bnc, oldbnc);
+  return bgp_nexthop_valid (afi, ri);
+}
 
-		  if (bnc->metric != oldbnc->metric)
-		    bnc->metricchanged = 1;
-		}
-	    }
-	}
+/* The nexthop of BNC resolves differently: revalidate its paths. */
+static void
+bgp_nexthop_revalidate (afi_t afi, struct bgp_nexthop_cache *bnc)
+{
+  struct bgp_info *ri;
+  struct bgp_info *next;
+  struct bgp_node *rn;
+  struct bgp *bgp;
+  int valid;
+  int current;
+
+  for (ri = bnc->paths; ri; ri = next)
+    {
+      next = ri->nh_next;
+      rn = ri->nh_rn;
+      bgp = ri->peer->bgp;
+
+      valid = bgp_nexthop_valid (afi, ri);
+      current = CHECK_FLAG (ri->flags, BGP_INFO_VALID) ? 1 : 0;
+
+      if (bnc->changed)
+	SET_FLAG (ri->flags, BGP_INFO_IGP_CHANGED);
       else
+	UNSET_FLAG (ri->flags, BGP_INFO_IGP_CHANGED);
+
+      if (valid != current)
 	{
-	  bnc = bnc_new ();
-	  bnc->valid = 0;
+	  if (CHECK_FLAG (ri->flags, BGP_INFO_VALID))
+	    {
+	      bgp_aggregate_decrement (bgp, &rn->p, ri, afi, SAFI_UNICAST);
+	      UNSET_FLAG (ri->flags, BGP_INFO_VALID);
+	    }
+	  else
+	    {
+	      SET_FLAG (ri->flags, BGP_INFO_VALID);
+	      bgp_aggregate_increment (bgp, &rn->p, ri, afi, SAFI_UNICAST);
+	    }
 	}
-      rn->info = bnc;
+
+      bgp_process (bgp, rn, afi, SAFI_UNICAST);
     }
+}
 
-  if (changed)
-    *changed = bnc->changed;
+/* Zebra tells how a registered nexthop resolves now. */
+void
+bgp_nexthop_update (struct stream *s)
+{
+  struct prefix p;
+  struct bgp_node *node;
+  struct bgp_nexthop_cache *bnc;
+  struct bgp_nexthop_cache *new;
+  struct nexthop *nexthop;
+  char buf[BUFSIZ];
+  afi_t afi;
+  int i;
 
-  if (metricchanged)
-    *metricchanged = bnc->metricchanged;
+  memset (&p, 0, sizeof (struct prefix));
+  p.family = stream_getc (s);
 
-  if (bnc->valid)
-    ri->igpmetric = bnc->metric;
+  if (p.family == AF_INET)
+    {
+      p.prefixlen = IPV4_MAX_BITLEN;
+      p.u.prefix4.s_addr = stream_get_ipv4 (s);
+    }
+#ifdef HAVE_IPV6
+  else if (p.family == AF_INET6)
+    {
+      p.prefixlen = IPV6_MAX_BITLEN;
+      stream_get (&p.u.prefix6, s, 16);
+    }
+#endif /* HAVE_IPV6 */
   else
-    ri->igpmetric = 0;
+    return;
 
-  return bnc->valid;
+  afi = family2afi (p.family);
+
+  new = bnc_new ();
+  new->metric = stream_getl (s);
+  new->nexthop_num = stream_getc (s);
+  new->valid = (new->nexthop_num ? 1 : 0);
+
+  for (i = 0; i < new->nexthop_num; i++)
+    {
+      nexthop = XMALLOC (MTYPE_NEXTHOP, sizeof (struct nexthop));
+      memset (nexthop, 0, sizeof (struct nexthop));
+      nexthop->type = stream_getc (s);
+      switch (nexthop->type)
+	{
+	case ZEBRA_NEXTHOP_IPV4:
+	  nexthop->gate.ipv4.s_addr = stream_get_ipv4 (s);
+	  break;
+#ifdef HAVE_IPV6
+	case ZEBRA_NEXTHOP_IPV6:
+	  stream_get (&nexthop->gate.ipv6, s, 16);
+	  break;
+	case ZEBRA_NEXTHOP_IPV6_IFINDEX:
+	case ZEBRA_NEXTHOP_IPV6_IFNAME:
+	  stream_get (&nexthop->gate.ipv6, s, 16);
+	  nexthop->ifindex = stream_getl (s);
+	  break;
+#endif /* HAVE_IPV6 */
+	case ZEBRA_NEXTHOP_IFINDEX:
+	case ZEBRA_NEXTHOP_IFNAME:
+	  nexthop->ifindex = stream_getl (s);
+	  break;
+	}
+      bnc_nexthop_add (new, nexthop);
+    }
+
+  /* Unregistered meanwhile. */
+  node = bgp_node_lookup (bgp_nexthop_cache_table (afi), &p);
+  if (! node)
+    {
+      bnc_free (new);
+      return;
+    }
+  bgp_unlock_node (node);
+  bnc = node->info;
+
+  bnc->changed = (bnc->valid != new->valid
+		  || bgp_nexthop_cache_changed (bnc, new));
+  bnc->metricchanged = (bnc->metric != new->metric);
+
+  if (! bnc->changed && ! bnc->metricchanged)
+    {
+      bnc_free (new);
+      return;
+    }
+
+  if (BGP_DEBUG (normal, NORMAL))
+    zlog_info ("nexthop %s %s [IGP metric %d]",
+	       inet_ntop (p.family, &p.u.prefix, buf, BUFSIZ),
+	       new->valid ? "valid" : "invalid", new->metric);
+
+  /* Take the new resolution over. */
+  bnc_nexthop_free (bnc);
+  bnc->valid = new->valid;
+  bnc->metric = new->metric;
+  bnc->nexthop_num = new->nexthop_num;
+  bnc->nexthop = new->nexthop;
+  XFREE (MTYPE_BGP_NEXTHOP_CACHE, new);
+
+  bgp_nexthop_revalidate (afi, bnc);
 }
 
-/* Reset and free all BGP nexthop cache. */
+/* Connection to zebra is up again: register all nexthops in use. */
 void
-bgp_nexthop_cache_reset (struct bgp_table *table)
+bgp_nexthop_register_all ()
 {
   struct bgp_node *rn;
-  struct bgp_nexthop_cache *bnc;
 
-  for (rn = bgp_table_top (table); rn; rn = bgp_route_next (rn))
-    if ((bnc = rn->info) != NULL)
-      {
-	bnc_free (bnc);
-	rn->info = NULL;
-	bgp_unlock_node (rn);
-      }
+  for (rn = bgp_table_top (bgp_nexthop_cache_ipv4); rn;
+       rn = bgp_route_next (rn))
+    if (rn->info)
+      bgp_zebra_nexthop_send (ZEBRA_NEXTHOP_REGISTER, &rn->p);
+#ifdef HAVE_IPV6
+  for (rn = bgp_table_top (bgp_nexthop_cache_ipv6); rn;
+       rn = bgp_route_next (rn))
+    if (rn->info)
+      bgp_zebra_nexthop_send (ZEBRA_NEXTHOP_REGISTER, &rn->p);
+#endif /* HAVE_IPV6 */
 }
 
 void
 bgp_scan_ipv4 ()
 {
-  struct bgp_node *rn;
   struct bgp *bgp;
-  struct bgp_info *bi;
-  struct bgp_info *next;
   struct peer *peer;
   struct listnode *nn;
-  int valid;
-  int current;
-  int changed;
-  int metricchanged;
-
-  /* Change cache. */
-  if (bgp_nexthop_cache_ipv4 == cache1)
-    bgp_nexthop_cache_ipv4 = cache2;
-  else
-    bgp_nexthop_cache_ipv4 = cache1;
 
   /* Get default bgp. */
   bgp = bgp_get_default ();
@@ -454,86 +585,15 @@ bgp_scan_ipv4 ()
       if (peer->afc[AFI_IP][SAFI_MPLS_VPN])
 	bgp_maximum_prefix_overflow (peer, AFI_IP, SAFI_MPLS_VPN, 1);
     }
-
-  for (rn = bgp_table_top (bgp->rib[AFI_IP][SAFI_UNICAST]); rn;
-       rn = bgp_route_next (rn))
-    {
-      for (bi = rn->info; bi; bi = next)
-	{
-	  next = bi->next;
-
-	  if (bi->type == ZEBRA_ROUTE_BGP && bi->sub_type == BGP_ROUTE_NORMAL)
-	    {
-	      changed = 0;
-	      metricchanged = 0;
-
-	      if (peer_sort (bi->peer) == BGP_PEER_EBGP && bi->peer->ttl == 1)
-		valid = bgp_nexthop_check_ebgp (AFI_IP, bi->attr);
-	      else
-		valid = bgp_nexthop_lookup (AFI_IP, bi->peer, bi,
-					    &changed, &metricchanged);
-
-	      current = CHECK_FLAG (bi->flags, BGP_INFO_VALID) ? 1 : 0;
-
-	      if (changed)
-		SET_FLAG (bi->flags, BGP_INFO_IGP_CHANGED);
-	      else
-		UNSET_FLAG (bi->flags, BGP_INFO_IGP_CHANGED);
-
-	      if (valid != current)
-		{
-		  if (CHECK_FLAG (bi->flags, BGP_INFO_VALID))
-		    {
-		      bgp_aggregate_decrement (bgp, &rn->p, bi,
-					       AFI_IP, SAFI_UNICAST);
-		      UNSET_FLAG (bi->flags, BGP_INFO_VALID);
-		    }
-		  else
-		    {
-		      SET_FLAG (bi->flags, BGP_INFO_VALID);
-		      bgp_aggregate_increment (bgp, &rn->p, bi,
-					       AFI_IP, SAFI_UNICAST);
-		    }
-		}
-
-              if (CHECK_FLAG (bgp->af_flags[AFI_IP][SAFI_UNICAST],
-		  BGP_CONFIG_DAMPENING)
-                  &&  bi->damp_info )
-                if (bgp_damp_scan (bi, AFI_IP, SAFI_UNICAST))
-		  bgp_aggregate_increment (bgp, &rn->p, bi,
-					   AFI_IP, SAFI_UNICAST);
-	    }
-	}
-      bgp_process (bgp, rn, AFI_IP, SAFI_UNICAST);
-    }
-
-  /* Flash old cache. */
-  if (bgp_nexthop_cache_ipv4 == cache1)
-    bgp_nexthop_cache_reset (cache2);
-  else
-    bgp_nexthop_cache_reset (cache1);
 }
 
 #ifdef HAVE_IPV6
 void
 bgp_scan_ipv6 ()
 {
-  struct bgp_node *rn;
   struct bgp *bgp;
-  struct bgp_info *bi;
-  struct bgp_info *next;
   struct peer *peer;
   struct listnode *nn;
-  int valid;
-  int current;
-  int changed;
-  int metricchanged;
-
-  /* Change cache. */
-  if (bgp_nexthop_cache_ipv6 == cache6_1)
-    bgp_nexthop_cache_ipv6 = cache6_2;
-  else
-    bgp_nexthop_cache_ipv6 = cache6_1;
 
   /* Get default bgp. */
   bgp = bgp_get_default ();
@@ -551,68 +611,10 @@ bgp_scan_ipv6 ()
       if (peer->afc[AFI_IP6][SAFI_MULTICAST])
 	bgp_maximum_prefix_overflow (peer, AFI_IP6, SAFI_MULTICAST, 1);
     }
-
-  for (rn = bgp_table_top (bgp->rib[AFI_IP6][SAFI_UNICAST]); rn;
-       rn = bgp_route_next (rn))
-    {
-      for (bi = rn->info; bi; bi = next)
-	{
-	  next = bi->next;
-
-	  if (bi->type == ZEBRA_ROUTE_BGP && bi->sub_type == BGP_ROUTE_NORMAL)
-	    {
-	      changed = 0;
-	      metricchanged = 0;
-
-	      if (peer_sort (bi->peer) == BGP_PEER_EBGP && bi->peer->ttl == 1)
-		valid = 1;
-	      else
-		valid = bgp_nexthop_lookup_ipv6 (bi->peer, bi,
-						 &changed, &metricchanged);
-
-	      current = CHECK_FLAG (bi->flags, BGP_INFO_VALID) ? 1 : 0;
-
-	      if (changed)
-		SET_FLAG (bi->flags, BGP_INFO_IGP_CHANGED);
-	      else
-		UNSET_FLAG (bi->flags, BGP_INFO_IGP_CHANGED);
-
-	      if (valid != current)
-		{
-		  if (CHECK_FLAG (bi->flags, BGP_INFO_VALID))
-		    {
-		      bgp_aggregate_decrement (bgp, &rn->p, bi,
-					       AFI_IP6, SAFI_UNICAST);
-		      UNSET_FLAG (bi->flags, BGP_INFO_VALID);
-		    }
-		  else
-		    {
-		      SET_FLAG (bi->flags, BGP_INFO_VALID);
-		      bgp_aggregate_increment (bgp, &rn->p, bi,
-					       AFI_IP6, SAFI_UNICAST);
-		    }
-		}
-
-              if (CHECK_FLAG (bgp->af_flags[AFI_IP6][SAFI_UNICAST],
-		  BGP_CONFIG_DAMPENING)
-                  &&  bi->damp_info )
-                if (bgp_damp_scan (bi, AFI_IP6, SAFI_UNICAST))
-		  bgp_aggregate_increment (bgp, &rn->p, bi,
-					   AFI_IP6, SAFI_UNICAST);
-	    }
-	}
-      bgp_process (bgp, rn, AFI_IP6, SAFI_UNICAST);
-    }
-
-  /* Flash old cache. */
-  if (bgp_nexthop_cache_ipv6 == cache6_1)
-    bgp_nexthop_cache_reset (cache6_2);
-  else
-    bgp_nexthop_cache_reset (cache6_1);
 }
 #endif /* HAVE_IPV6 */
 
-/* BGP scan thread.  This thread check nexthop reachability. */
+/* BGP scan thread.  This thread checks maximum prefix counts. */
 int
 bgp_scan (struct thread *t)
 {
@@ -636,6 +638,18 @@ struct bgp_connected
   unsigned int refcnt;
 };
 
+/* Update groups are split by the connected network of their eBGP
+   members, regroup whenever it changes.  */
+static void
+bgp_connected_regroup ()
+{
+  struct bgp *bgp;
+  struct listnode *nn;
+
+  LIST_LOOP (bm->bgp, bgp, nn)
+    bgp_update_group_reset (bgp);
+}
+
 void
 bgp_connected_add (struct connected *ifc)
 {
@@ -685,6 +699,7 @@ bgp_connected_add (struct connected *ifc)
 	  memset (bc, 0, sizeof (struct bgp_connected));
 	  bc->refcnt = 1;
 	  rn->info = bc;
+	  bgp_connected_regroup ();
 	}
     }
 #ifdef HAVE_IPV6
@@ -768,6 +783,7 @@ bgp_connected_delete (struct connected *ifc)
 	{
 	  XFREE (0, bc);
 	  rn->info = NULL;
+	  bgp_connected_regroup ();
 	}
       bgp_unlock_node (rn);
       bgp_unlock_node (rn);
@@ -1246,6 +1262,40 @@ bgp_multiaccess_check_v4 (struct in_addr nexthop, char *peer)
 
   return 0;
 }
+
+/* Whether the addresses of PEER1 and PEER2 are on the same connected
+   network, so that the third party nexthop check decides alike for
+   them.  */
+int
+bgp_multiaccess_same_v4 (char *peer1, char *peer2)
+{
+  struct bgp_node *rn1 = NULL;
+  struct bgp_node *rn2 = NULL;
+  struct prefix p;
+  int ret;
+
+  /* If bgp scan is not enabled, the check fails for everyone. */
+  if (zlookup->sock < 0)
+    return 1;
+
+  memset (&p, 0, sizeof (struct prefix));
+  p.family = AF_INET;
+  p.prefixlen = IPV4_MAX_BITLEN;
+
+  if (inet_aton (peer1, &p.u.prefix4))
+    rn1 = bgp_node_match (bgp_connected_ipv4, &p);
+  if (inet_aton (peer2, &p.u.prefix4))
+    rn2 = bgp_node_match (bgp_connected_ipv4, &p);
+
+  ret = (rn1 == rn2);
+
+  if (rn1)
+    bgp_unlock_node (rn1);
+  if (rn2)
+    bgp_unlock_node (rn2);
+
+  return ret;
+}
  
 DEFUN (bgp_scan_time,
        bgp_scan_time_cmd,
@@ -1382,16 +1432,12 @@ bgp_scan_init ()
   bgp_scan_interval = BGP_SCAN_INTERVAL_DEFAULT;
   bgp_import_interval = BGP_IMPORT_INTERVAL_DEFAULT;
 
-  cache1 = bgp_table_init ();
-  cache2 = bgp_table_init ();
-  bgp_nexthop_cache_ipv4 = cache1;
+  bgp_nexthop_cache_ipv4 = bgp_table_init ();
 
   bgp_connected_ipv4 = bgp_table_init ();
 
 #ifdef HAVE_IPV6
-  cache6_1 = bgp_table_init ();
-  cache6_2 = bgp_table_init ();
-  bgp_nexthop_cache_ipv6 = cache6_1;
+  bgp_nexthop_cache_ipv6 = bgp_table_init ();
   bgp_connected_ipv6 = bgp_table_init ();
 #endif /* HAVE_IPV6 */
 
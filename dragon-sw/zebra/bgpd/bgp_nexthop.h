@@ -39,14 +39,23 @@ struct bgp_nexthop_cache
   /* Nexthop number and nexthop linked list.*/
   u_char nexthop_num;
   struct nexthop *nexthop;
+
+  /* Node of the cache table this entry is kept in. */
+  struct bgp_node *node;
+
+  /* Paths resolving through this nexthop. */
+  struct bgp_info *paths;
 };
 
 void bgp_scan_init ();
-int bgp_nexthop_lookup (afi_t, struct peer *peer, struct bgp_info *,
-			int *, int *);
+int bgp_nexthop_track (afi_t, struct bgp_node *, struct bgp_info *);
+void bgp_nexthop_untrack (struct bgp_info *);
+void bgp_nexthop_update (struct stream *);
+void bgp_nexthop_register_all ();
 void bgp_connected_add (struct connected *c);
 void bgp_connected_delete (struct connected *c);
 int bgp_multiaccess_check_v4 (struct in_addr, char *);
+int bgp_multiaccess_same_v4 (char *, char *);
 int bgp_config_write_scan_time (struct vty *);
 int bgp_nexthop_check_ebgp (afi_t, struct attr *);
 int bgp_nexthop_self (afi_t, struct attr *);
@@ -157,6 +157,50 @@ bgp_connect_check (struct peer *peer)
     }
 }
 
+/* Prefixes of the UPDATE being built, for the update group cache.  */
+static struct bgp_node *bgp_update_rn[BGP_MAX_PACKET_SIZE];
+
+/* Send the advertisements an UPDATE of PEER's update group carries,
+   sharing its packet.  */
+static struct stream *
+bgp_update_packet_cached (struct peer *peer, afi_t afi, safi_t safi,
+			  struct bgp_advertise *adv,
+			  struct bgp_update_cache *cache)
+{
+  struct bgp_adj_out *adj;
+  struct bgp_node *rn;
+  struct stream *packet;
+  char buf[BUFSIZ];
+  int i;
+
+  for (i = 0; i < cache->count && adv; i++)
+    {
+      rn = adv->rn;
+      adj = adv->adj;
+
+      if (BGP_DEBUG (update, UPDATE_OUT))
+	zlog (peer->log, LOG_INFO, "%s send UPDATE %s/%d",
+	      peer->host,
+	      inet_ntop (rn->p.family, &(rn->p.u.prefix), buf, BUFSIZ),
+	      rn->p.prefixlen);
+
+      /* Synchnorize attribute.  */
+      if (adj->attr)
+	bgp_attr_unintern (adj->attr);
+      else
+	peer->scount[afi][safi]++;
+
+      adj->attr = bgp_attr_intern (adv->baa->attr);
+
+      adv = bgp_advertise_clean (peer, adj, afi, safi);
+    }
+
+  packet = stream_share (cache->packet);
+  bgp_packet_add (peer, packet);
+  bgp_update_cache_used (peer, afi, safi, cache);
+  return packet;
+}
+
 /* Make BGP update packet.  */
 struct stream *
 bgp_update_packet (struct peer *peer, afi_t afi, safi_t safi)
@@ -172,12 +216,20 @@ bgp_update_packet (struct peer *peer, afi_t afi, safi_t safi)
   char buf[BUFSIZ];
   struct prefix_rd *prd = NULL;
   char *tag = NULL;
+  struct bgp_update_cache *cache;
+  struct attr *attr = NULL;
+  struct peer *from = NULL;
+  int count = 0;
 
   s = peer->work;
   stream_reset (s);
 
   adv = FIFO_HEAD (&peer->sync[afi][safi]->update);
 
+  /* Another member of the update group may have built it already.  */
+  if (adv && (cache = bgp_update_cache_lookup (peer, afi, safi, adv)))
+    return bgp_update_packet_cached (peer, afi, safi, adv, cache);
+
   while (adv)
     {
       if (adv->rn)
@@ -208,10 +260,14 @@ bgp_update_packet (struct peer *peer, afi_t afi, safi_t safi)
 						 &rn->p, afi, safi,
 						 binfo->peer, prd, tag);
 	  stream_putw_at (s, pos, total_attr_len);
+
+	  attr = bgp_attr_intern (adv->baa->attr);
+	  from = binfo->peer;
 	}
 
       if (afi == AFI_IP && safi == SAFI_UNICAST)
 	stream_put_prefix (s, &rn->p);
+      bgp_update_rn[count++] = rn;
       
       if (BGP_DEBUG (update, UPDATE_OUT))
 	zlog (peer->log, LOG_INFO, "%s send UPDATE %s/%d",
@@ -239,6 +295,10 @@ bgp_update_packet (struct peer *peer, afi_t afi, safi_t safi)
       packet = bgp_packet_dup (s);
       bgp_packet_add (peer, packet);
       stream_reset (s);
+
+      bgp_update_cache_add (peer, afi, safi, packet, attr, from,
+			    bgp_update_rn, count);
+      bgp_attr_unintern (attr);
       return packet;
     }
   return NULL;
@@ -333,7 +393,6 @@ bgp_default_update_send (struct peer *peer, struct attr *attr,
 			 afi_t afi, safi_t safi, struct peer *from)
 {
   struct stream *s;
-  struct stream *packet;
   struct prefix p;
   unsigned long pos;
   bgp_size_t total_attr_len;
@@ -383,16 +442,13 @@ bgp_default_update_send (struct peer *peer, struct attr *attr,
   /* Set size. */
   bgp_packet_set_size (s);
 
-  packet = bgp_packet_dup (s);
-  stream_free (s);
-
   /* Dump packet if debug option is set. */
 #ifdef DEBUG
-  bgp_packet_dump (packet);
+  bgp_packet_dump (s);
 #endif /* DEBUG */
 
   /* Add packet to the peer. */
-  bgp_packet_add (peer, packet);
+  bgp_packet_add (peer, s);
 
   BGP_WRITE_ON (peer->t_write, bgp_write, peer->fd);
 }
@@ -401,7 +457,6 @@ void
 bgp_default_withdraw_send (struct peer *peer, afi_t afi, safi_t safi)
 {
   struct stream *s;
-  struct stream *packet;
   struct prefix p;
   unsigned long pos;
   unsigned long cp;
@@ -462,16 +517,14 @@ bgp_default_withdraw_send (struct peer *peer, afi_t afi, safi_t safi)
 
   bgp_packet_set_size (s);
 
-  packet = bgp_packet_dup (s);
-  stream_free (s);
-
   /* Add packet to the peer. */
-  bgp_packet_add (peer, packet);
+  bgp_packet_add (peer, s);
 
   BGP_WRITE_ON (peer->t_write, bgp_write, peer->fd);
 }
 
-/* Get next packet to be written.  */
+/* Make the next UPDATE packet which may be sent to the peer and queue
+   it.  */
 struct stream *
 bgp_write_packet (struct peer *peer)
 {
@@ -480,10 +533,6 @@ bgp_write_packet (struct peer *peer)
   struct stream *s = NULL;
   struct bgp_advertise *adv;
 
-  s = stream_fifo_head (peer->obuf);
-  if (s)
-    return s;
-
   for (afi = AFI_IP; afi < AFI_MAX; afi++)
     for (safi = SAFI_UNICAST; safi < SAFI_MAX; safi++)
       {
@@ -539,15 +588,18 @@ bgp_write_proceed (struct peer *peer)
   return 0;
 }
 
-/* Write packet to the peer. */
+/* Write packets to the peer.  Up to BGP_WRITE_PACKET_MAX queued
+   packets go out with one writev() call.  */
 int
 bgp_write (struct thread *thread)
 {
   struct peer *peer;
   u_char type;
   struct stream *s; 
+  struct iovec iov[BGP_WRITE_PACKET_MAX];
+  int iovcnt;
   int num;
-  int count = 0;
+  int writenum;
   int write_errno;
 
   /* Yes first of all get peer pointer. */
@@ -561,45 +613,57 @@ bgp_write (struct thread *thread)
       return 0;
     }
 
-    /* Nonblocking write until TCP output buffer is full.  */
-  while (1)
-    {
-      int writenum;
-
-      s = bgp_write_packet (peer);
-      if (! s)
-	return 0;
+  /* Make packets ready until the vector is full.  */
+  while (peer->obuf->count < BGP_WRITE_PACKET_MAX)
+    if (! bgp_write_packet (peer))
+      break;
 
-      /* Number of bytes to be sent.  */
-      writenum = stream_get_endp (s) - stream_get_getp (s);
+  iovcnt = 0;
+  for (s = stream_fifo_head (peer->obuf); s && iovcnt < BGP_WRITE_PACKET_MAX;
+       s = s->next)
+    {
+      iov[iovcnt].iov_base = STREAM_PNT (s);
+      iov[iovcnt].iov_len = stream_get_endp (s) - stream_get_getp (s);
+      iovcnt++;
+    }
+  if (! iovcnt)
+    return 0;
 
-      /* Call write() system call.  */
-      num = write (peer->fd, STREAM_PNT (s), writenum);
-      write_errno = errno;
-      if (num <= 0)
+  /* Call writev() system call.  */
+  num = writev (peer->fd, iov, iovcnt);
+  write_errno = errno;
+  if (num <= 0)
+    {
+      if (num < 0
+	  && (write_errno == EWOULDBLOCK || write_errno == EAGAIN
+	      || write_errno == EINTR))
 	{
-	  /* Partial write. */
-	  if (write_errno == EWOULDBLOCK || write_errno == EAGAIN)
-	      break;
-
-	  bgp_stop (peer);
-	  peer->status = Idle;
-	  bgp_timer_set (peer);
+	  BGP_WRITE_ON (peer->t_write, bgp_write, peer->fd);
 	  return 0;
 	}
-      if (num != writenum)
-	{
-	  stream_forward (s, num);
 
-	  if (write_errno == EAGAIN)
-	    break;
+      bgp_stop (peer);
+      peer->status = Idle;
+      bgp_timer_set (peer);
+      return 0;
+    }
+
+  /* Delete the packets which were written completely.  */
+  while (num > 0 && (s = stream_fifo_head (peer->obuf)) != NULL)
+    {
+      /* Number of bytes of this packet still to be sent.  */
+      writenum = stream_get_endp (s) - stream_get_getp (s);
 
-	  continue;
+      /* Partial write. */
+      if (num < writenum)
+	{
+	  stream_forward (s, num);
+	  break;
 	}
+      num -= writenum;
 
       /* Retrieve BGP packet type. */
-      stream_set_getp (s, BGP_MARKER_SIZE + 2);
-      type = stream_getc (s);
+      type = stream_getc_from (s, BGP_MARKER_SIZE + 2);
 
       switch (type)
 	{
@@ -638,9 +702,6 @@ bgp_write (struct thread *thread)
 
       /* OK we send packet so delete it. */
       bgp_packet_delete (peer);
-
-      if (++count >= BGP_WRITE_PACKET_MAX)
-	break;
     }
   
   if (bgp_write_proceed (peer))
@@ -901,7 +962,6 @@ bgp_route_refresh_send (struct peer *peer, afi_t afi, safi_t safi,
 			u_char orf_type, u_char when_to_refresh, int remove)
 {
   struct stream *s;
-  struct stream *packet;
   int length;
   struct bgp_filter *filter;
   int orf_refresh = 0;
@@ -983,12 +1043,8 @@ bgp_route_refresh_send (struct peer *peer, afi_t afi, safi_t safi,
 		 BGP_MSG_ROUTE_REFRESH_NEW : BGP_MSG_ROUTE_REFRESH_OLD, length);
     }
 
-  /* Make real packet. */
-  packet = bgp_packet_dup (s);
-  stream_free (s);
-
   /* Add packet to the peer. */
-  bgp_packet_add (peer, packet);
+  bgp_packet_add (peer, s);
 
   BGP_WRITE_ON (peer->t_write, bgp_write, peer->fd);
 }
@@ -999,7 +1055,6 @@ bgp_capability_send (struct peer *peer, afi_t afi, safi_t safi,
 		     int capability_code, int action)
 {
   struct stream *s;
-  struct stream *packet;
   int length;
 
   /* Adjust safi code. */
@@ -1046,12 +1101,8 @@ bgp_capability_send (struct peer *peer, afi_t afi, safi_t safi,
   /* Set packet size. */
   length = bgp_packet_set_size (s);
 
-  /* Make real packet. */
-  packet = bgp_packet_dup (s);
-  stream_free (s);
-
   /* Add packet to the peer. */
-  bgp_packet_add (peer, packet);
+  bgp_packet_add (peer, s);
 
   if (BGP_DEBUG (normal, NORMAL))
     zlog_info ("%s send message type %d, length (incl. header) %d",
@@ -1222,7 +1273,6 @@ bgp_open_receive (struct peer *peer, bgp_size_t size)
       /* Transfer input buffer. */
       stream_free (realpeer->ibuf);
       realpeer->ibuf = peer->ibuf;
-      realpeer->packet_size = peer->packet_size;
       peer->ibuf = NULL;
 
       /* Transfer status. */
@@ -1349,8 +1399,10 @@ bgp_open_receive (struct peer *peer, bgp_size_t size)
 
   BGP_EVENT_ADD (peer, Receive_OPEN_message);
 
-  peer->packet_size = 0;
-  if (peer->ibuf)
+  /* The input buffer taken over from the accepted connection is still
+     inside this message.  Nothing follows it, as the neighbor waits for
+     our OPEN.  */
+  if (realpeer)
     stream_reset (peer->ibuf);
 
   return 0;
@@ -1828,6 +1880,7 @@ bgp_route_refresh_receive (struct peer *peer, bgp_size_t size)
 		}
 	      peer->orf_plist[afi][safi] =
 			 prefix_list_lookup (AFI_ORF_PREFIX, name);
+	      bgp_update_group_reset (peer->bgp);
 	    }
 	  stream_forward (s, orf_len);
 	}
@@ -1937,6 +1990,7 @@ bgp_capability_msg_parse (struct peer *peer, u_char *pnt, bgp_size_t length)
 		{
 		  peer->afc_recv[afi][safi] = 0;
 		  peer->afc_nego[afi][safi] = 0;
+		  bgp_update_group_reset (peer->bgp);
 
 		  if (peer_active_nego (peer))
 		    bgp_clear_route (peer, afi, safi);
@@ -2028,14 +2082,15 @@ bgp_capability_receive (struct peer *peer, bgp_size_t size)
   ret = bgp_capability_msg_parse (peer, pnt, size);
 }
  
-/* BGP read utility function. */
+/* BGP read utility function.  Read what the socket has into the free
+   part of the input buffer.  */
 int
 bgp_read_packet (struct peer *peer)
 {
   int nbytes;
   int readsize;
 
-  readsize = peer->packet_size - peer->ibuf->putp;
+  readsize = STREAM_REMAIN (peer->ibuf);
 
   /* If size is zero then return. */
   if (! readsize)
@@ -2048,7 +2103,7 @@ bgp_read_packet (struct peer *peer)
   if (nbytes < 0) 
     {
       if (errno == EAGAIN)
-	return -1;
+	return 0;
 
       plog_err (peer->log, "%s [Error] bgp_read_packet error: %s",
 		 peer->host, strerror (errno));
@@ -2070,10 +2125,6 @@ bgp_read_packet (struct peer *peer)
       return -1;
     }
 
-  /* We read partial packet. */
-  if (peer->ibuf->putp != peer->packet_size)
-    return -1;
-
   return 0;
 }
 
@@ -2084,13 +2135,30 @@ bgp_marker_all_one (struct stream *s, int length)
   int i;
 
   for (i = 0; i < length; i++)
-    if (s->data[i] != 0xff)
+    if (STREAM_PNT (s)[i] != 0xff)
       return 0;
 
   return 1;
 }
 
-/* Starting point of packet process function. */
+/* Move the part of a message left at the end of the input buffer to
+   its start.  */
+static void
+bgp_read_compact (struct stream *s)
+{
+  unsigned long left;
+
+  left = stream_get_putp (s) - stream_get_getp (s);
+  if (left && stream_get_getp (s))
+    memmove (STREAM_DATA (s), STREAM_PNT (s), left);
+
+  s->putp = s->endp = left;
+  s->getp = 0;
+}
+
+/* Starting point of packet process function.  All the complete
+   messages brought in by one read are processed where they are in the
+   input buffer.  */
 int
 bgp_read (struct thread *thread)
 {
@@ -2098,6 +2166,7 @@ bgp_read (struct thread *thread)
   u_char type = 0;
   struct peer *peer;
   bgp_size_t size;
+  unsigned long start;
   char notify_data_length[2];
 
   /* Yes first of all get peer pointer. */
@@ -2117,26 +2186,27 @@ bgp_read (struct thread *thread)
 	  zlog_err ("bgp_read peer's fd is negative value %d", peer->fd);
 	  return -1;
 	}
-      BGP_READ_ON (peer->t_read, bgp_read, peer->fd);
+      if (bgp_process_congested ())
+	BGP_READ_YIELD (peer->t_read, bgp_read);
+      else
+	BGP_READ_ON (peer->t_read, bgp_read, peer->fd);
     }
 
-  /* Read packet header to determine type of the packet */
-  if (peer->packet_size == 0)
-    peer->packet_size = BGP_HEADER_SIZE;
+  ret = bgp_read_packet (peer);
+  if (ret < 0) 
+    goto done;
 
-  if (peer->ibuf->putp < BGP_HEADER_SIZE)
+  while (peer->ibuf
+	 && stream_get_putp (peer->ibuf) - stream_get_getp (peer->ibuf)
+	    >= BGP_HEADER_SIZE)
     {
-      ret = bgp_read_packet (peer);
-
-      /* Header read error or partial read packet. */
-      if (ret < 0) 
-	goto done;
+      start = stream_get_getp (peer->ibuf);
 
       /* Get size and type. */
-      stream_forward (peer->ibuf, BGP_MARKER_SIZE);
-      memcpy (notify_data_length, stream_pnt (peer->ibuf), 2);
-      size = stream_getw (peer->ibuf);
-      type = stream_getc (peer->ibuf);
+      size = stream_getw_from (peer->ibuf, start + BGP_MARKER_SIZE);
+      type = stream_getc_from (peer->ibuf, start + BGP_MARKER_SIZE + 2);
+      memcpy (notify_data_length,
+	      STREAM_DATA (peer->ibuf) + start + BGP_MARKER_SIZE, 2);
 
       if (BGP_DEBUG (normal, NORMAL) && type != 2 && type != 0)
 	zlog_info ("%s rcv message type %d, length (excl. header) %d",
@@ -2193,56 +2263,76 @@ bgp_read (struct thread *thread)
 	  goto done;
 	}
 
-      /* Adjust size to message length. */
-      peer->packet_size = size;
-    }
+      /* Wait for the rest of the message. */
+      if (stream_get_putp (peer->ibuf) - start < size)
+	break;
 
-  ret = bgp_read_packet (peer);
-  if (ret < 0) 
-    goto done;
+      /* BGP packet dump function. */
+      bgp_dump_packet (peer, type, peer->ibuf);
 
-  /* Get size and type again. */
-  size = stream_getw_from (peer->ibuf, BGP_MARKER_SIZE);
-  type = stream_getc_from (peer->ibuf, BGP_MARKER_SIZE + 2);
+      stream_forward (peer->ibuf, BGP_HEADER_SIZE);
+      size -= BGP_HEADER_SIZE;
 
-  /* BGP packet dump function. */
-  bgp_dump_packet (peer, type, peer->ibuf);
-  
-  size = (peer->packet_size - BGP_HEADER_SIZE);
+      /* Read rest of the packet and call each sort of packet routine */
+      switch (type) 
+	{
+	case BGP_MSG_OPEN:
+	  peer->open_in++;
+	  bgp_open_receive (peer, size);
+	  break;
+	case BGP_MSG_UPDATE:
+	  peer->readtime = time(NULL);    /* Last read timer reset */
+	  bgp_update_receive (peer, size);
+	  break;
+	case BGP_MSG_NOTIFY:
+	  bgp_notify_receive (peer, size);
+	  break;
+	case BGP_MSG_KEEPALIVE:
+	  peer->readtime = time(NULL);    /* Last read timer reset */
+	  bgp_keepalive_receive (peer, size);
+	  break;
+	case BGP_MSG_ROUTE_REFRESH_NEW:
+	case BGP_MSG_ROUTE_REFRESH_OLD:
+	  peer->refresh_in++;
+	  bgp_route_refresh_receive (peer, size);
+	  break;
+	case BGP_MSG_CAPABILITY:
+	  peer->dynamic_cap_in++;
+	  bgp_capability_receive (peer, size);
+	  break;
+	}
 
-  /* Read rest of the packet and call each sort of packet routine */
-  switch (type) 
-    {
-    case BGP_MSG_OPEN:
-      peer->open_in++;
-      bgp_open_receive (peer, size);
-      break;
-    case BGP_MSG_UPDATE:
-      peer->readtime = time(NULL);    /* Last read timer reset */
-      bgp_update_receive (peer, size);
-      break;
-    case BGP_MSG_NOTIFY:
-      bgp_notify_receive (peer, size);
-      break;
-    case BGP_MSG_KEEPALIVE:
-      peer->readtime = time(NULL);    /* Last read timer reset */
-      bgp_keepalive_receive (peer, size);
-      break;
-    case BGP_MSG_ROUTE_REFRESH_NEW:
-    case BGP_MSG_ROUTE_REFRESH_OLD:
-      peer->refresh_in++;
-      bgp_route_refresh_receive (peer, size);
-      break;
-    case BGP_MSG_CAPABILITY:
-      peer->dynamic_cap_in++;
-      bgp_capability_receive (peer, size);
-      break;
+      /* The input buffer was reset or handed over while the message
+	 was processed. */
+      if (! peer->ibuf
+	  || stream_get_putp (peer->ibuf) < start + BGP_HEADER_SIZE + size)
+	break;
+
+      /* Skip to the next message. */
+      stream_set_getp (peer->ibuf, start + BGP_HEADER_SIZE + size);
+
+      /* An OPEN or KEEPALIVE before Established only queued an FSM
+	 event.  Leave what follows until that event has run, or an
+	 UPDATE would be taken for an FSM error.  */
+      if (peer->t_read && peer->status != Established
+	  && (type == BGP_MSG_OPEN || type == BGP_MSG_KEEPALIVE))
+	{
+	  BGP_READ_OFF (peer->t_read);
+	  BGP_READ_AFTER_EVENTS (peer->t_read, bgp_read);
+	  break;
+	}
+
+      /* Leave the rest for when best path selection caught up. */
+      if (peer->t_read && bgp_process_congested ())
+	{
+	  BGP_READ_OFF (peer->t_read);
+	  BGP_READ_YIELD (peer->t_read, bgp_read);
+	  break;
+	}
     }
 
-  /* Clear input buffer. */
-  peer->packet_size = 0;
   if (peer->ibuf)
-    stream_reset (peer->ibuf);
+    bgp_read_compact (peer->ibuf);
 
  done:
   if (CHECK_FLAG (peer->sflags, PEER_STATUS_ACCEPT_PEER))
@@ -82,7 +82,7 @@ bgp_regcomp (char *regstr)
 int
 bgp_regexec (regex_t *regex, struct aspath *aspath)
 {
-  return regexec (regex, aspath->str, 0, NULL, 0);
+  return regexec (regex, aspath_print (aspath), 0, NULL, 0);
 }
 
 void
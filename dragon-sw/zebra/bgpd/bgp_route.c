@@ -102,6 +102,8 @@ bgp_info_new ()
 void
 bgp_info_free (struct bgp_info *binfo)
 {
+  bgp_nexthop_untrack (binfo);
+
   if (binfo->attr)
     bgp_attr_unintern (binfo->attr);
 
@@ -136,6 +138,30 @@ bgp_info_delete (struct bgp_node *rn, struct bgp_info *ri)
     rn->info = ri->next;
 }
 
+/* Take RI out of RN and free it.  A path which is still selected is
+   kept on the node until its pending best path selection withdraws
+   it. */
+void
+bgp_info_remove (struct bgp_node *rn, struct bgp_info *ri)
+{
+  bgp_info_delete (rn, ri);
+
+  if (! CHECK_FLAG (ri->flags, BGP_INFO_SELECTED))
+    {
+      bgp_info_free (ri);
+      bgp_unlock_node (rn);
+      return;
+    }
+
+  bgp_nexthop_untrack (ri);
+  if (ri->damp_info)
+    bgp_damp_info_free (ri->damp_info, 0);
+
+  ri->prev = NULL;
+  ri->next = rn->removed;
+  rn->removed = ri;
+}
+
 /* Get MED value.  If MED value is missing and "bgp bestpath
    missing-as-worst" is specified, treat it as the worst value. */
 u_int32_t
@@ -454,9 +480,45 @@ bgp_input_modifier (struct peer *peer, struct prefix *p, struct attr *attr,
   return RMAP_PERMIT;
 }
  
-int
-bgp_announce_check (struct bgp_info *ri, struct peer *peer, struct prefix *p,
-		    struct attr *attr, afi_t afi, safi_t safi)
+/* The part of the announce check which differs between the members of
+   an update group. */
+static int
+bgp_announce_check_peer (struct bgp_info *ri, struct peer *peer,
+			 struct prefix *p)
+{
+  char buf[SU_ADDRSTRLEN];
+
+#ifdef DISABLE_BGP_ANNOUNCE
+  return 0;
+#endif
+
+  /* Do not send back route to sender. */
+  if (ri->peer == peer)
+    return 0;
+
+  /* If the attribute has originator-id and it is same as remote
+     peer's id. */
+  if (ri->attr->flag & ATTR_FLAG_BIT (BGP_ATTR_ORIGINATOR_ID))
+    {
+      if (IPV4_ADDR_SAME (&peer->remote_id, &ri->attr->originator_id))
+	{
+	  if (BGP_DEBUG (filter, FILTER))  
+	    zlog (peer->log, LOG_INFO,
+		  "%s [Update:SEND] %s/%d originator-id is same as remote router-id",
+		  peer->host,
+		  inet_ntop(p->family, &p->u.prefix, buf, SU_ADDRSTRLEN),
+		  p->prefixlen);
+	  return 0;
+	}
+    }
+  return 1;
+}
+
+/* Outbound policy, the same for all members of an update group. */
+static int
+bgp_announce_check_policy (struct bgp_info *ri, struct peer *peer,
+			   struct prefix *p, struct attr *attr,
+			   afi_t afi, safi_t safi)
 {
   int ret;
   char buf[SU_ADDRSTRLEN];
@@ -476,10 +538,6 @@ bgp_announce_check (struct bgp_info *ri, struct peer *peer, struct prefix *p,
   return 0;
 #endif
 
-  /* Do not send back route to sender. */
-  if (from == peer)
-    return 0;
-
   /* Aggregate-address suppress check. */
   if (ri->suppress)
     if (! UNSUPPRESS_MAP_NAME (filter))
@@ -507,22 +565,6 @@ bgp_announce_check (struct bgp_info *ri, struct peer *peer, struct prefix *p,
   if (! transparent && bgp_community_filter (peer, ri->attr)) 
     return 0;
 
-  /* If the attribute has originator-id and it is same as remote
-     peer's id. */
-  if (ri->attr->flag & ATTR_FLAG_BIT (BGP_ATTR_ORIGINATOR_ID))
-    {
-      if (IPV4_ADDR_SAME (&peer->remote_id, &ri->attr->originator_id))
-	{
-	  if (BGP_DEBUG (filter, FILTER))  
-	    zlog (peer->log, LOG_INFO,
-		  "%s [Update:SEND] %s/%d originator-id is same as remote router-id",
-		  peer->host,
-		  inet_ntop(p->family, &p->u.prefix, buf, SU_ADDRSTRLEN),
-		  p->prefixlen);
-	  return 0;
-	}
-    }
- 
   /* ORF prefix-list filter check */
   if (CHECK_FLAG (peer->af_cap[afi][safi], PEER_CAP_ORF_PREFIX_RM_ADV)
       && (CHECK_FLAG (peer->af_cap[afi][safi], PEER_CAP_ORF_PREFIX_SM_RCV)
@@ -727,17 +769,44 @@ bgp_announce_check (struct bgp_info *ri, struct peer *peer, struct prefix *p,
 }
 
 int
-bgp_process (struct bgp *bgp, struct bgp_node *rn, afi_t afi, safi_t safi)
+bgp_announce_check (struct bgp_info *ri, struct peer *peer, struct prefix *p,
+		    struct attr *attr, afi_t afi, safi_t safi)
+{
+  if (! bgp_announce_check_peer (ri, peer, p))
+    return 0;
+  return bgp_announce_check_policy (ri, peer, p, attr, afi, safi);
+}
+
+/* Free the selected paths which were removed before RN was processed. */
+static void
+bgp_process_reap (struct bgp_node *rn)
+{
+  struct bgp_info *ri;
+
+  while ((ri = rn->removed) != NULL)
+    {
+      rn->removed = ri->next;
+      bgp_info_free (ri);
+      bgp_unlock_node (rn);
+    }
+}
+
+static int
+bgp_process_main (struct bgp *bgp, struct bgp_node *rn, afi_t afi,
+		  safi_t safi)
 {
   struct prefix *p;
   struct bgp_info *ri;
   struct bgp_info *new_select;
   struct bgp_info *old_select;
   struct listnode *nn;
+  struct listnode *nm;
   struct peer *peer;
   struct attr attr;
   struct bgp_info *ri1;
   struct bgp_info *ri2;
+  struct bgp_update_group *group;
+  int announce;
 
   p = &rn->p;
 
@@ -778,7 +847,7 @@ bgp_process (struct bgp *bgp, struct bgp_node *rn, afi_t afi, safi_t safi)
       }
 
   /* Check old selected route and new selected route. */
-  old_select = NULL;
+  old_select = rn->removed;
   new_select = NULL;
   for (ri = rn->info; ri; ri = ri->next)
     {
@@ -807,7 +876,10 @@ bgp_process (struct bgp *bgp, struct bgp_node *rn, afi_t afi, safi_t safi)
       if (! CHECK_FLAG (old_select->flags, BGP_INFO_ATTR_CHANGED))
 	{
 	  if (CHECK_FLAG (old_select->flags, BGP_INFO_IGP_CHANGED))
-	    bgp_zebra_announce (p, old_select, bgp);
+	    {
+	      bgp_zebra_announce (p, old_select, bgp);
+	      UNSET_FLAG (old_select->flags, BGP_INFO_IGP_CHANGED);
+	    }
 	  return 0;
 	}
     }
@@ -820,28 +892,38 @@ bgp_process (struct bgp *bgp, struct bgp_node *rn, afi_t afi, safi_t safi)
       UNSET_FLAG (new_select->flags, BGP_INFO_ATTR_CHANGED);
     }
 
-  /* Check each BGP peer. */
-  LIST_LOOP (bgp->peer, peer, nn)
+  /* Check each update group of Established peers.  The policy is
+     evaluated once for the group. */
+  LIST_LOOP (bgp_update_groups (bgp, afi, safi), group, nn)
     {
-      /* Announce route to Established peer. */
-      if (peer->status != Established)
-	continue;
+      announce = (new_select
+		  && bgp_announce_check_policy (new_select,
+						getdata (listhead (group->peer)),
+						p, &attr, afi, safi));
 
-      /* Address family configuration check. */
-      if (! peer->afc_nego[afi][safi])
-	continue;
+      LIST_LOOP (group->peer, peer, nm)
+	{
+	  /* Announce route to Established peer. */
+	  if (peer->status != Established)
+	    continue;
 
-      /* First update is deferred until ORF or ROUTE-REFRESH is received */
-      if (CHECK_FLAG (peer->af_sflags[afi][safi], PEER_STATUS_ORF_WAIT_REFRESH))
-	continue;
+	  /* Address family configuration check. */
+	  if (! peer->afc_nego[afi][safi])
+	    continue;
 
-      /* Announcement to peer->conf.  If the route is filtered,
-         withdraw it. */
-      if (new_select 
-	  && bgp_announce_check (new_select, peer, p, &attr, afi, safi))
-	bgp_adj_out_set (rn, peer, p, &attr, afi, safi, new_select);
-      else
-	bgp_adj_out_unset (rn, peer, p, afi, safi);
+	  /* First update is deferred until ORF or ROUTE-REFRESH is
+	     received */
+	  if (CHECK_FLAG (peer->af_sflags[afi][safi],
+			  PEER_STATUS_ORF_WAIT_REFRESH))
+	    continue;
+
+	  /* Announcement to peer->conf.  If the route is filtered,
+	     withdraw it. */
+	  if (announce && bgp_announce_check_peer (new_select, peer, p))
+	    bgp_adj_out_set (rn, peer, p, &attr, afi, safi, new_select);
+	  else
+	    bgp_adj_out_unset (rn, peer, p, afi, safi);
+	}
     }
 
   /* FIB update. */
@@ -861,6 +943,120 @@ bgp_process (struct bgp *bgp, struct bgp_node *rn, afi_t afi, safi_t safi)
 	    bgp_zebra_withdraw (p, old_select);
 	}
     }
+
+  /* The metric change, if any, is with zebra now. */
+  if (new_select)
+    UNSET_FLAG (new_select->flags, BGP_INFO_IGP_CHANGED);
+
+  bgp_process_reap (rn);
+  return 0;
+}
+
+/* Best path selection is deferred to a background thread.  A node is
+   queued once however many times it changes before its turn, and the
+   queues are worked in slices of BGP_PROCESS_SLICE microseconds so that
+   reading and writing of the peers go on during large updates.  Once
+   BGP_PROCESS_BACKLOG nodes are waiting, peers read from the background
+   too, so selection and reading take turns. */
+#define BGP_PROCESS_SLICE  10000
+#define BGP_PROCESS_BACKLOG  20000
+
+static struct thread *bgp_process_thread;
+static unsigned long bgp_process_count;
+
+static int bgp_process_queue (struct thread *);
+
+static void
+bgp_process_node (struct bgp *bgp, struct list *queue, afi_t afi,
+		  safi_t safi)
+{
+  struct bgp_node *rn;
+
+  rn = listnode_head (queue);
+  list_delete_node (queue, listhead (queue));
+  bgp_process_count--;
+
+  UNSET_FLAG (rn->flags, BGP_NODE_PROCESS_SCHEDULED);
+  bgp_process_main (bgp, rn, afi, safi);
+  bgp_unlock_node (rn);
+}
+
+static int
+bgp_process_queue (struct thread *thread)
+{
+  struct bgp *bgp;
+  struct listnode *nn;
+  struct list *queue;
+  struct timeval start;
+  struct timeval now;
+  afi_t afi;
+  safi_t safi;
+  int pending = 0;
+
+  bgp_process_thread = NULL;
+  gettimeofday (&start, NULL);
+
+  LIST_LOOP (bm->bgp, bgp, nn)
+    for (afi = AFI_IP; afi < AFI_MAX; afi++)
+      for (safi = SAFI_UNICAST; safi < SAFI_MAX; safi++)
+	{
+	  queue = bgp->process_queue[afi][safi];
+
+	  while (! pending && listcount (queue))
+	    {
+	      bgp_process_node (bgp, queue, afi, safi);
+
+	      gettimeofday (&now, NULL);
+	      if ((now.tv_sec - start.tv_sec) * 1000000L
+		  + (now.tv_usec - start.tv_usec) >= BGP_PROCESS_SLICE)
+		break;
+	    }
+
+	  if (listcount (queue))
+	    pending = 1;
+	}
+
+  if (pending)
+    THREAD_BACKGROUND_ON (master, bgp_process_thread, bgp_process_queue,
+			  NULL);
+  return 0;
+}
+
+/* Run the pending best path selection of BGP now. */
+void
+bgp_process_queue_flush (struct bgp *bgp)
+{
+  struct list *queue;
+  afi_t afi;
+  safi_t safi;
+
+  for (afi = AFI_IP; afi < AFI_MAX; afi++)
+    for (safi = SAFI_UNICAST; safi < SAFI_MAX; safi++)
+      {
+	queue = bgp->process_queue[afi][safi];
+	while (listcount (queue))
+	  bgp_process_node (bgp, queue, afi, safi);
+      }
+}
+
+/* Whether peers should leave their input alone for a while. */
+int
+bgp_process_congested ()
+{
+  return bgp_process_count >= BGP_PROCESS_BACKLOG;
+}
+
+int
+bgp_process (struct bgp *bgp, struct bgp_node *rn, afi_t afi, safi_t safi)
+{
+  if (CHECK_FLAG (rn->flags, BGP_NODE_PROCESS_SCHEDULED))
+    return 0;
+
+  SET_FLAG (rn->flags, BGP_NODE_PROCESS_SCHEDULED);
+  listnode_add (bgp->process_queue[afi][safi], bgp_lock_node (rn));
+  bgp_process_count++;
+
+  THREAD_BACKGROUND_ON (master, bgp_process_thread, bgp_process_queue, NULL);
   return 0;
 }
 
@@ -935,9 +1131,7 @@ bgp_rib_remove (struct bgp_node *rn, struct bgp_info *ri, struct peer *peer,
       UNSET_FLAG (ri->flags, BGP_INFO_VALID);
       bgp_process (peer->bgp, rn, afi, safi);
     }
-  bgp_info_delete (rn, ri);
-  bgp_info_free (ri);
-  bgp_unlock_node (rn);
+  bgp_info_remove (rn, ri);
 }
 
 void
@@ -972,9 +1166,7 @@ bgp_rib_withdraw (struct bgp_node *rn, struct bgp_info *ri, struct peer *peer,
 
   if (status != BGP_DAMP_USED)
     {
-      bgp_info_delete (rn, ri);
-      bgp_info_free (ri);
-      bgp_unlock_node (rn);
+      bgp_info_remove (rn, ri);
     }
 }
 
@@ -1176,14 +1368,12 @@ bgp_update (struct peer *peer, struct prefix *p, struct attr *attr,
 	    }
 	}
 
-      /* Nexthop reachability check. */
+      /* Nexthop reachability check.  The nexthop is tracked from now
+	 on. */
       if ((afi == AFI_IP || afi == AFI_IP6)
-	  && safi == SAFI_UNICAST 
-	  && (peer_sort (peer) == BGP_PEER_IBGP
-	      || (peer_sort (peer) == BGP_PEER_EBGP && peer->ttl != 1)
-	      || CHECK_FLAG (peer->flags, PEER_FLAG_ENFORCE_MULTIHOP)))
+	  && safi == SAFI_UNICAST)
 	{
-	  if (bgp_nexthop_lookup (afi, peer, ri, NULL, NULL))
+	  if (bgp_nexthop_track (afi, rn, ri))
 	    SET_FLAG (ri->flags, BGP_INFO_VALID);
 	  else
 	    UNSET_FLAG (ri->flags, BGP_INFO_VALID);
@@ -1223,14 +1413,12 @@ bgp_update (struct peer *peer, struct prefix *p, struct attr *attr,
   if (safi == SAFI_MPLS_VPN)
     memcpy (new->tag, tag, 3);
 
-  /* Nexthop reachability check. */
+  /* Nexthop reachability check.  The nexthop is tracked from now
+     on. */
   if ((afi == AFI_IP || afi == AFI_IP6)
-      && safi == SAFI_UNICAST
-      && (peer_sort (peer) == BGP_PEER_IBGP
-	  || (peer_sort (peer) == BGP_PEER_EBGP && peer->ttl != 1)
-	  || CHECK_FLAG (peer->flags, PEER_FLAG_ENFORCE_MULTIHOP)))
+      && safi == SAFI_UNICAST)
     {
-      if (bgp_nexthop_lookup (afi, peer, new, NULL, NULL))
+      if (bgp_nexthop_track (afi, rn, new))
 	SET_FLAG (new->flags, BGP_INFO_VALID);
       else
 	UNSET_FLAG (new->flags, BGP_INFO_VALID);
@@ -1427,6 +1615,8 @@ bgp_announce_route (struct peer *peer, afi_t afi, safi_t safi)
   struct bgp_node *rn;
   struct bgp_table *table;
 
+  bgp_update_group_reset (peer->bgp);
+
   if (peer->status != Established)
     return;
 
@@ -1959,9 +2149,7 @@ bgp_static_withdraw (struct bgp *bgp, struct prefix *p, afi_t afi,
       bgp_aggregate_decrement (bgp, p, ri, afi, safi);
       UNSET_FLAG (ri->flags, BGP_INFO_VALID);
       bgp_process (bgp, rn, afi, safi);
-      bgp_info_delete (rn, ri);
-      bgp_info_free (ri);
-      bgp_unlock_node (rn);
+      bgp_info_remove (rn, ri);
     }
 
   /* Unlock bgp_node_lookup. */
@@ -1990,9 +2178,7 @@ bgp_static_withdraw_vpnv4 (struct bgp *bgp, struct prefix *p, u_int16_t afi,
       bgp_aggregate_decrement (bgp, p, ri, afi, safi);
       UNSET_FLAG (ri->flags, BGP_INFO_VALID);
       bgp_process (bgp, rn, afi, safi);
-      bgp_info_delete (rn, ri);
-      bgp_info_free (ri);
-      bgp_unlock_node (rn);
+      bgp_info_remove (rn, ri);
     }
 
   /* Unlock bgp_node_lookup. */
@@ -3102,9 +3288,7 @@ bgp_aggregate_delete (struct bgp *bgp, struct prefix *p, afi_t afi,
     {
       UNSET_FLAG (ri->flags, BGP_INFO_VALID);
       bgp_process (bgp, rn, afi, safi);
-      bgp_info_delete (rn, ri);
-      bgp_info_free (ri);
-      bgp_unlock_node (rn);
+      bgp_info_remove (rn, ri);
     }
 
   /* Unlock bgp_node_lookup. */
@@ -3683,9 +3867,7 @@ bgp_redistribute_delete (struct prefix *p, u_char type)
 	      bgp_aggregate_decrement (bgp, p, ri, afi, SAFI_UNICAST);
 	      UNSET_FLAG (ri->flags, BGP_INFO_VALID);
 	      bgp_process (bgp, rn, afi, SAFI_UNICAST);
-	      bgp_info_delete (rn, ri);
-	      bgp_info_free (ri);
-	      bgp_unlock_node (rn);
+	      bgp_info_remove (rn, ri);
 	    }
 	  bgp_unlock_node (rn);
 	}
@@ -3714,9 +3896,7 @@ bgp_redistribute_withdraw (struct bgp *bgp, afi_t afi, int type)
 	  bgp_aggregate_decrement (bgp, &rn->p, ri, afi, SAFI_UNICAST);
 	  UNSET_FLAG (ri->flags, BGP_INFO_VALID);
 	  bgp_process (bgp, rn, afi, SAFI_UNICAST);
-	  bgp_info_delete (rn, ri);
-	  bgp_info_free (ri);
-	  bgp_unlock_node (rn);
+	  bgp_info_remove (rn, ri);
 	}
     }
 }
@@ -3851,7 +4031,7 @@ route_vty_out (struct vty *vty, struct prefix *p,
       aspath_print_vty (vty, attr->aspath);
 
     /* Print origin */
-    if (strlen (attr->aspath->str) == 0)
+    if (strlen (aspath_print (attr->aspath)) == 0)
       vty_out (vty, "%s", bgp_origin_str[attr->origin]);
     else
       vty_out (vty, " %s", bgp_origin_str[attr->origin]);
@@ -3917,7 +4097,7 @@ route_vty_out_tmp (struct vty *vty, struct prefix *p,
       aspath_print_vty (vty, attr->aspath);
 
     /* Print origin */
-    if (strlen (attr->aspath->str) == 0)
+    if (strlen (aspath_print (attr->aspath)) == 0)
       vty_out (vty, "%s", bgp_origin_str[attr->origin]);
     else
       vty_out (vty, " %s", bgp_origin_str[attr->origin]);
@@ -4058,7 +4238,7 @@ damp_route_vty_out (struct vty *vty, struct prefix *p,
 	aspath_print_vty (vty, attr->aspath);
 
       /* Print origin */
-      if (strlen (attr->aspath->str) == 0)
+      if (strlen (aspath_print (attr->aspath)) == 0)
 	vty_out (vty, "%s", bgp_origin_str[attr->origin]);
       else
 	vty_out (vty, " %s", bgp_origin_str[attr->origin]);
@@ -4142,7 +4322,7 @@ flap_route_vty_out (struct vty *vty, struct prefix *p,
 	aspath_print_vty (vty, attr->aspath);
 
       /* Print origin */
-      if (strlen (attr->aspath->str) == 0)
+      if (strlen (aspath_print (attr->aspath)) == 0)
 	vty_out (vty, "%s", bgp_origin_str[attr->origin]);
       else
 	vty_out (vty, " %s", bgp_origin_str[attr->origin]);
@@ -4286,12 +4466,13 @@ route_vty_out_detail (struct vty *vty, struct bgp *bgp, struct prefix *p,
 	  
       /* Line 4 display Community */
       if (attr->community)
-	vty_out (vty, "      Community: %s%s", attr->community->str,
+	vty_out (vty, "      Community: %s%s", community_str (attr->community),
 		 VTY_NEWLINE);
 	  
       /* Line 5 display Extended-community */
       if (attr->flag & ATTR_FLAG_BIT(BGP_ATTR_EXT_COMMUNITIES))
-	vty_out (vty, "      Extended Community: %s%s", attr->ecommunity->str,
+	vty_out (vty, "      Extended Community: %s%s",
+		 ecommunity_str (attr->ecommunity),
 		 VTY_NEWLINE);
 	  
       /* Line 6 display Originator, Cluster-id */
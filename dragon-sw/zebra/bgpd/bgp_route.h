@@ -64,6 +64,13 @@ struct bgp_info
   /* Pointer to dampening structure.  */
   struct bgp_damp_info *damp_info;
 
+  /* Nexthop cache entry this path resolves through, the other paths
+     of that entry, and this path's route node.  */
+  struct bgp_nexthop_cache *nexthop;
+  struct bgp_info *nh_next;
+  struct bgp_info *nh_prev;
+  struct bgp_node *nh_rn;
+
   /* MPLS label.  */
   u_char tag[3];
 };
@@ -126,6 +133,8 @@ void bgp_soft_reconfig_in (struct peer *, afi_t, safi_t);
 void bgp_clear_route (struct peer *, afi_t, safi_t);
 void bgp_clear_route_all (struct peer *);
 void bgp_clear_adj_in (struct peer *, afi_t, safi_t);
+void bgp_process_queue_flush (struct bgp *);
+int bgp_process_congested ();
 
 int bgp_nlri_sanity_check (struct peer *, int, u_char *, bgp_size_t);
 int bgp_nlri_parse (struct peer *, struct attr *, struct bgp_nlri *);
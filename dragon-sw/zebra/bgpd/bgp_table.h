@@ -44,6 +44,12 @@ struct bgp_node
   void *aggregate;
 
   struct bgp_node *prn;
+
+  /* Selected paths taken out of the node before it was processed. */
+  struct bgp_info *removed;
+
+  u_char flags;
+#define BGP_NODE_PROCESS_SCHEDULED	(1 << 0)
 };
 
 struct bgp_table *bgp_table_init (void);
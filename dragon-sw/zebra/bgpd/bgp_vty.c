@@ -7113,6 +7113,18 @@ DEFUN (show_ip_bgp_attr_info,
   attr_show_all (vty);
   return CMD_SUCCESS;
 }
+
+DEFUN (show_ip_bgp_attr_memory, 
+       show_ip_bgp_attr_memory_cmd,
+       "show ip bgp attribute-memory",
+       SHOW_STR
+       IP_STR
+       BGP_STR
+       "Memory used by each kind of bgp attribute\n")
+{
+  attr_memory_show (vty);
+  return CMD_SUCCESS;
+}
  
 /* Redistribute VTY commands.  */
 
@@ -8586,6 +8598,8 @@ bgp_vty_init ()
   /* "show ip bgp attribute-info" commands. */
   install_element (VIEW_NODE, &show_ip_bgp_attr_info_cmd);
   install_element (ENABLE_NODE, &show_ip_bgp_attr_info_cmd);
+  install_element (VIEW_NODE, &show_ip_bgp_attr_memory_cmd);
+  install_element (ENABLE_NODE, &show_ip_bgp_attr_memory_cmd);
 
   /* "redistribute" commands.  */
   install_element (BGP_NODE, &bgp_redistribute_ipv4_cmd);
@@ -971,6 +971,31 @@ bgp_redistribute_metric_unset (struct bgp *bgp, afi_t afi, int type)
   return 1;
 }
  
+/* Register or unregister nexthop P with zebra. */
+void
+bgp_zebra_nexthop_send (int command, struct prefix *p)
+{
+  if (! zclient || zclient->sock < 0)
+    return;
+
+  zebra_nexthop_send (command, zclient->sock, p);
+}
+
+int
+bgp_zebra_nexthop_update (int command, struct zclient *zclient,
+			  zebra_size_t length)
+{
+  bgp_nexthop_update (zclient->ibuf);
+  return 0;
+}
+
+/* Zebra forgot our nexthops when the connection went down. */
+static void
+bgp_zebra_connected (struct zclient *zclient)
+{
+  bgp_nexthop_register_all ();
+}
+
 void
 bgp_zclient_reset ()
 {
@@ -995,6 +1020,8 @@ bgp_zebra_init (int enable)
   zclient->ipv6_route_add = zebra_read_ipv6;
   zclient->ipv6_route_delete = zebra_read_ipv6;
 #endif /* HAVE_IPV6 */
+  zclient->nexthop_update = bgp_zebra_nexthop_update;
+  zclient->connected = bgp_zebra_connected;
 
   /* Interface related init. */
   if_init ();
@@ -23,6 +23,7 @@ int bgp_config_write_redistribute (struct vty *, struct bgp *, afi_t, safi_t,
 				   int *);
 void bgp_zebra_announce (struct prefix *, struct bgp_info *, struct bgp *);
 void bgp_zebra_withdraw (struct prefix *, struct bgp_info *);
+void bgp_zebra_nexthop_send (int, struct prefix *);
 
 int bgp_redistribute_set (struct bgp *, afi_t, int);
 int bgp_redistribute_rmap_set (struct bgp *, afi_t, int, char *);
@@ -736,7 +736,7 @@ peer_new ()
   SET_FLAG (peer->sflags, PEER_STATUS_CAPABILITY_OPEN);
 
   /* Create buffers.  */
-  peer->ibuf = stream_new (BGP_MAX_PACKET_SIZE);
+  peer->ibuf = stream_new (BGP_READ_BUFFER_SIZE);
   peer->obuf = stream_fifo_new ();
   peer->work = stream_new (BGP_MAX_PACKET_SIZE);
 
@@ -1082,6 +1082,9 @@ peer_delete (struct peer *peer)
   bgp_stop (peer);
   bgp_fsm_change_status (peer, Idle);
 
+  /* The withdrawn routes still refer to the peer until processed. */
+  bgp_process_queue_flush (bgp);
+
   /* Stop all timers. */
   BGP_TIMER_OFF (peer->t_start);
   BGP_TIMER_OFF (peer->t_connect);
@@ -1574,6 +1577,8 @@ peer_group_bind (struct bgp *bgp, union sockunion *su,
 	first_member = 1;
     }
 
+  bgp_update_group_reset (bgp);
+
   peer->af_group[afi][safi] = 1;
   peer->afc[afi][safi] = 1;
   if (! peer->group)
@@ -1625,6 +1630,8 @@ peer_group_unbind (struct bgp *bgp, struct peer *peer,
   if (group != peer->group)
     return BGP_ERR_PEER_GROUP_MISMATCH;
 
+  bgp_update_group_reset (bgp);
+
   peer->af_group[afi][safi] = 0;
   peer->afc[afi][safi] = 0;
   peer_af_flag_reset (peer, afi, safi);
@@ -1678,6 +1685,7 @@ bgp_create (as_t *as, char *name)
 	bgp->route[afi][safi] = bgp_table_init ();
 	bgp->aggregate[afi][safi] = bgp_table_init ();
 	bgp->rib[afi][safi] = bgp_table_init ();
+	bgp->process_queue[afi][safi] = list_new ();
       }
 
   bgp->default_local_pref = BGP_DEFAULT_LOCAL_PREF;
@@ -1824,6 +1832,9 @@ bgp_delete (struct bgp *bgp)
       peer_delete (peer);
     }
 
+  bgp_process_queue_flush (bgp);
+  bgp_update_group_reset (bgp);
+
   listnode_delete (bm->bgp, bgp);
 
   if (bgp->name)
@@ -1838,6 +1849,7 @@ bgp_delete (struct bgp *bgp)
 	  XFREE (MTYPE_ROUTE_TABLE,bgp->aggregate[afi][safi]) ;
 	if (bgp->rib[afi][safi])
 	  XFREE (MTYPE_ROUTE_TABLE,bgp->rib[afi][safi]);
+	list_free (bgp->process_queue[afi][safi]);
       }
   XFREE (MTYPE_BGP, bgp);
 
@@ -2159,6 +2171,8 @@ peer_flag_modify (struct peer *peer, u_int32_t flag, int set)
 	return 0;
     }
 
+  bgp_update_group_reset (peer->bgp);
+
   if (set)
     SET_FLAG (peer->flags, flag);
   else
@@ -2266,6 +2280,8 @@ peer_af_flag_modify (struct peer *peer, afi_t afi, safi_t safi, u_int32_t flag,
 	return 0;
     }
 
+  bgp_update_group_reset (peer->bgp);
+
   if (set)
     SET_FLAG (peer->af_flags[afi][safi], flag);
   else
@@ -2676,6 +2692,8 @@ peer_default_originate_set (struct peer *peer, afi_t afi, safi_t safi,
   if (peer_is_group_member (peer, afi, safi))
     return BGP_ERR_INVALID_FOR_PEER_GROUP_MEMBER;
 
+  bgp_update_group_reset (peer->bgp);
+
   if (! CHECK_FLAG (peer->af_flags[afi][safi], PEER_FLAG_DEFAULT_ORIGINATE)
       || (rmap && ! peer->default_rmap[afi][safi].name)
       || (rmap && strcmp (rmap, peer->default_rmap[afi][safi].name) != 0))
@@ -2732,6 +2750,8 @@ peer_default_originate_unset (struct peer *peer, afi_t afi, safi_t safi)
   if (peer_is_group_member (peer, afi, safi))
     return BGP_ERR_INVALID_FOR_PEER_GROUP_MEMBER;
 
+  bgp_update_group_reset (peer->bgp);
+
   if (CHECK_FLAG (peer->af_flags[afi][safi], PEER_FLAG_DEFAULT_ORIGINATE))
     { 
       UNSET_FLAG (peer->af_flags[afi][safi], PEER_FLAG_DEFAULT_ORIGINATE);
@@ -2972,6 +2992,8 @@ peer_version_set (struct peer *peer, int version)
   if (version != BGP_VERSION_4 && version != BGP_VERSION_MP_4_DRAFT_00)
     return BGP_ERR_INVALID_VALUE;
 
+  bgp_update_group_reset (peer->bgp);
+
   peer->version = version;
 
   return 0;
@@ -2980,6 +3002,8 @@ peer_version_set (struct peer *peer, int version)
 int
 peer_version_unset (struct peer *peer)
 {
+  bgp_update_group_reset (peer->bgp);
+
   peer->version = BGP_VERSION_4;
   return 0;
 }
@@ -3088,6 +3112,8 @@ peer_local_as_set (struct peer *peer, as_t as, int no_prepend)
        || (! CHECK_FLAG (peer->flags, PEER_FLAG_LOCAL_AS_NO_PREPEND) && ! no_prepend)))
     return 0;
 
+  bgp_update_group_reset (peer->bgp);
+
   peer->change_local_as = as;
   if (no_prepend)
     SET_FLAG (peer->flags, PEER_FLAG_LOCAL_AS_NO_PREPEND);
@@ -3142,6 +3168,8 @@ peer_local_as_unset (struct peer *peer)
   if (! peer->change_local_as)
     return 0;
 
+  bgp_update_group_reset (peer->bgp);
+
   peer->change_local_as = 0;
   UNSET_FLAG (peer->flags, PEER_FLAG_LOCAL_AS_NO_PREPEND);
 
@@ -3200,6 +3228,8 @@ peer_distribute_set (struct peer *peer, afi_t afi, safi_t safi, int direct,
   if (filter->plist[direct].name)
     return BGP_ERR_PEER_FILTER_CONFLICT;
 
+  bgp_update_group_reset (peer->bgp);
+
   if (filter->dlist[direct].name)
     free (filter->dlist[direct].name);
   filter->dlist[direct].name = strdup (name);
@@ -3244,6 +3274,8 @@ peer_distribute_unset (struct peer *peer, afi_t afi, safi_t safi, int direct)
 
   filter = &peer->filter[afi][safi];
 
+  bgp_update_group_reset (peer->bgp);
+
   /* apply peer-group filter */
   if (peer->af_group[afi][safi])
     {
@@ -3359,6 +3391,8 @@ peer_prefix_list_set (struct peer *peer, afi_t afi, safi_t safi, int direct,
   if (filter->dlist[direct].name)
     return BGP_ERR_PEER_FILTER_CONFLICT;
 
+  bgp_update_group_reset (peer->bgp);
+
   if (filter->plist[direct].name)
     free (filter->plist[direct].name);
   filter->plist[direct].name = strdup (name);
@@ -3402,6 +3436,8 @@ peer_prefix_list_unset (struct peer *peer, afi_t afi, safi_t safi, int direct)
 
   filter = &peer->filter[afi][safi];
 
+  bgp_update_group_reset (peer->bgp);
+
   /* apply peer-group filter */
   if (peer->af_group[afi][safi])
     {
@@ -3513,6 +3549,8 @@ peer_aslist_set (struct peer *peer, afi_t afi, safi_t safi, int direct,
 
   filter = &peer->filter[afi][safi];
 
+  bgp_update_group_reset (peer->bgp);
+
   if (filter->aslist[direct].name)
     free (filter->aslist[direct].name);
   filter->aslist[direct].name = strdup (name);
@@ -3556,6 +3594,8 @@ peer_aslist_unset (struct peer *peer,afi_t afi, safi_t safi, int direct)
 
   filter = &peer->filter[afi][safi];
 
+  bgp_update_group_reset (peer->bgp);
+
   /* apply peer-group filter */
   if (peer->af_group[afi][safi])
     {
@@ -3667,6 +3707,8 @@ peer_route_map_set (struct peer *peer, afi_t afi, safi_t safi, int direct,
 
   filter = &peer->filter[afi][safi];
 
+  bgp_update_group_reset (peer->bgp);
+
   if (filter->map[direct].name)
     free (filter->map[direct].name);
   
@@ -3712,6 +3754,8 @@ peer_route_map_unset (struct peer *peer, afi_t afi, safi_t safi, int direct)
 
   filter = &peer->filter[afi][safi];
 
+  bgp_update_group_reset (peer->bgp);
+
   /* apply peer-group filter */
   if (peer->af_group[afi][safi])
     {
@@ -3767,6 +3811,8 @@ peer_unsuppress_map_set (struct peer *peer, afi_t afi, safi_t safi, char *name)
       
   filter = &peer->filter[afi][safi];
 
+  bgp_update_group_reset (peer->bgp);
+
   if (filter->usmap.name)
     free (filter->usmap.name);
   
@@ -3808,6 +3854,8 @@ peer_unsuppress_map_unset (struct peer *peer, afi_t afi, safi_t safi)
 
   filter = &peer->filter[afi][safi];
 
+  bgp_update_group_reset (peer->bgp);
+
   if (filter->usmap.name)
     free (filter->usmap.name);
   filter->usmap.name = NULL;
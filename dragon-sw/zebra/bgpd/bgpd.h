@@ -111,6 +111,12 @@ struct bgp
   /* BGP routing information base.  */
   struct bgp_table *rib[AFI_MAX][SAFI_MAX];
 
+  /* Update groups of the established peers, built on demand.  */
+  struct list *update_groups[AFI_MAX][SAFI_MAX];
+
+  /* Route nodes waiting for best path selection.  */
+  struct list *process_queue[AFI_MAX][SAFI_MAX];
+
   /* BGP redistribute configuration. */
   u_char redist[AFI_MAX][ZEBRA_ROUTE_MAX];
 
@@ -408,6 +414,9 @@ struct peer
   struct bgp_synchronize *sync[AFI_MAX][SAFI_MAX];
   time_t synctime;
 
+  /* Update group this peer belongs to.  */
+  struct bgp_update_group *update_group[AFI_MAX][SAFI_MAX];
+
   /* Send prefix count. */
   unsigned long scount[AFI_MAX][SAFI_MAX];
 
@@ -417,9 +426,6 @@ struct peer
   /* Notify data. */
   struct bgp_notify notify;
 
-  /* Whole packet size to be read. */
-  unsigned long packet_size;
-
   /* Filter structure. */
   struct bgp_filter filter[AFI_MAX][SAFI_MAX];
 
@@ -500,6 +506,10 @@ struct bgp_nlri
 #define BGP_HEADER_SIZE		                19
 #define BGP_MAX_PACKET_SIZE                   4096
 
+/* Size of the input buffer; one read() may bring in this many bytes of
+   messages.  */
+#define BGP_READ_BUFFER_SIZE       (BGP_MAX_PACKET_SIZE * 16)
+
 /* BGP minimum message size.  */
 #define BGP_MSG_OPEN_MIN_SIZE                   (BGP_HEADER_SIZE + 10)
 #define BGP_MSG_UPDATE_MIN_SIZE                 (BGP_HEADER_SIZE + 4)
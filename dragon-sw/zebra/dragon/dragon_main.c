@@ -103,6 +103,8 @@ sigint (int sig)
   struct lsp *lsp = NULL;
 
   zlog (NULL, LOG_INFO, "Terminating on signal");
+  /* hand all teardowns to RSVPD in one write */
+  zBeginRsvpBatch(dmaster.api);
   LIST_LOOP(dmaster.dragon_lsp_table, lsp , node)
   {
   	/* TODO: inform NARB upon termination */
@@ -119,6 +121,7 @@ sigint (int sig)
 			break;
   	}
   }
+  zEndRsvpBatch(dmaster.api);
 
   exit (0);
 }
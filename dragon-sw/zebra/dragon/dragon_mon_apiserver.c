@@ -11,6 +11,7 @@ To be incorporated into GNU Zebra  - DRAGON extension
 
 #include "thread.h"
 #include "linklist.h"
+#include "hash.h"
 #include "memory.h"
 #include "buffer.h"
 #include "sockunion.h"
@@ -162,6 +163,223 @@ int mon_api_msg_write (int fd, struct mon_api_msg *msg)
   return 0;
 }
 
+/* -----------------------------------------------------------
+ * LSP status subscriptions and monitoring reply cache
+ * -----------------------------------------------------------
+ */
+
+#define MON_LSP_INFO_MAX_LEN (3*sizeof(struct dragon_tlv_header) + MAX_MON_NAME_LEN \
+                              + sizeof(struct _MON_LSP_Info) + sizeof(struct _Error_Spec_Para))
+#define MON_API_MAX_BODY_LEN (DRAGON_MAX_PACKET_SIZE - sizeof(struct mon_api_msg_header))
+
+static int mon_apiserver_post_reply (struct mon_apiserver *apiserv, u_int8_t type, u_int8_t action, struct _MON_Reply_Para* reply);
+
+/* Copy the payload of the GRI TLV that starts the message body into gri,
+   NUL-terminated and bounded by the received length; the payload itself
+   need not be terminated */
+static char* mon_apiserver_copy_gri (struct mon_api_msg *msg, char *gri)
+{
+  int len = ntohs(msg->header.length) - sizeof(struct dragon_tlv_header);
+
+  if (len < 0)
+    len = 0;
+  if (len > MAX_MON_NAME_LEN-1)
+    len = MAX_MON_NAME_LEN-1;
+  memcpy(gri, msg->body+sizeof(struct dragon_tlv_header), len);
+  gri[len] = '\0';
+  return gri;
+}
+
+static void mon_gri_key (struct dragon_index_key *key, char *gri)
+{
+  memset (key, 0, sizeof (struct dragon_index_key));
+  strncpy (key->name, gri, sizeof(key->name)-1);
+}
+
+/* Pack the LSP_INFO (and ERRSPEC) TLVs of an LSP, preceded by its GRI if asked;
+   returns the length, at most MON_LSP_INFO_MAX_LEN */
+static int mon_apiserver_pack_lsp_info (char *buf, struct lsp *lsp, u_int32_t status, int with_gri)
+{
+  struct dragon_tlv_header* tlv;
+  struct _MON_LSP_Info * lsp_info;
+  int len = 0;
+
+  if (with_gri)
+    {
+      tlv = (struct dragon_tlv_header*)buf;
+      tlv->type = htons(MON_TLV_GRI);
+      tlv->length = htons(MAX_MON_NAME_LEN);
+      len += sizeof(struct dragon_tlv_header);
+      memset(buf+len, 0, MAX_MON_NAME_LEN);
+      strncpy(buf+len, lsp->common.SessionAttribute_Para->sessionName, MAX_MON_NAME_LEN-1);
+      len += MAX_MON_NAME_LEN;
+    }
+  tlv = (struct dragon_tlv_header*)(buf+len);
+  tlv->type = htons(MON_TLV_LSP_INFO);
+  tlv->length = htons(sizeof(struct _MON_LSP_Info));
+  len += sizeof(struct dragon_tlv_header);
+  lsp_info = (struct _MON_LSP_Info*)(buf+len);
+  lsp_info->source.s_addr = lsp->common.Session_Para.srcAddr.s_addr;
+  lsp_info->destination.s_addr = lsp->common.Session_Para.destAddr.s_addr;
+  lsp_info->narb.s_addr = dmaster.module[MODULE_NARB_INTRA].ip_addr.s_addr;
+  lsp_info->lsp_id = lsp->common.Session_Para.srcPort;
+  lsp_info->tunnel_id = lsp->common.Session_Para.destPort;
+  lsp_info->status = status;
+  lsp_info->time_sec = lsp->timestamp.tv_sec;
+  len += sizeof(struct _MON_LSP_Info);
+  if (status == LSP_ERROR)
+    {
+      tlv = (struct dragon_tlv_header*)(buf+len);
+      tlv->type = htons(MON_TLV_LSP_ERRSPEC);
+      tlv->length = htons(sizeof(struct _Error_Spec_Para));
+      len += sizeof(struct dragon_tlv_header);
+      memcpy(tlv+1, &lsp->error_spec, sizeof(struct _Error_Spec_Para));
+      len += sizeof(struct _Error_Spec_Para);
+    }
+  return len;
+}
+
+/* Subscribe the client to the status of the LSP named gri, or of all LSPs if gri is NULL */
+static void mon_subscription_add (struct mon_apiserver *apiserv, char *gri, u_int32_t seqnum)
+{
+  struct mon_subscription *sub = XMALLOC (MTYPE_TMP, sizeof (struct mon_subscription));
+  struct dragon_index_key key;
+
+  sub->apiserv = apiserv;
+  sub->seqnum = seqnum;
+  sub->idx_gri = NULL;
+  if (gri)
+    {
+      mon_gri_key (&key, gri);
+      sub->idx_gri = dragon_index_add (dmaster.mon_subscription_index, &key, sub);
+    }
+  else
+    listnode_add (dmaster.mon_subscription_all, sub);
+  listnode_add (apiserv->subscriptions, sub);
+}
+
+static void mon_subscription_free (struct mon_subscription *sub)
+{
+  if (sub->idx_gri)
+    dragon_index_remove (dmaster.mon_subscription_index, sub->idx_gri, sub);
+  else
+    listnode_delete (dmaster.mon_subscription_all, sub);
+  listnode_delete (sub->apiserv->subscriptions, sub);
+  XFREE (MTYPE_TMP, sub);
+}
+
+/* Drop the client's subscriptions to gri, or all of them if gri is NULL */
+static void mon_subscription_remove (struct mon_apiserver *apiserv, char *gri)
+{
+  struct mon_subscription *sub;
+  struct dragon_index_key key;
+  listnode node, next;
+
+  if (gri)
+    mon_gri_key (&key, gri);
+  for (node = listhead (apiserv->subscriptions); node; node = next)
+    {
+      next = node->next;
+      sub = getdata (node);
+      if (gri == NULL || (sub->idx_gri && dragon_index_name_cmp (&sub->idx_gri->key, &key)))
+        mon_subscription_free (sub);
+    }
+}
+
+static void mon_subscription_post (struct mon_subscription *sub, char *buf, int len)
+{
+  struct mon_api_msg *msg;
+
+  msg = mon_api_msg_new (MON_API_MSGTYPE_LSPINFO, MON_API_ACTION_UPDATE, len, sub->apiserv->ucid, sub->seqnum, 0, buf);
+  MON_APISERVER_POST_MESSAGE (sub->apiserv, msg);
+}
+
+static void mon_reply_cache_free (struct mon_reply_cache *cache)
+{
+  DRAGON_TIMER_OFF (cache->t_expire);
+  dragon_index_remove (dmaster.mon_reply_cache, cache->idx_gri, cache);
+  XFREE (MTYPE_TMP, cache);
+}
+
+static void mon_reply_cache_entry_free (void *data)
+{
+  struct dragon_index_entry *entry = data;
+  struct mon_reply_cache *cache;
+  listnode node;
+
+  LIST_LOOP (entry->members, cache, node)
+    {
+      DRAGON_TIMER_OFF (cache->t_expire);
+      XFREE (MTYPE_TMP, cache);
+    }
+  list_delete (entry->members);
+  XFREE (MTYPE_OSPF_DRAGON, entry);
+}
+
+static int mon_reply_cache_expire (struct thread *t)
+{
+  struct mon_reply_cache *cache = THREAD_ARG (t);
+
+  cache->t_expire = NULL;
+  mon_reply_cache_free (cache);
+  return 0;
+}
+
+static struct mon_reply_cache *mon_reply_cache_lookup (struct dragon_index_key *key, struct in_addr addr)
+{
+  struct dragon_index_entry *entry;
+  struct mon_reply_cache *cache;
+  listnode node;
+
+  if ((entry = hash_lookup (dmaster.mon_reply_cache, key)) == NULL)
+    return NULL;
+  LIST_LOOP (entry->members, cache, node)
+    {
+      if (cache->addr.s_addr == addr.s_addr)
+        return cache;
+    }
+  return NULL;
+}
+
+/* Forget what the hops reported about an LSP whose status has changed */
+static void mon_reply_cache_flush (struct dragon_index_key *key)
+{
+  struct mon_reply_cache *cache;
+
+  while ((cache = dragon_index_lookup (dmaster.mon_reply_cache, key)) != NULL)
+    mon_reply_cache_free (cache);
+}
+
+/* Push the new status of an LSP to the clients subscribed to it; status
+   is LSP_DELETE once the LSP is removed from the table. */
+void mon_apiserver_notify_lsp (struct lsp *lsp, u_int32_t status)
+{
+  char buf[MON_LSP_INFO_MAX_LEN];
+  struct dragon_index_entry *entry;
+  struct dragon_index_key key;
+  struct mon_subscription *sub;
+  listnode node;
+  int len;
+
+  if (dmaster.mon_apiserver_list == NULL || !lsp->common.SessionAttribute_Para)
+    return;
+
+  mon_gri_key (&key, lsp->common.SessionAttribute_Para->sessionName);
+  mon_reply_cache_flush (&key);
+
+  entry = hash_lookup (dmaster.mon_subscription_index, &key);
+  if (entry == NULL && listcount (dmaster.mon_subscription_all) == 0)
+    return;
+  len = mon_apiserver_pack_lsp_info (buf, lsp, status, 1);
+  if (entry)
+    {
+      LIST_LOOP (entry->members, sub, node)
+        mon_subscription_post (sub, buf, len);
+    }
+  LIST_LOOP (dmaster.mon_subscription_all, sub, node)
+    mon_subscription_post (sub, buf, len);
+}
+
 /* -----------------------------------------------------------
  * Monitoring API server functions
  * -----------------------------------------------------------
@@ -233,6 +451,10 @@ int mon_apiserver_init (void)
 
   /* Initialize list that keeps track of all connections. */
   dmaster.mon_apiserver_list = list_new ();
+  dmaster.mon_apiserver_index = dragon_index_new (dragon_index_id_key, dragon_index_id_cmp);
+  dmaster.mon_subscription_index = dragon_index_new (dragon_index_name_key, dragon_index_name_cmp);
+  dmaster.mon_subscription_all = list_new ();
+  dmaster.mon_reply_cache = dragon_index_new (dragon_index_name_key, dragon_index_name_cmp);
 
   rc = 0;
 
@@ -258,6 +480,16 @@ void mon_apiserver_term (void)
   /* Free client list itself */
   list_delete (dmaster.mon_apiserver_list);
   dmaster.mon_apiserver_list = NULL;
+  hash_free (dmaster.mon_apiserver_index);
+  dmaster.mon_apiserver_index = NULL;
+  /* Subscriptions went away with their apiservers */
+  hash_free (dmaster.mon_subscription_index);
+  dmaster.mon_subscription_index = NULL;
+  list_delete (dmaster.mon_subscription_all);
+  dmaster.mon_subscription_all = NULL;
+  hash_clean (dmaster.mon_reply_cache, mon_reply_cache_entry_free);
+  hash_free (dmaster.mon_reply_cache);
+  dmaster.mon_reply_cache = NULL;
   /* Closing accept socket */
   close (THREAD_FD (dmaster.t_mon_accept));
   thread_cancel(dmaster.t_mon_accept);
@@ -273,6 +505,7 @@ struct mon_apiserver *mon_apiserver_new (int fd)
   apiserv->out_fifo = list_new ();
   apiserv->t_sync_read = NULL;
   apiserv->t_sync_write = NULL;
+  apiserv->subscriptions = list_new ();
 
   return apiserv;
 }
@@ -301,6 +534,7 @@ void mon_apiserver_free (struct mon_apiserver *apiserv)
     {
       thread_cancel (apiserv->t_sync_write);
     }
+  DRAGON_TIMER_OFF (apiserv->t_query_timer);
 
   /* Close connections to client. */
   if (apiserv->fd_sync > 0)
@@ -310,7 +544,12 @@ void mon_apiserver_free (struct mon_apiserver *apiserv)
 
   fifo_free (apiserv->out_fifo);
 
+  mon_subscription_remove (apiserv, NULL);
+  list_delete (apiserv->subscriptions);
+
   /* Remove from the list of active clients. */
+  if (apiserv->idx_ucid)
+    dragon_index_remove (dmaster.mon_apiserver_index, apiserv->idx_ucid, apiserv);
   listnode_delete (dmaster.mon_apiserver_list, apiserv);
 
   /* And free instance. */
@@ -383,6 +622,32 @@ int mon_query_timer(struct thread *t)
   return 0;
 }
 
+/* Answer a switch/circuit query from a recent reply, or forward it to RSVPD */
+static void mon_apiserver_query (struct mon_apiserver *apiserv, u_int32_t seqnum, char *gri, u_int32_t dest_addr)
+{
+  struct _MON_Reply_Para reply;
+  struct mon_reply_cache *cache;
+  struct dragon_index_key key;
+  struct in_addr addr;
+
+  addr.s_addr = dest_addr;
+  mon_gri_key (&key, gri);
+  if ((cache = mon_reply_cache_lookup (&key, addr)) != NULL)
+    {
+      memcpy (&reply, &cache->reply, sizeof (struct _MON_Reply_Para));
+      reply.seqnum = seqnum;
+      mon_apiserver_post_reply (apiserv, cache->type, MON_API_ACTION_DATA, &reply);
+      return;
+    }
+
+  zMonitoringQuery(dmaster.api, apiserv->ucid, seqnum, gri, dest_addr, 0, 0);
+  apiserv->query_seqnum = seqnum;
+  apiserv->query_addr = addr;
+  memset (apiserv->query_gri, 0, MAX_MON_NAME_LEN);
+  strncpy (apiserv->query_gri, gri, MAX_MON_NAME_LEN-1);
+  DRAGON_TIMER_ON(apiserv->t_query_timer, mon_query_timer, apiserv, MON_QUERY_EXPIRATION);
+}
+
 int mon_apiserver_read (struct thread *thread)
 {
   struct mon_apiserver *apiserv;
@@ -430,6 +695,7 @@ out:
 int mon_apiserver_handle_msg (struct mon_apiserver *apiserv, struct mon_api_msg *msg)
 {
   char buf[DRAGON_MAX_PACKET_SIZE];
+  char gri[MAX_MON_NAME_LEN];
   int rc = 0;
   int i, len;
   int num_lsp_ero_nodes = 0, num_subnet_ero_nodes = 0;
@@ -439,7 +705,6 @@ int mon_apiserver_handle_msg (struct mon_apiserver *apiserv, struct mon_api_msg
   struct lsp* lsp = NULL;
   struct in_addr * addr = NULL;
   struct _EROAbstractNode_Para *hop = NULL;
-  struct _MON_LSP_Info * lsp_info = NULL;
   struct _LSPService_Request* lsp_req = NULL;
   struct _PCE_Spec* pce_spec = NULL;
   struct _EROAbstractNode_Para* lsp_ero = NULL;
@@ -449,7 +714,15 @@ int mon_apiserver_handle_msg (struct mon_apiserver *apiserv, struct mon_api_msg
   assert(msg);
 
   if (apiserv->ucid == 0)
-    apiserv->ucid = ntohl(msg->header.ucid);
+    {
+      struct dragon_index_key key;
+
+      apiserv->ucid = ntohl(msg->header.ucid);
+      memset (&key, 0, sizeof (struct dragon_index_key));
+      key.id = apiserv->ucid;
+      if (apiserv->ucid != 0)
+        apiserv->idx_ucid = dragon_index_add (dmaster.mon_apiserver_index, &key, apiserv);
+    }
   else if (apiserv->ucid != ntohl(msg->header.ucid))
     {
       rc = 0x0000000f; /* error_code TBD */
@@ -493,6 +766,42 @@ int mon_apiserver_handle_msg (struct mon_apiserver *apiserv, struct mon_api_msg
         break;
 
       case MON_API_MSGTYPE_LSPINFO:
+        switch (msg->header.action)
+          {
+          case MON_API_ACTION_SUBSCRIBE:
+          case MON_API_ACTION_UNSUBSCRIBE:
+            /* An empty body stands for all LSPs */
+            lsp_gri = NULL;
+            if (ntohs(msg->header.length) != 0)
+              {
+                tlv = (struct dragon_tlv_header*)msg->body;
+                if (ntohs(tlv->type) != MON_TLV_GRI || ntohs(tlv->length) != MAX_MON_NAME_LEN)
+                  {
+                    zlog_warn ("mon_apiserver_handle_msg (type %d): Invalid TLV in message body: %d", msg->header.type, ntohs(tlv->type));
+                    rc = -20;
+                    goto _error;
+                  }
+                lsp_gri = mon_apiserver_copy_gri(msg, gri);
+              }
+            if (msg->header.action == MON_API_ACTION_UNSUBSCRIBE)
+              {
+                mon_subscription_remove(apiserv, lsp_gri);
+                mon_apiserver_send_ack(apiserv, msg->header.type, ntohl(msg->header.seqnum));
+                rc = 0;
+                break;
+              }
+            mon_subscription_add(apiserv, lsp_gri, ntohl(msg->header.seqnum));
+            mon_apiserver_send_ack(apiserv, msg->header.type, ntohl(msg->header.seqnum));
+            /* Start the subscriber off with the current status */
+            if (lsp_gri && (lsp = dragon_find_lsp_by_griname(lsp_gri)) != NULL)
+              {
+                len = mon_apiserver_pack_lsp_info(buf, lsp, lsp->status, 1);
+                rmsg = mon_api_msg_new(MON_API_MSGTYPE_LSPINFO, MON_API_ACTION_UPDATE, len, apiserv->ucid, ntohl(msg->header.seqnum), 0, buf);
+                MON_APISERVER_POST_MESSAGE(apiserv, rmsg);
+              }
+            rc = 0;
+            break;
+          default:
             tlv = (struct dragon_tlv_header*)msg->body;
             if (ntohs(tlv->type) != MON_TLV_GRI || htons(tlv->length) != MAX_MON_NAME_LEN)
             	{
@@ -501,7 +810,7 @@ int mon_apiserver_handle_msg (struct mon_apiserver *apiserv, struct mon_api_msg
                 goto _error;
 
             	}
-            lsp_gri = (char*)(tlv+1);
+            lsp_gri = mon_apiserver_copy_gri(msg, gri);
             lsp = dragon_find_lsp_by_griname(lsp_gri);
             if (lsp == NULL)
             	{
@@ -509,32 +818,41 @@ int mon_apiserver_handle_msg (struct mon_apiserver *apiserv, struct mon_api_msg
                 rc = -6;
                 goto _error;
             	}           
-            len = 0;
-            tlv = (struct dragon_tlv_header*)buf;
-            tlv->type = htons(MON_TLV_LSP_INFO);
-            tlv->length = htons(sizeof(struct _MON_LSP_Info));
-            len += sizeof(struct dragon_tlv_header);
-            lsp_info = (struct _MON_LSP_Info*)(buf+len);
-            lsp_info->source.s_addr = lsp->common.Session_Para.srcAddr.s_addr;
-            lsp_info->destination.s_addr = lsp->common.Session_Para.destAddr.s_addr;
-            lsp_info->narb.s_addr = dmaster.module[MODULE_NARB_INTRA].ip_addr.s_addr;
-            lsp_info->lsp_id = lsp->common.Session_Para.srcPort;
-            lsp_info->tunnel_id = lsp->common.Session_Para.destPort;
-            lsp_info->status = lsp->status;
-            lsp_info->time_sec = lsp->timestamp.tv_sec;
-            len += sizeof(struct _MON_LSP_Info);
-            if (lsp->status == LSP_ERROR)
-            	{
-                tlv = (struct dragon_tlv_header*)(buf+len);
-                tlv->type = htons(MON_TLV_LSP_ERRSPEC);
-                tlv->length = htons(sizeof(struct _Error_Spec_Para));
-                len += sizeof(struct dragon_tlv_header);
-                memcpy(tlv+1, &lsp->error_spec, sizeof(struct _Error_Spec_Para));
-                len += sizeof(struct _Error_Spec_Para);
-            	}
+            len = mon_apiserver_pack_lsp_info(buf, lsp, lsp->status, 0);
             rmsg = mon_api_msg_new(MON_API_MSGTYPE_LSPINFO, MON_API_ACTION_DATA, len, apiserv->ucid, ntohl(msg->header.seqnum), 0, buf);
             MON_APISERVER_POST_MESSAGE(apiserv, rmsg);
             rc = 0;
+            break;
+          }
+        break;
+
+      case MON_API_MSGTYPE_LSPSUMMARY:
+        switch (msg->header.action)
+          {
+          case MON_API_ACTION_RTRV:
+            /* Answered locally: GRI and LSP info of every LSP, in as many messages as it takes */
+            len = 0;
+            LIST_LOOP(dmaster.dragon_lsp_table, lsp, node)
+              {
+                if (!lsp->common.SessionAttribute_Para)
+                    continue;
+                if (len + MON_LSP_INFO_MAX_LEN > MON_API_MAX_BODY_LEN)
+                  {
+                    rmsg = mon_api_msg_new(MON_API_MSGTYPE_LSPSUMMARY, MON_API_ACTION_DATA, len, apiserv->ucid, ntohl(msg->header.seqnum), MON_API_OPTION_MORE, buf);
+                    MON_APISERVER_POST_MESSAGE(apiserv, rmsg);
+                    len = 0;
+                  }
+                len += mon_apiserver_pack_lsp_info(buf+len, lsp, lsp->status, 1);
+              }
+            rmsg = mon_api_msg_new(MON_API_MSGTYPE_LSPSUMMARY, MON_API_ACTION_DATA, len, apiserv->ucid, ntohl(msg->header.seqnum), 0, buf);
+            MON_APISERVER_POST_MESSAGE(apiserv, rmsg);
+            rc = 0;
+            break;
+          default:
+            zlog_warn ("mon_apiserver_handle_msg (type %d): Unknown API message action: %d", msg->header.type, msg->header.action);
+            rc = -21;
+            goto _error;
+          }
         break;
 
       case MON_API_MSGTYPE_LSPERO:
@@ -546,7 +864,7 @@ int mon_apiserver_handle_msg (struct mon_apiserver *apiserv, struct mon_api_msg
                 goto _error;
 
             	}
-            lsp_gri = (char*)(tlv+1);
+            lsp_gri = mon_apiserver_copy_gri(msg, gri);
             lsp = dragon_find_lsp_by_griname(lsp_gri);
             if (lsp == NULL)
             	{
@@ -600,7 +918,7 @@ int mon_apiserver_handle_msg (struct mon_apiserver *apiserv, struct mon_api_msg
                 goto _error;
 
             	}
-            lsp_gri = (char*)(tlv+1);
+            lsp_gri = mon_apiserver_copy_gri(msg, gri);
             lsp = dragon_find_lsp_by_griname(lsp_gri);
             if (lsp == NULL)
             	{
@@ -640,8 +958,7 @@ int mon_apiserver_handle_msg (struct mon_apiserver *apiserv, struct mon_api_msg
         switch (msg->header.action)
           {
           case MON_API_ACTION_RTRV:
-            zMonitoringQuery(dmaster.api, ntohl(msg->header.ucid), ntohl(msg->header.seqnum), "none", 0, 0, 0);
-            DRAGON_TIMER_ON(apiserv->t_query_timer, mon_query_timer, apiserv, MON_QUERY_EXPIRATION);
+            mon_apiserver_query(apiserv, ntohl(msg->header.seqnum), "none", 0);
             rc = 0;
             break;
           default:
@@ -670,8 +987,7 @@ int mon_apiserver_handle_msg (struct mon_apiserver *apiserv, struct mon_api_msg
                 rc = -16;
                 goto _error;
             	}
-            zMonitoringQuery(dmaster.api, ntohl(msg->header.ucid), ntohl(msg->header.seqnum), lsp_gri, *(u_int32_t*)(tlv+1), 0, 0);
-            DRAGON_TIMER_ON(apiserv->t_query_timer, mon_query_timer, apiserv, MON_QUERY_EXPIRATION);
+            mon_apiserver_query(apiserv, ntohl(msg->header.seqnum), lsp_gri, *(u_int32_t*)(tlv+1));
             rc = 0;
             break;
           default:
@@ -823,16 +1139,13 @@ int mon_apiserver_write (struct thread *thread)
   return rc;
 }
 
-int mon_apiserver_send_reply (struct mon_apiserver *apiserv, u_int8_t type, u_int8_t action, struct _MON_Reply_Para* reply)
+static int mon_apiserver_post_reply (struct mon_apiserver *apiserv, u_int8_t type, u_int8_t action, struct _MON_Reply_Para* reply)
 {
   static char buf[DRAGON_MAX_PACKET_SIZE];
   struct mon_api_msg* msg;
   struct dragon_tlv_header* tlv = (struct dragon_tlv_header*)buf;
   u_int16_t bodylen = 0;
 
-  if (apiserv->t_query_timer != NULL)
-        DRAGON_TIMER_OFF(apiserv->t_query_timer);
-
   /*assemble reply tlv's into buffer */
   /* switch_info tlv */
   tlv->type = htons(MON_TLV_SWITCH_INFO);
@@ -926,6 +1239,51 @@ int mon_apiserver_send_reply (struct mon_apiserver *apiserv, u_int8_t type, u_in
   return 0;
 }
 
+int mon_apiserver_send_reply (struct mon_apiserver *apiserv, u_int8_t type, u_int8_t action, struct _MON_Reply_Para* reply)
+{
+  if (apiserv->t_query_timer != NULL)
+        DRAGON_TIMER_OFF(apiserv->t_query_timer);
+
+  return mon_apiserver_post_reply(apiserv, type, action, reply);
+}
+
+/* Relay a MonReply upcall to the client that sent the query, keeping
+   the data for MON_REPLY_CACHE_TTL seconds */
+void mon_apiserver_handle_reply (struct mon_apiserver *apiserv, struct _MON_Reply_Para* reply)
+{
+  struct mon_reply_cache *cache;
+  struct dragon_index_key key;
+  u_int8_t type;
+  u_int8_t action;
+
+  if ((reply->switch_options & MON_SWITCH_OPTION_SUBNET_TRANSIT) == 0 && reply->length == MON_REPLY_BASE_SIZE)
+    type = MON_API_MSGTYPE_SWITCH;
+  else
+    type = MON_API_MSGTYPE_CIRCUIT;
+  if ((reply->switch_options & MON_SWITCH_OPTION_ERROR) == 0)
+    action = MON_API_ACTION_DATA;
+  else
+    action = MON_API_ACTION_ERROR;
+
+  if (action == MON_API_ACTION_DATA && apiserv->t_query_timer != NULL && reply->seqnum == apiserv->query_seqnum)
+    {
+      mon_gri_key (&key, apiserv->query_gri);
+      if ((cache = mon_reply_cache_lookup (&key, apiserv->query_addr)) == NULL)
+        {
+          cache = XMALLOC (MTYPE_TMP, sizeof (struct mon_reply_cache));
+          cache->addr = apiserv->query_addr;
+          cache->t_expire = NULL;
+          cache->idx_gri = dragon_index_add (dmaster.mon_reply_cache, &key, cache);
+        }
+      cache->type = type;
+      memcpy (&cache->reply, reply, sizeof (struct _MON_Reply_Para));
+      DRAGON_TIMER_OFF (cache->t_expire);
+      DRAGON_TIMER_ON (cache->t_expire, mon_reply_cache_expire, cache, MON_REPLY_CACHE_TTL);
+    }
+
+  mon_apiserver_send_reply(apiserv, type, action, reply);
+}
+
 void mon_apiserver_send_ack(struct mon_apiserver* apiserv, u_int8_t type, u_int32_t seqnum)
 {
   struct mon_api_msg * msg;
@@ -949,21 +1307,7 @@ void mon_apiserver_send_error(struct mon_apiserver* apiserv, u_int8_t type, u_in
 
 struct lsp* dragon_find_lsp_by_griname(char* name)
 {
-  struct lsp *lsp, *find=NULL;
-  listnode node;
-
-  if (dmaster.dragon_lsp_table)
-    {
-      LIST_LOOP(dmaster.dragon_lsp_table,lsp,node)
-        {
-          if (strncmp(lsp->common.SessionAttribute_Para->sessionName, name, MAX_MON_NAME_LEN) == 0) 
-            {
-              find = lsp;
-              break;
-            }
-        }
-    }
-  return find;
+  return dragon_find_lsp_by_name(name);
 }
 
 int mon_apiserver_lsp_commit(char* lsp_gri, struct _LSPService_Request * lsp_req, int num_lsp_ero_nodes, struct _EROAbstractNode_Para* lsp_ero, 
@@ -19,10 +19,38 @@ struct mon_apiserver
   list out_fifo;
   /* Identifier for the apiserver (using client UCID) */
   u_int32_t ucid;
+  /* Entry of dmaster.mon_apiserver_index once ucid is known */
+  struct dragon_index_entry *idx_ucid;
   /* Read and write threads */
   struct thread *t_sync_read;
   struct thread *t_sync_write;
   struct thread *t_query_timer;
+  /* Outstanding switch/circuit query, to cache its reply */
+  u_int32_t query_seqnum;
+  struct in_addr query_addr;
+  char query_gri[MAX_MON_NAME_LEN];
+  /* LSP status subscriptions of this client */
+  list subscriptions;
+};
+
+/* Interest of a client in the status of one LSP (or all of them) */
+struct mon_subscription
+{
+  struct mon_apiserver *apiserv;
+  /* Seqnum of the subscribe request, echoed in the notifications */
+  u_int32_t seqnum;
+  /* Entry of dmaster.mon_subscription_index, NULL for all LSPs */
+  struct dragon_index_entry *idx_gri;
+};
+
+/* Switch/circuit monitoring reply kept for MON_REPLY_CACHE_TTL */
+struct mon_reply_cache
+{
+  struct dragon_index_entry *idx_gri;
+  struct in_addr addr;
+  u_int8_t type;
+  struct _MON_Reply_Para reply;
+  struct thread *t_expire;
 };
 
 
@@ -82,6 +110,7 @@ struct _PCE_Spec
 #define MON_API_MSGTYPE_LSPINFO		0x02 /* LSP info at source VLSR */
 #define MON_API_MSGTYPE_LSPERO		0x03 /* LSP ERO (and Subnet ERO if any) */
 #define MON_API_MSGTYPE_NODELIST		0x04 /* Control plane (VLSR) node list */
+#define MON_API_MSGTYPE_LSPSUMMARY	0x05 /* GRI and LSP info of all LSPs */
 #define MON_API_MSGTYPE_SWITCH 		0x10 /* Monitoring information for switch */
 #define MON_API_MSGTYPE_CIRCUIT		0x20 /* Monitoring information for circuit */
 #define MON_API_MSGTYPE_LSPPROV		0x30 /* LSP provisioning */
@@ -94,6 +123,8 @@ struct _PCE_Spec
 #define MON_API_ACTION_ACK 	0x05 /* Reply with acknowledgement */
 #define MON_API_ACTION_DATA 	0x06 /* Reply/Ack with information data */
 #define MON_API_ACTION_ERROR 	0x07 /* Reply with error code */
+#define MON_API_ACTION_SUBSCRIBE	0x08 /* Push LSPINFO updates on status change */
+#define MON_API_ACTION_UNSUBSCRIBE	0x09 /* Stop pushing LSPINFO updates */
 
 #define MON_TLV_GRI 			0x01
 #define MON_TLV_SWITCH_INFO 	0x02
@@ -109,6 +140,10 @@ struct _PCE_Spec
 #define MON_TLV_ERROR			0x0f
 
 #define MON_QUERY_EXPIRATION  2  /*in seconds*/
+#define MON_REPLY_CACHE_TTL  5  /*in seconds*/
+
+/* Set on all but the last message of a multi-message reply */
+#define MON_API_OPTION_MORE	0x0001
 
 #define MON_ERRCODE_TIMEOUT	0xf0f0
 
@@ -130,7 +165,8 @@ int mon_api_msg_write(int fd, struct mon_api_msg* msg);
 
 #define MON_APISERVER_POST_MESSAGE(S, M) \
                 listnode_add(S->out_fifo, M); \
-                S->t_sync_write = thread_add_write (master, mon_apiserver_write, S, S->fd_sync);
+                if (S->t_sync_write == NULL) \
+                  S->t_sync_write = thread_add_write (master, mon_apiserver_write, S, S->fd_sync);
 
 unsigned short mon_apiserver_getport (void);
 int mon_apiserver_init (void);
@@ -143,6 +179,8 @@ int mon_apiserver_read (struct thread *thread);
 int mon_apiserver_handle_msg (struct mon_apiserver *apiserv, struct mon_api_msg *msg);
 int mon_apiserver_write (struct thread *thread);
 int mon_apiserver_send_reply (struct mon_apiserver *apiserv, u_int8_t type, u_int8_t action, struct _MON_Reply_Para* reply);
+void mon_apiserver_handle_reply (struct mon_apiserver *apiserv, struct _MON_Reply_Para* reply);
+void mon_apiserver_notify_lsp (struct lsp *lsp, u_int32_t status);
 void mon_apiserver_send_ack(struct mon_apiserver* apiserv, u_int8_t type, u_int32_t seqnum);
 void mon_apiserver_send_error(struct mon_apiserver* apiserv, u_int8_t type, u_int32_t seqnum, u_int32_t err_code);
 struct lsp* dragon_find_lsp_by_griname(char* name);
@@ -37,6 +37,7 @@
 #include "thread.h"
 #include "stream.h"
 #include "linklist.h"
+#include "hash.h"
 #include "log.h"
 #include "dragon/dragond.h"
 #include "dragon_mon_apiserver.h"
@@ -718,44 +719,242 @@ dragon_narb_override_ero(struct _EROAbstractNode_Para * ero_hops, u_int8_t* num_
 	return ero_hops_ret;
 }
 
-struct lsp *
-dragon_find_lsp_by_seqno(u_int32_t seqno)
+/* Lookup indexes: each hash maps a key to the (usually single) objects
+   filed under it, so that duplicates keep their list order. */
+static void *
+dragon_index_entry_alloc (struct dragon_index_key *key)
 {
-	struct lsp *lsp, *find=NULL;
-	listnode node;
+	struct dragon_index_entry *entry;
+
+	entry = XMALLOC(MTYPE_OSPF_DRAGON, sizeof(struct dragon_index_entry));
+	memcpy(&entry->key, key, sizeof(struct dragon_index_key));
+	entry->members = list_new();
+	return entry;
+}
+
+struct hash *
+dragon_index_new (unsigned int (*hash_key) (), int (*hash_cmp) ())
+{
+	return hash_create(hash_key, hash_cmp);
+}
+
+struct dragon_index_entry *
+dragon_index_add (struct hash *table, struct dragon_index_key *key, void *member)
+{
+	struct dragon_index_entry *entry;
+
+	entry = hash_get(table, key, dragon_index_entry_alloc);
+	listnode_add(entry->members, member);
+	return entry;
+}
+
+void
+dragon_index_remove (struct hash *table, struct dragon_index_entry *entry, void *member)
+{
+	listnode_delete(entry->members, member);
+	if (listcount(entry->members) > 0)
+		return;
+	hash_release(table, entry);
+	list_free(entry->members);
+	XFREE(MTYPE_OSPF_DRAGON, entry);
+}
+
+/* First object filed under the key */
+void *
+dragon_index_lookup (struct hash *table, struct dragon_index_key *key)
+{
+	struct dragon_index_entry *entry;
+
+	if (!table || !(entry = hash_lookup(table, key)))
+		return NULL;
+	return getdata(listhead(entry->members));
+}
+
+unsigned int
+dragon_index_id_key (struct dragon_index_key *key)
+{
+	return key->id;
+}
+
+int
+dragon_index_id_cmp (struct dragon_index_key *a, struct dragon_index_key *b)
+{
+	return a->id == b->id;
+}
+
+static unsigned int
+dragon_index_session_key (struct dragon_index_key *key)
+{
+	return ntohl(key->addr.s_addr) ^ ((unsigned int)key->port << 16 | key->port);
+}
+
+static int
+dragon_index_session_cmp (struct dragon_index_key *a, struct dragon_index_key *b)
+{
+	return a->addr.s_addr == b->addr.s_addr && a->port == b->port;
+}
+
+unsigned int
+dragon_index_name_key (struct dragon_index_key *key)
+{
+	unsigned int hash = 0;
+	char *c;
+
+	for (c = key->name; *c; c++)
+		hash = hash * 31 + (unsigned char)*c;
+	return hash;
+}
 
-	if (dmaster.dragon_lsp_table)
+int
+dragon_index_name_cmp (struct dragon_index_key *a, struct dragon_index_key *b)
+{
+	return strcmp(a->name, b->name) == 0;
+}
+
+void
+dragon_lsp_index_init (void)
+{
+	dmaster.lsp_seqno_index = dragon_index_new(dragon_index_id_key, dragon_index_id_cmp);
+	dmaster.lsp_session_index = dragon_index_new(dragon_index_session_key, dragon_index_session_cmp);
+	dmaster.lsp_name_index = dragon_index_new(dragon_index_name_key, dragon_index_name_cmp);
+}
+
+static void
+dragon_lsp_session_key (struct lsp *lsp, struct dragon_index_key *key)
+{
+	memset(key, 0, sizeof(struct dragon_index_key));
+	key->addr = lsp->common.Session_Para.destAddr;
+	key->port = lsp->common.Session_Para.destPort;
+}
+
+static void
+dragon_lsp_name_key (struct lsp *lsp, struct dragon_index_key *key)
+{
+	memset(key, 0, sizeof(struct dragon_index_key));
+	if (lsp->common.SessionAttribute_Para && lsp->common.SessionAttribute_Para->sessionName)
+		strncpy(key->name, lsp->common.SessionAttribute_Para->sessionName, sizeof(key->name)-1);
+}
+
+/* (Re)file the LSP under its current seqno, session and name */
+static void
+dragon_lsp_index (struct lsp *lsp)
+{
+	struct dragon_index_key key;
+
+	memset(&key, 0, sizeof(struct dragon_index_key));
+	key.id = lsp->seqno;
+	if (!lsp->idx_seqno || !dragon_index_id_cmp(&lsp->idx_seqno->key, &key))
 	{
-		LIST_LOOP(dmaster.dragon_lsp_table,lsp,node)
-		{
-			 if (lsp->seqno == seqno) {
-				 find = lsp;
-				 break;
-			 }
-		}
+		if (lsp->idx_seqno)
+			dragon_index_remove(dmaster.lsp_seqno_index, lsp->idx_seqno, lsp);
+		lsp->idx_seqno = dragon_index_add(dmaster.lsp_seqno_index, &key, lsp);
 	}
-	return find;
+
+	dragon_lsp_session_key(lsp, &key);
+	if (!lsp->idx_session || !dragon_index_session_cmp(&lsp->idx_session->key, &key))
+	{
+		if (lsp->idx_session)
+			dragon_index_remove(dmaster.lsp_session_index, lsp->idx_session, lsp);
+		lsp->idx_session = dragon_index_add(dmaster.lsp_session_index, &key, lsp);
+	}
+
+	dragon_lsp_name_key(lsp, &key);
+	if (!lsp->idx_name || !dragon_index_name_cmp(&lsp->idx_name->key, &key))
+	{
+		if (lsp->idx_name)
+			dragon_index_remove(dmaster.lsp_name_index, lsp->idx_name, lsp);
+		lsp->idx_name = dragon_index_add(dmaster.lsp_name_index, &key, lsp);
+	}
+}
+
+void
+dragon_lsp_table_add (struct lsp *lsp)
+{
+	listnode_add(dmaster.dragon_lsp_table, lsp);
+	dragon_lsp_index(lsp);
+}
+
+void
+dragon_lsp_table_delete (struct lsp *lsp)
+{
+	mon_apiserver_notify_lsp(lsp, LSP_DELETE);
+	listnode_delete(dmaster.dragon_lsp_table, lsp);
+	if (lsp->idx_seqno)
+		dragon_index_remove(dmaster.lsp_seqno_index, lsp->idx_seqno, lsp);
+	if (lsp->idx_session)
+		dragon_index_remove(dmaster.lsp_session_index, lsp->idx_session, lsp);
+	if (lsp->idx_name)
+		dragon_index_remove(dmaster.lsp_name_index, lsp->idx_name, lsp);
+	lsp->idx_seqno = lsp->idx_session = lsp->idx_name = NULL;
+}
+
+/* Must be called after changing the seqno, session or name of an LSP in the table */
+void
+dragon_lsp_reindex (struct lsp *lsp)
+{
+	if (dragon_lsp_in_table(lsp))
+		dragon_lsp_index(lsp);
+}
+
+int
+dragon_lsp_in_table (struct lsp *lsp)
+{
+	return lsp->idx_name != NULL;
+}
+
+struct lsp *
+dragon_find_lsp_by_seqno(u_int32_t seqno)
+{
+	struct dragon_index_key key;
+
+	memset(&key, 0, sizeof(struct dragon_index_key));
+	key.id = seqno;
+	return dragon_index_lookup(dmaster.lsp_seqno_index, &key);
+}
+
+struct lsp *
+dragon_find_lsp_by_name(char *name)
+{
+	struct dragon_index_key key;
+
+	if (strlen(name) >= sizeof(key.name))
+		return NULL;
+	memset(&key, 0, sizeof(struct dragon_index_key));
+	strcpy(key.name, name);
+	return dragon_index_lookup(dmaster.lsp_name_index, &key);
+}
+
+/* All LSPs with this destination and tunnel ID (the LSP_SAME_SESSION test), or NULL */
+list
+dragon_find_lsps_by_session(struct in_addr dest, u_int16_t tunnel_id)
+{
+	struct dragon_index_key key;
+	struct dragon_index_entry *entry;
+
+	memset(&key, 0, sizeof(struct dragon_index_key));
+	key.addr = dest;
+	key.port = tunnel_id;
+	if (!dmaster.lsp_session_index || !(entry = hash_lookup(dmaster.lsp_session_index, &key)))
+		return NULL;
+	return entry->members;
 }
 
 struct lsp *
 dragon_find_lsp_by_rsvpupcallparam(struct _rsvp_upcall_parameter *p)
 {
-	struct lsp *lsp, *find=NULL;
+	struct lsp *lsp;
 	listnode node;
+	list lsps;
 
-	if (dmaster.dragon_lsp_table)
+	if ((lsps = dragon_find_lsps_by_session(p->destAddr, p->destPort)) != NULL)
 	{
-		LIST_LOOP(dmaster.dragon_lsp_table,lsp,node)
+		LIST_LOOP(lsps,lsp,node)
 		{
-			 if (lsp->common.Session_Para.srcAddr.s_addr == p->srcAddr.s_addr &&
-			     lsp->common.Session_Para.destAddr.s_addr == p->destAddr.s_addr &&
-			     lsp->common.Session_Para.destPort == p->destPort ) {
-				 find = lsp;
-				 break;
-			 }
+			 if (lsp->common.Session_Para.srcAddr.s_addr == p->srcAddr.s_addr)
+				 return lsp;
 		}
 	}
-	return find;
+	return NULL;
 }
 
 /* Topology response from NARB, should contain an ERO */
@@ -1000,9 +1199,7 @@ dragon_read (struct thread *thread)
   struct api_msg_header *amsgh;
   struct dragon_tlv_header *tlvh;
   struct lsp *lsp = THREAD_ARG(thread);
-  struct lsp *l;
   u_int8_t find = 0;
-  listnode node;
   int fd = THREAD_FD(thread);
   int lsp_deleted = 0;
  
@@ -1012,14 +1209,8 @@ dragon_read (struct thread *thread)
     return -1;
     
   /* make sure that this lsp is still in the global LSP table */
-  if (dmaster.dragon_lsp_table)
-	  LIST_LOOP(dmaster.dragon_lsp_table,l,node)
-	  {
-		   if (lsp == l && lsp->narb_fd == fd) {
-			   find = 1;
-			   break;
-		   }
-	  }
+  if (dragon_lsp_in_table(lsp) && lsp->narb_fd == fd)
+	  find = 1;
 
   if (lsp->status == LSP_RECYCLE)
   {
@@ -1095,7 +1286,7 @@ out:
   if (lsp_deleted)
   {
        DRAGON_TIMER_OFF (lsp->t_lsp_refresh);
-	listnode_delete(dmaster.dragon_lsp_table, lsp);
+	dragon_lsp_table_delete(lsp);
 	lsp_recycle(lsp); /*Keep lsp in recycle list for messages that were orginted from this LSP*/
 	//lsp_del(lsp);
   }
@@ -1231,7 +1422,7 @@ void rsvpupcall_register_lsp(struct _rsvp_upcall_parameter* p)
 		}
 	}
 
-	listnode_add(dmaster.dragon_lsp_table, lsp);	
+	dragon_lsp_table_add(lsp);
 	zlog_info("LSP= %s : Register API in RSVPD.",
 		  (lsp->common.SessionAttribute_Para)->sessionName);
 	zInitRsvpPathRequest(dmaster.api, &lsp->common, 0); /* register this api in RSVPD */
@@ -1239,6 +1430,7 @@ void rsvpupcall_register_lsp(struct _rsvp_upcall_parameter* p)
 		zInitRsvpResvRequest(dmaster.api, p);
 		lsp->status = LSP_IS;
 	}
+	mon_apiserver_notify_lsp(lsp, lsp->status);
         /* update LSP based on dragonUNI*/
 	if ( p->dragonUniPara) {
 		lsp->common.DragonUni_Para = p->dragonUniPara;
@@ -1267,31 +1459,20 @@ void  rsvpUpcall(void* para)
 	struct dragon_fifo_elt *new;
 	struct lsp *lsp = NULL;
 	int lsp_deleted = 0;
+	u_int32_t old_status;
 
 	if (p->code == MonReply) /* For monitoring service API */
 	{
 		struct mon_apiserver* apiserv;
-		listnode node;
-		u_int8_t type;                   
-		u_int8_t action;
-
-		/* search dmaster->mon_apiserver_list for apiserver matching ucid */
-		LIST_LOOP(dmaster.mon_apiserver_list, apiserv, node)
-		{         
-			assert(apiserv && p->monReplyPara);
-			if (apiserv->ucid == p->monReplyPara->ucid)
-			{
-				if ((p->monReplyPara->switch_options & MON_SWITCH_OPTION_SUBNET_TRANSIT) == 0 && p->monReplyPara->length == MON_REPLY_BASE_SIZE)
-					type = MON_API_MSGTYPE_SWITCH;
-				else
-					type = MON_API_MSGTYPE_CIRCUIT;
-				if ((p->monReplyPara->switch_options & MON_SWITCH_OPTION_ERROR) == 0)
-					action = MON_API_ACTION_DATA;
-				else
-					action = MON_API_ACTION_ERROR;					
-				mon_apiserver_send_reply(apiserv, type, action, p->monReplyPara);
-				return;
-			}
+		struct dragon_index_key key;
+
+		assert(p->monReplyPara);
+		memset(&key, 0, sizeof(struct dragon_index_key));
+		key.id = p->monReplyPara->ucid;
+		if ((apiserv = dragon_index_lookup(dmaster.mon_apiserver_index, &key)) != NULL)
+		{
+			mon_apiserver_handle_reply(apiserv, p->monReplyPara);
+			return;
 		}
 		zlog_warn("Unable to find a Moitoring API server instance for this MonReply upcall.");
 		return;
@@ -1315,6 +1496,7 @@ void  rsvpUpcall(void* para)
 				  lsp->seqno);
 
 	dragon_show_lsp_detail(lsp, NULL);
+	old_status = lsp->status;
 	
 	switch( p->code) {
 		case Path:
@@ -1418,12 +1600,16 @@ void  rsvpUpcall(void* para)
 			break;
 	}
 	
+	/* Deletion is notified by dragon_lsp_table_delete() */
+	if (!lsp_deleted && (lsp->status != old_status || lsp->status == LSP_ERROR))
+		mon_apiserver_notify_lsp(lsp, lsp->status);
+
 	dragon_upcall_callback(p->code, lsp); /*ast call*/
  
 	if (lsp_deleted) {
 	       DRAGON_TIMER_OFF (lsp->t_lsp_refresh);
 	  	//dragon_fifo_lsp_cleanup(lsp); /**/
-		listnode_delete(dmaster.dragon_lsp_table, lsp);
+		dragon_lsp_table_delete(lsp);
 		lsp_recycle(lsp);
 		//lsp_del(lsp);
 	}
@@ -37,6 +37,7 @@
 #include "log.h"
 #include "linklist.h"
 #include "dragon/dragond.h"
+#include "dragon/dragon_mon_apiserver.h"
 #include "buffer.h"
 
 char lsp_prompt[100] = "%s(edit-lsp)# ";
@@ -894,7 +895,6 @@ DEFUN (dragon_edit_lsp,
        "LSP name, maximum length is 64 characters\n"
        )
 {
-  struct listnode *node;
   struct lsp *lsp = NULL;
   int found;
 
@@ -904,10 +904,8 @@ DEFUN (dragon_edit_lsp,
 	return CMD_WARNING;
   }
   found = 0;
-  LIST_LOOP(dmaster.dragon_lsp_table, lsp , node)
+  if ((lsp = dragon_find_lsp_by_name(argv[0])) != NULL)
   {
-  	if (strcmp((lsp->common.SessionAttribute_Para)->sessionName, argv[0])==0)
-  	{
   		if (lsp->status != LSP_EDIT)
   		{
 			vty_out (vty, "The LSP %s is not in edit state. Please delete it first%s", argv[0], VTY_NEWLINE);
@@ -949,9 +947,7 @@ DEFUN (dragon_edit_lsp,
 				}
 				list_delete_all_node(lsp->dragon.subnet_ero);
 			}
-			break;
 		}
-  	}
   }
   if (!found)
   {
@@ -962,7 +958,7 @@ DEFUN (dragon_edit_lsp,
 	gettimeofday(&lsp->timestamp, NULL);
 	strcpy((lsp->common.SessionAttribute_Para)->sessionName, argv[0]);
 	(lsp->common.SessionAttribute_Para)->nameLength = strlen(argv[0]);
-	listnode_add(dmaster.dragon_lsp_table, lsp);	
+	dragon_lsp_table_add(lsp);
   }
   vty->node = LSP_NODE;
   strcpy(lsp_prompt,"%s(edit-lsp-");
@@ -991,12 +987,13 @@ DEFUN (dragon_set_lsp_name,
 	return CMD_WARNING;
   }
   /* Check if there is another LSP using the same name */
-  if (dmaster.dragon_lsp_table)
-	  LIST_LOOP(dmaster.dragon_lsp_table, l , node)
+  if ((l = dragon_find_lsp_by_name(argv[0])) != NULL)
+	  LIST_LOOP(l->idx_name->members, l , node)
 	  {
-		if (lsp != l && strcmp((l->common.SessionAttribute_Para)->sessionName, argv[0])==0)
+		if (lsp != l)
 		{
 			find = 1;
+			break;
 		}
 	  }
   if (find)
@@ -1009,6 +1006,7 @@ DEFUN (dragon_set_lsp_name,
   {
     strcpy((lsp->common.SessionAttribute_Para)->sessionName, argv[0]);
     (lsp->common.SessionAttribute_Para)->nameLength = strlen(argv[0]);
+    dragon_lsp_reindex(lsp);
     strcpy(lsp_prompt,"%s(edit-lsp-");
     strcat(lsp_prompt,argv[0]);
     strcat(lsp_prompt,")# ");
@@ -1227,6 +1225,7 @@ DEFUN (dragon_set_lsp_ip,
         lsp->common.Session_Para.destPort = (u_int16_t)port_dest;
     lsp->dragon.srcLocalId = ((u_int32_t)type_src)<<16 |port_src;
     lsp->dragon.destLocalId = ((u_int32_t)type_dest)<<16 |port_dest;
+    dragon_lsp_reindex(lsp);
 
     if ( (type_src != LOCAL_ID_TYPE_TAGGED_GROUP || port_src != 0) &&
 		(type_dest != LOCAL_ID_TYPE_TAGGED_GROUP || port_dest != 0) )
@@ -1734,26 +1733,20 @@ DEFUN (dragon_commit_lsp_sender,
   struct listnode *node;
   struct lsp *lsp = NULL, *lsp2 = NULL;
   struct dragon_fifo_elt *new;
+  list same_session;
   int found;
   struct timeval timeNow;
   gettimeofday(&timeNow, NULL);
   
   found = 0;
-  LIST_LOOP(dmaster.dragon_lsp_table, lsp , node)
+  if ((lsp = dragon_find_lsp_by_name(argv[0])) != NULL)
   {
-  	if (strcmp((lsp->common.SessionAttribute_Para)->sessionName, argv[0])==0)
-  	{
   		if (lsp->status != LSP_EDIT)
   		{
 			vty_out (vty, "The LSP %s is not in edit state. %s", argv[0], VTY_NEWLINE);
 			return CMD_WARNING;
   		}
-		else
-		{
-			found = 1;
-			break;
-		}
-  	}
+		found = 1;
   }
   if (!found)
   {
@@ -1768,8 +1761,9 @@ DEFUN (dragon_commit_lsp_sender,
   }
 
   /* Check if there is another non-subnet-interface LSP with the same session parameter */
-  if ((lsp->dragon.destLocalId >> 16) != LOCAL_ID_TYPE_SUBNET_IF_ID && (lsp->dragon.destLocalId >> 16) != LOCAL_ID_TYPE_OTNX_IF_ID && dmaster.dragon_lsp_table)
-      LIST_LOOP(dmaster.dragon_lsp_table, lsp2 , node)
+  if ((lsp->dragon.destLocalId >> 16) != LOCAL_ID_TYPE_SUBNET_IF_ID && (lsp->dragon.destLocalId >> 16) != LOCAL_ID_TYPE_OTNX_IF_ID
+      && (same_session = dragon_find_lsps_by_session(lsp->common.Session_Para.destAddr, lsp->common.Session_Para.destPort)) != NULL)
+      LIST_LOOP(same_session, lsp2 , node)
       {
           if (lsp!=lsp2 && LSP_SAME_SESSION(lsp, lsp2))
           {
@@ -1888,6 +1882,7 @@ DEFUN (dragon_commit_lsp_sender,
 	  }
 	  /* Assign a unique sequence number */
 	  lsp->seqno = dragon_assign_seqno();
+	  dragon_lsp_reindex(lsp);
 	  
 	  /* Construct topology create message */
 	  new = dragon_topology_create_msg_new(lsp);
@@ -1906,6 +1901,7 @@ DEFUN (dragon_commit_lsp_sender,
   /* Set commit flag */
   lsp->status = LSP_COMMIT;
   gettimeofday(&lsp->timestamp, NULL);
+  mon_apiserver_notify_lsp(lsp, lsp->status);
 
   return CMD_SUCCESS;
 }
@@ -1925,26 +1921,18 @@ DEFUN (dragon_commit_lsp_receiver,
        "LSP name\n"
        "This node is an RSVP receiver\n")
 {
-  struct listnode *node;
   struct lsp *lsp = NULL;
   int found;
   
   found = 0;
-  LIST_LOOP(dmaster.dragon_lsp_table, lsp , node)
+  if ((lsp = dragon_find_lsp_by_name(argv[0])) != NULL)
   {
-  	if (strcmp((lsp->common.SessionAttribute_Para)->sessionName, argv[0])==0)
-  	{
   		if (lsp->status != LSP_EDIT)
   		{
 			vty_out (vty, "The LSP %s is not in edit state. %s", argv[0], VTY_NEWLINE);
 			return CMD_WARNING;
   		}
-		else
-		{
-			found = 1;
-			break;
-		}
-  	}
+		found = 1;
   }
   if (!found)
   {
@@ -1965,6 +1953,7 @@ DEFUN (dragon_commit_lsp_receiver,
   /* Set commit flag */
   lsp->status = LSP_LISTEN;
   lsp->flag |= LSP_FLAG_RECEIVER;
+  mon_apiserver_notify_lsp(lsp, lsp->status);
   
   return CMD_SUCCESS;
 }
@@ -1977,23 +1966,13 @@ DEFUN (dragon_delete_lsp,
        "Label switched path\n"
        "LSP name\n")
 {
-  struct listnode *node;
   struct lsp *lsp = NULL;
   struct dragon_fifo_elt *new;
   int found;
   
   found = 0;
-  if (dmaster.dragon_lsp_table)
-  {
-	  LIST_LOOP(dmaster.dragon_lsp_table, lsp , node)
-  	{
-  		if (strcmp((lsp->common.SessionAttribute_Para)->sessionName, argv[0])==0)
-  		{
-			found = 1;
-			break;
-	  	}
- 	 }
-  }
+  if ((lsp = dragon_find_lsp_by_name(argv[0])) != NULL)
+	found = 1;
   if (!found)
   {
   	vty_out (vty, "No matching LSP named %s. %s", argv[0], VTY_NEWLINE);
@@ -2023,10 +2002,11 @@ DEFUN (dragon_delete_lsp,
 		  (lsp->common.SessionAttribute_Para)->sessionName);
 	zTearRsvpPathRequest(dmaster.api, &lsp->common);
 	lsp->status = LSP_LISTEN;  	
+	mon_apiserver_notify_lsp(lsp, lsp->status);
   }
   else if (lsp->status == LSP_EDIT)
   {
-	listnode_delete(dmaster.dragon_lsp_table, lsp);
+	dragon_lsp_table_delete(lsp);
 	lsp_recycle(lsp);
   }
   else{
@@ -2034,7 +2014,7 @@ DEFUN (dragon_delete_lsp,
        zlog_info("LSP= %s : Initiating RSVP path tear request",
 		  (lsp->common.SessionAttribute_Para)->sessionName);
 	zTearRsvpPathRequest(dmaster.api, &lsp->common);
-	listnode_delete(dmaster.dragon_lsp_table, lsp);
+	dragon_lsp_table_delete(lsp);
 	lsp_recycle(lsp);
 	//lsp_del(lsp);
   }
@@ -2185,15 +2165,12 @@ DEFUN (dragon_show_lsp,
   if (argc > 0)
   {
   	found = 0;
-  	LIST_LOOP(dmaster.dragon_lsp_table, lsp, node)
-  	{
-  		if (lsp->common.SessionAttribute_Para && 
-  		    strcmp((lsp->common.SessionAttribute_Para)->sessionName, argv[0])==0)
-  		{
+  	if ((lsp = dragon_find_lsp_by_name(argv[0])) != NULL)
+  	  LIST_LOOP(lsp->idx_name->members, lsp, node)
+  	  {
   			found = 1;
   		   	dragon_show_lsp_detail(lsp, vty); 
-  		}
-  	}
+  	  }
   	if (!found)
   		vty_out(vty, "No matching LSP named %s %s", argv[0], VTY_NEWLINE);
   }
@@ -2277,6 +2254,7 @@ dragon_master_init()
   
   dmaster.dragon_lsp_table = list_new();
   dmaster.dragon_lsp_table->del = (void (*) (void *))lsp_del;
+  dragon_lsp_index_init();
 
   dmaster.recycled_lsp_list = list_new();
   dmaster.recycled_lsp_list->del = (void (*) (void *))lsp_del;
@@ -612,7 +612,7 @@ dragon_build_lsp(struct resource *res)
   strcpy((lsp->common.SessionAttribute_Para)->sessionName, lsp_name);
   (lsp->common.SessionAttribute_Para)->nameLength = strlen(lsp_name);
   fake_vty->index = lsp;
-  listnode_add(dmaster.dragon_lsp_table, lsp);
+  dragon_lsp_table_add(lsp);
 
   if (IS_VTAG_ANY(link))
     res->flags |= FLAG_UNFIXED;
@@ -682,6 +682,25 @@ struct lsp {
 	struct thread *t_narb_read; /* LSP packet read thread (for NARB) */
 	u_int32_t seqno;  /* Unique sequence number for this LSP request */
 	struct timeval timestamp; /* Timestamp in (sec, usec) for LSP commit/creation */
+	/* Index entries this LSP is filed under while it is in dragon_lsp_table */
+	struct dragon_index_entry *idx_seqno;
+	struct dragon_index_entry *idx_session;
+	struct dragon_index_entry *idx_name;
+};
+
+/* Key of the dmaster lookup indexes; each index uses only some of the fields */
+struct dragon_index_key {
+	u_int32_t id;			/* LSP seqno or apiserver UCID */
+	struct in_addr addr;		/* session destination */
+	u_int16_t port;			/* session tunnel ID */
+	char name[MAX_MON_NAME_LEN];	/* LSP name or monitoring GRI */
+};
+
+/* All objects filed under one key, in the order they were added,
+   so that a lookup returns what a scan of the list would find first */
+struct dragon_index_entry {
+	struct dragon_index_key key;	/* must be first (hashed as the key) */
+	list members;
 };
 
 /* DRAGON fifo element structure. */
@@ -712,9 +731,14 @@ struct dragon_master {
  	/* Universal Client Identifier */
 	u_int32_t UCID;
 
-	/* A list of current LSPs */
+	/* A list of current LSPs (kept in creation order for display) */
 	list dragon_lsp_table;
 
+	/* Lookup indexes over dragon_lsp_table */
+	struct hash *lsp_seqno_index;
+	struct hash *lsp_session_index;	/* by destination and tunnel ID */
+	struct hash *lsp_name_index;
+
 	/* A list of deleted LSPs */
 	list recycled_lsp_list;
 
@@ -740,6 +764,13 @@ struct dragon_master {
 	struct thread *t_mon_accept;
 	/* Monitoring apiserver list */
 	list mon_apiserver_list;
+	/* Monitoring apiservers by client UCID */
+	struct hash *mon_apiserver_index;
+	/* Monitoring subscriptions by GRI, and those to all LSPs */
+	struct hash *mon_subscription_index;
+	list mon_subscription_all;
+	/* Recent monitoring replies by GRI */
+	struct hash *mon_reply_cache;
 };
 
 /* Structure for localID */
@@ -805,6 +836,22 @@ extern void dragon_fifo_free (struct dragon_fifo *fifo);
 extern void dragon_fifo_lsp_cleanup (struct lsp* lsp);
 extern struct lsp* lsp_recycle(struct lsp* lsp);
 extern struct lsp* lsp_new();
+extern struct hash *dragon_index_new (unsigned int (*) (), int (*) ());
+extern struct dragon_index_entry *dragon_index_add (struct hash *, struct dragon_index_key *, void *);
+extern void dragon_index_remove (struct hash *, struct dragon_index_entry *, void *);
+extern void *dragon_index_lookup (struct hash *, struct dragon_index_key *);
+extern unsigned int dragon_index_id_key (struct dragon_index_key *);
+extern int dragon_index_id_cmp (struct dragon_index_key *, struct dragon_index_key *);
+extern unsigned int dragon_index_name_key (struct dragon_index_key *);
+extern int dragon_index_name_cmp (struct dragon_index_key *, struct dragon_index_key *);
+extern void dragon_lsp_index_init (void);
+extern void dragon_lsp_table_add (struct lsp *lsp);
+extern void dragon_lsp_table_delete (struct lsp *lsp);
+extern void dragon_lsp_reindex (struct lsp *lsp);
+extern int dragon_lsp_in_table (struct lsp *lsp);
+extern struct lsp *dragon_find_lsp_by_seqno (u_int32_t seqno);
+extern struct lsp *dragon_find_lsp_by_name (char *name);
+extern list dragon_find_lsps_by_session (struct in_addr dest, u_int16_t tunnel_id);
 extern int dragon_lsp_refresh_timer(struct thread *t);
 extern int dragon_read (struct thread *thread);
 extern int dragon_write (struct thread *thread);
@@ -831,6 +878,8 @@ extern void zAddLocalId(void* api, u_int16_t type, u_int16_t value, u_int16_t ta
 extern void zDeleteLocalId(void* api, u_int16_t type, u_int16_t value, u_int16_t tag);
 extern void zRefreshLocalId(void* api, u_int16_t type, u_int16_t value, u_int16_t tag);
 extern void zMonitoringQuery(void* api, u_int32_t ucid, u_int32_t seqnum, char* gri, u_int32_t destAddrIp, u_int16_t tunnelId, u_int32_t extTunnelId);
+extern void zBeginRsvpBatch(void* api);
+extern void zEndRsvpBatch(void* api);
 	
 #endif /* _ZEBRA_DRAGOND_H */
 
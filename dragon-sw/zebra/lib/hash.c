@@ -50,6 +50,25 @@ hash_create (unsigned int (*hash_key) (), int (*hash_cmp) ())
   return hash_create_size (HASHTABSIZE, hash_key, hash_cmp);
 }
 
+/* Make a hash key from LEN bytes at DATA.  The bytes are mixed with
+   64-bit FNV-1a and the result folded to the key size, so keys built
+   from the canonical encoding of a structure spread over the table
+   however its fields are distributed.  */
+unsigned int
+hash_bytes (const void *data, unsigned int len)
+{
+  const u_char *pnt = data;
+  unsigned long long key = 14695981039346656037ULL;
+
+  while (len--)
+    {
+      key ^= *pnt++;
+      key *= 1099511628211ULL;
+    }
+
+  return (unsigned int) (key ^ (key >> 32));
+}
+
 /* Utility function for hash_get().  When this function is specified
    as alloc_func, return arugment as it is.  This function is used for
    intern already allocated value.  */
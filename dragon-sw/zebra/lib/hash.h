@@ -59,6 +59,7 @@ struct hash *hash_create_size (unsigned int, unsigned int (*) (), int (*) ());
 
 void *hash_get (struct hash *, void *, void * (*) ());
 void *hash_alloc_intern (void *);
+unsigned int hash_bytes (const void *, unsigned int);
 void *hash_lookup (struct hash *, void *);
 void *hash_release (struct hash *, void *);
 
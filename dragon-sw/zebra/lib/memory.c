@@ -240,6 +240,8 @@ struct memory_list memory_list_lib[] =
   { MTYPE_ROUTE_NODE,         "Route node      " },
   { MTYPE_RIB,                "RIB             " },
   { MTYPE_NEXTHOP,            "Nexthop         " },
+  { MTYPE_NEXTHOP_TRACK,      "Nexthop track   " },
+  { MTYPE_NEXTHOP_REGISTER,   "Nexthop register" },
   { MTYPE_LINK_LIST,          "Link List       " },
   { MTYPE_LINK_NODE,          "Link Node       " },
   { MTYPE_HASH,               "Hash            " },
@@ -279,6 +281,8 @@ struct memory_list memory_list_bgp[] =
   { MTYPE_BGP_ADVERTISE,          "BGP adv" },
   { MTYPE_BGP_ADJ_IN,             "BGP adj in" },
   { MTYPE_BGP_ADJ_OUT,            "BGP adj out" },
+  { MTYPE_BGP_UPDATE_GROUP,       "BGP update group" },
+  { MTYPE_BGP_UPDATE_CACHE,       "BGP update cache" },
   { 0, NULL },
   { MTYPE_AS_LIST,                "BGP AS list" },
   { MTYPE_AS_FILTER,              "BGP AS filter" },
@@ -80,6 +80,8 @@ enum
   MTYPE_ZLOG,
   MTYPE_ZCLIENT,
   MTYPE_NEXTHOP,
+  MTYPE_NEXTHOP_TRACK,
+  MTYPE_NEXTHOP_REGISTER,
   MTYPE_RTADV_PREFIX,
   MTYPE_IF_RMAP,
   MTYPE_SOCKUNION,
@@ -153,6 +155,8 @@ enum
   MTYPE_BGP_ADVERTISE,
   MTYPE_BGP_ADJ_IN,
   MTYPE_BGP_ADJ_OUT,
+  MTYPE_BGP_UPDATE_GROUP,
+  MTYPE_BGP_UPDATE_CACHE,
   MTYPE_BGP_REGEXP,
   MTYPE_AS_FILTER,
   MTYPE_AS_FILTER_STR,
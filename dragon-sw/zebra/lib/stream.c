@@ -57,9 +57,44 @@ stream_new (size_t size)
 void
 stream_free (struct stream *s)
 {
+  if (s->refcnt)
+    {
+      if (--(*s->refcnt))
+	{
+	  XFREE (MTYPE_STREAM, s);
+	  return;
+	}
+      XFREE (MTYPE_STREAM, s->refcnt);
+    }
   XFREE (MTYPE_STREAM_DATA, s->data);
   XFREE (MTYPE_STREAM, s);
 }
+
+/* Make a stream reading the same data as S, without copying it.  The
+   data goes with the last stream referring to it and must not be
+   written to anymore. */
+struct stream *
+stream_share (struct stream *s)
+{
+  struct stream *new;
+
+  if (! s->refcnt)
+    {
+      s->refcnt = XMALLOC (MTYPE_STREAM, sizeof (unsigned long));
+      *s->refcnt = 1;
+    }
+
+  new = XCALLOC (MTYPE_STREAM, sizeof (struct stream));
+  new->data = s->data;
+  new->size = s->size;
+  new->endp = s->endp;
+  new->putp = s->putp;
+  new->getp = s->getp;
+  new->refcnt = s->refcnt;
+  (*s->refcnt)++;
+
+  return new;
+}
  
 unsigned long
 stream_get_getp (struct stream *s)
@@ -41,6 +41,9 @@ struct stream
 
   /* Data size. */
   unsigned long size;
+
+  /* Number of streams sharing data, or NULL if it is not shared. */
+  unsigned long *refcnt;
 };
 
 /* First in first out queue structure. */
@@ -61,6 +64,7 @@ struct stream_fifo
 /* Stream prototypes. */
 struct stream *stream_new (size_t);
 void stream_free (struct stream *);
+struct stream *stream_share (struct stream *);
 
 unsigned long stream_get_getp (struct stream *);
 unsigned long stream_get_putp (struct stream *);
@@ -103,6 +103,8 @@ thread_master_debug (struct thread_master *m)
   thread_list_debug (&m->timer);
   printf ("eventlist : ");
   thread_list_debug (&m->event);
+  printf ("bgndlist  : ");
+  thread_list_debug (&m->background);
   printf ("unuselist : ");
   thread_list_debug (&m->unuse);
   printf ("total alloc: [%ld]\n", m->alloc);
@@ -200,6 +202,7 @@ thread_master_free (struct thread_master *m)
   thread_list_free (m, &m->timer);
   thread_list_free (m, &m->event);
   thread_list_free (m, &m->ready);
+  thread_list_free (m, &m->background);
   thread_list_free (m, &m->unuse);
 
   XFREE (MTYPE_THREAD_MASTER, m);
@@ -396,6 +399,24 @@ thread_add_event (struct thread_master *m,
   return thread;
 }
 
+/* Add background thread.  One background step runs whenever select
+   finds nothing to do, and one after the ready descriptors of every
+   select round, so long jobs split into background steps neither hold
+   off packet processing nor starve under sustained I/O. */
+struct thread *
+thread_add_background (struct thread_master *m,
+		       int (*func) (struct thread *), void *arg)
+{
+  struct thread *thread;
+
+  assert (m != NULL);
+
+  thread = thread_get (m, THREAD_BACKGROUND, func, arg);
+  thread_list_add (&m->background, thread);
+
+  return thread;
+}
+
 /* Cancel thread from scheduler. */
 void
 thread_cancel (struct thread *thread)
@@ -421,6 +442,9 @@ thread_cancel (struct thread *thread)
     case THREAD_READY:
       thread_list_delete (&thread->master->ready, thread);
       break;
+    case THREAD_BACKGROUND:
+      thread_list_delete (&thread->master->background, thread);
+      break;
     default:
       break;
     }
@@ -588,6 +612,15 @@ thread_fetch (struct thread_master *m, struct thread *fetch)
       if ((thread = thread_trim_head (&m->ready)) != NULL)
 	return thread_run (m, thread, fetch);
 
+      /* The ready threads of the last select round are done, give
+	 background work its step before polling again.  */
+      if (m->background_due)
+	{
+	  m->background_due = 0;
+	  if ((thread = thread_trim_head (&m->background)) != NULL)
+	    return thread_run (m, thread, fetch);
+	}
+
       /* Structure copy.  */
       readfd = m->readfd;
       writefd = m->writefd;
@@ -596,10 +629,18 @@ thread_fetch (struct thread_master *m, struct thread *fetch)
       /* Calculate select wait timer. */
       timer_wait = thread_timer_wait (m, &timer_val);
 
+      /* Pending background work only polls the descriptors. */
+      if (m->background.head)
+	timer_wait = &timer_nowait;
+
       num = select (FD_SETSIZE, &readfd, &writefd, &exceptfd, timer_wait);
 
       if (num == 0)
-	continue;
+	{
+	  if ((thread = thread_trim_head (&m->background)) != NULL)
+	    return thread_run (m, thread, fetch);
+	  continue;
+	}
 
       if (num < 0)
 	{
@@ -616,6 +657,9 @@ thread_fetch (struct thread_master *m, struct thread *fetch)
       /* Write thead. */
       ready = thread_process_fd (m, &m->write, &writefd, &m->writefd);
 
+      if (m->background.head)
+	m->background_due = 1;
+
       if ((thread = thread_trim_head (&m->ready)) != NULL)
 	return thread_run (m, thread, fetch);
     }
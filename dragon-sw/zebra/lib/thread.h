@@ -46,10 +46,12 @@ struct thread_master
   struct thread_list timer;
   struct thread_list event;
   struct thread_list ready;
+  struct thread_list background;
   struct thread_list unuse;
   fd_set readfd;
   fd_set writefd;
   fd_set exceptfd;
+  int background_due;		/* One background step owed to this round. */
   unsigned long alloc;
 };
 
@@ -77,6 +79,7 @@ struct thread
 #define THREAD_EVENT          3
 #define THREAD_READY          4
 #define THREAD_UNUSED         5
+#define THREAD_BACKGROUND     6
 
 /* Thread yield time.  */
 #define THREAD_YIELD_TIME_SLOT     100 * 1000L /* 100ms */
@@ -104,6 +107,12 @@ struct thread
       thread = thread_add_timer (master, func, arg, time); \
   } while (0)
 
+#define THREAD_BACKGROUND_ON(master,thread,func,arg) \
+  do { \
+    if (! thread) \
+      thread = thread_add_background (master, func, arg); \
+  } while (0)
+
 #define THREAD_OFF(thread) \
   do { \
     if (thread) \
@@ -116,6 +125,7 @@ struct thread
 #define THREAD_READ_OFF(thread)  THREAD_OFF(thread)
 #define THREAD_WRITE_OFF(thread)  THREAD_OFF(thread)
 #define THREAD_TIMER_OFF(thread)  THREAD_OFF(thread)
+#define THREAD_BACKGROUND_OFF(thread)  THREAD_OFF(thread)
 
 /* Prototypes. */
 struct thread_master *thread_master_create ();
@@ -129,6 +139,8 @@ struct thread *thread_add_timer (struct thread_master *,
 				 int (*)(struct thread *), void *, long);
 struct thread *thread_add_event (struct thread_master *,
 				 int (*)(struct thread *), void *, int );
+struct thread *thread_add_background (struct thread_master *,
+				      int (*)(struct thread *), void *);
 void thread_cancel (struct thread *);
 void thread_cancel_event (struct thread_master *, void *);
 
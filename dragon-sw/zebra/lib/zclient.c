@@ -269,6 +269,10 @@ zclient_start (struct zclient *zclient)
   if (zclient->default_information)
     zebra_message_send (zclient, ZEBRA_REDISTRIBUTE_DEFAULT_ADD);
 
+  /* Let the daemon restore its own requests. */
+  if (zclient->connected)
+    (*zclient->connected) (zclient);
+
   return 0;
 }
 
@@ -540,6 +544,30 @@ zebra_redistribute_send (int command, int sock, int type)
   return ret;
 }
 
+/* Register or unregister interest in how zebra resolves nexthop P.
+   Zebra answers a registration, and every later change, with a
+   ZEBRA_NEXTHOP_UPDATE message. */
+int
+zebra_nexthop_send (int command, int sock, struct prefix *p)
+{
+  int ret;
+  struct stream *s;
+
+  s = stream_new (ZEBRA_MAX_PACKET_SIZ);
+
+  stream_putw (s, 0);
+  stream_putc (s, command);
+  stream_putc (s, p->family);
+  stream_put (s, &p->u.prefix, PSIZE (p->prefixlen));
+  stream_putw_at (s, 0, stream_get_endp (s));
+
+  ret = writen (sock, (char*)s->data, stream_get_endp (s));
+
+  stream_free (s);
+
+  return ret;
+}
+
 /* Interface addition from zebra daemon. */
 struct interface *
 zebra_interface_add_read (struct stream *s)
@@ -707,10 +735,99 @@ zebra_interface_address_delete_read (struct stream *s)
 }
  
 /* Zebra client message read function. */
+/* Hand one message, whose body is at the read pointer of the input
+   buffer, to its callback. */
+static int
+zclient_dispatch (struct zclient *zclient, zebra_command_t command,
+		  zebra_size_t length)
+{
+  int ret = 0;
+
+  switch (command)
+    {
+    case ZEBRA_INTERFACE_ADD:
+      if (zclient->interface_add)
+	ret = (*zclient->interface_add) (command, zclient, length);
+      break;
+    case ZEBRA_INTERFACE_DELETE:
+      if (zclient->interface_delete)
+	ret = (*zclient->interface_delete) (command, zclient, length);
+      break;
+    case ZEBRA_INTERFACE_ADDRESS_ADD:
+      if (zclient->interface_address_add)
+	ret = (*zclient->interface_address_add) (command, zclient, length);
+      break;
+    case ZEBRA_INTERFACE_ADDRESS_DELETE:
+      if (zclient->interface_address_delete)
+	ret = (*zclient->interface_address_delete) (command, zclient, length);
+      break;
+    case ZEBRA_INTERFACE_UP:
+      if (zclient->interface_up)
+	ret = (*zclient->interface_up) (command, zclient, length);
+      break;
+    case ZEBRA_INTERFACE_DOWN:
+      if (zclient->interface_down)
+	ret = (*zclient->interface_down) (command, zclient, length);
+      break;
+    case ZEBRA_IPV4_ROUTE_ADD:
+      if (zclient->ipv4_route_add)
+	ret = (*zclient->ipv4_route_add) (command, zclient, length);
+      break;
+    case ZEBRA_IPV4_ROUTE_DELETE:
+      if (zclient->ipv4_route_delete)
+	ret = (*zclient->ipv4_route_delete) (command, zclient, length);
+      break;
+    case ZEBRA_IPV6_ROUTE_ADD:
+      if (zclient->ipv6_route_add)
+	ret = (*zclient->ipv6_route_add) (command, zclient, length);
+      break;
+    case ZEBRA_IPV6_ROUTE_DELETE:
+      if (zclient->ipv6_route_delete)
+	ret = (*zclient->ipv6_route_delete) (command, zclient, length);
+      break;
+    case ZEBRA_NEXTHOP_UPDATE:
+      if (zclient->nexthop_update)
+	ret = (*zclient->nexthop_update) (command, zclient, length);
+      break;
+    default:
+      break;
+    }
+  return ret;
+}
+
+/* A ZEBRA_MESSAGE_BATCH message is a sequence of whole messages. */
+static void
+zclient_read_batch (struct zclient *zclient, zebra_size_t length)
+{
+  unsigned long start;
+  unsigned long end;
+  zebra_size_t sublen;
+  zebra_command_t command;
+
+  end = stream_get_getp (zclient->ibuf) + length;
+
+  while ((start = stream_get_getp (zclient->ibuf)) + ZEBRA_HEADER_SIZE <= end)
+    {
+      sublen = stream_getw (zclient->ibuf);
+      command = stream_getc (zclient->ibuf);
+
+      if (sublen < ZEBRA_HEADER_SIZE || start + sublen > end
+	  || command == ZEBRA_MESSAGE_BATCH)
+	{
+	  zlog_warn ("zclient: bad message in batch (length %d)", sublen);
+	  break;
+	}
+
+      zclient_dispatch (zclient, command, sublen - ZEBRA_HEADER_SIZE);
+
+      /* Callbacks need not read everything. */
+      stream_set_getp (zclient->ibuf, start + sublen);
+    }
+}
+
 int
 zclient_read (struct thread *thread)
 {
-  int ret;
   int nbytes;
   int sock;
   zebra_size_t length;
@@ -774,51 +891,10 @@ zclient_read (struct thread *thread)
      return -1;
    }
 
-  switch (command)
-    {
-    case ZEBRA_INTERFACE_ADD:
-      if (zclient->interface_add)
-	ret = (*zclient->interface_add) (command, zclient, length);
-      break;
-    case ZEBRA_INTERFACE_DELETE:
-      if (zclient->interface_delete)
-	ret = (*zclient->interface_delete) (command, zclient, length);
-      break;
-    case ZEBRA_INTERFACE_ADDRESS_ADD:
-      if (zclient->interface_address_add)
-	ret = (*zclient->interface_address_add) (command, zclient, length);
-      break;
-    case ZEBRA_INTERFACE_ADDRESS_DELETE:
-      if (zclient->interface_address_delete)
-	ret = (*zclient->interface_address_delete) (command, zclient, length);
-      break;
-    case ZEBRA_INTERFACE_UP:
-      if (zclient->interface_up)
-	ret = (*zclient->interface_up) (command, zclient, length);
-      break;
-    case ZEBRA_INTERFACE_DOWN:
-      if (zclient->interface_down)
-	ret = (*zclient->interface_down) (command, zclient, length);
-      break;
-    case ZEBRA_IPV4_ROUTE_ADD:
-      if (zclient->ipv4_route_add)
-	ret = (*zclient->ipv4_route_add) (command, zclient, length);
-      break;
-    case ZEBRA_IPV4_ROUTE_DELETE:
-      if (zclient->ipv4_route_delete)
-	ret = (*zclient->ipv4_route_delete) (command, zclient, length);
-      break;
-    case ZEBRA_IPV6_ROUTE_ADD:
-      if (zclient->ipv6_route_add)
-	ret = (*zclient->ipv6_route_add) (command, zclient, length);
-      break;
-    case ZEBRA_IPV6_ROUTE_DELETE:
-      if (zclient->ipv6_route_delete)
-	ret = (*zclient->ipv6_route_delete) (command, zclient, length);
-      break;
-    default:
-      break;
-    }
+  if (command == ZEBRA_MESSAGE_BATCH)
+    zclient_read_batch (zclient, length);
+  else
+    zclient_dispatch (zclient, command, length);
 
   /* Register read thread. */
   zclient_event (ZCLIENT_READ, zclient);
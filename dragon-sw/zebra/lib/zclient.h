@@ -31,6 +31,9 @@
 /* Zebra header size. */
 #define ZEBRA_HEADER_SIZE                3
 
+/* Largest ZEBRA_MESSAGE_BATCH message zebra sends. */
+#define ZEBRA_BATCH_SIZ              32768
+
 /* Structure for the zebra client. */
 struct zclient
 {
@@ -72,6 +75,10 @@ struct zclient
   int (*ipv4_route_delete) (int, struct zclient *, zebra_size_t);
   int (*ipv6_route_add) (int, struct zclient *, zebra_size_t);
   int (*ipv6_route_delete) (int, struct zclient *, zebra_size_t);
+  int (*nexthop_update) (int, struct zclient *, zebra_size_t);
+
+  /* Called when the connection to zebra is (re)established. */
+  void (*connected) (struct zclient *);
 };
 
 /* Zebra API message flag. */
@@ -124,6 +131,7 @@ void zclient_redistribute_default_unset (struct zclient *);
 
 /* struct zebra *zebra_new (); */
 int zebra_redistribute_send (int, int, int);
+int zebra_nexthop_send (int, int, struct prefix *);
 
 struct interface *zebra_interface_add_read (struct stream *);
 struct interface *zebra_interface_state_read (struct stream *s);
@@ -239,7 +239,11 @@ struct in6_pktinfo
 #define ZEBRA_IPV6_NEXTHOP_LOOKUP         16
 #define ZEBRA_IPV4_IMPORT_LOOKUP          17
 #define ZEBRA_IPV6_IMPORT_LOOKUP          18
-#define ZEBRA_MESSAGE_MAX                 19
+#define ZEBRA_MESSAGE_BATCH               19
+#define ZEBRA_NEXTHOP_REGISTER            20
+#define ZEBRA_NEXTHOP_UNREGISTER          21
+#define ZEBRA_NEXTHOP_UPDATE              22
+#define ZEBRA_MESSAGE_MAX                 23
 
 /* Zebra route's types. */
 #define ZEBRA_ROUTE_SYSTEM               0
@@ -107,6 +107,7 @@ msg_new (u_char msgtype, void *msgbody, u_int32_t seqnum, u_int16_t msglen)
   new = XMALLOC (MTYPE_OSPF_API_MSG, sizeof (struct msg));
   memset (new, 0, sizeof (struct msg));
 
+  new->refcnt = 1;
   new->hdr.version = OSPF_API_VERSION;
   new->hdr.msgtype = msgtype;
   new->hdr.msglen = htons (msglen);
@@ -133,6 +134,16 @@ msg_dup (struct msg *msg)
   return new;
 }
 
+/* Take another reference on a message instead of copying it.  The
+   body is read-only once built, so all holders can share it. */
+struct msg *
+msg_ref (struct msg *msg)
+{
+  assert (msg);
+  msg->refcnt++;
+  return msg;
+}
+
 
 /* XXX only for testing, will be removed */
 
@@ -245,6 +256,10 @@ msg_print (struct msg *msg)
 void
 msg_free (struct msg *msg)
 {
+  assert (msg->refcnt > 0);
+  if (--msg->refcnt > 0)
+    return;
+
   if (msg->s)
     stream_free (msg->s);
 
@@ -284,16 +299,23 @@ msg_fifo_new ()
   return new;
 }
 
-/* Add new message to fifo. */
+/* Add new message to fifo.  The fifo takes over the caller's
+   reference. */
 void
 msg_fifo_push (struct msg_fifo *fifo, struct msg *msg)
 {
+  struct msg_fifo_node *node;
+
+  node = XMALLOC (MTYPE_OSPF_API_FIFO_NODE, sizeof (struct msg_fifo_node));
+  node->next = NULL;
+  node->msg = msg;
+
   if (fifo->tail)
-    fifo->tail->next = msg;
+    fifo->tail->next = node;
   else
-    fifo->head = msg;
+    fifo->head = node;
 
-  fifo->tail = msg;
+  fifo->tail = node;
   fifo->count++;
 }
 
@@ -302,17 +324,21 @@ msg_fifo_push (struct msg_fifo *fifo, struct msg *msg)
 struct msg *
 msg_fifo_pop (struct msg_fifo *fifo)
 {
-  struct msg *msg;
+  struct msg_fifo_node *node;
+  struct msg *msg = NULL;
 
-  msg = fifo->head;
-  if (msg)
+  node = fifo->head;
+  if (node)
     {
-      fifo->head = msg->next;
+      fifo->head = node->next;
 
       if (fifo->head == NULL)
 	fifo->tail = NULL;
 
       fifo->count--;
+
+      msg = node->msg;
+      XFREE (MTYPE_OSPF_API_FIFO_NODE, node);
     }
   return msg;
 }
@@ -321,20 +347,21 @@ msg_fifo_pop (struct msg_fifo *fifo)
 struct msg *
 msg_fifo_head (struct msg_fifo *fifo)
 {
-  return fifo->head;
+  return fifo->head ? fifo->head->msg : NULL;
 }
 
 /* Flush message fifo. */
 void
 msg_fifo_flush (struct msg_fifo *fifo)
 {
-  struct msg *op;
-  struct msg *next;
+  struct msg_fifo_node *node;
+  struct msg_fifo_node *next;
 
-  for (op = fifo->head; op; op = next)
+  for (node = fifo->head; node; node = next)
     {
-      next = op->next;
-      msg_free (op);
+      next = node->next;
+      msg_free (node->msg);
+      XFREE (MTYPE_OSPF_API_FIFO_NODE, node);
     }
 
   fifo->head = fifo->tail = NULL;
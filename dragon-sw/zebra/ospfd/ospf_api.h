@@ -32,6 +32,7 @@
 /* MTYPE definition is not reflected to "memory.h". */
 #define MTYPE_OSPF_API_MSG      MTYPE_TMP
 #define MTYPE_OSPF_API_FIFO     MTYPE_TMP
+#define MTYPE_OSPF_API_FIFO_NODE MTYPE_TMP
 
 /* Default API server port to accept connection request from client-side. */
 /* This value could be overridden by "ospfapi" entry in "/etc/services". */
@@ -51,10 +52,12 @@ struct apimsghdr
   u_int32_t msgseq;		/* Sequence number */
 };
 
-/* Message representation with header and body */
+/* Message representation with header and body.  A message may sit
+   in several client fifos at once (see msg_ref), it is freed when the
+   last reference is dropped by msg_free. */
 struct msg
 {
-  struct msg *next;		/* to link into fifo */
+  u_int32_t refcnt;		/* number of holders */
 
   /* Message header */
   struct apimsghdr hdr;
@@ -67,6 +70,7 @@ struct msg
 struct msg *msg_new (u_char msgtype, void *msgbody,
 		     u_int32_t seqnum, u_int16_t msglen);
 struct msg *msg_dup (struct msg *msg);
+struct msg *msg_ref (struct msg *msg);
 void msg_print (struct msg *msg);	/* XXX debug only */
 void msg_free (struct msg *msg);
 struct msg *msg_read (int fd);
@@ -86,13 +90,20 @@ u_int32_t msg_get_seq (struct msg *msg);
  * -----------------------------------------------------------
  */
 
+/* Message queue entry, so one message can be queued to many fifos. */
+struct msg_fifo_node
+{
+  struct msg_fifo_node *next;
+  struct msg *msg;
+};
+
 /* Message queue structure. */
 struct msg_fifo
 {
   unsigned long count;
 
-  struct msg *head;
-  struct msg *tail;
+  struct msg_fifo_node *head;
+  struct msg_fifo_node *tail;
 };
 
 /* Prototype for message fifo queues. */
@@ -315,6 +315,8 @@ ospf_apiserver_new (int fd_sync, int fd_async)
 #endif /* USE_ASYNC_READ */
   new->t_sync_write = NULL;
   new->t_async_write = NULL;
+  new->sync = NULL;
+  new->t_sync_lsdb = NULL;
 
   new->filter->typemask = htons(Power2[OSPF_OPAQUE_AREA_LSA]);	/* filter all LSAs other than opaque-LSA (10)*/
   new->filter->origin = ANY_ORIGIN;
@@ -391,6 +393,14 @@ ospf_apiserver_free (struct ospf_apiserver *apiserv)
       thread_cancel (apiserv->t_async_write);
     }
 
+  if (apiserv->t_sync_lsdb)
+    {
+      thread_cancel (apiserv->t_sync_lsdb);
+    }
+
+  /* Abort LSDB snapshot still in progress. */
+  ospf_apiserver_sync_lsdb_free (apiserv);
+
   /* Unregister all opaque types that application registered 
      and flush opaque LSAs if still in LSDB. */
 
@@ -626,6 +636,12 @@ ospf_apiserver_async_write (struct thread *thread)
                             apiserv);
     }
 
+  /* Client is keeping up, feed it the next part of its LSDB snapshot. */
+  if (apiserv->sync && !apiserv->t_sync_lsdb
+      && apiserv->out_async_fifo->count <= OSPF_APISERVER_SYNC_LOWAT)
+    apiserv->t_sync_lsdb =
+      thread_add_event (master, ospf_apiserver_sync_lsdb_timer, apiserv, 0);
+
  out:
 
   if (rc < 0)
@@ -863,10 +879,11 @@ ospf_apiserver_send_msg (struct ospf_apiserver *apiserv, struct msg *msg)
       return -1;
     }
 
-  /* Make a copy of the message and put in the fifo. Once the fifo
-     gets drained by the write thread, the message will be freed. */
+  /* Share the message with the fifo rather than copying it, so a
+     notification fanned out to many clients is built only once.  Once
+     the fifo gets drained by the write thread, the reference is dropped. */
   /* NB: Given "msg" is untouched in this function. */
-  msg2 = msg_dup (msg);
+  msg2 = msg_ref (msg);
 
   /* Enqueue message into corresponding fifo queue */
   msg_fifo_push (fifo, msg2);
@@ -1474,23 +1491,158 @@ out:
   return rc;
 }
 
-int
-ospf_apiserver_handle_sync_lsdb (struct ospf_apiserver *apiserv,
-				 struct msg *msg)
+/* LSA types walked for each area, then for the whole AS, in the same
+   order as the LSDB was always synchronized. */
+static u_char apiserver_sync_area_types[] =
 {
-  listnode node;
-  u_int32_t seqnum;
-  int rc = 0;
-  struct msg_sync_lsdb *smsg;
+  OSPF_ROUTER_LSA,
+  OSPF_NETWORK_LSA,
+  OSPF_SUMMARY_LSA,
+  OSPF_ASBR_SUMMARY_LSA,
+  OSPF_OPAQUE_LINK_LSA,
+  OSPF_OPAQUE_AREA_LSA,
+};
+
+static u_char apiserver_sync_as_types[] =
+{
+  OSPF_AS_EXTERNAL_LSA,
+  OSPF_OPAQUE_AS_LSA,
+};
+
+void
+ospf_apiserver_sync_lsdb_free (struct ospf_apiserver *apiserv)
+{
+  struct ospf_apiserver_sync *sync = apiserv->sync;
+
+  if (sync == NULL)
+    return;
+
+  if (sync->areas)
+    XFREE (MTYPE_OSPF_APISERVER_SYNC, sync->areas);
+  XFREE (MTYPE_OSPF_APISERVER_SYNC, sync);
+  apiserv->sync = NULL;
+}
+
+/* Queue the next chunk of an LSDB snapshot to the client's async
+   fifo.  Returns 1 once the whole LSDB has been sent. */
+static int
+ospf_apiserver_sync_lsdb_continue (struct ospf_apiserver *apiserv)
+{
+  struct ospf_apiserver_sync *sync = apiserv->sync;
+  struct lsa_filter_type filter;
   struct param_t
   {
     struct ospf_apiserver *apiserv;
     struct lsa_filter_type *filter;
   }
   param;
-  u_int16_t mask;
-  struct route_node *rn;
+  struct ospf *ospf;
+  struct ospf_area *area;
+  struct ospf_lsdb *lsdb;
   struct ospf_lsa *lsa;
+  int budget = OSPF_APISERVER_SYNC_CHUNK;
+  u_char type;
+
+  ospf = ospf_lookup ();
+  if (ospf == NULL)
+    return 1;
+
+  filter.origin = sync->origin;
+  param.apiserv = apiserv;
+  param.filter = &filter;
+
+  while (budget > 0
+	 && apiserv->out_async_fifo->count < OSPF_APISERVER_SYNC_HIWAT)
+    {
+      if (sync->area_idx < sync->num_areas)
+	{
+	  if (sync->type_idx >= sizeof (apiserver_sync_area_types))
+	    {
+	      sync->area_idx++;
+	      sync->type_idx = 0;
+	      continue;
+	    }
+	  type = apiserver_sync_area_types[sync->type_idx];
+
+	  /* Area may have gone away since the previous chunk. */
+	  area = ospf_area_lookup_by_area_id (ospf,
+					      sync->areas[sync->area_idx]);
+	  lsdb = area ? area->lsdb : NULL;
+	}
+      else
+	{
+	  if (sync->type_idx >= sizeof (apiserver_sync_as_types))
+	    return 1;
+	  type = apiserver_sync_as_types[sync->type_idx];
+	  lsdb = ospf->lsdb;
+	}
+
+      lsa = NULL;
+      if (lsdb && (sync->typemask & Power2[type]))
+	lsa = ospf_lsdb_lookup_by_id_next (lsdb, type, sync->id,
+					   sync->adv_router, sync->first);
+
+      if (lsa == NULL)
+	{
+	  /* This table is done, move on to the next LSA type. */
+	  sync->type_idx++;
+	  sync->first = 1;
+	  continue;
+	}
+
+      sync->first = 0;
+      sync->id = lsa->data->id;
+      sync->adv_router = lsa->data->adv_router;
+
+      apiserver_sync_callback (lsa, (void *) &param, sync->seqnum);
+      budget--;
+    }
+
+  return 0;
+}
+
+int
+ospf_apiserver_sync_lsdb_timer (struct thread *thread)
+{
+  struct ospf_apiserver *apiserv;
+
+  apiserv = THREAD_ARG (thread);
+  apiserv->t_sync_lsdb = NULL;
+
+  if (apiserv->sync == NULL)
+    return 0;
+
+  if (ospf_apiserver_sync_lsdb_continue (apiserv))
+    {
+      if (IS_DEBUG_OSPF_EVENT)
+	zlog_info ("API: LSDB sync seq %lu done",
+		   (unsigned long) apiserv->sync->seqnum);
+      ospf_apiserver_sync_lsdb_free (apiserv);
+    }
+  else if (apiserv->out_async_fifo->count < OSPF_APISERVER_SYNC_HIWAT)
+    {
+      /* Chunk budget used up, yield to other threads before going on.
+         Otherwise the async write thread restarts us once the client
+         has drained its fifo. */
+      apiserv->t_sync_lsdb =
+	thread_add_event (master, ospf_apiserver_sync_lsdb_timer, apiserv, 0);
+    }
+
+  return 0;
+}
+
+/* Start streaming a snapshot of the LSDB.  Instead of building one
+   message per LSA up front, only the resume position is kept and the
+   LSAs are queued chunk by chunk as the client drains its async fifo. */
+int
+ospf_apiserver_handle_sync_lsdb (struct ospf_apiserver *apiserv,
+				 struct msg *msg)
+{
+  listnode node;
+  u_int32_t seqnum;
+  int rc = 0;
+  struct msg_sync_lsdb *smsg;
+  struct ospf_apiserver_sync *sync;
   struct ospf *ospf;
 
   ospf = ospf_lookup ();
@@ -1500,15 +1652,23 @@ ospf_apiserver_handle_sync_lsdb (struct ospf_apiserver *apiserv,
   /* Set sync msg. */
   smsg = (struct msg_sync_lsdb *) STREAM_DATA (msg->s);
 
-  /* Set parameter struct. */
-  param.apiserv = apiserv;
-  param.filter = &smsg->filter;
+  /* A new request replaces a snapshot still in progress. */
+  ospf_apiserver_sync_lsdb_free (apiserv);
 
-  /* Remember mask. */
-  mask = ntohs (smsg->filter.typemask);
+  sync = XMALLOC (MTYPE_OSPF_APISERVER_SYNC,
+		  sizeof (struct ospf_apiserver_sync));
+  memset (sync, 0, sizeof (struct ospf_apiserver_sync));
+  sync->seqnum = seqnum;
+  sync->typemask = ntohs (smsg->filter.typemask);
+  sync->origin = smsg->filter.origin;
+  sync->first = 1;
 
-  /* Iterate over all areas. */
-  for (node = listhead (ospf->areas); node; nextnode (node))
+  /* Remember the areas to walk, in LSDB order. */
+  if (ospf && listcount (ospf->areas) > 0)
+    sync->areas = XMALLOC (MTYPE_OSPF_APISERVER_SYNC,
+			   listcount (ospf->areas) * sizeof (struct in_addr));
+
+  for (node = ospf ? listhead (ospf->areas) : NULL; node; nextnode (node))
     {
       struct ospf_area *area = node->data;
       int i;
@@ -1536,47 +1696,19 @@ ospf_apiserver_handle_sync_lsdb (struct ospf_apiserver *apiserv,
 
       /* If area was found, then i>0 here. */
       if (i)
-	{
-	  /* Check msg type. */
-	  if (mask & Power2[OSPF_ROUTER_LSA])
-	    LSDB_LOOP (ROUTER_LSDB (area), rn, lsa)
-	      apiserver_sync_callback(lsa, (void *) &param, seqnum);
-	  if (mask & Power2[OSPF_NETWORK_LSA])
-            LSDB_LOOP (NETWORK_LSDB (area), rn, lsa)
-              apiserver_sync_callback(lsa, (void *) &param, seqnum);
-	  if (mask & Power2[OSPF_SUMMARY_LSA])
-            LSDB_LOOP (SUMMARY_LSDB (area), rn, lsa)
-              apiserver_sync_callback(lsa, (void *) &param, seqnum);
-	  if (mask & Power2[OSPF_ASBR_SUMMARY_LSA])
-            LSDB_LOOP (ASBR_SUMMARY_LSDB (area), rn, lsa)
-              apiserver_sync_callback(lsa, (void *) &param, seqnum);
-	  if (mask & Power2[OSPF_OPAQUE_LINK_LSA])
-            LSDB_LOOP (OPAQUE_LINK_LSDB (area), rn, lsa)
-              apiserver_sync_callback(lsa, (void *) &param, seqnum);
-	  if (mask & Power2[OSPF_OPAQUE_AREA_LSA])
-            LSDB_LOOP (OPAQUE_AREA_LSDB (area), rn, lsa)
-              apiserver_sync_callback(lsa, (void *) &param, seqnum);
-	}
+	sync->areas[sync->num_areas++] = area->area_id;
     }
 
-  /* For AS-external LSAs */
-  if (ospf->lsdb)
-    {
-      if (mask & Power2[OSPF_AS_EXTERNAL_LSA])
-	LSDB_LOOP (EXTERNAL_LSDB (ospf), rn, lsa)
-	  apiserver_sync_callback(lsa, (void *) &param, seqnum);
-    }
+  apiserv->sync = sync;
 
-  /* For AS-external opaque LSAs */
-  if (ospf->lsdb)
-    {
-      if (mask & Power2[OSPF_OPAQUE_AS_LSA])
-	LSDB_LOOP (OPAQUE_AS_LSDB (ospf), rn, lsa)
-	  apiserver_sync_callback(lsa, (void *) &param, seqnum);
-    }
-
-  /* Send a reply back to client with return code */
+  /* Send a reply back to client with return code.  LSAs follow on the
+     async channel as before. */
   rc = ospf_apiserver_send_reply (apiserv, seqnum, rc);
+
+  if (apiserv->t_sync_lsdb == NULL)
+    apiserv->t_sync_lsdb =
+      thread_add_event (master, ospf_apiserver_sync_lsdb_timer, apiserv, 0);
+
   return rc;
 }
 
@@ -2888,13 +3020,6 @@ apiserver_clients_lsa_change_notify (u_char msgtype, struct ospf_lsa *lsa)
 int
 apiserver_notify_clients_lsa (u_char msgtype, struct ospf_lsa *lsa)
 {
-  struct msg *msg;
-  /* default area for AS-External and Opaque11 LSAs */
-  struct in_addr area_id = { 0L };
-
-  /* default interface for non Opaque9 LSAs */
-  struct in_addr ifaddr = { 0L };
-
   /* Only notify this update if the LSA's age is smaller than
      MAXAGE. Otherwise clients would see LSA updates with max age just
      before they are deleted from the LSDB. LSA delete messages have
@@ -2903,28 +3028,10 @@ apiserver_notify_clients_lsa (u_char msgtype, struct ospf_lsa *lsa)
     return 0;
   }
 
-  if (lsa->area)
-    {
-      area_id = lsa->area->area_id;
-    }
-  if (lsa->data->type == OSPF_OPAQUE_LINK_LSA)
-    {
-      ifaddr = lsa->oi->address->u.prefix4;
-    }
-  msg = new_msg_lsa_change_notify (msgtype, 0L,	/* no sequence number */
-				   ifaddr, area_id,
-				   lsa->flags & OSPF_LSA_SELF, lsa->data);
-  if (!msg)
-    {
-      zlog_warn ("notify_clients_lsa: msg_new failed");
-      return -1;
-    }
-  /* Notify all clients that new LSA is added/updated */
+  /* Notify all clients that new LSA is added/updated.  The message is
+     built once there and shared by every client with a matching filter. */
   apiserver_clients_lsa_change_notify (msgtype, lsa);
 
-  /* Clients made their own copies of msg so we can free msg here */
-  msg_free (msg);
-
   return 0;
 }
 
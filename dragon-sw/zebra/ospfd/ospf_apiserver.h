@@ -26,6 +26,14 @@
 /* MTYPE definition is not reflected to "memory.h". */
 #define MTYPE_OSPF_APISERVER MTYPE_TMP
 #define MTYPE_OSPF_APISERVER_MSGFILTER MTYPE_TMP
+#define MTYPE_OSPF_APISERVER_SYNC MTYPE_TMP
+
+/* LSDB snapshots are streamed to the client in chunks of this many
+   LSAs, and only while its async fifo holds fewer than HIWAT messages.
+   Streaming resumes once the write thread drains it below LOWAT. */
+#define OSPF_APISERVER_SYNC_CHUNK   256
+#define OSPF_APISERVER_SYNC_HIWAT   1024
+#define OSPF_APISERVER_SYNC_LOWAT   256
 
 /* List of opaque types that application registered */
 struct registered_opaque_type
@@ -35,6 +43,26 @@ struct registered_opaque_type
 };
 
 
+/* Position of an LSDB snapshot in progress.  Only the key of the last
+   LSA sent is kept, so the LSDB may change freely between chunks. */
+struct ospf_apiserver_sync
+{
+  u_int32_t seqnum;		/* of the MSG_SYNC_LSDB request */
+  u_int16_t typemask;		/* host byte order */
+  u_char origin;
+
+  /* Areas to walk, AS-scope LSAs are sent after the last one. */
+  int num_areas;
+  struct in_addr *areas;
+
+  /* Resume point. */
+  int area_idx;
+  int type_idx;
+  int first;
+  struct in_addr id;
+  struct in_addr adv_router;
+};
+
 /* Server instance for each accepted client connection. */
 struct ospf_apiserver
 {
@@ -58,6 +86,10 @@ struct ospf_apiserver
   /* filter for LSA update/delete notifies */
   struct lsa_filter_type *filter;
 
+  /* LSDB snapshot being streamed, NULL if none. */
+  struct ospf_apiserver_sync *sync;
+  struct thread *t_sync_lsdb;
+
   /* Fifo buffers for outgoing messages */
   struct msg_fifo *out_sync_fifo;
   struct msg_fifo *out_async_fifo;
@@ -144,6 +176,8 @@ int ospf_apiserver_handle_delete_request (struct ospf_apiserver *apiserv,
 					  struct msg *msg);
 int ospf_apiserver_handle_sync_lsdb (struct ospf_apiserver *apiserv,
 				     struct msg *msg);
+int ospf_apiserver_sync_lsdb_timer (struct thread *thread);
+void ospf_apiserver_sync_lsdb_free (struct ospf_apiserver *apiserv);
 int ospf_apiserver_handle_update_request (struct ospf_apiserver *apiserv,
 					     struct msg *msg);
 
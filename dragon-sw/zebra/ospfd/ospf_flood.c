@@ -75,7 +75,7 @@ ospf_flood_delayed_lsa_ack (struct ospf_neighbor *inbr, struct ospf_lsa *lsa)
     return;
 
   /* Schedule a delayed LSA Ack to be sent */ 
-  listnode_add (inbr->oi->ls_ack, ospf_lsa_lock (lsa));
+  ospf_ls_ack_add_delayed (inbr->oi, lsa);
 }
 
 /* Check LSA is related to external info. */
@@ -921,10 +921,7 @@ ospf_ls_retransmit_add (struct ospf_neighbor *nbr, struct ospf_lsa *lsa)
   if (ospf_lsa_more_recent (old, lsa) < 0)
     {
       if (old)
-	{
-	  old->retransmit_counter--;
-	  ospf_lsdb_delete (&nbr->ls_rxmt, old);
-	}
+	ospf_ls_retransmit_delete (nbr, old);
       lsa->retransmit_counter++;
       /*
        * We cannot make use of the newly introduced callback function
@@ -937,6 +934,17 @@ ospf_ls_retransmit_add (struct ospf_neighbor *nbr, struct ospf_lsa *lsa)
                      ospf_ls_retransmit_count (nbr),
 		     inet_ntoa (nbr->router_id), dump_lsa_key (lsa));
       ospf_lsdb_add (&nbr->ls_rxmt, lsa);
+
+      /* Remember the neighbor on the LSA itself, so that the LSA can
+	 be taken off every list without visiting each neighbor. */
+      if (lsa->rxmt_nbrs == NULL)
+	lsa->rxmt_nbrs = list_new ();
+      listnode_add (lsa->rxmt_nbrs, nbr);
+
+      if (ospf_ls_retransmit_count (nbr) > nbr->ls_rxmt_peak)
+	nbr->ls_rxmt_peak = ospf_ls_retransmit_count (nbr);
+      if (++nbr->oi->ospf->ls_rxmt_count > nbr->oi->ospf->ls_rxmt_peak)
+	nbr->oi->ospf->ls_rxmt_peak = nbr->oi->ospf->ls_rxmt_count;
     }
 }
 
@@ -944,13 +952,16 @@ ospf_ls_retransmit_add (struct ospf_neighbor *nbr, struct ospf_lsa *lsa)
 void
 ospf_ls_retransmit_delete (struct ospf_neighbor *nbr, struct ospf_lsa *lsa)
 {
-  if (ospf_ls_retransmit_lookup (nbr, lsa))
+  if ((lsa = ospf_ls_retransmit_lookup (nbr, lsa)) != NULL)
     {
       lsa->retransmit_counter--;  
       if (IS_DEBUG_OSPF (lsa, LSA_FLOODING))		/* -- endo. */
 	  zlog_info ("RXmtL(%lu)--, NBR(%s), LSA[%s]",
                      ospf_ls_retransmit_count (nbr),
 		     inet_ntoa (nbr->router_id), dump_lsa_key (lsa));
+      if (lsa->rxmt_nbrs)
+	listnode_delete (lsa->rxmt_nbrs, nbr);
+      nbr->oi->ospf->ls_rxmt_count--;
       ospf_lsdb_delete (&nbr->ls_rxmt, lsa);
     }
 }
@@ -986,44 +997,74 @@ ospf_ls_retransmit_lookup (struct ospf_neighbor *nbr, struct ospf_lsa *lsa)
   return ospf_lsdb_lookup (&nbr->ls_rxmt, lsa);
 }
 
+/* Remove one LSA instance from the retransmission lists of the
+   neighbors holding it, restricted to an interface or an area when
+   given.  Only the neighbors on lsa->rxmt_nbrs are visited. */
+static void
+ospf_ls_retransmit_delete_nbr_lsa (struct ospf_lsa *lsa,
+				   struct ospf_interface *oi,
+				   struct ospf_area *area)
+{
+  struct ospf_neighbor *nbr;
+  listnode node, next;
+
+  if (lsa->rxmt_nbrs == NULL)
+    return;
+
+  for (node = listhead (lsa->rxmt_nbrs); node; node = next)
+    {
+      next = node->next;
+      nbr = getdata (node);
+
+      if (oi != NULL && nbr->oi != oi)
+	continue;
+      if (area != NULL && nbr->oi->area != area)
+	continue;
+      if (! ospf_if_is_enable (nbr->oi))
+	continue;
+
+      ospf_ls_retransmit_delete (nbr, lsa);
+    }
+}
+
+/* Remove LSA, or the database copy with the same instance, from the
+   retransmission lists of neighbors within the given scope.  Only
+   database copies are ever put on those lists. */
+static void
+ospf_ls_retransmit_delete_nbr_scope (struct ospf_lsa *lsa,
+				     struct ospf_interface *oi,
+				     struct ospf_area *area)
+{
+  struct ospf_lsa *lsr = NULL;
+
+  if (lsa->lsdb != NULL)
+    lsr = ospf_lsdb_lookup (lsa->lsdb, lsa);
+
+  ospf_ls_retransmit_delete_nbr_lsa (lsa, oi, area);
+
+  if (lsr != NULL && lsr != lsa
+      && lsr->data->ls_seqnum == lsa->data->ls_seqnum)
+    ospf_ls_retransmit_delete_nbr_lsa (lsr, oi, area);
+}
+
 void
 ospf_ls_retransmit_delete_nbr_if (struct ospf_interface *oi,
 				  struct ospf_lsa *lsa)
 {
-  struct route_node *rn;
-  struct ospf_neighbor *nbr;
-  struct ospf_lsa *lsr;
-
-  if (ospf_if_is_enable (oi))
-    for (rn = route_top (oi->nbrs); rn; rn = route_next (rn))
-      /* If LSA find in LS-retransmit list, then remove it. */
-      if ((nbr = rn->info) != NULL)
-	{
-	  lsr = ospf_ls_retransmit_lookup (nbr, lsa);
-	     
-	  /* If LSA find in ls-retransmit list, remove it. */
-	  if (lsr != NULL && lsr->data->ls_seqnum == lsa->data->ls_seqnum)
-	    ospf_ls_retransmit_delete (nbr, lsr);
-	}
+  ospf_ls_retransmit_delete_nbr_scope (lsa, oi, NULL);
 }
 
 void
 ospf_ls_retransmit_delete_nbr_area (struct ospf_area *area,
 				    struct ospf_lsa *lsa)
 {
-  listnode node;
-
-  for (node = listhead (area->oiflist); node; nextnode (node))
-    ospf_ls_retransmit_delete_nbr_if (getdata (node), lsa);
+  ospf_ls_retransmit_delete_nbr_scope (lsa, NULL, area);
 }
 
 void
 ospf_ls_retransmit_delete_nbr_as (struct ospf *ospf, struct ospf_lsa *lsa)
 {
-  listnode node;
-
-  for (node = listhead (ospf->oiflist); node; nextnode (node))
-    ospf_ls_retransmit_delete_nbr_if (getdata (node), lsa);
+  ospf_ls_retransmit_delete_nbr_scope (lsa, NULL, NULL);
 }
 
  
@@ -121,11 +121,6 @@ ospf_if_reset_variables (struct ospf_interface *oi)
   oi->state = ISM_Down;
 
   oi->crypt_seqnum = 0;
-
-  /* This must be short, (less than RxmtInterval) 
-     - RFC 2328 Section 13.5 para 3.  Set to 1 second to avoid Acks being
-       held back for too long - MAG */
-  oi->v_ls_ack = 1;  
 }
 
 void
@@ -510,6 +505,7 @@ ospf_new_if_params ()
   UNSET_IF_PARAM (oip, passive_interface);
   UNSET_IF_PARAM (oip, v_hello);
   UNSET_IF_PARAM (oip, v_wait);
+  UNSET_IF_PARAM (oip, v_ls_ack);
   UNSET_IF_PARAM (oip, priority);
   UNSET_IF_PARAM (oip, type);
   UNSET_IF_PARAM (oip, auth_simple);
@@ -549,6 +545,7 @@ ospf_free_if_params (struct interface *ifp, struct in_addr addr)
       !OSPF_IF_PARAM_CONFIGURED (oip, passive_interface) &&
       !OSPF_IF_PARAM_CONFIGURED (oip, v_hello) &&
       !OSPF_IF_PARAM_CONFIGURED (oip, v_wait) &&
+      !OSPF_IF_PARAM_CONFIGURED (oip, v_ls_ack) &&
       !OSPF_IF_PARAM_CONFIGURED (oip, priority) &&
       !OSPF_IF_PARAM_CONFIGURED (oip, type) &&
       !OSPF_IF_PARAM_CONFIGURED (oip, auth_simple) &&
@@ -648,6 +645,9 @@ ospf_if_new_hook (struct interface *ifp)
   SET_IF_PARAM (IF_DEF_PARAMS (ifp), v_wait);
   IF_DEF_PARAMS (ifp)->v_wait = OSPF_ROUTER_DEAD_INTERVAL_DEFAULT;
 
+  SET_IF_PARAM (IF_DEF_PARAMS (ifp), v_ls_ack);
+  IF_DEF_PARAMS (ifp)->v_ls_ack = OSPF_LS_ACK_DELAY_DEFAULT;
+
   SET_IF_PARAM (IF_DEF_PARAMS (ifp), auth_simple);
   memset (IF_DEF_PARAMS (ifp)->auth_simple, 0, OSPF_AUTH_SIMPLE_SIZE);
   
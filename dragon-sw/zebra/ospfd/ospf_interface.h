@@ -53,6 +53,7 @@ struct ospf_if_params
   
   DECLARE_IF_PARAM (u_int32_t, v_hello);             /* Hello Interval */
   DECLARE_IF_PARAM (u_int32_t, v_wait);              /* Router Dead Interval */
+  DECLARE_IF_PARAM (u_int32_t, v_ls_ack);            /* Delayed Ack window */
 
   /* Authentication data. */
   u_char auth_simple[OSPF_AUTH_SIMPLE_SIZE + 1];       /* Simple password. */
@@ -158,9 +159,6 @@ struct ospf_interface
     struct in_addr dst;
   } ls_ack_direct;
 
-  /* Timer values. */
-  u_int32_t v_ls_ack;			/* Delayed Link State Acknowledgment */
-
   /* Threads. */
   struct thread *t_hello;               /* timer */
   struct thread *t_wait;                /* timer */
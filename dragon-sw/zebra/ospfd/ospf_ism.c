@@ -351,7 +351,8 @@ ism_timer_set (struct ospf_interface *oi)
       OSPF_ISM_TIMER_ON (oi->t_hello, ospf_hello_timer, 1);
       
       OSPF_ISM_TIMER_OFF (oi->t_wait);
-      OSPF_ISM_TIMER_ON (oi->t_ls_ack, ospf_ls_ack_timer, oi->v_ls_ack);
+      OSPF_ISM_TIMER_ON (oi->t_ls_ack, ospf_ls_ack_timer,
+			 OSPF_IF_PARAM (oi, v_ls_ack));
       break;
     case ISM_DROther:
       /* The network type of the interface is broadcast or NBMA network,
@@ -360,7 +361,8 @@ ism_timer_set (struct ospf_interface *oi)
       OSPF_ISM_TIMER_ON (oi->t_hello, ospf_hello_timer,
 			 OSPF_IF_PARAM (oi, v_hello));
       OSPF_ISM_TIMER_OFF (oi->t_wait);
-      OSPF_ISM_TIMER_ON (oi->t_ls_ack, ospf_ls_ack_timer, oi->v_ls_ack);
+      OSPF_ISM_TIMER_ON (oi->t_ls_ack, ospf_ls_ack_timer,
+			 OSPF_IF_PARAM (oi, v_ls_ack));
       break;
     case ISM_Backup:
       /* The network type of the interface is broadcast os NBMA network,
@@ -368,7 +370,8 @@ ism_timer_set (struct ospf_interface *oi)
       OSPF_ISM_TIMER_ON (oi->t_hello, ospf_hello_timer,
 			 OSPF_IF_PARAM (oi, v_hello));
       OSPF_ISM_TIMER_OFF (oi->t_wait);
-      OSPF_ISM_TIMER_ON (oi->t_ls_ack, ospf_ls_ack_timer, oi->v_ls_ack);
+      OSPF_ISM_TIMER_ON (oi->t_ls_ack, ospf_ls_ack_timer,
+			 OSPF_IF_PARAM (oi, v_ls_ack));
       break;
     case ISM_DR:
       /* The network type of the interface is broadcast or NBMA network,
@@ -376,7 +379,8 @@ ism_timer_set (struct ospf_interface *oi)
       OSPF_ISM_TIMER_ON (oi->t_hello, ospf_hello_timer,
 			 OSPF_IF_PARAM (oi, v_hello));
       OSPF_ISM_TIMER_OFF (oi->t_wait);
-      OSPF_ISM_TIMER_ON (oi->t_ls_ack, ospf_ls_ack_timer, oi->v_ls_ack);
+      OSPF_ISM_TIMER_ON (oi->t_ls_ack, ospf_ls_ack_timer,
+			 OSPF_IF_PARAM (oi, v_ls_ack));
       break;
     }
 }
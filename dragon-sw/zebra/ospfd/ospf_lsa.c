@@ -278,6 +278,7 @@ ospf_lsa_dup (struct ospf_lsa *lsa)
   UNSET_FLAG (new->flags, OSPF_LSA_DISCARD);
   new->lock = 1;
   new->retransmit_counter = 0;
+  new->rxmt_nbrs = NULL;
   new->data = ospf_lsa_data_dup (lsa->data);
   /* Re-parse this duplicated TE-LSA and generate all the necessary pointers */
 #ifdef HAVE_OPAQUE_LSA
@@ -310,6 +311,9 @@ ospf_lsa_free (struct ospf_lsa *lsa)
   if (lsa->data != NULL)
     ospf_lsa_data_free (lsa->data);
 
+  if (lsa->rxmt_nbrs != NULL)
+    list_free (lsa->rxmt_nbrs);
+
 #ifdef HAVE_OPAQUE_LSA
   if (lsa->tepara_ptr)
   {
@@ -2205,7 +2209,7 @@ ospf_summary_lsa_install (struct ospf *ospf, struct ospf_lsa *new,
       /* This doesn't exist yet... */
       ospf_summary_incremental_update(new); */
 #else /* #if 0 */
-      ospf_spf_calculate_schedule (ospf);
+      ospf_spf_ia_calculate_schedule (ospf);
 #endif /* #if 0 */
  
       if (IS_DEBUG_OSPF (lsa, LSA_INSTALL))
@@ -2238,7 +2242,7 @@ ospf_summary_asbr_lsa_install (struct ospf *ospf, struct ospf_lsa *new,
 	 - RFC 2328 Section 16.5 implies it should be */
       /* ospf_ase_calculate_schedule(); */
 #else  /* #if 0 */
-      ospf_spf_calculate_schedule (ospf);
+      ospf_spf_ia_calculate_schedule (ospf);
 #endif /* #if 0 */
     }
 
@@ -2688,6 +2692,10 @@ ospf_lsa_maxage_walker_remover (struct ospf *ospf, struct ospf_lsa *lsa)
 #endif /* HAVE_NSSA */
 	    ospf_ase_incremental_update (ospf, lsa);
             break;
+          case OSPF_SUMMARY_LSA:
+          case OSPF_ASBR_SUMMARY_LSA:
+	    ospf_spf_ia_calculate_schedule (ospf);
+            break;
           default:
 	    ospf_spf_calculate_schedule (ospf);
             break;
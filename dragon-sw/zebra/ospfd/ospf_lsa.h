@@ -96,6 +96,9 @@ struct ospf_lsa
   /* References to this LSA in neighbor retransmission lists*/
   int retransmit_counter;
 
+  /* Neighbors whose retransmission list holds this LSA. */
+  list rxmt_nbrs;
+
   /* Area the LSA belongs to, may be NULL if AS-external-LSA. */
   struct ospf_area *area;
 
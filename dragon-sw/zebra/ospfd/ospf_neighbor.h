@@ -59,6 +59,7 @@ struct ospf_neighbor
 
   /* LSA data. */
   struct ospf_lsdb ls_rxmt;
+  unsigned long ls_rxmt_peak;       /* Retransmission list high-water. */
   struct ospf_lsdb db_sum;
   struct ospf_lsdb ls_req;
   struct ospf_lsa *ls_req_last;
@@ -477,7 +477,8 @@ ospf_ls_ack_timer (struct thread *thread)
     ospf_ls_ack_send_delayed (oi);
 
   /* Set LS Ack timer. */
-  OSPF_ISM_TIMER_ON (oi->t_ls_ack, ospf_ls_ack_timer, oi->v_ls_ack);
+  OSPF_ISM_TIMER_ON (oi->t_ls_ack, ospf_ls_ack_timer,
+		     OSPF_IF_PARAM (oi, v_ls_ack));
 
   return 0;
 }
@@ -574,12 +575,11 @@ ospf_write_frags (int fd, struct ospf_packet *op, struct ip *iph,
   iph->ip_off &= (~IP_MF);
 }
 
-int
-ospf_write (struct thread *thread)
+/* Send one packet from the head of the interface output queue. */
+static void
+ospf_write_packet (struct ospf *ospf, struct ospf_interface *oi,
+		   struct ospf_packet *op, u_int16_t *ipid)
 {
-  struct ospf *ospf = THREAD_ARG (thread);
-  struct ospf_interface *oi;
-  struct ospf_packet *op;
   struct sockaddr_in sa_dst;
   struct ip iph;
   struct msghdr msg;
@@ -587,31 +587,18 @@ ospf_write (struct thread *thread)
   u_char type;
   int ret;
   int flags = 0;
-  listnode node;
-
-  static u_int16_t ipid = 0;
   u_int16_t maxdatasize;
 
-  
-  ospf->t_write = NULL;
-
-  node = listhead (ospf->oi_write_q);
-  assert (node);
-  oi = getdata (node);
-  assert (oi);
-
-  /* seed ipid static with low order bits of time */
-  if (ipid == 0)
-    ipid = (time(NULL) & 0xffff);
-
   /* convenience - max OSPF data per packet */
   maxdatasize = oi->ifp->mtu - sizeof (struct ip);
-  
-  /* Get one packet from queue. */
-  op = ospf_fifo_head (oi->obuf);
-  assert (op);
+
   assert (op->length >= OSPF_HEADER_SIZE);
 
+  /* Retrieve OSPF packet type. */
+  stream_set_getp (op->s, 1);
+  type = stream_getc (op->s);
+  stream_set_getp (op->s, 0);
+
   if (op->dst.s_addr == htonl (OSPF_ALLSPFROUTERS)
       || op->dst.s_addr == htonl (OSPF_ALLDROUTERS))
     ospf_if_ipmulticast (ospf, oi->address, oi->ifp->ifindex);
@@ -645,11 +632,8 @@ ospf_write (struct thread *thread)
    * XXX: this presumes this is only programme sending OSPF packets 
    * otherwise, no guarantee ipid will be unique
    */
-  iph.ip_id = ++ipid;
+  iph.ip_id = ++(*ipid);
 
- /*
-  iph.ip_id = 0;
- */
   iph.ip_off = 0;
   if (oi->type == OSPF_IFTYPE_VIRTUALLINK)
     iph.ip_ttl = OSPF_VL_IP_TTL;
@@ -675,27 +659,22 @@ ospf_write (struct thread *thread)
                       oi->ifp->mtu, flags, type);
 
 #if ! defined(__NetBSD__) && ! defined(__FreeBSD__)
-	  iph.ip_len = htons(iph.ip_len);
-	  iph.ip_off = htons(iph.ip_off);
+  iph.ip_len = htons(iph.ip_len);
+  iph.ip_off = htons(iph.ip_off);
 #endif
-	  iph.ip_id = htons(iph.ip_id);
-  
-	  ret = sendmsg (ospf->fd, &msg, flags);
-  
+  iph.ip_id = htons(iph.ip_id);
+
+  ret = sendmsg (ospf->fd, &msg, flags);
+
 #if ! defined(__NetBSD__) && ! defined(__FreeBSD__)
-	  iph.ip_len = ntohs(iph.ip_len);
-	  iph.ip_off = ntohs(iph.ip_off);
+  iph.ip_len = ntohs(iph.ip_len);
+  iph.ip_off = ntohs(iph.ip_off);
 #endif      
-	  iph.ip_id = ntohs(iph.ip_id);
+  iph.ip_id = ntohs(iph.ip_id);
 
-  
   if (ret < 0)
     zlog_warn ("*** sendmsg in ospf_write failed with %s", strerror (errno));
 
-  /* Retrieve OSPF packet type. */
-  stream_set_getp (op->s, 1);
-  type = stream_getc (op->s);
-
   /* Show debug sending packet. */
   if (IS_DEBUG_OSPF_PACKET (type - 1, SEND))
     {
@@ -714,14 +693,57 @@ ospf_write (struct thread *thread)
       if (IS_DEBUG_OSPF_PACKET (type - 1, DETAIL))
 	zlog_info ("-----------------------------------------------------");
     }
+}
+
+/* Drain the interface output queues.  Each wakeup sends up to
+   OSPF_WRITE_INTERFACE_COUNT packets from every queued interface, so
+   a burst of LS Updates/Acks no longer costs one thread wakeup per
+   packet while a single busy interface still can't starve the others
+   or the read thread. */
+int
+ospf_write (struct thread *thread)
+{
+  struct ospf *ospf = THREAD_ARG (thread);
+  struct ospf_interface *oi;
+  struct ospf_packet *op;
+  listnode node;
+  listnode next;
+  int count;
+
+  static u_int16_t ipid = 0;
+
+  ospf->t_write = NULL;
+
+  assert (listhead (ospf->oi_write_q));
 
-  /* Now delete packet from queue. */
-  ospf_packet_delete (oi);
+  /* seed ipid static with low order bits of time */
+  if (ipid == 0)
+    ipid = (time(NULL) & 0xffff);
 
-  if (ospf_fifo_head (oi->obuf) == NULL)
+  for (node = listhead (ospf->oi_write_q); node; node = next)
     {
-      oi->on_write_q = 0;
-      list_delete_node (ospf->oi_write_q, node);
+      next = node->next;
+      oi = getdata (node);
+      assert (oi);
+
+      for (count = 0; count < OSPF_WRITE_INTERFACE_COUNT; count++)
+	{
+	  /* Get one packet from queue. */
+	  op = ospf_fifo_head (oi->obuf);
+	  if (op == NULL)
+	    break;
+
+	  ospf_write_packet (ospf, oi, op, &ipid);
+
+	  /* Now delete packet from queue. */
+	  ospf_packet_delete (oi);
+	}
+
+      if (ospf_fifo_head (oi->obuf) == NULL)
+	{
+	  oi->on_write_q = 0;
+	  list_delete_node (ospf->oi_write_q, node);
+	}
     }
   
   /* If packets still remain in queue, call write thread. */
@@ -1378,7 +1400,6 @@ ospf_ls_req (struct ip *iph, struct ospf_header *ospfh,
   struct in_addr adv_router;
   struct ospf_lsa *find;
   list ls_upd;
-  int length;
 
   /* Increment statistics. */
   oi->ls_req_in++;
@@ -1403,7 +1424,6 @@ ospf_ls_req (struct ip *iph, struct ospf_header *ospfh,
 
   /* Send Link State Update for ALL requested LSAs. */
   ls_upd = list_new ();
-  length = OSPF_HEADER_SIZE + OSPF_LS_UPD_MIN_SIZE;
 
   while (size >= OSPF_LSA_KEY_SIZE)
     {
@@ -1429,23 +1449,9 @@ ospf_ls_req (struct ip *iph, struct ospf_header *ospfh,
 	  return;
 	}
 
-      /* Packet overflows MTU size, send immediatly. */
-      if (length + ntohs (find->data->length) > OSPF_PACKET_MAX (oi))
-	{
-	  if (oi->type == OSPF_IFTYPE_NBMA)
-	    ospf_ls_upd_send (nbr, ls_upd, OSPF_SEND_PACKET_DIRECT);
-	  else
-	    ospf_ls_upd_send (nbr, ls_upd, OSPF_SEND_PACKET_INDIRECT);
-
-	  /* Only remove list contents.  Keep ls_upd. */
-	  list_delete_all_node (ls_upd);
-
-	  length = OSPF_HEADER_SIZE + OSPF_LS_UPD_MIN_SIZE;
-	}
-
-      /* Append LSA to update list. */
+      /* Append LSA to update list.  The whole list is queued at once;
+         ospf_ls_upd_queue_send () packs it into MTU sized packets. */
       listnode_add (ls_upd, find);
-      length += ntohs (find->data->length);
 
       size -= OSPF_LSA_KEY_SIZE;
     }
@@ -1882,7 +1888,7 @@ ospf_ls_upd (struct ip *iph, struct ospf_header *ospfh,
 		 from Designated Router, otherwise do nothing. */
 	      if (oi->state == ISM_Backup)
 		if (NBR_IS_DR (nbr))
-		  listnode_add (oi->ls_ack, ospf_lsa_lock (lsa));
+		  ospf_ls_ack_add_delayed (oi, lsa);
 
               DISCARD_LSA (lsa, 5);
 	    }
@@ -2841,7 +2847,12 @@ ospf_make_ls_upd (struct ospf_interface *oi, list update, struct stream *s)
       assert (lsa);
       assert (lsa->data);
 
-      /* Check packet size. */
+      /* Check packet size.  Keep adding LSAs until the packet would
+         no longer fit in one IP datagram on this interface; only a
+         single oversized LSA is allowed to go out fragmented. */
+      if (count > 0
+	  && length + delta + ntohs (lsa->data->length) > OSPF_PACKET_MAX (oi))
+	break;
       if (length + delta + ntohs (lsa->data->length) > stream_get_size (s))
 	break;
       
@@ -3481,3 +3492,18 @@ ospf_ls_ack_send_delayed (struct ospf_interface *oi)
   while (listcount (oi->ls_ack))
     ospf_ls_ack_send_list (oi, oi->ls_ack, dst);
 }
+
+/* Queue an LSA header for delayed acknowledgment.  Acks are held for
+   the interface ack-delay window so they go out packed together, but
+   once a full packet's worth is pending there is nothing to gain by
+   waiting any longer. */
+void
+ospf_ls_ack_add_delayed (struct ospf_interface *oi, struct ospf_lsa *lsa)
+{
+  listnode_add (oi->ls_ack, ospf_lsa_lock (lsa));
+
+  if (OSPF_HEADER_SIZE + OSPF_LS_ACK_MIN_SIZE
+      + (listcount (oi->ls_ack) + 1) * OSPF_LSA_HEADER_SIZE
+      > OSPF_PACKET_MAX (oi))
+    ospf_ls_ack_send_delayed (oi);
+}
@@ -34,6 +34,9 @@
 #define OSPF_LS_UPD_MIN_SIZE      4
 #define OSPF_LS_ACK_MIN_SIZE      0
 
+/* Packets sent per interface on each ospf_write () wakeup. */
+#define OSPF_WRITE_INTERFACE_COUNT  64
+
 #define OSPF_MSG_HELLO         1  /* OSPF Hello Message. */
 #define OSPF_MSG_DB_DESC       2  /* OSPF Database Descriptoin Message. */
 #define OSPF_MSG_LS_REQ        3  /* OSPF Link State Request Message. */
@@ -159,6 +162,7 @@ void ospf_ls_upd_send_lsa (struct ospf_neighbor *, struct ospf_lsa *, int);
 void ospf_ls_upd_send (struct ospf_neighbor *, list, int);
 void ospf_ls_ack_send (struct ospf_neighbor *, struct ospf_lsa *);
 void ospf_ls_ack_send_delayed (struct ospf_interface *);
+void ospf_ls_ack_add_delayed (struct ospf_interface *, struct ospf_lsa *);
 void ospf_ls_retransmit (struct ospf_interface *, struct ospf_lsa *);
 void ospf_ls_req_event (struct ospf_neighbor *);
 
@@ -99,6 +99,24 @@ ospf_path_free (struct ospf_path *op)
   XFREE (MTYPE_OSPF_PATH, op);
 }
 
+/* Copy a route together with its paths. */
+struct ospf_route *
+ospf_route_dup (struct ospf_route *or)
+{
+  struct ospf_route *new;
+  listnode node;
+
+  new = ospf_route_new ();
+  memcpy (new, or, sizeof (struct ospf_route));
+
+  new->path = list_new ();
+  if (or->path)
+    for (node = listhead (or->path); node; nextnode (node))
+      listnode_add (new->path, ospf_path_dup (getdata (node)));
+
+  return new;
+}
+
 void
 ospf_route_delete (struct route_table *rt)
 {
@@ -134,6 +152,26 @@ ospf_route_table_free (struct route_table *rt)
    route_table_finish (rt);
 }
 
+/* Copy a network routing table. */
+struct route_table *
+ospf_route_table_dup (struct route_table *rt)
+{
+  struct route_table *new;
+  struct route_node *rn;
+  struct route_node *rn_new;
+
+  new = route_table_init ();
+
+  for (rn = route_top (rt); rn; rn = route_next (rn))
+    if (rn->info)
+      {
+	rn_new = route_node_get (new, &rn->p);
+	rn_new->info = ospf_route_dup (rn->info);
+      }
+
+  return new;
+}
+
 /* If a prefix and a nexthop match any route in the routing table,
    then return 1, otherwise return 0. */
 int
@@ -128,6 +128,8 @@ void ospf_path_free (struct ospf_path *);
 struct ospf_path *ospf_path_lookup (list, struct ospf_path *);
 struct ospf_route *ospf_route_new ();
 void ospf_route_free (struct ospf_route *);
+struct ospf_route *ospf_route_dup (struct ospf_route *);
+struct route_table *ospf_route_table_dup (struct route_table *);
 void ospf_route_delete (struct route_table *);
 void ospf_route_table_free (struct route_table *);
 
@@ -831,6 +831,31 @@ ospf_rtrs_free (struct route_table *rtrs)
   route_table_finish (rtrs);
 }
 
+/* Copy an ABR/ASBR routing table, whose nodes hold lists of routes. */
+struct route_table *
+ospf_rtrs_dup (struct route_table *rtrs)
+{
+  struct route_table *new;
+  struct route_node *rn;
+  struct route_node *rn_new;
+  list or_list;
+  listnode node;
+
+  new = route_table_init ();
+
+  for (rn = route_top (rtrs); rn; rn = route_next (rn))
+    if ((or_list = rn->info) != NULL)
+      {
+	rn_new = route_node_get (new, &rn->p);
+	rn_new->info = list_new ();
+
+	for (node = listhead (or_list); node; nextnode (node))
+	  listnode_add (rn_new->info, ospf_route_dup (getdata (node)));
+      }
+
+  return new;
+}
+
 void
 ospf_rtrs_print (struct route_table *rtrs)
 {
@@ -1007,31 +1032,12 @@ ospf_spf_calculate (struct ospf_area *area, struct route_table *new_table,
     zlog_info ("ospf_spf_calculate: Stop");
 }
  
-/* Timer for SPF calculation. */
-int
-ospf_spf_calculate_timer (struct thread *thread)
+/* Complete a routing table calculation once the intra-area routes of
+   every area are in new_table and new_rtrs. */
+static void
+ospf_spf_calculate_finish (struct ospf *ospf, struct route_table *new_table,
+			   struct route_table *new_rtrs)
 {
-  struct ospf *ospf = THREAD_ARG (thread);
-  struct route_table *new_table, *new_rtrs;
-  listnode node;
-
-  if (IS_DEBUG_OSPF_EVENT)
-    zlog_info ("SPF: Timer (SPF calculation expire)");
-  
-  ospf->t_spf_calc = NULL;
-
-  /* Allocate new table tree. */
-  new_table = route_table_init ();
-  new_rtrs  = route_table_init ();
-
-  ospf_vl_unapprove (ospf);
-
-  /* Calculate SPF for each area. */
-  for (node = listhead (ospf->areas); node; node = nextnode (node))
-    ospf_spf_calculate (node->data, new_table, new_rtrs);
-
-  ospf_vl_shut_unapproved (ospf);
-
   ospf_ia_routing (ospf, new_table, new_rtrs);
 
   ospf_prune_unreachable_networks (new_table);
@@ -1065,24 +1071,133 @@ ospf_spf_calculate_timer (struct thread *thread)
 
   if (IS_DEBUG_OSPF_EVENT)
     zlog_info ("SPF: calculation complete");
+}
+
+/* Abandon a full SPF run that has not gone through every area yet. */
+static void
+ospf_spf_calculate_cancel (struct ospf *ospf)
+{
+  OSPF_TIMER_OFF (ospf->t_spf_area);
+
+  if (ospf->spf_new_table)
+    ospf_route_table_free (ospf->spf_new_table);
+  if (ospf->spf_new_rtrs)
+    ospf_rtrs_free (ospf->spf_new_rtrs);
+  ospf->spf_new_table = NULL;
+  ospf->spf_new_rtrs = NULL;
+}
+
+/* Background step of a full SPF run.  The shortest-path tree of a
+   single area is calculated per step, so that hello and retransmission
+   timers and received packets are serviced between areas instead of
+   waiting for the whole routing table. */
+static int
+ospf_spf_calculate_area_event (struct thread *thread)
+{
+  struct ospf *ospf = THREAD_ARG (thread);
+  struct route_table *new_table, *new_rtrs;
+  listnode node;
+  int i;
+
+  ospf->t_spf_area = NULL;
+
+  for (i = 0, node = listhead (ospf->areas);
+       node && i < ospf->spf_area_next; nextnode (node))
+    i++;
+
+  if (node != NULL)
+    {
+      ospf_spf_calculate (getdata (node), ospf->spf_new_table,
+			  ospf->spf_new_rtrs);
+      ospf->spf_area_next++;
+      ospf->t_spf_area =
+	thread_add_background (master, ospf_spf_calculate_area_event, ospf);
+      return 0;
+    }
+
+  new_table = ospf->spf_new_table;
+  new_rtrs = ospf->spf_new_rtrs;
+  ospf->spf_new_table = NULL;
+  ospf->spf_new_rtrs = NULL;
+
+  ospf_vl_shut_unapproved (ospf);
+
+  /* Keep the intra-area result for later summary-only changes. */
+  if (ospf->intra_table)
+    ospf_route_table_free (ospf->intra_table);
+  if (ospf->intra_rtrs)
+    ospf_rtrs_free (ospf->intra_rtrs);
+  ospf->intra_table = ospf_route_table_dup (new_table);
+  ospf->intra_rtrs = ospf_rtrs_dup (new_rtrs);
+
+  ospf_spf_calculate_finish (ospf, new_table, new_rtrs);
+
+  return 0;
+}
+
+/* Timer for SPF calculation. */
+int
+ospf_spf_calculate_timer (struct thread *thread)
+{
+  struct ospf *ospf = THREAD_ARG (thread);
+
+  if (IS_DEBUG_OSPF_EVENT)
+    zlog_info ("SPF: Timer (SPF calculation expire)");
+  
+  ospf->t_spf_calc = NULL;
+
+  /* A run still going through the areas is based on an outdated
+     database; start over. */
+  if (ospf->t_spf_area)
+    {
+      if (IS_DEBUG_OSPF_EVENT)
+	zlog_info ("SPF: restarting calculation in progress");
+      ospf_spf_calculate_cancel (ospf);
+      ospf->spf_ia_only = 0;
+    }
+
+  if (ospf->spf_ia_only && ospf->intra_table && ospf->intra_rtrs)
+    {
+      /* Only summary-LSAs changed since the last run.  The shortest-path
+	 trees still hold, so start from the intra-area routes they gave
+	 and redo just the inter-area part -- RFC 2328 Section 16.5. */
+      if (IS_DEBUG_OSPF_EVENT)
+	zlog_info ("SPF: inter-area only calculation");
+
+      ospf->spf_ia_only = 0;
+      ospf->spf_ia_calculation++;
+
+      ospf_spf_calculate_finish (ospf, ospf_route_table_dup (ospf->intra_table),
+				 ospf_rtrs_dup (ospf->intra_rtrs));
+      return 0;
+    }
+
+  ospf->spf_ia_only = 0;
+
+  /* Allocate new table tree. */
+  ospf->spf_new_table = route_table_init ();
+  ospf->spf_new_rtrs  = route_table_init ();
+  ospf->spf_area_next = 0;
+
+  ospf_vl_unapprove (ospf);
+
+  /* Calculate SPF for each area, one per background step. */
+  ospf->t_spf_area =
+    thread_add_background (master, ospf_spf_calculate_area_event, ospf);
 
   return 0;
 }
 
 /* Add schedule for SPF calculation.  To avoid frequenst SPF calc, we
    set timer for SPF calc. */
-void
-ospf_spf_calculate_schedule (struct ospf *ospf)
+static void
+ospf_spf_schedule (struct ospf *ospf)
 {
   time_t ht, delay;
 
   if (IS_DEBUG_OSPF_EVENT)
     zlog_info ("SPF: calculation timer scheduled");
 
-  /* OSPF instance does not exist. */
-  if (ospf == NULL)
-    return;
-
   /* SPF calculation timer is already scheduled. */
   if (ospf->t_spf_calc)
     {
@@ -1111,3 +1226,44 @@ ospf_spf_calculate_schedule (struct ospf *ospf)
     thread_add_timer (master, ospf_spf_calculate_timer, ospf, delay);
 }
 
+/* Schedule a full routing table calculation, starting with the
+   shortest-path trees of every area -- router/network-LSA changes. */
+void
+ospf_spf_calculate_schedule (struct ospf *ospf)
+{
+  /* OSPF instance does not exist. */
+  if (ospf == NULL)
+    return;
+
+  ospf->spf_ia_only = 0;
+  ospf_spf_schedule (ospf);
+}
+
+/* An area was added or removed.  The background steps of a full run
+   go through the area list by position, so start such a run over. */
+void
+ospf_spf_areas_changed (struct ospf *ospf)
+{
+  if (ospf->t_spf_area == NULL)
+    return;
+
+  if (IS_DEBUG_OSPF_EVENT)
+    zlog_info ("SPF: area list changed, restarting calculation");
+
+  ospf_spf_calculate_cancel (ospf);
+  ospf_spf_calculate_schedule (ospf);
+}
+
+/* Schedule recalculation of inter-area routes only -- summary-LSA
+   changes.  A full calculation already pending takes precedence. */
+void
+ospf_spf_ia_calculate_schedule (struct ospf *ospf)
+{
+  /* OSPF instance does not exist. */
+  if (ospf == NULL)
+    return;
+
+  if (ospf->t_spf_calc == NULL && ospf->t_spf_area == NULL)
+    ospf->spf_ia_only = 1;
+  ospf_spf_schedule (ospf);
+}
@@ -45,7 +45,10 @@ struct vertex_nexthop
 };
 
 void ospf_spf_calculate_schedule (struct ospf *);
+void ospf_spf_ia_calculate_schedule (struct ospf *);
+void ospf_spf_areas_changed (struct ospf *);
 void ospf_rtrs_free (struct route_table *);
+struct route_table *ospf_rtrs_dup (struct route_table *);
 void ospf_nexthop_add_unique (struct vertex_nexthop *new, list nexthop);
 void ospf_install_candidate (list candidate, struct vertex *w);
 void ospf_spf_init (struct ospf_area *area);
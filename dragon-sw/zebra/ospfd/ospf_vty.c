@@ -41,6 +41,7 @@
 #include "ospfd/ospf_te_lsdb.h"
 #include "ospfd/ospf_interface.h"
 #include "ospfd/ospf_nsm.h"
+#include "ospfd/ospf_packet.h"
 #include "ospfd/ospf_neighbor.h"
 #include "ospfd/ospf_flood.h"
 #include "ospfd/ospf_abr.h"
@@ -2474,10 +2475,16 @@ DEFUN (show_ip_ospf,
   /* Show SPF timers. */
   vty_out (vty, " SPF schedule delay %d secs, Hold time between two SPFs %d secs%s",
 	   ospf->spf_delay, ospf->spf_holdtime, VTY_NEWLINE);
+  vty_out (vty, " Inter-area only route calculations %u%s",
+	   ospf->spf_ia_calculation, VTY_NEWLINE);
 
   /* Show refresh parameters. */
   vty_out (vty, " Refresh timer %d secs%s",
 	   ospf->lsa_refresh_interval, VTY_NEWLINE);
+
+  /* Show retransmission queue depth. */
+  vty_out (vty, " Number of LSAs awaiting retransmission %lu, peak %lu%s",
+	   ospf->ls_rxmt_count, ospf->ls_rxmt_peak, VTY_NEWLINE);
 	   
   /* Show ABR/ASBR flags. */
   if (CHECK_FLAG (ospf->flags, OSPF_FLAG_ABR))
@@ -2598,10 +2605,11 @@ show_ip_ospf_interface_sub (struct vty *vty, struct ospf *ospf,
 	    }
 	}
       vty_out (vty, "  Timer intervals configured,");
-      vty_out (vty, " Hello %d, Dead %d, Wait %d, Retransmit %d%s",
+      vty_out (vty, " Hello %d, Dead %d, Wait %d, Retransmit %d, Ack %d%s",
 	       OSPF_IF_PARAM (oi, v_hello), OSPF_IF_PARAM (oi, v_wait),
 	       OSPF_IF_PARAM (oi, v_wait),
 	       OSPF_IF_PARAM (oi, retransmit_interval),
+	       OSPF_IF_PARAM (oi, v_ls_ack),
 	       VTY_NEWLINE);
       
       if (OSPF_IF_PARAM (oi, passive_interface) == OSPF_IF_ACTIVE)
@@ -2877,8 +2885,8 @@ show_ip_ospf_neighbor_detail_sub (struct vty *vty, struct ospf_interface *oi,
   vty_out (vty, "    Link State Request List %ld%s",
 	   ospf_ls_request_count (nbr), VTY_NEWLINE);
   /* Show Link State Retransmission list. */
-  vty_out (vty, "    Link State Retransmission List %ld%s",
-	   ospf_ls_retransmit_count (nbr), VTY_NEWLINE);
+  vty_out (vty, "    Link State Retransmission List %ld, peak %lu%s",
+	   ospf_ls_retransmit_count (nbr), nbr->ls_rxmt_peak, VTY_NEWLINE);
   /* Show inactivity timer thread. */
   vty_out (vty, "    Thread Inactivity Timer %s%s", 
 	   nbr->t_inactivity != NULL ? "on" : "off", VTY_NEWLINE);
@@ -5167,6 +5175,141 @@ ALIAS (no_ip_ospf_retransmit_interval,
        "OSPF interface commands\n"
        "Time between retransmitting lost link state advertisements\n");
 
+static void
+ospf_ls_ack_timer_update (struct interface *ifp)
+{
+  struct route_node *rn;
+  struct ospf_interface *oi;
+
+  /* Re-arm a running delayed ack timer with the new window. */
+  for (rn = route_top (IF_OIFS (ifp)); rn; rn = route_next (rn))
+    if ((oi = rn->info) && oi->t_ls_ack)
+      {
+	OSPF_ISM_TIMER_OFF (oi->t_ls_ack);
+	OSPF_ISM_TIMER_ON (oi->t_ls_ack, ospf_ls_ack_timer,
+			   OSPF_IF_PARAM (oi, v_ls_ack));
+      }
+}
+
+DEFUN (ip_ospf_ack_delay,
+       ip_ospf_ack_delay_addr_cmd,
+       "ip ospf ack-delay <1-65535> A.B.C.D",
+       "IP Information\n"
+       "OSPF interface commands\n"
+       "Window for aggregating delayed link state acknowledgments\n"
+       "Seconds\n"
+       "Address of interface")
+{
+  struct interface *ifp = vty->index;
+  u_int32_t seconds;
+  struct in_addr addr;
+  int ret;
+  struct ospf_if_params *params;
+      
+  params = IF_DEF_PARAMS (ifp);
+  seconds = strtol (argv[0], NULL, 10);
+
+  /* Ack Delay range is <1-65535>. */
+  if (seconds < 1 || seconds > 65535)
+    {
+      vty_out (vty, "Ack Delay is invalid%s", VTY_NEWLINE);
+      return CMD_WARNING;
+    }
+
+  if (argc == 2)
+    {
+      ret = inet_aton(argv[1], &addr);
+      if (!ret)
+	{
+	  vty_out (vty, "Please specify interface address by A.B.C.D%s",
+		   VTY_NEWLINE);
+	  return CMD_WARNING;
+	}
+
+      params = ospf_get_if_params (ifp, addr);
+      ospf_if_update_params (ifp, addr);
+    }
+
+  /* RFC 2328 Section 13.5: delayed acks must go out before the
+     neighbor's retransmission of the LSA. */
+  if (seconds >= (OSPF_IF_PARAM_CONFIGURED (params, retransmit_interval) ?
+		  params->retransmit_interval :
+		  IF_DEF_PARAMS (ifp)->retransmit_interval))
+    {
+      vty_out (vty, "Ack Delay must be less than Retransmit Interval%s",
+	       VTY_NEWLINE);
+      return CMD_WARNING;
+    }
+
+  SET_IF_PARAM (params, v_ls_ack);
+  params->v_ls_ack = seconds;
+
+  ospf_ls_ack_timer_update (ifp);
+
+  return CMD_SUCCESS;
+}
+
+ALIAS (ip_ospf_ack_delay,
+       ip_ospf_ack_delay_cmd,
+       "ip ospf ack-delay <1-65535>",
+       "IP Information\n"
+       "OSPF interface commands\n"
+       "Window for aggregating delayed link state acknowledgments\n"
+       "Seconds\n");
+
+DEFUN (no_ip_ospf_ack_delay,
+       no_ip_ospf_ack_delay_addr_cmd,
+       "no ip ospf ack-delay A.B.C.D",
+       NO_STR
+       "IP Information\n"
+       "OSPF interface commands\n"
+       "Window for aggregating delayed link state acknowledgments\n"
+       "Address of interface")
+{
+  struct interface *ifp = vty->index;
+  struct in_addr addr;
+  int ret;
+  struct ospf_if_params *params;
+  
+  params = IF_DEF_PARAMS (ifp);
+
+  if (argc == 1)
+    {
+      ret = inet_aton(argv[0], &addr);
+      if (!ret)
+	{
+	  vty_out (vty, "Please specify interface address by A.B.C.D%s",
+		   VTY_NEWLINE);
+	  return CMD_WARNING;
+	}
+
+      params = ospf_lookup_if_params (ifp, addr);
+      if (params == NULL)
+	return CMD_SUCCESS;
+    }
+
+  UNSET_IF_PARAM (params, v_ls_ack);
+  params->v_ls_ack = OSPF_LS_ACK_DELAY_DEFAULT;
+
+  if (params != IF_DEF_PARAMS (ifp))
+    {
+      ospf_free_if_params (ifp, addr);
+      ospf_if_update_params (ifp, addr);
+    }
+
+  ospf_ls_ack_timer_update (ifp);
+
+  return CMD_SUCCESS;
+}
+
+ALIAS (no_ip_ospf_ack_delay,
+       no_ip_ospf_ack_delay_cmd,
+       "no ip ospf ack-delay",
+       NO_STR
+       "IP Information\n"
+       "OSPF interface commands\n"
+       "Window for aggregating delayed link state acknowledgments\n");
+
 DEFUN (ip_ospf_transmit_delay,
        ip_ospf_transmit_delay_addr_cmd,
        "ip ospf transmit-delay <1-65535> A.B.C.D",
@@ -6853,6 +6996,16 @@ config_write_interface (struct vty *vty)
 	    vty_out (vty, "%s", VTY_NEWLINE);
 	  }
 	
+	/* Ack Delay print. */
+	if (OSPF_IF_PARAM_CONFIGURED (params, v_ls_ack) &&
+	    params->v_ls_ack != OSPF_LS_ACK_DELAY_DEFAULT)
+	  {
+	    vty_out (vty, " ip ospf ack-delay %u", params->v_ls_ack);
+	    if (params != IF_DEF_PARAMS (ifp))
+	      vty_out (vty, " %s", inet_ntoa (rn->p.u.prefix4));
+	    vty_out (vty, "%s", VTY_NEWLINE);
+	  }
+	
 	/* Transmit Delay print. */
 	if (OSPF_IF_PARAM_CONFIGURED (params, transmit_delay) &&
 	    params->transmit_delay != OSPF_TRANSMIT_DELAY_DEFAULT)
@@ -7439,6 +7592,10 @@ ospf_vty_if_init ()
   install_element (INTERFACE_NODE, &ip_ospf_retransmit_interval_cmd);
   install_element (INTERFACE_NODE, &no_ip_ospf_retransmit_interval_addr_cmd);
   install_element (INTERFACE_NODE, &no_ip_ospf_retransmit_interval_cmd);
+  install_element (INTERFACE_NODE, &ip_ospf_ack_delay_addr_cmd);
+  install_element (INTERFACE_NODE, &ip_ospf_ack_delay_cmd);
+  install_element (INTERFACE_NODE, &no_ip_ospf_ack_delay_addr_cmd);
+  install_element (INTERFACE_NODE, &no_ip_ospf_ack_delay_cmd);
 
   /* "ip ospf transmit-delay" commands. */
   install_element (INTERFACE_NODE, &ip_ospf_transmit_delay_addr_cmd);
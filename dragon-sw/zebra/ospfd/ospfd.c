@@ -418,6 +418,7 @@ ospf_finish (struct ospf *ospf)
   OSPF_TIMER_OFF (ospf->t_router_id_update);
   OSPF_TIMER_OFF (ospf->t_router_lsa_update);
   OSPF_TIMER_OFF (ospf->t_spf_calc);
+  OSPF_TIMER_OFF (ospf->t_spf_area);
   OSPF_TIMER_OFF (ospf->t_ase_calc);
   OSPF_TIMER_OFF (ospf->t_maxage);
   OSPF_TIMER_OFF (ospf->t_maxage_walker);
@@ -455,6 +456,14 @@ ospf_finish (struct ospf *ospf)
     ospf_rtrs_free (ospf->old_rtrs);
   if (ospf->new_rtrs)
     ospf_rtrs_free (ospf->new_rtrs);
+  if (ospf->intra_table)
+    ospf_route_table_free (ospf->intra_table);
+  if (ospf->intra_rtrs)
+    ospf_rtrs_free (ospf->intra_rtrs);
+  if (ospf->spf_new_table)
+    ospf_route_table_free (ospf->spf_new_table);
+  if (ospf->spf_new_rtrs)
+    ospf_rtrs_free (ospf->spf_new_rtrs);
   if (ospf->new_external_route)
     {
       ospf_route_delete (ospf->new_external_route);
@@ -611,6 +620,7 @@ ospf_area_check_free (struct ospf *ospf, struct in_addr area_id)
     {
       listnode_delete (ospf->areas, area);
       ospf_area_free (area);
+      ospf_spf_areas_changed (ospf);
     }
 }
 
@@ -625,6 +635,7 @@ ospf_area_get (struct ospf *ospf, struct in_addr area_id, int format)
       area = ospf_area_new (ospf, area_id);
       area->format = format;
       listnode_add_sort (ospf->areas, area);
+      ospf_spf_areas_changed (ospf);
       ospf_check_abr_status (ospf);  
     }
 
@@ -99,6 +99,9 @@
 #define OSPF_ROUTER_PRIORITY_DEFAULT        1
 #define OSPF_RETRANSMIT_INTERVAL_DEFAULT    5
 #define OSPF_TRANSMIT_DELAY_DEFAULT         1
+/* Delayed Ack window.  This must be short, (less than RxmtInterval)
+   - RFC 2328 Section 13.5 para 3. */
+#define OSPF_LS_ACK_DELAY_DEFAULT           1
 #define OSPF_DEFAULT_BANDWIDTH		 10000	/* Kbps */
 
 #define OSPF_DEFAULT_REF_BANDWIDTH	100000  /* Kbps */
@@ -220,6 +223,16 @@ struct ospf
   struct route_table *old_rtrs;         /* Old ABR/ASBR RT. */
   struct route_table *new_rtrs;         /* New ABR/ASBR RT. */
 
+  /* Intra-area result of the last full SPF run, reused when only
+     summary-LSAs have changed. */
+  struct route_table *intra_table;      /* Intra-area network RT. */
+  struct route_table *intra_rtrs;       /* Intra-area ABR/ASBR RT. */
+
+  /* Full SPF run in progress, one area per background step. */
+  struct route_table *spf_new_table;    /* Network RT being built. */
+  struct route_table *spf_new_rtrs;     /* ABR/ASBR RT being built. */
+  int spf_area_next;                    /* Index of the next area. */
+
   struct route_table *new_external_route;   /* New External Route. */
   struct route_table *old_external_route;   /* Old External Route. */
   
@@ -229,7 +242,12 @@ struct ospf
   /* Time stamps. */
   time_t ts_spf;			/* SPF calculation time stamp. */
 
+  int spf_ia_only;			/* Pending calc is inter-area only. */
+  u_int32_t spf_ia_calculation;		/* Inter-area only calc counter. */
+
   list maxage_lsa;                      /* List of MaxAge LSA for deletion. */
+  unsigned long ls_rxmt_count;		/* LSAs on all retransmission lists. */
+  unsigned long ls_rxmt_peak;		/* High-water of ls_rxmt_count. */
   int redistribute;                     /* Num of redistributed protocols. */
 
   /* Threads. */
@@ -239,6 +257,7 @@ struct ospf
   struct thread *t_asbr_check;          /* ASBR check timer. */
   struct thread *t_distribute_update;   /* Distirbute list update timer. */
   struct thread *t_spf_calc;	        /* SPF calculation timer. */
+  struct thread *t_spf_area;		/* SPF next area step. */
   struct thread *t_ase_calc;		/* ASE calculation timer. */
   struct thread *t_external_lsa;	/* AS-external-LSA origin timer. */
 #ifdef HAVE_OPAQUE_LSA
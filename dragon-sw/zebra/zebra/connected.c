@@ -84,7 +84,7 @@ connected_up_ipv4 (struct interface *ifp, struct connected *ifc)
 
   rib_add_ipv4 (ZEBRA_ROUTE_CONNECT, 0, &p, NULL, ifp->ifindex, 0, 0, 0);
 
-  rib_update ();
+  rib_update_connected (ifp, (struct prefix *) &p);
 }
 
 /* Add connected IPv4 route to the interface. */
@@ -177,7 +177,7 @@ connected_down_ipv4 (struct interface *ifp, struct connected *ifc)
 
   rib_delete_ipv4 (ZEBRA_ROUTE_CONNECT, 0, &p, NULL, ifp->ifindex, 0);
 
-  rib_update ();
+  rib_update_connected (ifp, (struct prefix *) &p);
 }
 
 /* Delete connected IPv4 route to the interface. */
@@ -267,7 +267,7 @@ connected_up_ipv6 (struct interface *ifp, struct connected *ifc)
 
   rib_add_ipv6 (ZEBRA_ROUTE_CONNECT, 0, &p, NULL, ifp->ifindex, 0);
 
-  rib_update ();
+  rib_update_connected (ifp, (struct prefix *) &p);
 }
 
 /* Add connected IPv6 route to the interface. */
@@ -356,7 +356,7 @@ connected_down_ipv6 (struct interface *ifp, struct connected *ifc)
 
   rib_delete_ipv6 (ZEBRA_ROUTE_CONNECT, 0, &p, NULL, ifp->ifindex, 0);
 
-  rib_update ();
+  rib_update_connected (ifp, (struct prefix *) &p);
 }
 
 void
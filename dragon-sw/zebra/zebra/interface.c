@@ -284,8 +284,8 @@ if_up (struct interface *ifp)
 	}
     }
 
-  /* Examine all static routes. */
-  rib_update ();
+  /* Examine the routes which may resolve through the interface now. */
+  rib_if_up (ifp);
 }
 
 /* Interface goes down.  We have to manage different behavior of based
@@ -319,8 +319,8 @@ if_down (struct interface *ifp)
 	}
     }
 
-  /* Examine all static routes which direct to the interface. */
-  rib_update ();
+  /* Examine all routes which direct to the interface. */
+  rib_if_down (ifp);
 }
 
 void
@@ -103,7 +103,8 @@ zebra_redistribute_default (struct zserv *client)
 	{
 	  for (newrib = rn->info; newrib; newrib = newrib->next)
 	    if (CHECK_FLAG (newrib->flags, ZEBRA_FLAG_SELECTED)
-		&& newrib->distance != DISTANCE_INFINITY)
+		&& newrib->distance != DISTANCE_INFINITY
+		&& ! CHECK_FLAG (newrib->status, RIB_ENTRY_REMOVED))
 	      zsend_ipv4_add_multipath (client, &rn->p, newrib);
 	  route_unlock_node (rn);
 	}
@@ -123,7 +124,8 @@ zebra_redistribute_default (struct zserv *client)
 	{
 	  for (newrib = rn->info; newrib; newrib = newrib->next)
 	    if (CHECK_FLAG (newrib->flags, ZEBRA_FLAG_SELECTED)
-		&& newrib->distance != DISTANCE_INFINITY)
+		&& newrib->distance != DISTANCE_INFINITY
+		&& ! CHECK_FLAG (newrib->status, RIB_ENTRY_REMOVED))
 	      zsend_ipv6_add_multipath (client, &rn->p, newrib);
 	  route_unlock_node (rn);
 	}
@@ -146,6 +148,7 @@ zebra_redistribute (struct zserv *client, int type)
 	if (CHECK_FLAG (newrib->flags, ZEBRA_FLAG_SELECTED) 
 	    && newrib->type == type 
 	    && newrib->distance != DISTANCE_INFINITY
+	    && ! CHECK_FLAG (newrib->status, RIB_ENTRY_REMOVED)
 	    && zebra_check_addr (&rn->p))
 	  zsend_ipv4_add_multipath (client, &rn->p, newrib);
   
@@ -157,6 +160,7 @@ zebra_redistribute (struct zserv *client, int type)
 	if (CHECK_FLAG (newrib->flags, ZEBRA_FLAG_SELECTED)
 	    && newrib->type == type 
 	    && newrib->distance != DISTANCE_INFINITY
+	    && ! CHECK_FLAG (newrib->status, RIB_ENTRY_REMOVED)
 	    && zebra_check_addr (&rn->p))
 	  zsend_ipv6_add_multipath (client, &rn->p, newrib);
 #endif /* HAVE_IPV6 */
@@ -45,6 +45,17 @@ struct rib
      ZEBRA_FLAG_* */
   u_char flags;
 
+  /* Processing state of this route. */
+  u_char status;
+#define RIB_ENTRY_REMOVED	(1 << 0)
+
+  /* Processing state of the route node, kept in its first rib. */
+  u_char rn_status;
+#define RIB_ROUTE_QUEUED	(1 << 0)
+
+  /* What the node's nexthops resolve through, kept in its first rib. */
+  struct list *nh_deps;
+
   /* Metric */
   u_int32_t metric;
 
@@ -211,6 +222,10 @@ struct rib *
 rib_lookup_ipv4 (struct prefix_ipv4 *);
 
 void rib_update ();
+void rib_update_connected (struct interface *, struct prefix *);
+void rib_if_up (struct interface *);
+void rib_if_down (struct interface *);
+void rib_kernel_install_failed (struct prefix *);
 void rib_sweep_route ();
 void rib_close ();
 void rib_init ();
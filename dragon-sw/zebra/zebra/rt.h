@@ -29,6 +29,11 @@ int kernel_add_route (struct prefix_ipv4 *, struct in_addr *, int, int);
 int kernel_address_add_ipv4 (struct interface *, struct connected *);
 int kernel_address_delete_ipv4 (struct interface *, struct connected *);
 
+#ifdef HAVE_NETLINK
+int kernel_replace_ipv4 (struct prefix *, struct rib *);
+void kernel_route_flush ();
+#endif /* HAVE_NETLINK */
+
 #ifdef HAVE_IPV6
 int kernel_add_ipv6 (struct prefix *, struct rib *);
 int kernel_delete_ipv6 (struct prefix *, struct rib *);
@@ -33,6 +33,7 @@
 #include "connected.h"
 #include "table.h"
 #include "rib.h"
+#include "thread.h"
 
 #include "zebra/zserv.h"
 #include "zebra/redistribute.h"
@@ -66,6 +67,10 @@ struct message nlmsg_str[] =
 
 extern int rtm_table_default;
 
+extern struct thread_master *master;
+
+static void netlink_batch_sync (void);
+
 /* Make socket for Linux netlink interface. */
 static int
 netlink_socket (struct nlsock *nl, unsigned long groups)
@@ -143,6 +148,10 @@ netlink_request (int family, int type, struct nlsock *nl)
       return -1;
     }
 
+  /* The reply must not be mixed up with queued route acknowledgements. */
+  if (nl == &netlink_cmd)
+    netlink_batch_sync ();
+
   memset (&snl, 0, sizeof snl);
   snl.nl_family = AF_NETLINK;
 
@@ -1000,6 +1009,9 @@ netlink_talk (struct nlmsghdr *n, struct nlsock *nl)
   struct msghdr msg = {(void*) &snl, sizeof snl, &iov, 1, NULL, 0, 0};
   int flags = 0;
   
+  if (nl == &netlink_cmd)
+    netlink_batch_sync ();
+
   memset (&snl, 0, sizeof snl);
   snl.nl_family = AF_NETLINK;
   
@@ -1055,6 +1067,280 @@ netlink_talk (struct nlmsghdr *n, struct nlsock *nl)
   return status;
 }
 
+/* IPv4 route changes for the command socket are queued here and
+   written to the kernel with a single sendmsg() per batch.  Each
+   message asks for an acknowledgement; the acknowledgements are read
+   by kernel_batch_read() and matched with the queued routes by
+   sequence number, so zebra never blocks on a route change. */
+#define NL_BATCH_SIZE        32768
+#define NL_BATCH_PENDING_MAX  1024
+#define NL_BATCH_SYNC_TIMEOUT    5
+
+struct nl_batch_route
+{
+  u_int32_t seq;
+  u_int16_t type;		/* 0 if the slot is free */
+  struct prefix p;
+};
+
+static struct
+{
+  char buf[NL_BATCH_SIZE];
+  int len;
+
+  /* Messages waiting for their acknowledgement, indexed by sequence
+     number.  Batched sequence numbers are consecutive because the
+     batch is drained before any other request is sent. */
+  struct nl_batch_route pending[NL_BATCH_PENDING_MAX];
+  int count;
+
+  struct thread *t_flush;
+  struct thread *t_read;
+} nl_batch;
+
+static void
+netlink_batch_ack (u_int32_t seq, int error)
+{
+  struct nl_batch_route *route;
+  char buf[BUFSIZ];
+  int i;
+
+  route = &nl_batch.pending[seq % NL_BATCH_PENDING_MAX];
+  if (route->type == 0 || route->seq != seq)
+    return;
+
+  if (error)
+    {
+      zlog (NULL, LOG_ERR, "%s error: %s, type=%s, %s/%d, seq=%u",
+	    netlink_cmd.name, strerror (-error),
+	    lookup (nlmsg_str, route->type),
+	    inet_ntop (route->p.family, &route->p.u.prefix, buf, BUFSIZ),
+	    route->p.prefixlen, seq);
+
+      /* Unless a later change of the same route is still on its way,
+         the route is not in the kernel. */
+      if (route->type == RTM_NEWROUTE)
+	{
+	  for (i = 0; i < NL_BATCH_PENDING_MAX; i++)
+	    if (nl_batch.pending[i].type != 0
+		&& nl_batch.pending[i].seq > seq
+		&& prefix_same (&nl_batch.pending[i].p, &route->p))
+	      break;
+	  if (i == NL_BATCH_PENDING_MAX)
+	    rib_kernel_install_failed (&route->p);
+	}
+    }
+  else if (IS_ZEBRA_DEBUG_KERNEL)
+    zlog_info ("%s: %s ACK: type=%s, seq=%u", __FUNCTION__, netlink_cmd.name,
+	       lookup (nlmsg_str, route->type), seq);
+
+  route->type = 0;
+  nl_batch.count--;
+}
+
+/* Forget the outstanding acknowledgements after they were lost. */
+static void
+netlink_batch_reset (void)
+{
+  int i;
+
+  for (i = 0; i < NL_BATCH_PENDING_MAX; i++)
+    nl_batch.pending[i].type = 0;
+  nl_batch.count = 0;
+}
+
+/* Read whatever acknowledgements the kernel has sent so far. */
+static int
+netlink_batch_parse (void)
+{
+  int status;
+  char buf[4096];
+  struct iovec iov = { buf, sizeof buf };
+  struct sockaddr_nl snl;
+  struct msghdr msg = { (void*)&snl, sizeof snl, &iov, 1, NULL, 0, 0};
+  struct nlmsghdr *h;
+  struct nlmsgerr *err;
+
+  while (nl_batch.count > 0)
+    {
+      status = recvmsg (netlink_cmd.sock, &msg, MSG_DONTWAIT);
+      if (status < 0)
+	{
+	  if (errno == EINTR)
+	    continue;
+	  if (errno == EWOULDBLOCK || errno == EAGAIN)
+	    return 0;
+	  /* ENOBUFS: acknowledgements were dropped by the kernel. */
+	  zlog (NULL, LOG_ERR, "%s recvmsg error: %s, %d changes unconfirmed",
+		netlink_cmd.name, strerror (errno), nl_batch.count);
+	  netlink_batch_reset ();
+	  return -1;
+	}
+      if (status == 0)
+	{
+	  zlog (NULL, LOG_ERR, "%s EOF", netlink_cmd.name);
+	  return -1;
+	}
+      if (snl.nl_pid != 0)
+	continue;
+
+      for (h = (struct nlmsghdr *) buf; NLMSG_OK (h, status);
+	   h = NLMSG_NEXT (h, status))
+	{
+	  if (h->nlmsg_type != NLMSG_ERROR
+	      || h->nlmsg_len < NLMSG_LENGTH (sizeof (struct nlmsgerr)))
+	    {
+	      if (IS_ZEBRA_DEBUG_KERNEL)
+		zlog_info ("netlink_batch_parse: ignoring message type %s(%u)",
+			   lookup (nlmsg_str, h->nlmsg_type), h->nlmsg_type);
+	      continue;
+	    }
+	  err = (struct nlmsgerr *) NLMSG_DATA (h);
+	  netlink_batch_ack (err->msg.nlmsg_seq, err->error);
+	}
+    }
+  return 0;
+}
+
+static int kernel_batch_read (struct thread *);
+
+/* Write the queued messages to the kernel. */
+static void
+netlink_batch_flush (void)
+{
+  int status;
+  int error;
+  u_int32_t seq;
+  struct sockaddr_nl snl;
+  struct iovec iov = { nl_batch.buf, nl_batch.len };
+  struct msghdr msg = {(void*) &snl, sizeof snl, &iov, 1, NULL, 0, 0};
+
+  if (nl_batch.len == 0)
+    return;
+
+  memset (&snl, 0, sizeof snl);
+  snl.nl_family = AF_NETLINK;
+
+  if (IS_ZEBRA_DEBUG_KERNEL)
+    zlog_info ("netlink_batch_flush: %s %d bytes, seq up to %u",
+	       netlink_cmd.name, nl_batch.len, netlink_cmd.seq);
+
+  while ((status = sendmsg (netlink_cmd.sock, &msg, 0)) < 0 && errno == EINTR)
+    ;
+  nl_batch.len = 0;
+
+  if (status < 0)
+    {
+      error = errno;
+      zlog (NULL, LOG_ERR, "netlink_batch_flush sendmsg() error: %s",
+	    strerror (error));
+      /* None of the messages in the buffer reached the kernel. */
+      for (seq = ((struct nlmsghdr *) nl_batch.buf)->nlmsg_seq;
+	   seq <= (u_int32_t) netlink_cmd.seq; seq++)
+	netlink_batch_ack (seq, -error);
+      return;
+    }
+
+  if (nl_batch.count > 0 && ! nl_batch.t_read)
+    nl_batch.t_read = thread_add_read (master, kernel_batch_read, NULL,
+				       netlink_cmd.sock);
+}
+
+/* Write the queued messages and wait for all acknowledgements. */
+static void
+netlink_batch_sync (void)
+{
+  int ret;
+  fd_set readfd;
+  struct timeval timeout;
+
+  THREAD_OFF (nl_batch.t_flush);
+  netlink_batch_flush ();
+
+  while (nl_batch.count > 0 && netlink_batch_parse () == 0
+	 && nl_batch.count > 0)
+    {
+      FD_ZERO (&readfd);
+      FD_SET (netlink_cmd.sock, &readfd);
+      timeout.tv_sec = NL_BATCH_SYNC_TIMEOUT;
+      timeout.tv_usec = 0;
+      ret = select (netlink_cmd.sock + 1, &readfd, NULL, NULL, &timeout);
+      if (ret < 0 && errno == EINTR)
+	continue;
+      if (ret <= 0)
+	{
+	  zlog (NULL, LOG_ERR, "%s: %d changes unconfirmed by the kernel",
+		netlink_cmd.name, nl_batch.count);
+	  netlink_batch_reset ();
+	}
+    }
+
+  THREAD_READ_OFF (nl_batch.t_read);
+}
+
+static int
+kernel_batch_flush (struct thread *thread)
+{
+  nl_batch.t_flush = NULL;
+  netlink_batch_flush ();
+  return 0;
+}
+
+static int
+kernel_batch_read (struct thread *thread)
+{
+  nl_batch.t_read = NULL;
+  netlink_batch_parse ();
+  if (nl_batch.count > 0)
+    nl_batch.t_read = thread_add_read (master, kernel_batch_read, NULL,
+				       netlink_cmd.sock);
+  return 0;
+}
+
+/* Queue a route message.  It is written together with the other
+   changes of this thread round unless the batch fills up first. */
+static int
+netlink_batch_add (struct nlmsghdr *n, struct prefix *p)
+{
+  struct nl_batch_route *route;
+
+  if (netlink_cmd.sock < 0)
+    return -1;
+
+  if (nl_batch.len + NLMSG_ALIGN (n->nlmsg_len) > NL_BATCH_SIZE)
+    netlink_batch_flush ();
+  if (nl_batch.count == NL_BATCH_PENDING_MAX)
+    netlink_batch_sync ();
+
+  n->nlmsg_seq = ++netlink_cmd.seq;
+  n->nlmsg_flags |= NLM_F_ACK;
+
+  if (IS_ZEBRA_DEBUG_KERNEL)
+    zlog_info ("netlink_batch_add: %s type %s(%u), seq=%u", netlink_cmd.name,
+	       lookup (nlmsg_str, n->nlmsg_type), n->nlmsg_type,
+	       n->nlmsg_seq);
+
+  memcpy (nl_batch.buf + nl_batch.len, n, n->nlmsg_len);
+  nl_batch.len += NLMSG_ALIGN (n->nlmsg_len);
+
+  route = &nl_batch.pending[n->nlmsg_seq % NL_BATCH_PENDING_MAX];
+  route->seq = n->nlmsg_seq;
+  route->type = n->nlmsg_type;
+  prefix_copy (&route->p, p);
+  nl_batch.count++;
+
+  if (! nl_batch.t_flush)
+    nl_batch.t_flush = thread_add_event (master, kernel_batch_flush, NULL, 0);
+  return 0;
+}
+
+/* Write out all queued route changes, e.g. before zebra exits. */
+void
+kernel_route_flush ()
+{
+  netlink_batch_sync ();
+}
+
 /* Routing table change via netlink interface. */
 int
 netlink_route (int cmd, int family, void *dest, int length, void *gate,
@@ -1127,13 +1413,12 @@ netlink_route (int cmd, int family, void *dest, int length, void *gate,
 /* Routing table change via netlink interface. */
 int
 netlink_route_multipath (int cmd, struct prefix *p, struct rib *rib,
-			 int family)
+			 int family, int replace)
 {
   int bytelen;
   struct sockaddr_nl snl;
   struct nexthop *nexthop = NULL;
   int nexthop_num = 0;
-  struct nlsock *nl;
   int discard;
 
   struct 
@@ -1149,6 +1434,8 @@ netlink_route_multipath (int cmd, struct prefix *p, struct rib *rib,
 
   req.n.nlmsg_len = NLMSG_LENGTH (sizeof (struct rtmsg));
   req.n.nlmsg_flags = NLM_F_CREATE | NLM_F_REQUEST;
+  if (replace)
+    req.n.nlmsg_flags |= NLM_F_REPLACE;
   req.n.nlmsg_type = cmd;
   req.r.rtm_family = family;
   req.r.rtm_table = rib->table;
@@ -1343,7 +1630,13 @@ netlink_route_multipath (int cmd, struct prefix *p, struct rib *rib,
     {
       if (IS_ZEBRA_DEBUG_KERNEL)
 	zlog_info ("netlink_route_multipath(): No useful nexthop.");
-      return 0;
+      if (! replace)
+	return 0;
+
+      /* Nothing left to replace the kernel route with: remove it. */
+      req.n.nlmsg_type = RTM_DELROUTE;
+      req.n.nlmsg_flags = NLM_F_REQUEST;
+      req.r.rtm_scope = RT_SCOPE_NOWHERE;
     }
 
  skip:
@@ -1352,38 +1645,44 @@ netlink_route_multipath (int cmd, struct prefix *p, struct rib *rib,
   memset (&snl, 0, sizeof snl);
   snl.nl_family = AF_NETLINK;
 
+  /* IPv4 changes go out in batches on the command socket. */
   if (family == AF_INET)
-    nl = &netlink_cmd;
-  else
-    nl = &netlink;
+    return netlink_batch_add (&req.n, p);
 
   /* Talk to netlink socket. */
-  return netlink_talk (&req.n, nl);
+  return netlink_talk (&req.n, &netlink);
 }
 
 int
 kernel_add_ipv4 (struct prefix *p, struct rib *rib)
 {
-  return netlink_route_multipath (RTM_NEWROUTE, p, rib, AF_INET);
+  return netlink_route_multipath (RTM_NEWROUTE, p, rib, AF_INET, 0);
 }
 
 int
 kernel_delete_ipv4 (struct prefix *p, struct rib *rib)
 {
-  return netlink_route_multipath (RTM_DELROUTE, p, rib, AF_INET);
+  return netlink_route_multipath (RTM_DELROUTE, p, rib, AF_INET, 0);
+}
+
+/* Point an installed route at the rib's active nexthops in place. */
+int
+kernel_replace_ipv4 (struct prefix *p, struct rib *rib)
+{
+  return netlink_route_multipath (RTM_NEWROUTE, p, rib, AF_INET, 1);
 }
 
 #ifdef HAVE_IPV6
 int
 kernel_add_ipv6 (struct prefix *p, struct rib *rib)
 {
-  return netlink_route_multipath (RTM_NEWROUTE, p, rib, AF_INET6);
+  return netlink_route_multipath (RTM_NEWROUTE, p, rib, AF_INET6, 0);
 }
 
 int
 kernel_delete_ipv6 (struct prefix *p, struct rib *rib)
 {
-  return netlink_route_multipath (RTM_DELROUTE, p, rib, AF_INET6);
+  return netlink_route_multipath (RTM_DELROUTE, p, rib, AF_INET6, 0);
 }
 
 /* Delete IPv6 route from the kernel. */
@@ -1457,10 +1756,6 @@ kernel_address_delete_ipv4 (struct interface *ifp, struct connected *ifc)
   return netlink_address (RTM_DELADDR, AF_INET, ifp, ifc);
 }
 
-#include "thread.h"
-
-extern struct thread_master *master;
-
 /* Kernel route reflection. */
 int
 kernel_read (struct thread *thread)
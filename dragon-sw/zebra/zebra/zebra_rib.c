@@ -29,6 +29,9 @@
 #include "if.h"
 #include "log.h"
 #include "sockunion.h"
+#include "linklist.h"
+#include "thread.h"
+#include "hash.h"
 
 #include "zebra/rib.h"
 #include "zebra/rt.h"
@@ -39,6 +42,8 @@
 /* Default rtm_table for all clients */
 extern int rtm_table_default;
 
+extern struct thread_master *master;
+
 /* Each route type's string and default distance value. */
 struct
 {  
@@ -809,6 +814,31 @@ rib_install_kernel (struct route_node *rn, struct rib *rib)
     }
 }
 
+/* The kernel has refused a route queued by rib_install_kernel(). */
+void
+rib_kernel_install_failed (struct prefix *p)
+{
+  struct route_table *table;
+  struct route_node *rn;
+  struct rib *rib;
+  struct nexthop *nexthop;
+
+  table = vrf_table (family2afi (p->family), SAFI_UNICAST, 0);
+  if (! table)
+    return;
+
+  rn = route_node_lookup (table, p);
+  if (! rn)
+    return;
+
+  for (rib = rn->info; rib; rib = rib->next)
+    if (CHECK_FLAG (rib->flags, ZEBRA_FLAG_SELECTED))
+      for (nexthop = rib->nexthop; nexthop; nexthop = nexthop->next)
+	UNSET_FLAG (nexthop->flags, NEXTHOP_FLAG_FIB);
+
+  route_unlock_node (rn);
+}
+
 /* Uninstall the route from kernel. */
 int
 rib_uninstall_kernel (struct route_node *rn, struct rib *rib)
@@ -834,6 +864,38 @@ rib_uninstall_kernel (struct route_node *rn, struct rib *rib)
   return ret;
 }
 
+/* Move the kernel route of a changed rib to its new nexthops. */
+void
+rib_update_kernel (struct route_node *rn, struct rib *rib)
+{
+#ifdef HAVE_NETLINK
+  struct nexthop *nexthop;
+
+  /* netlink replaces the route in place, so it does not disappear
+     from the kernel in between. */
+  if (PREFIX_FAMILY (&rn->p) == AF_INET)
+    {
+      for (nexthop = rib->nexthop; nexthop; nexthop = nexthop->next)
+	UNSET_FLAG (nexthop->flags, NEXTHOP_FLAG_FIB);
+
+      /* Set real nexthop. */
+      nexthop_active_update (rn, rib, 1);
+
+      if (kernel_replace_ipv4 (&rn->p, rib) < 0)
+	for (nexthop = rib->nexthop; nexthop; nexthop = nexthop->next)
+	  UNSET_FLAG (nexthop->flags, NEXTHOP_FLAG_FIB);
+      return;
+    }
+#endif /* HAVE_NETLINK */
+
+  rib_uninstall_kernel (rn, rib);
+
+  /* Set real nexthop. */
+  nexthop_active_update (rn, rib, 1);
+
+  rib_install_kernel (rn, rib);
+}
+
 /* Uninstall the route from kernel. */
 void
 rib_uninstall (struct route_node *rn, struct rib *rib)
@@ -847,14 +909,330 @@ rib_uninstall (struct route_node *rn, struct rib *rib)
     }
 }
 
-/* Core function for processing routing information base. */
+/* Nexthop tracking.  A reverse index from what nexthops resolve
+   through to the route nodes using them, so that a change revalidates
+   only the routes depending on it.  Gateways are kept in a table per
+   address family: a route change at prefix P affects exactly the
+   gateways inside P.  Interface nexthops are kept in a hash by ifindex
+   or by name. */
+struct nh_track
+{
+  /* Interface key. */
+  unsigned int ifindex;
+  char *ifname;
+
+  /* Or the gateway's node in nh_track_table. */
+  struct route_node *tn;
+
+  /* struct nh_dep of the dependent route nodes. */
+  struct list *deps;
+};
+
+/* Link between a tracker and a dependent route node.  It is on the
+   tracker's list and on the node's nh_deps, so either side can drop it
+   without a search. */
+struct nh_dep
+{
+  struct route_node *rn;
+  struct nh_track *track;
+  struct listnode *node;
+};
+
+static struct route_table *nh_track_table[AFI_MAX];
+static struct hash *nh_track_if_hash;
+
+static unsigned int
+nh_track_if_key (struct nh_track *track)
+{
+  unsigned int key = track->ifindex;
+  char *cp;
+
+  if (track->ifname)
+    for (cp = track->ifname; *cp; cp++)
+      key = key * 31 + *cp;
+  return key;
+}
+
+static int
+nh_track_if_cmp (struct nh_track *t1, struct nh_track *t2)
+{
+  if (t1->ifname || t2->ifname)
+    return t1->ifname && t2->ifname && strcmp (t1->ifname, t2->ifname) == 0;
+  return t1->ifindex == t2->ifindex;
+}
+
+static struct nh_track *
+nh_track_new ()
+{
+  struct nh_track *track;
+
+  track = XMALLOC (MTYPE_NEXTHOP_TRACK, sizeof (struct nh_track));
+  memset (track, 0, sizeof (struct nh_track));
+  track->deps = list_new ();
+  return track;
+}
+
+static void *
+nh_track_if_alloc (struct nh_track *key)
+{
+  struct nh_track *track;
+
+  track = nh_track_new ();
+  track->ifindex = key->ifindex;
+  if (key->ifname)
+    track->ifname = XSTRDUP (MTYPE_NEXTHOP_TRACK, key->ifname);
+  return track;
+}
+
+/* Free a tracker nobody depends on anymore. */
+static void
+nh_track_free (struct nh_track *track)
+{
+  if (track->tn)
+    {
+      track->tn->info = NULL;
+      route_unlock_node (track->tn);
+    }
+  else
+    hash_release (nh_track_if_hash, track);
+
+  list_delete (track->deps);
+  if (track->ifname)
+    XFREE (MTYPE_NEXTHOP_TRACK, track->ifname);
+  XFREE (MTYPE_NEXTHOP_TRACK, track);
+}
+
+static struct nh_track *
+nh_track_gate (struct prefix *p)
+{
+  struct route_node *tn;
+  struct nh_track *track;
+
+  tn = route_node_get (nh_track_table[family2afi (p->family)], p);
+  if (tn->info)
+    {
+      route_unlock_node (tn);
+      return tn->info;
+    }
+
+  /* The tracker keeps the lock. */
+  track = nh_track_new ();
+  track->tn = tn;
+  tn->info = track;
+  return track;
+}
+
+static struct nh_track *
+nh_track_if (unsigned int ifindex, char *ifname)
+{
+  struct nh_track key;
+
+  memset (&key, 0, sizeof (struct nh_track));
+  key.ifindex = ifindex;
+  key.ifname = ifname;
+  return hash_get (nh_track_if_hash, &key, nh_track_if_alloc);
+}
+
+static void
+rib_nh_link (struct rib *head, struct route_node *rn, struct nh_track *track)
+{
+  struct nh_dep *dep;
+
+  dep = XMALLOC (MTYPE_NEXTHOP_TRACK, sizeof (struct nh_dep));
+  dep->rn = rn;
+  dep->track = track;
+  listnode_add (track->deps, dep);
+  dep->node = track->deps->tail;
+
+  if (! head->nh_deps)
+    head->nh_deps = list_new ();
+  listnode_add (head->nh_deps, dep);
+}
+
+/* Drop all links of the node whose first rib is HEAD. */
+static void
+rib_nh_untrack (struct rib *head)
+{
+  listnode node;
+  struct nh_dep *dep;
+
+  if (! head->nh_deps)
+    return;
+
+  LIST_LOOP (head->nh_deps, dep, node)
+    {
+      list_delete_node (dep->track->deps, dep->node);
+      if (! listcount (dep->track->deps))
+	nh_track_free (dep->track);
+      XFREE (MTYPE_NEXTHOP_TRACK, dep);
+    }
+  list_delete (head->nh_deps);
+  head->nh_deps = NULL;
+}
+
+/* Record what the nexthops of RN's ribs resolve through, replacing
+   what was recorded before. */
+static void
+rib_nh_track (struct route_node *rn)
+{
+  struct rib *head;
+  struct rib *rib;
+  struct nexthop *nexthop;
+  struct prefix p;
+  struct nh_track *track;
+
+  head = rn->info;
+  if (! head)
+    return;
+  rib_nh_untrack (head);
+
+  for (rib = head; rib; rib = rib->next)
+    {
+      if (CHECK_FLAG (rib->status, RIB_ENTRY_REMOVED))
+	continue;
+
+      for (nexthop = rib->nexthop; nexthop; nexthop = nexthop->next)
+	{
+	  memset (&p, 0, sizeof (struct prefix));
+	  track = NULL;
+
+	  switch (nexthop->type)
+	    {
+	    case NEXTHOP_TYPE_IFINDEX:
+	      track = nh_track_if (nexthop->ifindex, NULL);
+	      break;
+	    case NEXTHOP_TYPE_IFNAME:
+	    case NEXTHOP_TYPE_IPV6_IFNAME:
+	      track = nh_track_if (0, nexthop->ifname);
+	      break;
+	    case NEXTHOP_TYPE_IPV4:
+	    case NEXTHOP_TYPE_IPV4_IFINDEX:
+	      p.family = AF_INET;
+	      p.prefixlen = IPV4_MAX_PREFIXLEN;
+	      p.u.prefix4 = nexthop->gate.ipv4;
+	      track = nh_track_gate (&p);
+	      break;
+#ifdef HAVE_IPV6
+	    case NEXTHOP_TYPE_IPV6_IFINDEX:
+	      if (IN6_IS_ADDR_LINKLOCAL (&nexthop->gate.ipv6))
+		{
+		  track = nh_track_if (nexthop->ifindex, NULL);
+		  break;
+		}
+	      /* Fall through. */
+	    case NEXTHOP_TYPE_IPV6:
+	      p.family = AF_INET6;
+	      p.prefixlen = IPV6_MAX_PREFIXLEN;
+	      p.u.prefix6 = nexthop->gate.ipv6;
+	      track = nh_track_gate (&p);
+	      break;
+#endif /* HAVE_IPV6 */
+	    default:
+	      break;
+	    }
+
+	  if (track)
+	    rib_nh_link (head, rn, track);
+	}
+    }
+}
+
+static void rib_queue_add (struct route_node *);
+
+static void
+nh_track_notify (struct nh_track *track)
+{
+  listnode node;
+  struct nh_dep *dep;
+
+  LIST_LOOP (track->deps, dep, node)
+    rib_queue_add (dep->rn);
+}
+
+/* The route for P changed: revalidate the routes with a gateway in P. */
+static void
+rib_nh_notify (struct prefix *p)
+{
+  struct route_table *table;
+  struct route_node *start;
+  struct route_node *tn;
+
+  /* Clients registered for nexthops in P. */
+  zebra_nexthop_notify (p);
+
+  table = nh_track_table[family2afi (p->family)];
+  if (! table || ! table->top)
+    return;
+
+  start = route_node_get (table, p);
+  route_lock_node (start);
+  for (tn = start; tn; tn = route_next_until (tn, start))
+    if (tn->info)
+      nh_track_notify (tn->info);
+  route_unlock_node (start);
+}
+
+/* Add RIB to head of the route node. */
+void
+rib_addnode (struct route_node *rn, struct rib *rib)
+{
+  struct rib *head;
+
+  head = rn->info;
+  if (head)
+    {
+      head->prev = rib;
+      /* The node's state moves to the new head. */
+      rib->rn_status = head->rn_status;
+      rib->nh_deps = head->nh_deps;
+      head->rn_status = 0;
+      head->nh_deps = NULL;
+    }
+  rib->next = head;
+  rn->info = rib;
+}
+
 void
-rib_process (struct route_node *rn, struct rib *del)
+rib_delnode (struct route_node *rn, struct rib *rib)
+{
+  if (rib->next)
+    rib->next->prev = rib->prev;
+  if (rib->prev)
+    rib->prev->next = rib->next;
+  else
+    {
+      rn->info = rib->next;
+      if (rib->next)
+	{
+	  rib->next->rn_status = rib->rn_status;
+	  rib->next->nh_deps = rib->nh_deps;
+	}
+      else
+	rib_nh_untrack (rib);
+    }
+  rib->rn_status = 0;
+  rib->nh_deps = NULL;
+}
+
+/* Drop a removed rib from its node for good. */
+static void
+rib_unlink (struct route_node *rn, struct rib *rib)
+{
+  rib_delnode (rn, rib);
+  newrib_free (rib);
+  route_unlock_node (rn);
+}
+
+/* Core function for processing routing information base.  Ribs
+   marked RIB_ENTRY_REMOVED are withdrawn here and then freed. */
+static void
+rib_process (struct route_node *rn)
 {
   struct rib *rib;
   struct rib *next;
   struct rib *fib = NULL;
   struct rib *select = NULL;
+  struct rib *del = NULL;
 
   for (rib = rn->info; rib; rib = next)
     {
@@ -864,6 +1242,16 @@ rib_process (struct route_node *rn, struct rib *del)
       if (CHECK_FLAG (rib->flags, ZEBRA_FLAG_SELECTED))
 	fib = rib;
 
+      if (CHECK_FLAG (rib->status, RIB_ENTRY_REMOVED))
+	{
+	  /* An installed rib must be withdrawn before it goes. */
+	  if (rib == fib)
+	    del = rib;
+	  else
+	    rib_unlink (rn, rib);
+	  continue;
+	}
+
       /* Skip unreachable nexthop. */
       if (! nexthop_active_update (rn, rib, 0))
 	continue;
@@ -878,10 +1266,6 @@ rib_process (struct route_node *rn, struct rib *del)
 	select = rib;
     }
 
-  /* Deleted route check. */
-  if (del && CHECK_FLAG (del->flags, ZEBRA_FLAG_SELECTED))
-    fib = del;
-
   /* Same route is selected. */
   if (select && select == fib)
     {
@@ -889,15 +1273,14 @@ rib_process (struct route_node *rn, struct rib *del)
 	{
 	  redistribute_delete (&rn->p, select);
 	  if (! RIB_SYSTEM_ROUTE (select))
-	    rib_uninstall_kernel (rn, select);
-
-	  /* Set real nexthop. */
-	  nexthop_active_update (rn, select, 1);
-  
-	  if (! RIB_SYSTEM_ROUTE (select))
-	    rib_install_kernel (rn, select);
+	    rib_update_kernel (rn, select);
+	  else
+	    /* Set real nexthop. */
+	    nexthop_active_update (rn, select, 1);
 	  redistribute_add (&rn->p, select);
+	  rib_nh_notify (&rn->p);
 	}
+      rib_nh_track (rn);
       return;
     }
 
@@ -924,30 +1307,84 @@ rib_process (struct route_node *rn, struct rib *del)
       SET_FLAG (select->flags, ZEBRA_FLAG_SELECTED);
       redistribute_add (&rn->p, select);
     }
+
+  /* Routes resolving through this prefix may resolve differently. */
+  if (fib || select)
+    rib_nh_notify (&rn->p);
+
+  if (del)
+    rib_unlink (rn, del);
+
+  rib_nh_track (rn);
 }
 
-/* Add RIB to head of the route node. */
-void
-rib_addnode (struct route_node *rn, struct rib *rib)
+/* RIB work queue.  Route nodes with pending changes are queued once,
+   however many updates they get before their turn, and processed by a
+   background thread in slices of RIB_QUEUE_SLICE microseconds so that
+   clients and the kernel are served during large changes. */
+#define RIB_QUEUE_SLICE  10000
+
+static struct
+{
+  struct list *nodes;
+  struct thread *t_process;
+} rib_queue;
+
+static int rib_queue_process (struct thread *);
+
+static void
+rib_queue_add (struct route_node *rn)
 {
   struct rib *head;
 
   head = rn->info;
-  if (head)
-    head->prev = rib;
-  rib->next = head;
-  rn->info = rib;
+  if (! head || CHECK_FLAG (head->rn_status, RIB_ROUTE_QUEUED))
+    return;
+
+  SET_FLAG (head->rn_status, RIB_ROUTE_QUEUED);
+  listnode_add (rib_queue.nodes, route_lock_node (rn));
+
+  THREAD_BACKGROUND_ON (master, rib_queue.t_process, rib_queue_process, NULL);
 }
 
-void
-rib_delnode (struct route_node *rn, struct rib *rib)
+/* Process the route node at the head of the RIB work queue.  */
+static void
+rib_queue_process_node ()
 {
-  if (rib->next)
-    rib->next->prev = rib->prev;
-  if (rib->prev)
-    rib->prev->next = rib->next;
-  else
-    rn->info = rib->next;
+  struct route_node *rn;
+
+  rn = listnode_head (rib_queue.nodes);
+  list_delete_node (rib_queue.nodes, listhead (rib_queue.nodes));
+
+  if (rn->info)
+    UNSET_FLAG (((struct rib *) rn->info)->rn_status, RIB_ROUTE_QUEUED);
+  rib_process (rn);
+  route_unlock_node (rn);
+}
+
+static int
+rib_queue_process (struct thread *thread)
+{
+  struct timeval start;
+  struct timeval now;
+
+  rib_queue.t_process = NULL;
+  gettimeofday (&start, NULL);
+
+  while (listcount (rib_queue.nodes))
+    {
+      rib_queue_process_node ();
+
+      gettimeofday (&now, NULL);
+      if ((now.tv_sec - start.tv_sec) * 1000000L
+	  + (now.tv_usec - start.tv_usec) >= RIB_QUEUE_SLICE)
+	break;
+    }
+
+  if (listcount (rib_queue.nodes))
+    THREAD_BACKGROUND_ON (master, rib_queue.t_process, rib_queue_process,
+			  NULL);
+  return 0;
 }
 
 int
@@ -986,6 +1423,9 @@ rib_add_ipv4 (int type, int flags, struct prefix_ipv4 *p,
      withdraw. */
   for (rib = rn->info; rib; rib = rib->next)
     {
+      if (CHECK_FLAG (rib->status, RIB_ENTRY_REMOVED))
+	continue;
+
       if (rib->type == ZEBRA_ROUTE_CONNECT)
 	{
 	  nexthop = rib->nexthop;
@@ -1002,8 +1442,7 @@ rib_add_ipv4 (int type, int flags, struct prefix_ipv4 *p,
       else if (rib->type == type)
 	{
 	  same = rib;
-	  rib_delnode (rn, same);
-	  route_unlock_node (rn);
+	  SET_FLAG (same->status, RIB_ENTRY_REMOVED);
 	  break;
 	}
     }
@@ -1038,11 +1477,7 @@ rib_add_ipv4 (int type, int flags, struct prefix_ipv4 *p,
   rib_addnode (rn, rib);
 
   /* Process this route node. */
-  rib_process (rn, same);
-
-  /* Free implicit route.*/
-  if (same)
-    newrib_free (same);
+  rib_queue_add (rn);
 
   return 0;
 }
@@ -1082,10 +1517,10 @@ rib_add_ipv4_multipath (struct prefix_ipv4 *p, struct rib *rib)
   for (same = rn->info; same; same = same->next)
     {
       if (same->type == rib->type && same->table == rib->table
-	  && same->type != ZEBRA_ROUTE_CONNECT)
+	  && same->type != ZEBRA_ROUTE_CONNECT
+	  && ! CHECK_FLAG (same->status, RIB_ENTRY_REMOVED))
 	{
-	  rib_delnode (rn, same);
-	  route_unlock_node (rn);
+	  SET_FLAG (same->status, RIB_ENTRY_REMOVED);
 	  break;
 	}
     }
@@ -1099,11 +1534,7 @@ rib_add_ipv4_multipath (struct prefix_ipv4 *p, struct rib *rib)
   rib_addnode (rn, rib);
 
   /* Process this route node. */
-  rib_process (rn, same);
-
-  /* Free implicit route.*/
-  if (same)
-    newrib_free (same);
+  rib_queue_add (rn);
 
   return 0;
 }
@@ -1153,6 +1584,9 @@ rib_delete_ipv4 (int type, int flags, struct prefix_ipv4 *p,
   /* Lookup same type route. */
   for (rib = rn->info; rib; rib = rib->next)
     {
+      if (CHECK_FLAG (rib->status, RIB_ENTRY_REMOVED))
+	continue;
+
       if (CHECK_FLAG (rib->flags, ZEBRA_FLAG_SELECTED))
 	fib = rib;
 
@@ -1221,16 +1655,10 @@ rib_delete_ipv4 (int type, int flags, struct prefix_ipv4 *p,
     }
 
   if (same)
-    rib_delnode (rn, same);
+    SET_FLAG (same->status, RIB_ENTRY_REMOVED);
 
   /* Process changes. */
-  rib_process (rn, same);
-
-  if (same)
-    {
-      newrib_free (same);
-      route_unlock_node (rn);
-    }
+  rib_queue_add (rn);
 
   route_unlock_node (rn);
 
@@ -1253,7 +1681,8 @@ static_install_ipv4 (struct prefix *p, struct static_ipv4 *si)
   /* Lookup existing route */
   rn = route_node_get (table, p);
   for (rib = rn->info; rib; rib = rib->next)
-    if (rib->type == ZEBRA_ROUTE_STATIC && rib->distance == si->distance)
+    if (rib->type == ZEBRA_ROUTE_STATIC && rib->distance == si->distance
+	&& ! CHECK_FLAG (rib->status, RIB_ENTRY_REMOVED))
       break;
 
   if (rib)
@@ -1275,7 +1704,7 @@ static_install_ipv4 (struct prefix *p, struct static_ipv4 *si)
 	  nexthop_blackhole_add (rib);
 	  break;
 	}
-      rib_process (rn, NULL);
+      rib_queue_add (rn);
     }
   else
     {
@@ -1305,7 +1734,7 @@ static_install_ipv4 (struct prefix *p, struct static_ipv4 *si)
       rib_addnode (rn, rib);
 
       /* Process this prefix. */
-      rib_process (rn, NULL);
+      rib_queue_add (rn);
     }
 }
 
@@ -1346,7 +1775,8 @@ static_uninstall_ipv4 (struct prefix *p, struct static_ipv4 *si)
     return;
 
   for (rib = rn->info; rib; rib = rib->next)
-    if (rib->type == ZEBRA_ROUTE_STATIC && rib->distance == si->distance)
+    if (rib->type == ZEBRA_ROUTE_STATIC && rib->distance == si->distance
+	&& ! CHECK_FLAG (rib->status, RIB_ENTRY_REMOVED))
       break;
 
   if (! rib)
@@ -1369,19 +1799,14 @@ static_uninstall_ipv4 (struct prefix *p, struct static_ipv4 *si)
   
   /* Check nexthop. */
   if (rib->nexthop_num == 1)
-    {
-      rib_delnode (rn, rib);
-      rib_process (rn, rib);
-      newrib_free (rib);
-      route_unlock_node (rn);
-    }
+    SET_FLAG (rib->status, RIB_ENTRY_REMOVED);
   else
     {
       rib_uninstall (rn, rib);
       nexthop_delete (rib, nexthop);
       nexthop_free (nexthop);
-      rib_process (rn, rib);
     }
+  rib_queue_add (rn);
 
   /* Unlock node. */
   route_unlock_node (rn);
@@ -1596,6 +2021,9 @@ rib_add_ipv6 (int type, int flags, struct prefix_ipv6 *p,
      withdraw. */
   for (rib = rn->info; rib; rib = rib->next)
     {
+      if (CHECK_FLAG (rib->status, RIB_ENTRY_REMOVED))
+	continue;
+
       if (rib->type == ZEBRA_ROUTE_CONNECT)
 	{
 	  nexthop = rib->nexthop;
@@ -1611,8 +2039,7 @@ rib_add_ipv6 (int type, int flags, struct prefix_ipv6 *p,
       else if (rib->type == type)
 	{
 	  same = rib;
-	  rib_delnode (rn, same);
-	  route_unlock_node (rn);
+	  SET_FLAG (same->status, RIB_ENTRY_REMOVED);
 	  break;
 	}
     }
@@ -1647,11 +2074,7 @@ rib_add_ipv6 (int type, int flags, struct prefix_ipv6 *p,
   rib_addnode (rn, rib);
 
   /* Process this route node. */
-  rib_process (rn, same);
-
-  /* Free implicit route.*/
-  if (same)
-    newrib_free (same);
+  rib_queue_add (rn);
 
   return 0;
 }
@@ -1701,6 +2124,9 @@ rib_delete_ipv6 (int type, int flags, struct prefix_ipv6 *p,
   /* Lookup same type route. */
   for (rib = rn->info; rib; rib = rib->next)
     {
+      if (CHECK_FLAG (rib->status, RIB_ENTRY_REMOVED))
+	continue;
+
       if (CHECK_FLAG (rib->flags, ZEBRA_FLAG_SELECTED))
 	fib = rib;
 
@@ -1769,16 +2195,10 @@ rib_delete_ipv6 (int type, int flags, struct prefix_ipv6 *p,
     }
 
   if (same)
-    rib_delnode (rn, same);
+    SET_FLAG (same->status, RIB_ENTRY_REMOVED);
 
   /* Process changes. */
-  rib_process (rn, same);
-
-  if (same)
-    {
-      newrib_free (same);
-      route_unlock_node (rn);
-    }
+  rib_queue_add (rn);
 
   route_unlock_node (rn);
 
@@ -1801,7 +2221,8 @@ static_install_ipv6 (struct prefix *p, struct static_ipv6 *si)
   /* Lookup existing route */
   rn = route_node_get (table, p);
   for (rib = rn->info; rib; rib = rib->next)
-    if (rib->type == ZEBRA_ROUTE_STATIC && rib->distance == si->distance)
+    if (rib->type == ZEBRA_ROUTE_STATIC && rib->distance == si->distance
+	&& ! CHECK_FLAG (rib->status, RIB_ENTRY_REMOVED))
       break;
 
   if (rib)
@@ -1823,7 +2244,7 @@ static_install_ipv6 (struct prefix *p, struct static_ipv6 *si)
 	  nexthop_ipv6_ifname_add (rib, &si->ipv6, si->ifname);
 	  break;
 	}
-      rib_process (rn, NULL);
+      rib_queue_add (rn);
     }
   else
     {
@@ -1853,7 +2274,7 @@ static_install_ipv6 (struct prefix *p, struct static_ipv6 *si)
       rib_addnode (rn, rib);
 
       /* Process this prefix. */
-      rib_process (rn, NULL);
+      rib_queue_add (rn);
     }
 }
 
@@ -1895,7 +2316,8 @@ static_uninstall_ipv6 (struct prefix *p, struct static_ipv6 *si)
     return;
 
   for (rib = rn->info; rib; rib = rib->next)
-    if (rib->type == ZEBRA_ROUTE_STATIC && rib->distance == si->distance)
+    if (rib->type == ZEBRA_ROUTE_STATIC && rib->distance == si->distance
+	&& ! CHECK_FLAG (rib->status, RIB_ENTRY_REMOVED))
       break;
   if (! rib)
     {
@@ -1917,19 +2339,14 @@ static_uninstall_ipv6 (struct prefix *p, struct static_ipv6 *si)
   
   /* Check nexthop. */
   if (rib->nexthop_num == 1)
-    {
-      rib_delnode (rn, rib);
-      rib_process (rn, rib);
-      newrib_free (rib);
-      route_unlock_node (rn);
-    }
+    SET_FLAG (rib->status, RIB_ENTRY_REMOVED);
   else
     {
       rib_uninstall (rn, rib);
       nexthop_delete (rib, nexthop);
       nexthop_free (nexthop);
-      rib_process (rn, rib);
     }
+  rib_queue_add (rn);
 
   /* Unlock node. */
   route_unlock_node (rn);
@@ -2076,26 +2493,54 @@ rib_update ()
   table = vrf_table (AFI_IP, SAFI_UNICAST, 0);
   if (table)
     for (rn = route_top (table); rn; rn = route_next (rn))
-      rib_process (rn, NULL);
+      rib_queue_add (rn);
 
   table = vrf_table (AFI_IP6, SAFI_UNICAST, 0);
   if (table)
     for (rn = route_top (table); rn; rn = route_next (rn))
-      rib_process (rn, NULL);
+      rib_queue_add (rn);
+}
+
+/* Connected address P of IFP comes or goes.  The connected route's
+   own processing catches most of this, but do not wait for it. */
+void
+rib_update_connected (struct interface *ifp, struct prefix *p)
+{
+  rib_nh_notify (p);
+}
+
+/* Revalidate the routes with nexthops on interface IFP. */
+static void
+rib_if_notify (struct interface *ifp)
+{
+  struct nh_track key;
+  struct nh_track *track;
+
+  memset (&key, 0, sizeof (struct nh_track));
+  key.ifindex = ifp->ifindex;
+  track = hash_lookup (nh_track_if_hash, &key);
+  if (track)
+    nh_track_notify (track);
+
+  key.ifindex = 0;
+  key.ifname = ifp->name;
+  track = hash_lookup (nh_track_if_hash, &key);
+  if (track)
+    nh_track_notify (track);
 }
 
 /* Interface goes up. */
 void
 rib_if_up (struct interface *ifp)
 {
-  rib_update ();
+  rib_if_notify (ifp);
 }
 
 /* Interface goes down. */
 void
 rib_if_down (struct interface *ifp)
 {
-  rib_update ();
+  rib_if_notify (ifp);
 }
  
 /* Remove all routes which comes from non main table.  */
@@ -2186,8 +2631,16 @@ rib_close_table (struct route_table *table)
 void
 rib_close ()
 {
+  /* Settle queued changes first so the right routes are withdrawn. */
+  THREAD_BACKGROUND_OFF (rib_queue.t_process);
+  while (listcount (rib_queue.nodes))
+    rib_queue_process_node ();
+
   rib_close_table (vrf_table (AFI_IP, SAFI_UNICAST, 0));
   rib_close_table (vrf_table (AFI_IP6, SAFI_UNICAST, 0));
+#ifdef HAVE_NETLINK
+  kernel_route_flush ();
+#endif /* HAVE_NETLINK */
 }
  
 /* Routing information base initialize. */
@@ -2196,4 +2649,12 @@ rib_init ()
 {
   /* VRF initialization.  */
   vrf_init ();
+
+  rib_queue.nodes = list_new ();
+
+  nh_track_table[AFI_IP] = route_table_init ();
+#ifdef HAVE_IPV6
+  nh_track_table[AFI_IP6] = route_table_init ();
+#endif /* HAVE_IPV6 */
+  nh_track_if_hash = hash_create (nh_track_if_key, nh_track_if_cmp);
 }
@@ -147,7 +147,8 @@ ipFwNumber (struct variable *v, oid objid[], size_t *objid_len,
   result = 0;
   for (rn = route_top (table); rn; rn = route_next (rn))
     for (rib = rn->info; rib; rib = rib->next)
-      result++;
+      if (! CHECK_FLAG (rib->status, RIB_ENTRY_REMOVED))
+	result++;
 
   return (u_char *)&result;
 }
@@ -172,7 +173,8 @@ ipCidrNumber (struct variable *v, oid objid[], size_t *objid_len,
   result = 0;
   for (rn = route_top (table); rn; rn = route_next (rn))
     for (rib = rn->info; rib; rib = rib->next)
-      result++;
+      if (! CHECK_FLAG (rib->status, RIB_ENTRY_REMOVED))
+	result++;
 
   return (u_char *)&result;
 }
@@ -366,6 +368,8 @@ get_fwtable_route_node(struct variable *v, oid objid[], size_t *objid_len,
 	    {
 	      for (*rib = (*np)->info; *rib; *rib = (*rib)->next)
 	        {
+		  if (CHECK_FLAG ((*rib)->status, RIB_ENTRY_REMOVED))
+		    continue;
 		  if (!in_addr_cmp((u_char *)&(*rib)->nexthop->gate.ipv4,
 				   (u_char *)&nexthop))
 		    if (proto == proto_trans((*rib)->type))
@@ -384,7 +388,8 @@ get_fwtable_route_node(struct variable *v, oid objid[], size_t *objid_len,
       /* Check destination first */
       if (in_addr_cmp(&np2->p.u.prefix, (u_char *)&dest) > 0)
         for (rib2 = np2->info; rib2; rib2 = rib2->next)
-	  check_replace(np2, rib2, np, rib);
+	  if (! CHECK_FLAG (rib2->status, RIB_ENTRY_REMOVED))
+	    check_replace(np2, rib2, np, rib);
 
       if (in_addr_cmp(&np2->p.u.prefix, (u_char *)&dest) == 0)
         { /* have to look at each rib individually */
@@ -392,6 +397,9 @@ get_fwtable_route_node(struct variable *v, oid objid[], size_t *objid_len,
 	    {
 	      int proto2, policy2;
 
+	      if (CHECK_FLAG (rib2->status, RIB_ENTRY_REMOVED))
+		continue;
+
 	      proto2 = proto_trans(rib2->type);
 	      policy2 = 0;
 
@@ -280,6 +280,9 @@ vty_show_ip_route_detail (struct vty *vty, struct route_node *rn)
 
   for (rib = rn->info; rib; rib = rib->next)
     {
+      if (CHECK_FLAG (rib->status, RIB_ENTRY_REMOVED))
+	continue;
+
       vty_out (vty, "Routing entry for %s/%d%s", 
 	       inet_ntoa (rn->p.u.prefix4), rn->p.prefixlen,
 	       VTY_NEWLINE);
@@ -501,6 +504,9 @@ DEFUN (show_ip_route,
   for (rn = route_top (table); rn; rn = route_next (rn))
     for (rib = rn->info; rib; rib = rib->next)
       {
+	if (CHECK_FLAG (rib->status, RIB_ENTRY_REMOVED))
+	  continue;
+
 	if (first)
 	  {
 	    vty_out (vty, SHOW_ROUTE_V4_HEADER, VTY_NEWLINE, VTY_NEWLINE,
@@ -542,7 +548,8 @@ DEFUN (show_ip_route_prefix_longer,
   /* Show matched type IPv4 routes. */
   for (rn = route_top (table); rn; rn = route_next (rn))
     for (rib = rn->info; rib; rib = rib->next)
-      if (prefix_match (&p, &rn->p))
+      if (prefix_match (&p, &rn->p)
+	  && ! CHECK_FLAG (rib->status, RIB_ENTRY_REMOVED))
 	{
 	  if (first)
 	    {
@@ -577,6 +584,9 @@ DEFUN (show_ip_route_supernets,
   for (rn = route_top (table); rn; rn = route_next (rn))
     for (rib = rn->info; rib; rib = rib->next)
       {
+	if (CHECK_FLAG (rib->status, RIB_ENTRY_REMOVED))
+	  continue;
+
 	addr = ntohl (rn->p.u.prefix4.s_addr);
 
 	if ((IN_CLASSC (addr) && rn->p.prefixlen < 24)
@@ -639,7 +649,8 @@ DEFUN (show_ip_route_protocol,
   /* Show matched type IPv4 routes. */
   for (rn = route_top (table); rn; rn = route_next (rn))
     for (rib = rn->info; rib; rib = rib->next)
-      if (rib->type == type)
+      if (rib->type == type
+	  && ! CHECK_FLAG (rib->status, RIB_ENTRY_REMOVED))
 	{
 	  if (first)
 	    {
@@ -1004,6 +1015,9 @@ vty_show_ipv6_route_detail (struct vty *vty, struct route_node *rn)
 
   for (rib = rn->info; rib; rib = rib->next)
     {
+      if (CHECK_FLAG (rib->status, RIB_ENTRY_REMOVED))
+	continue;
+
       vty_out (vty, "Routing entry for %s/%d%s", 
 	       inet_ntop (AF_INET6, &rn->p.u.prefix6, buf, BUFSIZ),
 	       rn->p.prefixlen,
@@ -1242,6 +1256,9 @@ DEFUN (show_ipv6_route,
   for (rn = route_top (table); rn; rn = route_next (rn))
     for (rib = rn->info; rib; rib = rib->next)
       {
+	if (CHECK_FLAG (rib->status, RIB_ENTRY_REMOVED))
+	  continue;
+
 	if (first)
 	  {
 	    vty_out (vty, SHOW_ROUTE_V6_HEADER, VTY_NEWLINE, VTY_NEWLINE, VTY_NEWLINE);
@@ -1282,7 +1299,8 @@ DEFUN (show_ipv6_route_prefix_longer,
   /* Show matched type IPv6 routes. */
   for (rn = route_top (table); rn; rn = route_next (rn))
     for (rib = rn->info; rib; rib = rib->next)
-      if (prefix_match (&p, &rn->p))
+      if (prefix_match (&p, &rn->p)
+	  && ! CHECK_FLAG (rib->status, RIB_ENTRY_REMOVED))
 	{
 	  if (first)
 	    {
@@ -1338,7 +1356,8 @@ DEFUN (show_ipv6_route_protocol,
   /* Show matched type IPv6 routes. */
   for (rn = route_top (table); rn; rn = route_next (rn))
     for (rib = rn->info; rib; rib = rib->next)
-      if (rib->type == type)
+      if (rib->type == type
+	  && ! CHECK_FLAG (rib->status, RIB_ENTRY_REMOVED))
 	{
 	  if (first)
 	    {
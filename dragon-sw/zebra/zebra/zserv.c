@@ -73,46 +73,50 @@ char *zebra_command_str [] =
   "ZEBRA_IPV4_NEXTHOP_LOOKUP",
   "ZEBRA_IPV6_NEXTHOP_LOOKUP",
   "ZEBRA_IPV4_IMPORT_LOOKUP",
-  "ZEBRA_IPV6_IMPORT_LOOKUP"
+  "ZEBRA_IPV6_IMPORT_LOOKUP",
+  "ZEBRA_MESSAGE_BATCH",
+  "ZEBRA_NEXTHOP_REGISTER",
+  "ZEBRA_NEXTHOP_UNREGISTER",
+  "ZEBRA_NEXTHOP_UPDATE"
 };
  
 struct zebra_message_queue
 {
-  struct nsm_message_queue *next;
-  struct nsm_message_queue *prev;
+  struct zebra_message_queue *next;
+  struct zebra_message_queue *prev;
 
   u_char *buf;
   u_int16_t length;
   u_int16_t written;
 };
 
-struct thread *t_write;
-struct fifo message_queue;
-
+/* Write out what the socket takes of the client's queue. */
 int
 zebra_server_dequeue (struct thread *t)
 {
-  int sock;
   int nbytes;
+  struct zserv *client;
   struct zebra_message_queue *queue;
 
-  sock = THREAD_FD (t);
-  t_write = NULL;
+  client = THREAD_ARG (t);
+  client->t_write = NULL;
 
-  queue = (struct zebra_message_queue *) FIFO_HEAD (&message_queue);
-  if (queue)
+  while ((queue = (struct zebra_message_queue *)
+	  FIFO_HEAD (&client->wqueue)) != NULL)
     {
-      nbytes = write (sock, queue->buf + queue->written,
+      nbytes = write (client->sock, queue->buf + queue->written,
 		      queue->length - queue->written);
 
       if (nbytes <= 0)
         {
-          if (errno != EAGAIN)
+          if (errno != EAGAIN && errno != EINTR)
 	    return -1;
+	  break;
         }
       else if (nbytes != (queue->length - queue->written))
 	{
 	  queue->written += nbytes;
+	  break;
 	}
       else
         {
@@ -122,16 +126,17 @@ zebra_server_dequeue (struct thread *t)
         }
     }
 
-  if (FIFO_TOP (&message_queue))
-    THREAD_WRITE_ON (master, t_write, zebra_server_dequeue, NULL, sock);
+  if (FIFO_TOP (&client->wqueue))
+    client->t_write = thread_add_write (master, zebra_server_dequeue,
+					client, client->sock);
 
   return 0;
 }
 
 /* Enqueu message.  */
 void
-zebra_server_enqueue (int sock, u_char *buf, unsigned long length,
-		      unsigned long written)
+zebra_server_enqueue (struct zserv *client, u_char *buf,
+		      unsigned long length, unsigned long written)
 {
   struct zebra_message_queue *queue;
 
@@ -141,35 +146,98 @@ zebra_server_enqueue (int sock, u_char *buf, unsigned long length,
   queue->length = length;
   queue->written = written;
 
-  FIFO_ADD (&message_queue, queue);
+  FIFO_ADD (&client->wqueue, queue);
 
-  THREAD_WRITE_ON (master, t_write, zebra_server_dequeue, NULL, sock);
+  if (! client->t_write)
+    client->t_write = thread_add_write (master, zebra_server_dequeue,
+					client, client->sock);
 }
 
-int
-zebra_server_send_message (int sock, u_char *buf, unsigned long length)
+static void
+zebra_server_write (struct zserv *client, u_char *buf, unsigned long length)
 {
   int nbytes;
 
-  if (FIFO_TOP (&message_queue))
+  if (FIFO_TOP (&client->wqueue))
     {
-      zebra_server_enqueue (sock, buf, length, 0);
-      return 0;
+      zebra_server_enqueue (client, buf, length, 0);
+      return;
     }
 
   /* Send message.  */
-  nbytes = write (sock, buf, length);
+  nbytes = write (client->sock, buf, length);
 
   if (nbytes <= 0)
     {
-      if (errno == EAGAIN)
-        zebra_server_enqueue (sock, buf, length, 0);
-      else
-	return -1;
+      if (errno == EAGAIN || errno == EINTR)
+        zebra_server_enqueue (client, buf, length, 0);
     }
   else if (nbytes != length)
-    zebra_server_enqueue (sock, buf, length, nbytes);
+    zebra_server_enqueue (client, buf, length, nbytes);
+}
+
+/* Messages to a client are collected in its batch and written with one
+   call when the thread loop comes round, wrapped in a ZEBRA_MESSAGE_BATCH
+   message when there are several of them. */
+static void
+zebra_server_batch_reset (struct zserv *client)
+{
+  stream_reset (client->batch);
+  stream_putw (client->batch, 0);
+  stream_putc (client->batch, ZEBRA_MESSAGE_BATCH);
+  client->batch_count = 0;
+}
+
+static void
+zebra_server_batch_flush (struct zserv *client)
+{
+  struct stream *s = client->batch;
+  unsigned long length;
+
+  if (client->batch_count == 0)
+    return;
+
+  length = stream_get_endp (s);
+  if (client->batch_count == 1)
+    zebra_server_write (client, s->data + ZEBRA_HEADER_SIZE,
+			length - ZEBRA_HEADER_SIZE);
+  else
+    {
+      stream_putw_at (s, 0, length);
+      zebra_server_write (client, s->data, length);
+    }
+
+  zebra_server_batch_reset (client);
+}
 
+static int
+zebra_server_flush (struct thread *t)
+{
+  struct zserv *client;
+
+  client = THREAD_ARG (t);
+  client->t_flush = NULL;
+
+  zebra_server_batch_flush (client);
+  return 0;
+}
+
+int
+zebra_server_send_message (struct zserv *client, u_char *buf,
+			   unsigned long length)
+{
+  if (client->sock < 0)
+    return -1;
+
+  if (stream_get_endp (client->batch) + length > ZEBRA_BATCH_SIZ)
+    zebra_server_batch_flush (client);
+
+  stream_put (client->batch, buf, length);
+  client->batch_count++;
+
+  if (! client->t_flush)
+    client->t_flush = thread_add_event (master, zebra_server_flush,
+					client, 0);
   return 0;
 }
 
@@ -210,7 +278,7 @@ zsend_interface_add (struct zserv *client, struct interface *ifp)
   /* Write packet size. */
   stream_putw_at (s, 0, stream_get_endp (s));
 
-  zebra_server_send_message (client->sock, s->data, stream_get_endp (s));
+  zebra_server_send_message (client, s->data, stream_get_endp (s));
 
   return 0;
 }
@@ -243,7 +311,7 @@ zsend_interface_delete (struct zserv *client, struct interface *ifp)
   /* Write packet length. */
   stream_putw_at (s, 0, stream_get_endp (s));
 
-  zebra_server_send_message (client->sock, s->data, stream_get_endp (s));
+  zebra_server_send_message (client, s->data, stream_get_endp (s));
 
   return 0;
 }
@@ -291,7 +359,7 @@ zsend_interface_address_add (struct zserv *client, struct interface *ifp,
   /* Write packet size. */
   stream_putw_at (s, 0, stream_get_endp (s));
 
-  zebra_server_send_message (client->sock, s->data, stream_get_endp (s));
+  zebra_server_send_message (client, s->data, stream_get_endp (s));
 
   return 0;
 }
@@ -337,7 +405,7 @@ zsend_interface_address_delete (struct zserv *client, struct interface *ifp,
   /* Write packet size. */
   stream_putw_at (s, 0, stream_get_endp (s));
 
-  zebra_server_send_message (client->sock, s->data, stream_get_endp (s));
+  zebra_server_send_message (client, s->data, stream_get_endp (s));
 
   return 0;
 }
@@ -371,7 +439,7 @@ zsend_interface_up (struct zserv *client, struct interface *ifp)
   /* Write packet size. */
   stream_putw_at (s, 0, stream_get_endp (s));
 
-  zebra_server_send_message (client->sock, s->data, stream_get_endp (s));
+  zebra_server_send_message (client, s->data, stream_get_endp (s));
 
   return 0;
 }
@@ -405,7 +473,7 @@ zsend_interface_down (struct zserv *client, struct interface *ifp)
   /* Write packet size. */
   stream_putw_at (s, 0, stream_get_endp (s));
 
-  zebra_server_send_message (client->sock, s->data, stream_get_endp (s));
+  zebra_server_send_message (client, s->data, stream_get_endp (s));
 
   return 0;
 }
@@ -464,7 +532,7 @@ zsend_ipv4_add_multipath (struct zserv *client, struct prefix *p,
   /* Write packet size. */
   stream_putw_at (s, 0, stream_get_endp (s));
 
-  zebra_server_send_message (client->sock, s->data, stream_get_endp (s));
+  zebra_server_send_message (client, s->data, stream_get_endp (s));
 
   return 0;
 }
@@ -520,7 +588,7 @@ zsend_ipv4_delete_multipath (struct zserv *client, struct prefix *p,
   /* Write packet size. */
   stream_putw_at (s, 0, stream_get_endp (s));
 
-  zebra_server_send_message (client->sock, s->data, stream_get_endp (s));
+  zebra_server_send_message (client, s->data, stream_get_endp (s));
 
   return 0;
 }
@@ -561,7 +629,7 @@ zsend_ipv4_add (struct zserv *client, int type, int flags,
   /* Write packet size. */
   stream_putw_at (s, 0, stream_get_endp (s));
 
-  zebra_server_send_message (client->sock, s->data, stream_get_endp (s));
+  zebra_server_send_message (client, s->data, stream_get_endp (s));
 
   return 0;
 }
@@ -602,7 +670,7 @@ zsend_ipv4_delete (struct zserv *client, int type, int flags,
   /* Write packet size. */
   stream_putw_at (s, 0, stream_get_endp (s));
 
-  zebra_server_send_message (client->sock, s->data, stream_get_endp (s));
+  zebra_server_send_message (client, s->data, stream_get_endp (s));
 
   return 0;
 }
@@ -644,7 +712,7 @@ zsend_ipv6_add (struct zserv *client, int type, int flags,
   /* Write packet size. */
   stream_putw_at (s, 0, stream_get_endp (s));
 
-  zebra_server_send_message (client->sock, s->data, stream_get_endp (s));
+  zebra_server_send_message (client, s->data, stream_get_endp (s));
 
   return 0;
 }
@@ -702,7 +770,7 @@ zsend_ipv6_add_multipath (struct zserv *client, struct prefix *p,
   /* Write packet size. */
   stream_putw_at (s, 0, stream_get_endp (s));
 
-  zebra_server_send_message (client->sock, s->data, stream_get_endp (s));
+  zebra_server_send_message (client, s->data, stream_get_endp (s));
 
   return 0;
 }
@@ -743,7 +811,7 @@ zsend_ipv6_delete (struct zserv *client, int type, int flags,
   /* Write packet size. */
   stream_putw_at (s, 0, stream_get_endp (s));
 
-  zebra_server_send_message (client->sock, s->data, stream_get_endp (s));
+  zebra_server_send_message (client, s->data, stream_get_endp (s));
 
   return 0;
 }
@@ -798,7 +866,7 @@ zsend_ipv6_delete_multipath (struct zserv *client, struct prefix *p,
   /* Write packet size. */
   stream_putw_at (s, 0, stream_get_endp (s));
 
-  zebra_server_send_message (client->sock, s->data, stream_get_endp (s));
+  zebra_server_send_message (client, s->data, stream_get_endp (s));
 
   return 0;
 }
@@ -861,7 +929,7 @@ zsend_ipv6_nexthop_lookup (struct zserv *client, struct in6_addr *addr)
 
   stream_putw_at (s, 0, stream_get_endp (s));
   
-  zebra_server_send_message (client->sock, s->data, stream_get_endp (s));
+  zebra_server_send_message (client, s->data, stream_get_endp (s));
 
   return 0;
 }
@@ -920,7 +988,7 @@ zsend_ipv4_nexthop_lookup (struct zserv *client, struct in_addr addr)
 
   stream_putw_at (s, 0, stream_get_endp (s));
   
-  zebra_server_send_message (client->sock, s->data, stream_get_endp (s));
+  zebra_server_send_message (client, s->data, stream_get_endp (s));
 
   return 0;
 }
@@ -978,10 +1046,161 @@ zsend_ipv4_import_lookup (struct zserv *client, struct prefix_ipv4 *p)
 
   stream_putw_at (s, 0, stream_get_endp (s));
   
-  zebra_server_send_message (client->sock, s->data, stream_get_endp (s));
+  zebra_server_send_message (client, s->data, stream_get_endp (s));
 
   return 0;
 }
+/* Nexthops clients asked to hear about, by address. */
+struct zserv_nexthop
+{
+  /* Registered clients. */
+  struct list *clients;
+
+  /* Resolution last sent, as the body of a ZEBRA_NEXTHOP_UPDATE. */
+  u_char *state;
+  u_int16_t state_len;
+};
+
+static struct route_table *zserv_nexthop_table[AFI_MAX];
+
+/* Scratch buffer to encode resolutions in. */
+static struct stream *zserv_nexthop_buf;
+
+/* Write how nexthop P resolves, in the form of the nexthop lookup
+   replies. */
+static void
+zserv_nexthop_encode (struct stream *s, struct prefix *p)
+{
+  struct rib *rib;
+  unsigned long nump;
+  u_char num;
+  struct nexthop *nexthop;
+
+  stream_putc (s, p->family);
+#ifdef HAVE_IPV6
+  if (p->family == AF_INET6)
+    {
+      rib = rib_match_ipv6 (&p->u.prefix6);
+      stream_put (s, &p->u.prefix6, 16);
+    }
+  else
+#endif /* HAVE_IPV6 */
+    {
+      rib = rib_match_ipv4 (p->u.prefix4);
+      stream_put_in_addr (s, &p->u.prefix4);
+    }
+
+  if (rib)
+    {
+      stream_putl (s, rib->metric);
+      num = 0;
+      nump = s->putp;
+      stream_putc (s, 0);
+      for (nexthop = rib->nexthop; nexthop; nexthop = nexthop->next)
+	if (CHECK_FLAG (nexthop->flags, NEXTHOP_FLAG_FIB))
+	  {
+	    stream_putc (s, nexthop->type);
+	    switch (nexthop->type)
+	      {
+	      case ZEBRA_NEXTHOP_IPV4:
+		stream_put_in_addr (s, &nexthop->gate.ipv4);
+		break;
+#ifdef HAVE_IPV6
+	      case ZEBRA_NEXTHOP_IPV6:
+		stream_put (s, &nexthop->gate.ipv6, 16);
+		break;
+	      case ZEBRA_NEXTHOP_IPV6_IFINDEX:
+	      case ZEBRA_NEXTHOP_IPV6_IFNAME:
+		stream_put (s, &nexthop->gate.ipv6, 16);
+		stream_putl (s, nexthop->ifindex);
+		break;
+#endif /* HAVE_IPV6 */
+	      case ZEBRA_NEXTHOP_IFINDEX:
+	      case ZEBRA_NEXTHOP_IFNAME:
+		stream_putl (s, nexthop->ifindex);
+		break;
+	      }
+	    num++;
+	  }
+      stream_putc_at (s, nump, num);
+    }
+  else
+    {
+      stream_putl (s, 0);
+      stream_putc (s, 0);
+    }
+}
+
+static int
+zsend_nexthop_update (struct zserv *client, struct route_node *rn)
+{
+  struct stream *s;
+  struct zserv_nexthop *nh = rn->info;
+
+  s = client->obuf;
+  stream_reset (s);
+
+  stream_putw (s, 0);
+  stream_putc (s, ZEBRA_NEXTHOP_UPDATE);
+  stream_put (s, nh->state, nh->state_len);
+  stream_putw_at (s, 0, stream_get_endp (s));
+
+  zebra_server_send_message (client, s->data, stream_get_endp (s));
+
+  return 0;
+}
+
+/* Work out again how the registered nexthop of RN resolves and tell
+   its clients if that changed.  Returns 1 when they were told. */
+static int
+zserv_nexthop_refresh (struct route_node *rn)
+{
+  struct zserv_nexthop *nh = rn->info;
+  struct stream *s = zserv_nexthop_buf;
+  struct zserv *client;
+  listnode node;
+  u_int16_t len;
+
+  stream_reset (s);
+  zserv_nexthop_encode (s, &rn->p);
+  len = stream_get_endp (s);
+
+  if (nh->state && nh->state_len == len
+      && memcmp (nh->state, s->data, len) == 0)
+    return 0;
+
+  if (nh->state)
+    XFREE (MTYPE_NEXTHOP_REGISTER, nh->state);
+  nh->state = XMALLOC (MTYPE_NEXTHOP_REGISTER, len);
+  memcpy (nh->state, s->data, len);
+  nh->state_len = len;
+
+  LIST_LOOP (nh->clients, client, node)
+    zsend_nexthop_update (client, rn);
+
+  return 1;
+}
+
+/* The route for P changed: refresh the registered nexthops in P. */
+void
+zebra_nexthop_notify (struct prefix *p)
+{
+  struct route_table *table;
+  struct route_node *start;
+  struct route_node *rn;
+
+  table = zserv_nexthop_table[family2afi (p->family)];
+  if (! table || ! table->top)
+    return;
+
+  start = route_node_get (table, p);
+  route_lock_node (start);
+  for (rn = start; rn; rn = route_next_until (rn, start))
+    if (rn->info)
+      zserv_nexthop_refresh (rn);
+  route_unlock_node (start);
+}
+
  
 /* Register zebra server interface information.  Send current all
    interface and address information. */
@@ -1379,10 +1598,110 @@ zread_ipv6_nexthop_lookup (struct zserv *client, u_short length)
 }
 #endif /* HAVE_IPV6 */
 
+/* Read the nexthop of a (un)registration. */
+static int
+zread_nexthop_prefix (struct zserv *client, struct prefix *p)
+{
+  memset (p, 0, sizeof (struct prefix));
+  p->family = stream_getc (client->ibuf);
+
+  switch (p->family)
+    {
+    case AF_INET:
+      p->prefixlen = IPV4_MAX_BITLEN;
+      p->u.prefix4.s_addr = stream_get_ipv4 (client->ibuf);
+      return 0;
+#ifdef HAVE_IPV6
+    case AF_INET6:
+      p->prefixlen = IPV6_MAX_BITLEN;
+      stream_get (&p->u.prefix6, client->ibuf, 16);
+      return 0;
+#endif /* HAVE_IPV6 */
+    }
+  return -1;
+}
+
+/* Drop CLIENT's registration of the nexthop of RN. */
+static void
+zserv_nexthop_release (struct zserv *client, struct route_node *rn)
+{
+  struct zserv_nexthop *nh = rn->info;
+
+  listnode_delete (nh->clients, client);
+  if (listcount (nh->clients) == 0)
+    {
+      list_delete (nh->clients);
+      if (nh->state)
+	XFREE (MTYPE_NEXTHOP_REGISTER, nh->state);
+      XFREE (MTYPE_NEXTHOP_REGISTER, nh);
+      rn->info = NULL;
+    }
+  route_unlock_node (rn);
+}
+
+/* Client wants to be told how a nexthop resolves. */
+void
+zread_nexthop_register (struct zserv *client, u_short length)
+{
+  struct prefix p;
+  struct route_node *rn;
+  struct zserv_nexthop *nh;
+
+  if (zread_nexthop_prefix (client, &p) < 0)
+    return;
+
+  rn = route_node_get (zserv_nexthop_table[family2afi (p.family)], &p);
+  nh = rn->info;
+  if (! nh)
+    {
+      nh = XCALLOC (MTYPE_NEXTHOP_REGISTER, sizeof (struct zserv_nexthop));
+      nh->clients = list_new ();
+      rn->info = nh;
+    }
+
+  /* Each registration holds a lock of the node. */
+  if (listnode_lookup (nh->clients, client))
+    route_unlock_node (rn);
+  else
+    {
+      listnode_add (nh->clients, client);
+      listnode_add (client->nexthops, rn);
+    }
+
+  /* Answer with the current resolution. */
+  if (! zserv_nexthop_refresh (rn))
+    zsend_nexthop_update (client, rn);
+}
+
+void
+zread_nexthop_unregister (struct zserv *client, u_short length)
+{
+  struct prefix p;
+  struct route_node *rn;
+
+  if (zread_nexthop_prefix (client, &p) < 0)
+    return;
+
+  rn = route_node_lookup (zserv_nexthop_table[family2afi (p.family)], &p);
+  if (! rn)
+    return;
+
+  if (listnode_lookup (client->nexthops, rn))
+    {
+      listnode_delete (client->nexthops, rn);
+      zserv_nexthop_release (client, rn);
+    }
+  route_unlock_node (rn);
+}
+
 /* Close zebra client. */
 void
 zebra_client_close (struct zserv *client)
 {
+  struct zebra_message_queue *queue;
+  struct route_node *rn;
+  listnode node;
+
   /* Close file descriptor. */
   if (client->sock)
     {
@@ -1395,12 +1714,30 @@ zebra_client_close (struct zserv *client)
     stream_free (client->ibuf);
   if (client->obuf)
     stream_free (client->obuf);
+  if (client->batch)
+    stream_free (client->batch);
+
+  /* Drop nexthop registrations. */
+  LIST_LOOP (client->nexthops, rn, node)
+    zserv_nexthop_release (client, rn);
+  list_delete (client->nexthops);
+
+  /* Drop unsent messages. */
+  while ((queue = (struct zebra_message_queue *)
+	  FIFO_HEAD (&client->wqueue)) != NULL)
+    {
+      FIFO_DEL (queue);
+      XFREE (MTYPE_TMP, queue->buf);
+      XFREE (MTYPE_TMP, queue);
+    }
 
   /* Release threads. */
   if (client->t_read)
     thread_cancel (client->t_read);
   if (client->t_write)
     thread_cancel (client->t_write);
+  if (client->t_flush)
+    thread_cancel (client->t_flush);
 
   /* Free client structure. */
   listnode_delete (client_list, client);
@@ -1419,6 +1756,10 @@ zebra_client_create (int sock)
   client->sock = sock;
   client->ibuf = stream_new (ZEBRA_MAX_PACKET_SIZ);
   client->obuf = stream_new (ZEBRA_MAX_PACKET_SIZ);
+  client->batch = stream_new (ZEBRA_BATCH_SIZ);
+  zebra_server_batch_reset (client);
+  FIFO_INIT (&client->wqueue);
+  client->nexthops = list_new ();
 
   /* Set table number. */
   client->rtm_table = rtm_table_default;
@@ -1533,6 +1874,12 @@ zebra_client_read (struct thread *thread)
     case ZEBRA_IPV4_IMPORT_LOOKUP:
       zread_ipv4_import_lookup (client, length);
       break;
+    case ZEBRA_NEXTHOP_REGISTER:
+      zread_nexthop_register (client, length);
+      break;
+    case ZEBRA_NEXTHOP_UNREGISTER:
+      zread_nexthop_unregister (client, length);
+      break;
     default:
       zlog_info ("Zebra received unknown command %d", command);
       break;
@@ -1909,6 +2256,13 @@ zebra_init ()
   /* Client list init. */
   client_list = list_new ();
 
+  /* Registered nexthops. */
+  zserv_nexthop_table[AFI_IP] = route_table_init ();
+#ifdef HAVE_IPV6
+  zserv_nexthop_table[AFI_IP6] = route_table_init ();
+#endif /* HAVE_IPV6 */
+  zserv_nexthop_buf = stream_new (ZEBRA_MAX_PACKET_SIZ);
+
   /* Forwarding is on by default. */
   ipforward_on ();
 #ifdef HAVE_IPV6
@@ -1942,7 +2296,4 @@ zebra_init ()
   install_element (ENABLE_NODE, &show_ipv6_forwarding_cmd);
   install_element (CONFIG_NODE, &no_ipv6_forwarding_cmd);
 #endif /* HAVE_IPV6 */
-
-  FIFO_INIT(&message_queue);
-  t_write = NULL;
 }
@@ -45,6 +45,14 @@ struct zserv
   struct thread *t_read;
   struct thread *t_write;
 
+  /* Messages collected for the next write, and their count. */
+  struct stream *batch;
+  int batch_count;
+  struct thread *t_flush;
+
+  /* Messages the socket did not take yet. */
+  struct fifo wqueue;
+
   /* default routing table this client munges */
   int rtm_table;
 
@@ -56,6 +64,9 @@ struct zserv
 
   /* Interface information. */
   u_char ifinfo;
+
+  /* Route nodes of the nexthops this client registered. */
+  struct list *nexthops;
 };
 
 /* Count prefix size from mask length */
@@ -126,6 +137,8 @@ zsend_ipv6_delete_multipath (struct zserv *, struct prefix *, struct rib *);
 
 #endif /* HAVE_IPV6 */
 
+void zebra_nexthop_notify (struct prefix *);
+
 extern pid_t pid;
 extern pid_t old_pid;
 